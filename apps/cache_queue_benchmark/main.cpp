@@ -0,0 +1,111 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/ren/cache_queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lamure;
+using namespace lamure::ren;
+
+char *get_cmd_option(char **begin, char **end, const std::string &option)
+{
+    char **it = std::find(begin, end, option);
+    if(it != end && ++it != end)
+        return *it;
+    return 0;
+}
+
+// Emulates the access pattern of ooc_pool on cache_queue: one cut update
+// thread requests nodes and updates priorities of waiting nodes, while a
+// number of loader threads take the top job and retire it again.
+int main(int argc, char *argv[])
+{
+    const model_t num_models = get_cmd_option(argv, argv + argc, "-m") ? atoi(get_cmd_option(argv, argv + argc, "-m")) : 64;
+    const node_t num_nodes = get_cmd_option(argv, argv + argc, "-n") ? atoi(get_cmd_option(argv, argv + argc, "-n")) : 100000;
+    const double duration = get_cmd_option(argv, argv + argc, "-t") ? atof(get_cmd_option(argv, argv + argc, "-t")) : 1.0;
+
+    std::cout << "models: " << num_models << " nodes per model: " << num_nodes << " seconds per run: " << duration << std::endl << std::endl;
+    std::cout << std::setw(10) << "loaders" << std::setw(18) << "requests/s" << std::setw(18) << "updates/s" << std::setw(18) << "loads/s" << std::endl;
+
+    for(uint32_t num_loaders : {1u, 2u, 4u, 8u, 16u, 32u})
+    {
+        cache_queue queue;
+        queue.initialize(cache_queue::update_mode::UPDATE_ALWAYS, std::vector<node_t>(num_models, num_nodes));
+
+        std::atomic<bool> running(true);
+        std::atomic<size_t> num_loaded(0);
+        size_t num_requests = 0;
+        size_t num_updates = 0;
+
+        std::vector<std::thread> loaders;
+        for(uint32_t i = 0; i < num_loaders; ++i)
+        {
+            loaders.push_back(std::thread([&] {
+                size_t loaded = 0;
+                while(running.load(std::memory_order_relaxed))
+                {
+                    cache_queue::job job = queue.top_job();
+                    if(job.node_id_ != invalid_node_t)
+                    {
+                        queue.pop_job(job);
+                        ++loaded;
+                    }
+                }
+                num_loaded += loaded;
+            }));
+        }
+
+        std::mt19937 gen(num_loaders);
+        std::uniform_int_distribution<model_t> model_dist(0, num_models - 1);
+        std::uniform_int_distribution<node_t> node_dist(0, num_nodes - 1);
+        std::uniform_int_distribution<int32_t> priority_dist(0, 1 << 20);
+
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        while(elapsed < duration)
+        {
+            for(uint32_t i = 0; i < 1024; ++i)
+            {
+                model_t model_id = model_dist(gen);
+                node_t node_id = node_dist(gen);
+                switch(queue.is_node_indexed(model_id, node_id))
+                {
+                case cache_queue::query_result::NOT_INDEXED:
+                    num_requests += queue.push_job(cache_queue::job(model_id, node_id, 0, priority_dist(gen), nullptr, nullptr));
+                    break;
+                case cache_queue::query_result::INDEXED_AS_WAITING:
+                    queue.update_job(model_id, node_id, priority_dist(gen));
+                    ++num_updates;
+                    break;
+                default:
+                    break;
+                }
+            }
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        running = false;
+        for(auto &loader : loaders)
+        {
+            loader.join();
+        }
+
+        std::cout << std::setw(10) << num_loaders << std::setw(18) << size_t(num_requests / elapsed) << std::setw(18) << size_t(num_updates / elapsed) << std::setw(18)
+                  << size_t(num_loaded / elapsed) << std::endl;
+    }
+
+    return 0;
+}
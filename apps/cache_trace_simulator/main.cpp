@@ -0,0 +1,264 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/ren/cache_index.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace lamure;
+using namespace lamure::ren;
+
+char *get_cmd_option(char **begin, char **end, const std::string &option)
+{
+    char **it = std::find(begin, end, option);
+    if(it != end && ++it != end)
+        return *it;
+    return 0;
+}
+
+bool cmd_option_exists(char **begin, char **end, const std::string &option) { return std::find(begin, end, option) != end; }
+
+struct trace_event
+{
+    char type_;
+    view_t view_id_;
+    model_t model_id_;
+    node_t node_id_;
+    float error_;
+};
+
+// Reads a trace written by cache_index::start_trace, see
+// policy::set_cache_trace_file. Returns the number of slots of the
+// recorded cache or 0 if the header is missing.
+slot_t read_trace(const std::string &filename, std::vector<trace_event> &events)
+{
+    std::ifstream file(filename);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("lamure: cache_trace_simulator: unable to open " + filename);
+    }
+
+    slot_t num_slots = 0;
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.empty())
+        {
+            continue;
+        }
+        if(line[0] == '#')
+        {
+            const size_t pos = line.find("slots ");
+            if(pos != std::string::npos)
+            {
+                num_slots = std::stoull(line.substr(pos + 6));
+            }
+            continue;
+        }
+
+        std::istringstream line_stream(line);
+        trace_event event{0, 0, 0, 0, 0.f};
+        line_stream >> event.type_;
+        if(event.type_ == 'e')
+        {
+            line_stream >> event.model_id_ >> event.node_id_ >> event.error_;
+        }
+        else
+        {
+            line_stream >> event.view_id_ >> event.model_id_ >> event.node_id_;
+        }
+        if(line_stream.fail())
+        {
+            throw std::runtime_error("lamure: cache_trace_simulator: malformed line: " + line);
+        }
+        events.push_back(event);
+    }
+
+    return num_slots;
+}
+
+// Camera sweeping back and forth between two areas. Both working sets fit
+// into the cache together, but every pass in between touches nodes that are
+// never needed again. While resting in an area, a few nodes drop out of the
+// cut and come back each frame.
+slot_t generate_sweep_trace(const slot_t num_slots, const uint32_t num_sweeps, std::vector<trace_event> &events)
+{
+    const node_t area_size = node_t(num_slots * 2 / 5);
+    const node_t transit_size = std::max(node_t(num_slots / 40), node_t(1));
+    const uint32_t frames_per_area = 20;
+    const uint32_t frames_per_transit = 24;
+    const view_t view_id = 0;
+    const model_t model_id = 0;
+
+    std::mt19937 gen(42);
+    node_t next_transit_node = 2 * area_size;
+    std::vector<node_t> cut;
+
+    auto set_cut = [&](const std::vector<node_t> &new_cut, const float error) {
+        for(node_t node_id : cut)
+        {
+            if(std::find(new_cut.begin(), new_cut.end(), node_id) == new_cut.end())
+                events.push_back(trace_event{'r', view_id, model_id, node_id, 0.f});
+        }
+        for(node_t node_id : new_cut)
+        {
+            events.push_back(trace_event{'a', view_id, model_id, node_id, 0.f});
+            events.push_back(trace_event{'e', view_id, model_id, node_id, error});
+        }
+        cut = new_cut;
+    };
+
+    for(uint32_t sweep = 0; sweep < num_sweeps; ++sweep)
+    {
+        const node_t area_begin = (sweep % 2) * area_size;
+
+        for(uint32_t frame = 0; frame < frames_per_area; ++frame)
+        {
+            std::vector<node_t> area_cut;
+            std::bernoulli_distribution in_cut(0.95);
+            for(node_t node_id = area_begin; node_id < area_begin + area_size; ++node_id)
+            {
+                if(in_cut(gen))
+                    area_cut.push_back(node_id);
+            }
+            set_cut(area_cut, 4.f);
+        }
+
+        for(uint32_t frame = 0; frame < frames_per_transit; ++frame)
+        {
+            std::vector<node_t> transit_cut;
+            for(node_t i = 0; i < transit_size; ++i)
+                transit_cut.push_back(next_transit_node++);
+            set_cut(transit_cut, 1.f);
+        }
+    }
+
+    return num_slots;
+}
+
+void write_trace(const std::string &filename, const slot_t num_slots, const std::vector<trace_event> &events)
+{
+    std::ofstream file(filename);
+    file << "# lamure cache trace, slots " << num_slots << "\n";
+    for(const auto &event : events)
+    {
+        if(event.type_ == 'e')
+            file << "e " << event.model_id_ << " " << event.node_id_ << " " << event.error_ << "\n";
+        else
+            file << event.type_ << " " << event.view_id_ << " " << event.model_id_ << " " << event.node_id_ << "\n";
+    }
+}
+
+// Replays the aquire and release calls of the cut update against each
+// eviction policy. A node that is not resident when it is aquired counts as
+// a miss and is loaded into a reserved slot right away, if there is one.
+int main(int argc, char *argv[])
+{
+    if(cmd_option_exists(argv, argv + argc, "-h"))
+    {
+        std::cout << "Usage: " << argv[0] << " [-f trace file] [-c slots] [-s sweeps] [-o synthetic trace output]" << std::endl
+                  << "without -f, a synthetic trace of a camera sweeping between two areas is replayed" << std::endl;
+        return 0;
+    }
+
+    std::vector<trace_event> events;
+    slot_t num_slots = get_cmd_option(argv, argv + argc, "-c") ? std::stoull(get_cmd_option(argv, argv + argc, "-c")) : 0;
+
+    if(get_cmd_option(argv, argv + argc, "-f"))
+    {
+        const slot_t recorded_slots = read_trace(get_cmd_option(argv, argv + argc, "-f"), events);
+        if(num_slots == 0)
+            num_slots = recorded_slots;
+    }
+    else
+    {
+        const uint32_t num_sweeps = get_cmd_option(argv, argv + argc, "-s") ? atoi(get_cmd_option(argv, argv + argc, "-s")) : 16;
+        if(num_slots == 0)
+            num_slots = 8192;
+        generate_sweep_trace(num_slots, num_sweeps, events);
+
+        if(get_cmd_option(argv, argv + argc, "-o"))
+            write_trace(get_cmd_option(argv, argv + argc, "-o"), num_slots, events);
+    }
+
+    if(num_slots == 0)
+    {
+        std::cout << "lamure: cache_trace_simulator: number of slots unknown, use -c" << std::endl;
+        return 1;
+    }
+
+    model_t num_models = 0;
+    for(const auto &event : events)
+        num_models = std::max(num_models, model_t(event.model_id_ + 1));
+
+    std::cout << "events: " << events.size() << " slots: " << num_slots << " models: " << num_models << std::endl << std::endl;
+    std::cout << std::setw(16) << "policy" << std::setw(12) << "aquires" << std::setw(12) << "misses" << std::setw(12) << "hit rate" << std::setw(12) << "stalls"
+              << std::setw(12) << "ms" << std::endl;
+
+    for(auto type : {cache_policy::policy_type::LRU, cache_policy::policy_type::TWO_QUEUE, cache_policy::policy_type::ARC, cache_policy::policy_type::ERROR_WEIGHTED})
+    {
+        cache_index index(num_models, num_slots, type);
+
+        size_t num_aquires = 0;
+        size_t num_misses = 0;
+        size_t num_stalls = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for(const auto &event : events)
+        {
+            switch(event.type_)
+            {
+            case 'a':
+                ++num_aquires;
+                if(!index.is_node_indexed(event.model_id_, event.node_id_))
+                {
+                    ++num_misses;
+                    if(index.num_free_slots() == 0)
+                    {
+                        ++num_stalls;
+                        break;
+                    }
+                    index.apply_slot(index.reserve_slot(), event.model_id_, event.node_id_);
+                }
+                index.aquire_slot(event.view_id_, event.model_id_, event.node_id_);
+                break;
+            case 'r':
+                if(index.is_node_indexed(event.model_id_, event.node_id_))
+                    index.release_slot(event.view_id_, event.model_id_, event.node_id_);
+                break;
+            case 'i':
+                if(index.is_node_indexed(event.model_id_, event.node_id_))
+                    index.release_slot_invalidate(event.view_id_, event.model_id_, event.node_id_);
+                break;
+            case 'e':
+                if(index.uses_node_errors())
+                    index.update_node_error(event.model_id_, event.node_id_, event.error_);
+                break;
+            default:
+                break;
+            }
+        }
+
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const double hit_rate = num_aquires > 0 ? 1.0 - double(num_misses) / double(num_aquires) : 0.0;
+
+        std::cout << std::setw(16) << cache_policy::type_name(type) << std::setw(12) << num_aquires << std::setw(12) << num_misses << std::setw(12) << std::fixed
+                  << std::setprecision(4) << hit_rate << std::setw(12) << num_stalls << std::setw(12) << std::setprecision(1) << elapsed << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/ren/camera.h>
+#include <lamure/ren/cut_database.h>
+#include <lamure/ren/cut_update_pool.h>
+#include <lamure/ren/model_database.h>
+#include <lamure/ren/ooc_cache.h>
+#include <lamure/ren/policy.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+using namespace lamure;
+using namespace lamure::ren;
+
+// reads a camera session file as written by the rendering app (one view matrix per line)
+std::vector<scm::math::mat4d> parse_camera_session_file(const std::string &session_file_path)
+{
+    std::ifstream camera_session_file(session_file_path);
+
+    std::string view_matrix_as_string;
+    std::vector<scm::math::mat4d> view_matrices;
+
+    while(std::getline(camera_session_file, view_matrix_as_string))
+    {
+        scm::math::mat4d view_matrix;
+        std::istringstream view_matrix_as_strstream(view_matrix_as_string);
+
+        for(int matrix_element_idx = 0; matrix_element_idx < 16; ++matrix_element_idx)
+        {
+            view_matrix_as_strstream >> view_matrix[matrix_element_idx];
+        }
+
+        view_matrices.push_back(view_matrix);
+    }
+
+    return view_matrices;
+}
+
+// orbits around the root bounding box of the first model while moving in and out,
+// such that every frame forces splits as well as collapses
+std::vector<scm::math::mat4d> create_orbit_path(const scm::gl::boxf &bounding_box, const uint32_t num_frames)
+{
+    const scm::math::vec3f center = bounding_box.center();
+    const float radius = scm::math::length(bounding_box.max_vertex() - bounding_box.min_vertex());
+
+    std::vector<scm::math::mat4d> view_matrices;
+
+    for(uint32_t frame = 0; frame < num_frames; ++frame)
+    {
+        const float t = float(frame) / float(num_frames);
+        const float angle = 2.f * 3.14159265f * t;
+        const float distance = radius * (0.2f + 0.8f * (0.5f + 0.5f * std::cos(3.f * angle)));
+
+        scm::math::vec3f eye = center + scm::math::vec3f(distance * std::cos(angle), 0.25f * distance, distance * std::sin(angle));
+
+        scm::math::mat4f view_matrix;
+        scm::math::look_at_matrix(view_matrix, eye, center, scm::math::vec3f(0.f, 1.f, 0.f));
+        view_matrices.push_back(scm::math::mat4d(view_matrix));
+    }
+
+    return view_matrices;
+}
+
+// Replays a camera path through cut_update_pool without a render device. The
+// pool writes its node uploads into plain host buffers in place of the
+// temporary gpu storage, so only cut analysis, cut update and the out-of-core
+// cache are measured.
+int main(int argc, const char *argv[])
+{
+    namespace po = boost::program_options;
+
+    po::options_description od("Usage: cut_update_benchmark [OPTION]... -f MODEL.bvh...\n\nAllowed Options");
+    od.add_options()
+        ("help,h", "print help message")
+        ("models,f", po::value<std::vector<std::string>>()->multitoken()->required(), "bvh files to load")
+        ("session,s", po::value<std::string>()->default_value(""), "camera session file (.csn), an orbit is used if omitted")
+        ("frames,n", po::value<uint32_t>()->default_value(1000), "number of frames of the orbit")
+        ("threshold,t", po::value<float>()->default_value(LAMURE_DEFAULT_THRESHOLD), "error threshold")
+        ("vram,v", po::value<size_t>()->default_value(2048), "render budget in MB")
+        ("ram,m", po::value<size_t>()->default_value(4096), "out-of-core budget in MB")
+        ("upload,u", po::value<size_t>()->default_value(64), "upload budget in MB")
+        ("width", po::value<uint32_t>()->default_value(1920), "window width")
+        ("height", po::value<uint32_t>()->default_value(1080), "window height")
+        ("latency,l", "print the cut update latency of every frame")
+        ("predict,p", "prefetch nodes along the extrapolated camera path");
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, od), vm);
+
+        if(vm.count("help"))
+        {
+            std::cout << od << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        po::notify(vm);
+    }
+    catch(po::error &e)
+    {
+        std::cerr << e.what() << std::endl << od << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const uint32_t window_width = vm["width"].as<uint32_t>();
+    const uint32_t window_height = vm["height"].as<uint32_t>();
+    const float threshold = vm["threshold"].as<float>();
+
+    policy *policy = policy::get_instance();
+    policy->set_render_budget_in_mb(vm["vram"].as<size_t>());
+    policy->set_out_of_core_budget_in_mb(vm["ram"].as<size_t>());
+    policy->set_max_upload_budget_in_mb(vm["upload"].as<size_t>());
+    policy->set_window_width(window_width);
+    policy->set_window_height(window_height);
+    policy->set_measure_cut_update_latency(vm.count("latency") > 0);
+    policy->set_predictive_prefetching(vm.count("predict") > 0);
+
+    model_database *database = model_database::get_instance();
+
+    for(const auto &model_filename : vm["models"].as<std::vector<std::string>>())
+    {
+        database->add_model(model_filename, std::to_string(database->num_models()));
+    }
+
+    std::vector<scm::math::mat4d> view_matrices;
+    if(!vm["session"].as<std::string>().empty())
+    {
+        view_matrices = parse_camera_session_file(vm["session"].as<std::string>());
+    }
+    else
+    {
+        view_matrices = create_orbit_path(database->get_model(0)->get_bvh()->get_bounding_boxes()[0], vm["frames"].as<uint32_t>());
+    }
+
+    if(view_matrices.empty())
+    {
+        std::cerr << "camera path is empty" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const context_t context_id = 0;
+    const view_t view_id = 0;
+
+    const size_t slot_size = database->get_slot_size();
+    const node_t render_budget_in_nodes = (policy->render_budget_in_mb() * 1024u * 1024u) / slot_size;
+    const node_t upload_budget_in_nodes = (policy->max_upload_budget_in_mb() * 1024u * 1024u) / slot_size;
+
+    // stands in for the mapped temporary storages of the gpu context
+    std::vector<char> storage_a(upload_budget_in_nodes * slot_size);
+    std::vector<char> storage_b(upload_budget_in_nodes * slot_size);
+
+    cut_database *cuts = cut_database::get_instance();
+    cut_update_pool *pool = new cut_update_pool(context_id, upload_budget_in_nodes, render_budget_in_nodes);
+
+    camera cam(view_id, scm::math::mat4f::identity(), 1.f);
+    cam.set_projection_matrix(30.f, float(window_width) / float(window_height), 0.01f, 1000.f);
+
+    std::vector<double> frame_times;
+    double total_analysis = 0.0;
+    double total_update = 0.0;
+    size_t num_cut_nodes = 0;
+    size_t num_warmup_frames = 0;
+
+    for(const auto &view_matrix : view_matrices)
+    {
+        cam.set_view_matrix(view_matrix);
+
+        for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
+        {
+            cuts->send_transform(context_id, model_id, scm::math::mat4f::identity());
+            cuts->send_threshold(context_id, model_id, threshold);
+            cuts->send_rendered(context_id, model_id);
+        }
+
+        std::vector<scm::math::vec3d> corner_values = cam.get_frustum_corners();
+        double top_minus_bottom = scm::math::length((corner_values[2]) - (corner_values[0]));
+
+        cuts->send_camera(context_id, view_id, cam);
+        cuts->send_height_divided_by_top_minus_bottom(context_id, view_id, window_height / top_minus_bottom);
+
+        cuts->swap(context_id);
+
+        auto start = std::chrono::steady_clock::now();
+
+        pool->dispatch_cut_update(storage_a.data(), storage_b.data(), nullptr, nullptr);
+        while(pool->is_running())
+        {
+            std::this_thread::yield();
+        }
+
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if(cuts->is_front_modified(context_id))
+        {
+            cuts->signal_upload_complete(context_id);
+        }
+
+        size_t frame_cut_nodes = 0;
+        for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
+        {
+            frame_cut_nodes += cuts->get_cut(context_id, view_id, model_id).complete_set().size();
+        }
+
+        // the first frames only wait for the root nodes to become resident
+        if(frame_cut_nodes == 0)
+        {
+            ++num_warmup_frames;
+            continue;
+        }
+
+        const cut_update_pool::latency latency = pool->last_latency();
+        total_analysis += latency.analysis_ms_;
+        total_update += latency.update_ms_;
+
+        num_cut_nodes += frame_cut_nodes;
+        frame_times.push_back(elapsed);
+    }
+
+    const cut_update_pool::prefetch_statistics prefetch_stats = pool->prefetch_stats();
+
+    delete pool;
+
+    if(frame_times.empty())
+    {
+        std::cerr << "no cut was produced" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<double> sorted_times = frame_times;
+    std::sort(sorted_times.begin(), sorted_times.end());
+
+    double total = 0.0;
+    for(const double t : frame_times)
+    {
+        total += t;
+    }
+
+    std::cout << "models: " << database->num_models() << " frames: " << frame_times.size() << " (+" << num_warmup_frames << " warmup)" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "avg cut size [nodes]:    " << num_cut_nodes / frame_times.size() << std::endl;
+    std::cout << "avg cut update [ms]:     " << total / frame_times.size() << std::endl;
+    std::cout << "  avg analysis [ms]:     " << total_analysis / frame_times.size() << std::endl;
+    std::cout << "  avg update [ms]:       " << total_update / frame_times.size() << std::endl;
+    std::cout << "median cut update [ms]:  " << sorted_times[sorted_times.size() / 2] << std::endl;
+    std::cout << "p99 cut update [ms]:     " << sorted_times[std::min(sorted_times.size() - 1, sorted_times.size() * 99 / 100)] << std::endl;
+    std::cout << "max cut update [ms]:     " << sorted_times.back() << std::endl;
+
+    if(policy->predictive_prefetching())
+    {
+        const size_t num_split_loads = prefetch_stats.num_prefetch_hits_ + prefetch_stats.num_demand_loads_;
+        std::cout << "prefetched [nodes]:      " << prefetch_stats.num_prefetched_ << std::endl;
+        std::cout << "  used by splits:        " << prefetch_stats.num_prefetch_hits_ << std::endl;
+        std::cout << "  expired:               " << prefetch_stats.num_prefetch_expired_ << std::endl;
+        std::cout << "demand loads [nodes]:    " << prefetch_stats.num_demand_loads_ << std::endl;
+        std::cout << "prefetch accuracy:       " << (prefetch_stats.num_prefetched_ > 0 ? double(prefetch_stats.num_prefetch_hits_) / prefetch_stats.num_prefetched_ : 0.0) << std::endl;
+        std::cout << "prefetch coverage:       " << (num_split_loads > 0 ? double(prefetch_stats.num_prefetch_hits_) / num_split_loads : 0.0) << std::endl;
+    }
+
+    delete cut_database::get_instance();
+    delete ooc_cache::get_instance();
+    delete model_database::get_instance();
+    delete policy::get_instance();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <lamure/pre/external_sort.h>
+#include <lamure/pre/surfel_disk_array.h>
+
+using namespace lamure::pre;
+
+// Measures the throughput of the out-of-core merge in external_sort for
+// varying numbers of runs. The memory limit is chosen such that the input
+// is split into exactly the requested number of runs.
+int main(int argc, const char *argv[])
+{
+    namespace po = boost::program_options;
+
+    po::options_description od("Usage: external_sort_benchmark [OPTION]...\n\nAllowed Options");
+    od.add_options()
+        ("help,h", "print help message")
+        ("surfels,n", po::value<size_t>()->default_value(16 * 1024 * 1024), "number of surfels to sort")
+        ("runs,r", po::value<std::vector<uint32_t>>()->multitoken()->default_value({4, 16, 64, 256, 512}, "4 16 64 256 512"),
+         "run counts to benchmark")
+        ("file,f", po::value<std::string>()->default_value("external_sort_benchmark.bin"), "temporary file");
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, od), vm);
+        po::notify(vm);
+    }
+    catch (po::error &e) {
+        std::cerr << e.what() << std::endl << od << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (vm.count("help")) {
+        std::cout << od << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    const size_t num_surfels = vm["surfels"].as<size_t>();
+    const std::string file_name = vm["file"].as<std::string>();
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1000.0, 1000.0);
+
+    auto input = std::make_shared<surfel_vector>(num_surfels);
+    for (auto &s : *input)
+        s = surfel(lamure::vec3r(dist(gen), dist(gen), dist(gen)));
+
+    const auto compare = surfel::compare(0);
+
+    std::cout << std::setw(8) << "runs"
+              << std::setw(16) << "runs [s]"
+              << std::setw(16) << "merge [s]"
+              << std::setw(20) << "merge [surfels/s]" << std::endl;
+
+    for (const uint32_t runs : vm["runs"].as<std::vector<uint32_t>>()) {
+        auto file = std::make_shared<surfel_file>();
+        file->open(file_name, true);
+        file->append(&(*input));
+
+        surfel_disk_array array(file, 0, num_surfels);
+
+        const size_t run_length = (num_surfels + runs - 1) / runs;
+        const size_t memory_limit = run_length * sizeof(surfel) * 3u;
+
+        external_sort::statistics stats;
+        external_sort::sort(array, memory_limit, compare, &stats);
+
+        shared_surfel_vector sorted = array.read_all();
+        const bool is_sorted = std::is_sorted(sorted->begin(), sorted->end(), compare);
+        file->close(true);
+
+        std::cout << std::setw(8) << stats.runs_count
+                  << std::setw(16) << stats.create_runs_time
+                  << std::setw(16) << stats.merge_time
+                  << std::setw(20) << (stats.merge_time > 0.0 ? num_surfels / stats.merge_time : 0.0)
+                  << (is_sorted ? "" : "  NOT SORTED") << std::endl;
+
+        if (!is_sorted)
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
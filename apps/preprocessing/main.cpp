@@ -160,7 +160,8 @@ int main(int argc, const char *argv[])
 
             ("normal-computation-algo", po::value<std::string>()->default_value("planefitting"),
             "Algorithm for computing surfel normal. Possible values:\n"
-            "  planefitting ")
+            "  planefitting \n"
+            "  pca - batched closed-form eigensolver, vectorized where available")
 
             ("radius-computation-algo", po::value<std::string>()->default_value("naturalneighbours"),
             "Algorithm for computing surfel radius. Possible values:\n"
@@ -171,6 +172,12 @@ int main(int argc, const char *argv[])
             "the multiplier for the average distance to the neighbours"
             "during radius computation when using the averagedistance strategy")
 
+            ("lod-format", po::value<std::string>()->default_value("surfels"),
+            "Surfel layout of the serialized nodes. Possible values:\n"
+            "  surfels - uncompressed surfels (.bvh, .lod)\n"
+            "  qz - quantized surfels (.bvhqz, .lodqz)\n"
+            "  qzdeflate - quantized surfels, every node deflated (.bvhqz, .lodqz)")
+
             ("rep-radius-algo", po::value<std::string>()->default_value("amean"),
             "Algorithm for computing representative surfel radius for tree nodes. Possible values:\n"
             "  amean - arithmetic mean\n"
@@ -384,6 +391,8 @@ int main(int argc, const char *argv[])
     std::string na = vm["normal-computation-algo"].as<std::string>();
     if(na == "planefitting")
         desc.normal_computation_algo = lamure::pre::normal_computation_algorithm::plane_fitting;
+    else if(na == "pca")
+        desc.normal_computation_algo = lamure::pre::normal_computation_algorithm::pca;
     else
         throw std::runtime_error("Unknown normal computation algorithm: " + na);
 
@@ -396,6 +405,17 @@ int main(int argc, const char *argv[])
     else
         throw std::runtime_error("Unknown radius computation algorithm: " + ra2);
 
+    // serialized node layout
+    std::string lf = vm["lod-format"].as<std::string>();
+    if(lf == "surfels")
+        desc.output_format = lamure::pre::lod_format::surfels;
+    else if(lf == "qz")
+        desc.output_format = lamure::pre::lod_format::quantized;
+    else if(lf == "qzdeflate")
+        desc.output_format = lamure::pre::lod_format::quantized_deflate;
+    else
+        throw std::runtime_error("Unknown lod format: " + lf);
+
     // representative radius
     std::string rra = vm["rep-radius-algo"].as<std::string>();
     if(rra == "amean")
@@ -64,7 +64,7 @@ int main(int argc, char *argv[])
         auto start = std::chrono::high_resolution_clock::now();
         cache_sparse.cache();
         auto end = std::chrono::high_resolution_clock::now();
-        printf("Caching sparse data took: %f ms\n", std::chrono::duration<double, std::milli>(end - start));
+        printf("Caching sparse data took: %f ms\n", std::chrono::duration<double, std::milli>(end - start).count());
         in_sparse.close();
     }
     if(in_dense.is_open())
@@ -72,7 +72,68 @@ int main(int argc, char *argv[])
         auto start = std::chrono::high_resolution_clock::now();
         cache_dense.cache();
         auto end = std::chrono::high_resolution_clock::now();
-        printf("Caching dense data took: %f ms\n", std::chrono::duration<double, std::milli>(end - start));
+        printf("Caching dense data took: %f ms\n", std::chrono::duration<double, std::milli>(end - start).count());
+        in_dense.close();
+    }
+
+    // Compare against loading the same files memory mapped and decoded in parallel.
+    in_sparse.open(name_file_sparse, std::ios::in | std::ios::binary);
+    in_sparse_meta.close();
+    in_sparse_meta.open(name_file_sparse + ".meta", std::ios::in | std::ios::binary);
+
+    if(in_sparse.is_open())
+    {
+        lamure::prov::SparseCache cache_sparse_mapped(in_sparse, in_sparse_meta);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        cache_sparse_mapped.cache_mapped(name_file_sparse, name_file_sparse + ".meta");
+        auto end = std::chrono::high_resolution_clock::now();
+        printf("Caching sparse data memory mapped took: %f ms\n", std::chrono::duration<double, std::milli>(end - start).count());
+
+        bool equal = cache_sparse_mapped.get_points().size() == cache_sparse.get_points().size() &&
+                     cache_sparse_mapped.get_points_metadata().size() == cache_sparse.get_points_metadata().size() &&
+                     cache_sparse_mapped.get_cameras().size() == cache_sparse.get_cameras().size();
+        for(size_t i = 0; equal && i < cache_sparse.get_points().size(); i++)
+        {
+            const lamure::prov::SparsePoint &mapped_point = cache_sparse_mapped.get_points()[i];
+            const lamure::prov::SparsePoint &point = cache_sparse.get_points()[i];
+
+            equal = mapped_point.get_index() == point.get_index() &&
+                    mapped_point.get_position() == point.get_position() &&
+                    mapped_point.get_measurements().size() == point.get_measurements().size() &&
+                    cache_sparse_mapped.get_points_metadata()[i].get_metadata() == cache_sparse.get_points_metadata()[i].get_metadata();
+
+            for(size_t j = 0; equal && j < point.get_measurements().size(); j++)
+            {
+                equal = mapped_point.get_measurements()[j].get_camera() == point.get_measurements()[j].get_camera() &&
+                        mapped_point.get_measurements()[j].get_occurence() == point.get_measurements()[j].get_occurence();
+            }
+        }
+        printf("Memory mapped sparse data %s\n", equal ? "matches" : "DIFFERS");
+        in_sparse.close();
+    }
+
+    in_dense.open(name_file_dense, std::ios::in | std::ios::binary);
+    in_dense_meta.close();
+    in_dense_meta.open(name_file_dense + ".meta", std::ios::in | std::ios::binary);
+
+    if(in_dense.is_open())
+    {
+        lamure::prov::DenseCache cache_dense_mapped(in_dense, in_dense_meta);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        cache_dense_mapped.cache_mapped(name_file_dense, name_file_dense + ".meta");
+        auto end = std::chrono::high_resolution_clock::now();
+        printf("Caching dense data memory mapped took: %f ms\n", std::chrono::duration<double, std::milli>(end - start).count());
+
+        bool equal = cache_dense_mapped.get_points().size() == cache_dense.get_points().size();
+        for(size_t i = 0; equal && i < cache_dense.get_points().size(); i++)
+        {
+            equal = cache_dense_mapped.get_points()[i].get_position() == cache_dense.get_points()[i].get_position() &&
+                    cache_dense_mapped.get_points()[i].get_normal() == cache_dense.get_points()[i].get_normal() &&
+                    cache_dense_mapped.get_points_metadata()[i].get_images_seen() == cache_dense.get_points_metadata()[i].get_images_seen();
+        }
+        printf("Memory mapped dense data %s\n", equal ? "matches" : "DIFFERS");
         in_dense.close();
     }
 
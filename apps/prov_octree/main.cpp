@@ -57,7 +57,7 @@ int main(int argc, char *argv[])
     if(in_dense.is_open())
     {
         auto start = std::chrono::high_resolution_clock::now();
-        cache_dense.cache();
+        cache_dense.cache_mapped(name_file_dense, name_file_dense + ".meta");
         auto end = std::chrono::high_resolution_clock::now();
         printf("Caching dense data took: %f ms\n", std::chrono::duration<double, std::milli>(end - start));
         in_dense.close();
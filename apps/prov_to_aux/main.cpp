@@ -81,7 +81,7 @@ int main(int argc, char *argv[]) {
     
     if(in_sparse.is_open()) {
       std::cout << "Caching sparse..." << std::endl;
-      cache_sparse.cache(true, fotos_directory);
+      cache_sparse.cache_mapped(sparse_file, sparse_file + ".meta", true, fotos_directory);
       in_sparse.close();
     }
     else {
@@ -91,7 +91,7 @@ int main(int argc, char *argv[]) {
 /*
     if(in_dense.is_open()) {
       std::cout << "Caching dense..." << std::endl;
-      cache_dense.cache();
+      cache_dense.cache_mapped(dense_file, dense_file + ".meta");
       in_dense.close();
     }
     else {
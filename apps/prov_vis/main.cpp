@@ -169,7 +169,7 @@ Controller *load_scene_depending_on_arguments(int argc, char *argv[])
         std::ifstream in_sparse(name_file_sparse, std::ios::in | std::ios::binary);
         std::ifstream in_sparse_meta(name_file_sparse + ".meta", std::ios::in | std::ios::binary);
         lamure::prov::SparseCache cache_sparse = lamure::prov::SparseCache(in_sparse, in_sparse_meta);
-        cache_sparse.cache();
+        cache_sparse.cache_mapped(name_file_sparse, name_file_sparse + ".meta");
         in_sparse.close();
 
         std::vector<lamure::prov::Camera> vec_camera = cache_sparse.get_cameras();
@@ -15,6 +15,7 @@
 
 #include <lamure/pvs/grid_regular.h>
 #include <lamure/pvs/grid_regular_compressed.h>
+#include <lamure/pvs/grid_regular_roaring.h>
 #include <lamure/pvs/grid_octree.h>
 #include <lamure/pvs/grid_octree_compressed.h>
 #include <lamure/pvs/grid_octree_hierarchical.h>
@@ -54,7 +55,7 @@ int main(int argc, char** argv)
       ("pvs-file", po::value<std::string>(&pvs_input_file_path), "specify input file of calculated pvs data (.pvs)")
       ("2nd-pvs-file", po::value<std::string>(&second_pvs_input_file_path), "(optional) specify second input file of calculated pvs data (.pvs) to join visibility with first pvs file")
       ("output-file", po::value<std::string>(&pvs_output_file_path), "specify output file of converted visibility data (.pvs)")
-      ("gridtype", po::value<std::string>(&output_grid_type), "specify type of grid to store visibility data. If no grid type is given, the input grid type will be used. ('regular', 'regular_compressed', 'irregular', 'irregular_compressed', octree', 'octree_compressed', octree_hierarchical', 'octree_hierarchical_v2', 'octree_hierarchical_v3')")
+      ("gridtype", po::value<std::string>(&output_grid_type), "specify type of grid to store visibility data. If no grid type is given, the input grid type will be used. ('regular', 'regular_compressed', 'regular_roaring', 'irregular', 'irregular_compressed', octree', 'octree_compressed', octree_hierarchical', 'octree_hierarchical_v2', 'octree_hierarchical_v3')")
       ("optithresh", po::value<float>(&optimization_threshold)->default_value(-1.0f), "specify the threshold at which common data are converged (percent value between 0 and 1). Negative values will deactivate optimization process. Default value is -1.0, so grid optimization is deactivated.");
       ;
 
@@ -103,11 +104,12 @@ int main(int argc, char** argv)
 
     if(input_grid->get_grid_type() != lamure::pvs::grid_regular::get_grid_identifier() && 
         input_grid->get_grid_type() != lamure::pvs::grid_regular_compressed::get_grid_identifier() && 
+        input_grid->get_grid_type() != lamure::pvs::grid_regular_roaring::get_grid_identifier() &&
         input_grid->get_grid_type() != lamure::pvs::grid_octree_hierarchical_v3::get_grid_identifier() &&
         input_grid->get_grid_type() != lamure::pvs::grid_irregular::get_grid_identifier() &&
         input_grid->get_grid_type() != lamure::pvs::grid_irregular_compressed::get_grid_identifier())
     {
-        std::cout << "Input grid must be of regular, regular compressed or hierarchical v3 grid type. Irregular works as well, yet should be unoptimized." << std::endl;
+        std::cout << "Input grid must be of regular, regular compressed, regular roaring or hierarchical v3 grid type. Irregular works as well, yet should be unoptimized." << std::endl;
         return 0;
     }
     else
@@ -140,11 +142,12 @@ int main(int argc, char** argv)
 
         if(second_input_grid->get_grid_type() != lamure::pvs::grid_regular::get_grid_identifier() && 
             second_input_grid->get_grid_type() != lamure::pvs::grid_regular_compressed::get_grid_identifier() && 
+            second_input_grid->get_grid_type() != lamure::pvs::grid_regular_roaring::get_grid_identifier() &&
             second_input_grid->get_grid_type() != lamure::pvs::grid_octree_hierarchical_v3::get_grid_identifier() &&
             second_input_grid->get_grid_type() != lamure::pvs::grid_irregular::get_grid_identifier() &&
             second_input_grid->get_grid_type() != lamure::pvs::grid_irregular_compressed::get_grid_identifier())
         {
-            std::cout << "Input grid must be of regular, regular compressed or hierarchical v3 grid type. Irregular works as well, yet should be unoptimized." << std::endl;
+            std::cout << "Input grid must be of regular, regular compressed, regular roaring or hierarchical v3 grid type. Irregular works as well, yet should be unoptimized." << std::endl;
             return 0;
         }
 
@@ -209,7 +212,8 @@ int main(int argc, char** argv)
 
         size_t num_cells = depth;
         if(output_grid_type == lamure::pvs::grid_regular::get_grid_identifier() || 
-            output_grid_type == lamure::pvs::grid_regular_compressed::get_grid_identifier())
+            output_grid_type == lamure::pvs::grid_regular_compressed::get_grid_identifier() ||
+            output_grid_type == lamure::pvs::grid_regular_roaring::get_grid_identifier())
         {
             num_cells = cells_per_axis;
         }
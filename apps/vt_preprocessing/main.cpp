@@ -35,6 +35,8 @@ AtlasFile::LAYOUT parseFileFormat(const char *formatStr){
         return AtlasFile::LAYOUT::RAW;
     }else if(std::strcmp(formatStr, "packed") == 0){
         return AtlasFile::LAYOUT::PACKED;
+    }else if(std::strcmp(formatStr, "deflate") == 0){
+        return AtlasFile::LAYOUT::PACKED_DEFLATE;
     }else{
         throw std::runtime_error("Invalid file format given.");
     }
@@ -46,6 +48,8 @@ const char *printLayout(AtlasFile::LAYOUT layout){
             return "raw";
         case AtlasFile::LAYOUT::PACKED:
             return "packed";
+        case AtlasFile::LAYOUT::PACKED_DEFLATE:
+            return "packed, deflated";
     }
 }
 
@@ -61,21 +65,21 @@ const char *printPxFormat(Bitmap::PIXEL_FORMAT pxFormat){
 }
 
 int process(const int argc, const char **argv){
-    if(argc != 10){
+    if(argc != 10 && argc != 11){
         std::cout << "Wrong count of parameters." << std::endl;
         std::cout << "Expected parameters:" << std::endl;
         std::cout << "\t<image file> <image pixel format (r, rgb, rgba)>" << std::endl;
         std::cout << "\t<image width> <image height>" << std::endl;
         std::cout << "\t<tile width> <tile height> <padding>" << std::endl;
         std::cout << "\t<out file (without extension)> <out pixel format (r, rgb, rgba)>" << std::endl;
-        std::cout << "\t<max memory usage (in GB)>" << std::endl;
+        std::cout << "\t<max memory usage (in GB)> [out layout (packed, deflate)]" << std::endl;
 
         return 1;
     }
 
     Bitmap::PIXEL_FORMAT inPixelFormat;
     Bitmap::PIXEL_FORMAT outPixelFormat;
-    //AtlasFile::LAYOUT outFileFormat;
+    AtlasFile::LAYOUT outFileFormat = AtlasFile::LAYOUT::PACKED;
 
     try {
         inPixelFormat = parsePixelFormat(argv[1]);
@@ -95,13 +99,23 @@ int process(const int argc, const char **argv){
         return 1;
     }
 
-    /*try {
-        outFileFormat = parseFileFormat(argv[8]);
-    }catch(std::runtime_error &error){
-        std::cout << "Invalid output file format given: \"" << argv[8] << "\"." << std::endl;
+    if(argc == 11) {
+        try {
+            outFileFormat = parseFileFormat(argv[10]);
+        }
+        catch(std::runtime_error &/*error*/)
+        {
+            std::cout << "Invalid output layout given: \"" << argv[10] << "\"." << std::endl;
 
-        return 1;
-    }*/
+            return 1;
+        }
+
+        if(outFileFormat == AtlasFile::LAYOUT::RAW){
+            std::cout << "The raw layout is deprecated." << std::endl;
+
+            return 1;
+        }
+    }
 
     std::stringstream stream;
 
@@ -170,7 +184,7 @@ int process(const int argc, const char **argv){
 
     Preprocessor pre(argv[0], inPixelFormat, imageWidth, imageHeight);
 
-    pre.setOutput(argv[7], outPixelFormat, AtlasFile::LAYOUT::PACKED, tileWidth, tileHeight, padding);
+    pre.setOutput(argv[7], outPixelFormat, outFileFormat, tileWidth, tileHeight, padding);
     pre.run(maxMemory);
 
     return 0;
@@ -208,6 +222,7 @@ int info(const int argc, const char **argv){
     std::cout << "\toffset index at " << atlas->getOffsetIndexOffset() << std::endl;
     std::cout << "\tcielab index at " << atlas->getCielabIndexOffset() << std::endl;
     std::cout << "\tpayload at " << atlas->getPayloadOffset() << std::endl;
+    std::cout << "\tpayload size " << atlas->getPayloadSize() << " Bytes" << std::endl;
     std::cout << std::endl;
 
     delete atlas;
@@ -0,0 +1,273 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/vt/Observer.h>
+#include <lamure/vt/ooc/TileCache.h>
+#include <lamure/vt/ooc/TileLoader.h>
+#include <lamure/vt/ooc/TileRequest.h>
+#include <lamure/vt/pre/AtlasFile.h>
+#include <lamure/vt/pre/CielabIndex.h>
+#include <lamure/vt/pre/OffsetIndex.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+typedef std::chrono::steady_clock bench_clock;
+
+char *get_cmd_option(char **begin, char **end, const std::string &option)
+{
+    char **it = std::find(begin, end, option);
+    if(it != end && ++it != end)
+        return *it;
+    return 0;
+}
+
+bool cmd_option_exists(char **begin, char **end, const std::string &option) { return std::find(begin, end, option) != end; }
+
+void put_le(uint8_t *data, uint64_t value)
+{
+    for(int i = 0; i < 8; ++i)
+    {
+        data[i] = (uint8_t)(value >> (i << 3));
+    }
+}
+
+// Writes a packed RGBA8 atlas whose image fills every level of the quad tree,
+// so each tile id below the total tile count is present in the file.
+void write_atlas(const std::string &filename, const uint32_t depth, const uint64_t tile_size)
+{
+    const uint64_t padding = 1;
+    const uint64_t inner_tile_size = tile_size - 2 * padding;
+    const uint64_t image_size = inner_tile_size << (depth - 1);
+    const uint64_t tile_byte_size = tile_size * tile_size * 4;
+
+    uint64_t total_tiles = 0;
+    for(uint32_t level = 0; level < depth; ++level)
+    {
+        total_tiles += uint64_t(1) << (2 * level);
+    }
+
+    vt::pre::OffsetIndex offset_index(total_tiles, vt::pre::AtlasFile::LAYOUT::PACKED);
+    vt::pre::CielabIndex cielab_index(total_tiles);
+
+    // the end of a tile is stored in the entry of its predecessor, so fill from the back
+    for(uint64_t id = total_tiles; id-- > 0;)
+    {
+        offset_index.set(id, id * tile_byte_size, tile_byte_size);
+        cielab_index.set(id, 0.f);
+    }
+
+    const uint64_t offset_index_offset = vt::pre::AtlasFile::HEADER_SIZE;
+    const uint64_t cielab_index_offset = offset_index_offset + offset_index.getByteSize();
+    const uint64_t payload_offset = cielab_index_offset + cielab_index.getByteSize();
+
+    uint8_t header[vt::pre::AtlasFile::HEADER_SIZE];
+    std::memcpy(header, "ATLAS", 5);
+    put_le(&header[5], image_size);
+    put_le(&header[13], image_size);
+    put_le(&header[21], tile_size);
+    put_le(&header[29], tile_size);
+    put_le(&header[37], padding);
+    header[45] = 3; // RGBA8
+    header[46] = 2; // PACKED
+    put_le(&header[47], offset_index_offset);
+    put_le(&header[55], cielab_index_offset);
+    put_le(&header[63], payload_offset);
+
+    std::fstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("vt_tile_loader_benchmark: unable to write " + filename);
+    }
+
+    file.write((char *)header, sizeof(header));
+    offset_index.writeToFile(file);
+    cielab_index.writeToFile(file);
+
+    std::vector<uint8_t> tile(tile_byte_size);
+    std::mt19937 gen(7);
+    for(uint64_t id = 0; id < total_tiles; ++id)
+    {
+        for(auto &byte : tile)
+        {
+            byte = (uint8_t)gen();
+        }
+        file.write((char *)tile.data(), tile.size());
+    }
+}
+
+// drops the pages of the atlas from the os cache, so the next run reads from disk
+void evict_file(const std::string &filename)
+{
+#ifndef WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd >= 0)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+class timed_request final : public vt::ooc::TileRequest
+{
+  public:
+    size_t index_;
+};
+
+// is informed by the loader threads when a request has been processed
+class completion_observer : public vt::Observer
+{
+  public:
+    explicit completion_observer(std::vector<bench_clock::time_point> &completion_times) : completion_times_(completion_times), num_completed_(0) {}
+
+    void inform(vt::event_type event, vt::Observable *observable) override
+    {
+        auto req = (timed_request *)observable;
+        completion_times_[req->index_] = bench_clock::now();
+        delete req;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++num_completed_;
+        completed_.notify_all();
+    }
+
+    void wait_for(size_t num_completed)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        completed_.wait(lock, [&] { return num_completed_ >= num_completed; });
+    }
+
+  private:
+    std::vector<bench_clock::time_point> &completion_times_;
+    std::mutex mutex_;
+    std::condition_variable completed_;
+    size_t num_completed_;
+};
+
+// Loads frames of random tiles from the atlas through a TileLoader with the
+// given number of threads. Each frame issues all of its requests at once and
+// waits for them, like a cut update that misses many tiles after a jump.
+int main(int argc, char *argv[])
+{
+    if(cmd_option_exists(argv, argv + argc, "-h"))
+    {
+        std::cout << "Usage: " << argv[0] << " [-f atlas file] [-o generated atlas file] [-d quad tree depth] [-s tile size]" << std::endl
+                  << "       [-t thread counts, e.g. 1,2,4,8] [-n frames] [-r requests per frame] [-m cache size in MB] [-c]" << std::endl
+                  << "without -f, an atlas is generated, -c drops the atlas from the os cache before each run" << std::endl;
+        return 0;
+    }
+
+    std::string atlas_filename = "vt_tile_loader_benchmark.atlas";
+    if(get_cmd_option(argv, argv + argc, "-f"))
+    {
+        atlas_filename = get_cmd_option(argv, argv + argc, "-f");
+    }
+    else
+    {
+        if(get_cmd_option(argv, argv + argc, "-o"))
+            atlas_filename = get_cmd_option(argv, argv + argc, "-o");
+        const uint32_t depth = get_cmd_option(argv, argv + argc, "-d") ? atoi(get_cmd_option(argv, argv + argc, "-d")) : 7;
+        const uint64_t tile_size = get_cmd_option(argv, argv + argc, "-s") ? atoi(get_cmd_option(argv, argv + argc, "-s")) : 256;
+        std::cout << "writing " << atlas_filename << " (depth " << depth << ", tile size " << tile_size << ")" << std::endl;
+        write_atlas(atlas_filename, depth, tile_size);
+    }
+
+    std::vector<size_t> thread_counts;
+    {
+        std::stringstream list(get_cmd_option(argv, argv + argc, "-t") ? get_cmd_option(argv, argv + argc, "-t") : "1,2,4,8");
+        std::string item;
+        while(std::getline(list, item, ','))
+            thread_counts.push_back(std::max(atoi(item.c_str()), 1));
+    }
+
+    const size_t num_frames = get_cmd_option(argv, argv + argc, "-n") ? atoi(get_cmd_option(argv, argv + argc, "-n")) : 20;
+    const size_t requests_per_frame = get_cmd_option(argv, argv + argc, "-r") ? atoi(get_cmd_option(argv, argv + argc, "-r")) : 256;
+    const size_t cache_size_mb = get_cmd_option(argv, argv + argc, "-m") ? atoi(get_cmd_option(argv, argv + argc, "-m")) : 256;
+    const bool cold = cmd_option_exists(argv, argv + argc, "-c");
+
+    vt::pre::AtlasFile atlas(atlas_filename.c_str());
+    const uint64_t total_tiles = atlas.getTotalTiles();
+    const size_t tile_byte_size = atlas.getTileByteSize();
+    const size_t num_slots = std::max(cache_size_mb * 1024 * 1024 / tile_byte_size, requests_per_frame);
+
+    std::cout << "tiles: " << total_tiles << " tile size: " << tile_byte_size / 1024 << " KB, cache slots: " << num_slots << (cold ? ", cold" : ", warm") << std::endl << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(10) << "tiles" << std::setw(12) << "tiles/s" << std::setw(10) << "MB/s" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms"
+              << std::setw(12) << "max ms" << std::endl;
+
+    for(size_t thread_count : thread_counts)
+    {
+        if(cold)
+            evict_file(atlas_filename);
+
+        vt::ooc::TileCache cache(tile_byte_size, num_slots);
+        vt::ooc::TileLoader loader;
+        loader.writeTo(&cache);
+        loader.start(thread_count);
+
+        const size_t num_requests = num_frames * requests_per_frame;
+        std::vector<bench_clock::time_point> request_times(num_requests);
+        std::vector<bench_clock::time_point> completion_times(num_requests);
+        completion_observer observer(completion_times);
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<uint64_t> tile_id(0, total_tiles - 1);
+
+        const auto start = bench_clock::now();
+        for(size_t frame = 0; frame < num_frames; ++frame)
+        {
+            for(size_t i = 0; i < requests_per_frame; ++i)
+            {
+                const size_t index = frame * requests_per_frame + i;
+
+                auto req = new timed_request;
+                req->index_ = index;
+                req->setResource(&atlas);
+                req->setId(tile_id(gen));
+                req->setPriority(100);
+                req->observe(0, &observer);
+
+                request_times[index] = bench_clock::now();
+                vt::ooc::TileRequest *queued = req;
+                loader.request(queued);
+            }
+            observer.wait_for((frame + 1) * requests_per_frame);
+        }
+        const double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+        loader.stop();
+
+        std::vector<double> latencies(num_requests);
+        for(size_t i = 0; i < num_requests; ++i)
+            latencies[i] = std::chrono::duration<double, std::milli>(completion_times[i] - request_times[i]).count();
+        std::sort(latencies.begin(), latencies.end());
+
+        const double tiles_per_second = num_requests / seconds;
+        std::cout << std::setw(8) << thread_count << std::setw(10) << num_requests << std::fixed << std::setprecision(0) << std::setw(12) << tiles_per_second << std::setw(10)
+                  << tiles_per_second * tile_byte_size / (1024.0 * 1024.0) << std::setprecision(3) << std::setw(12) << latencies[num_requests / 2] << std::setw(12)
+                  << latencies[std::min(num_requests - 1, num_requests * 99 / 100)] << std::setw(12) << latencies.back() << std::endl;
+    }
+
+    return 0;
+}
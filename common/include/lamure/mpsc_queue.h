@@ -0,0 +1,96 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef COMMON_MPSC_QUEUE_H_
+#define COMMON_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lamure {
+
+// bounded lock-free ring for many producers and a single consumer.
+// capacity must be a power of two. each cell carries a sequence number
+// that tells producers and the consumer whether it is free or filled.
+template <typename T>
+class mpsc_queue {
+public:
+    explicit mpsc_queue(const size_t capacity)
+    : mask_(capacity - 1), cells_(capacity), tail_(0), head_(0) {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        for (size_t i = 0; i < capacity; ++i) {
+            cells_[i].sequence_.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    // any thread, returns false if the ring is full
+    bool try_push(const T& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            cell& c = cells_[pos & mask_];
+            const size_t sequence = c.sequence_.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value_ = value;
+                    c.sequence_.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // consumer only, returns false if the ring is empty
+    bool try_pop(T& value) {
+        const size_t pos = head_.load(std::memory_order_relaxed);
+        cell& c = cells_[pos & mask_];
+        const size_t sequence = c.sequence_.load(std::memory_order_acquire);
+        if ((intptr_t)sequence - (intptr_t)(pos + 1) < 0) {
+            return false;
+        }
+        value = c.value_;
+        c.sequence_.store(pos + mask_ + 1, std::memory_order_release);
+        head_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct cell {
+        std::atomic<size_t> sequence_;
+        T value_;
+    };
+
+    const size_t mask_;
+    std::vector<cell> cells_;
+
+    // producers and the consumer work on separate cache lines. padded instead
+    // of alignas(64), plain new does not honour alignment beyond max_align_t
+    char pad0_[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail_;
+    char pad1_[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> head_;
+    char pad2_[64 - sizeof(std::atomic<size_t>)];
+};
+
+
+} // namespace lamure
+
+#endif // COMMON_MPSC_QUEUE_H_
@@ -53,6 +53,7 @@ public:
         reduction_algorithm reduction_algo;
         radius_computation_algorithm radius_computation_algo;
         normal_computation_algorithm normal_computation_algo;
+        lod_format output_format;
     };
 
 
@@ -180,6 +181,10 @@ inline std::string enum_to_string(normal_computation_algorithm algo)
     {
         return "planefitting";
     }
+    if(algo == normal_computation_algorithm::pca)
+    {
+        return "pca";
+    }
     return "unknown";
 }
 
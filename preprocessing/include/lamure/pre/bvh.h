@@ -100,6 +100,13 @@ class PREPROCESSING_DLL bvh
 
     std::vector<std::pair<surfel_id_t, real>> get_nearest_neighbours(const surfel_id_t target_surfel, const uint32_t num_neighbours, const bool do_local_search = true) const;
 
+    /**
+     * Batched version of get_nearest_neighbours for all surfels of a node.
+     * The surfels of the node are indexed by a k-d tree once, the result
+     * holds the neighbours of every surfel in node order.
+     */
+    std::vector<std::vector<std::pair<surfel_id_t, real>>> get_nearest_neighbours_of_node(const node_id_type node_id, const uint32_t num_neighbours, const bool do_local_search = true) const;
+
     std::vector<std::pair<surfel_id_t, real>> get_nearest_neighbours_in_nodes(const surfel_id_t target_surfel, const std::vector<node_id_type> &target_nodes, const uint32_t num_neighbours) const;
 
     std::vector<std::pair<surfel_id_t, real>> get_natural_neighbours(const surfel_id_t &target_surfel, std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const;
@@ -122,11 +129,22 @@ class PREPROCESSING_DLL bvh
                  bool recompute_leaf_level = true, bool resample = false);
     void resample();
 
-    surfel_vector remove_outliers_statistically(uint32_t num_outliers, uint16_t num_neighbours);
+    /**
+     * Removes the num_outliers surfels with the largest average distance to
+     * their num_neighbours nearest neighbours from the leaf level.
+     *
+     * The leaves are scored in batches of consecutive leaves which are loaded
+     * together with the leaves in reach of their neighbour searches within
+     * the memory limit. Leaves that contain outliers are compacted in place
+     * in the leaf level file, a leaf always keeps at least one surfel.
+     * Returns the number of removed surfels.
+     */
+    size_t remove_outliers_statistically(const uint32_t num_outliers, const uint16_t num_neighbours);
 
-    void serialize_tree_to_file(const std::string &output_file, bool write_intermediate_data);
+    void serialize_tree_to_file(const std::string &output_file, bool write_intermediate_data, const lod_format format = lod_format::surfels);
 
-    void serialize_surfels_to_file(const std::string &lod_output_file, const std::string &prov_output_file, const size_t buffer_size) const;
+    void serialize_surfels_to_file(const std::string &lod_output_file, const std::string &prov_output_file, const size_t buffer_size,
+                                   const lod_format format = lod_format::surfels) const;
 
     /* resets all nodes and deletes temp files
      */
@@ -149,11 +167,9 @@ class PREPROCESSING_DLL bvh
     void set_first_leaf(const node_id_type first_leaf) { first_leaf_ = first_leaf; };
     void set_state(const state_type state) { state_ = state; };
 
-    void spawn_create_lod_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const reduction_strategy &reduction_strgy, const bool resample);
     void spawn_compute_attribute_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const normal_computation_strategy &normal_strategy,
                                       const radius_computation_strategy &radius_strategy, const bool is_leaf_level);
     void spawn_compute_bounding_boxes_downsweep_jobs(const uint32_t slice_left, const uint32_t slice_right);
-    void spawn_compute_bounding_boxes_upsweep_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const int32_t level);
     void spawn_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t &new_slice_left, size_t &new_slice_right, const uint32_t level);
 
 
@@ -161,13 +177,16 @@ class PREPROCESSING_DLL bvh
                                     std::vector<std::pair<surfel_id_t, real>> &intermediate_outliers_for_thread);
     void thread_compute_attributes(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const normal_computation_strategy &normal_strategy,
                                    const radius_computation_strategy &radius_strategy, const bool is_leaf_level);
-    void thread_create_lod(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const reduction_strategy &reduction_strgy, const bool resample);
     void thread_compute_bounding_boxes_downsweep(const uint32_t slice_left, const uint32_t slice_right, const bool update_percentage, const uint32_t num_threads);
-    void thread_compute_bounding_boxes_upsweep(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const int32_t level, const uint32_t num_threads);
     void thread_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t &new_slice_left, size_t &new_slice_right, const bool update_percentage, const int32_t level,
                                 const uint32_t num_threads);
     void thread_resample(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage);
 
+    // per-node bodies run as tasks of the upsweep, compute_attributes also by the attribute jobs above
+    void create_lod(const uint32_t node_index, const reduction_strategy &reduction_strgy, const bool resample);
+    void compute_attributes(const uint32_t node_index, const normal_computation_strategy &normal_strategy, const radius_computation_strategy &radius_strategy, const bool is_leaf_level);
+    void compute_bounding_box_upsweep(const uint32_t node_index, const int32_t level);
+
   private:
     surfel_vector resampled_leaf_level_;
     std::mutex resample_mutex_;
@@ -203,7 +222,12 @@ class PREPROCESSING_DLL bvh
         shared_surfel_file leaf_level_access, shared_prov_file prov_leaf_level_access);
 
     void get_descendant_leaves(const node_id_type node, std::vector<node_id_type> &result, const node_id_type first_leaf, const std::unordered_set<size_t> &excluded_leaves) const;
-    void get_descendant_nodes(const node_id_type node, std::vector<node_id_type> &result, const node_id_type desired_depth, const std::unordered_set<size_t> &excluded_nodes) const;
+    void insert_nearest_neighbour(std::vector<std::pair<surfel_id_t, real>> &candidates, const uint32_t num_neighbours, const surfel_id_t &candidate_id, const real distance_to_center) const;
+    void expand_nearest_neighbours(const surfel_id_t target_surfel, const uint32_t num_neighbours, std::vector<std::pair<surfel_id_t, real>> &candidates) const;
+
+    // squared distance that bounds the neighbour search of every surfel in the leaf, the leaf has to be in-core
+    const real get_neighbour_search_bound(const node_id_type leaf, const uint32_t num_neighbours) const;
+    void get_intersecting_leaves(const node_id_type node, const bounding_box &box, std::vector<node_id_type> &result) const;
 
     surfel_mem_array resample_node(uint32_t node_id) const;
 };
@@ -45,7 +45,7 @@ public:
     { return filename_; };
 
     void read_bvh(const std::string &filename, bvh &bvh);
-    void write_bvh(const std::string &filename, bvh &bvh, const bool intermediate);
+    void write_bvh(const std::string &filename, bvh &bvh, const bool intermediate, const lod_format format = lod_format::surfels);
 
 protected:
 
@@ -72,6 +72,17 @@ protected:
         uint64_t length_;
         std::string string_;
     };
+    enum bvh_primitive_type
+    {
+        BVH_POINTCLOUD = 0,
+        BVH_TRIMESH = 1,
+        BVH_POINTCLOUD_QZ = 2
+    };
+    enum bvh_node_compression
+    {
+        BVH_UNCOMPRESSED = 0,
+        BVH_DEFLATE = 1
+    };
     enum bvh_node_visibility
     {
         BVH_NODE_VISIBLE = 0,
@@ -259,7 +270,8 @@ protected:
 
         uint32_t max_surfels_per_node_;
         uint32_t serialized_surfel_size_;
-        uint64_t reserved_0_;
+        uint32_t primitive_;
+        uint32_t compression_;
 
         bvh_tree_state state_;
         uint32_t reserved_1_;
@@ -297,7 +309,8 @@ protected:
             file.write((char *) &fan_factor_, 4);
             file.write((char *) &max_surfels_per_node_, 4);
             file.write((char *) &serialized_surfel_size_, 4);
-            file.write((char *) &reserved_0_, 8);
+            file.write((char *) &primitive_, 4);
+            file.write((char *) &compression_, 4);
             file.write((char *) &state_, 4);
             file.write((char *) &reserved_1_, 4);
             file.write((char *) &reserved_2_, 8);
@@ -318,7 +331,8 @@ protected:
             file.read((char *) &fan_factor_, 4);
             file.read((char *) &max_surfels_per_node_, 4);
             file.read((char *) &serialized_surfel_size_, 4);
-            file.read((char *) &reserved_0_, 8);
+            file.read((char *) &primitive_, 4);
+            file.read((char *) &compression_, 4);
             file.read((char *) &state_, 4);
             file.read((char *) &reserved_1_, 4);
             file.read((char *) &reserved_2_, 8);
@@ -22,7 +22,8 @@ enum class rep_radius_algorithm
 
 enum class normal_computation_algorithm
 {
-    plane_fitting = 0
+    plane_fitting = 0,
+    pca = 1
 };
 
 enum class radius_computation_algorithm
@@ -47,6 +48,13 @@ enum class reduction_algorithm
     ndc_prov = 11
 };
 
+enum class lod_format
+{
+    surfels = 0,          // serialized_surfel, .bvh + .lod
+    quantized = 1,        // serialized_surfel_qz, .bvhqz + .lodqz
+    quantized_deflate = 2 // serialized_surfel_qz, every node deflated
+};
+
 }
 }
 
@@ -10,6 +10,12 @@
 
 #include <lamure/pre/surfel_disk_array.h>
 #include <vector>
+#include <future>
+#include <thread>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include <lamure/pre/logger.h>
 
 namespace lamure
@@ -21,9 +27,17 @@ class PREPROCESSING_DLL external_sort
 {
 public:
 
+    struct statistics
+    {
+        uint32_t runs_count = 0;
+        double create_runs_time = 0.0; // seconds
+        double merge_time = 0.0;       // seconds
+    };
+
     static void sort(surfel_disk_array &array,
                      const size_t memory_limit,
-                     const surfel::compare_function &compare);
+                     const surfel::compare_function &compare,
+                     statistics *stats = nullptr);
 
 private:
     explicit external_sort(const size_t memory_limit,
@@ -31,56 +45,141 @@ private:
     external_sort(const external_sort &) = delete;
     external_sort &operator=(const external_sort &) = delete;
 
-    class buffer
+    /**
+    * Small pool of persistent threads that executes the background reads
+    * and writes of the merge phase in submission order.
+    */
+    class io_queue
     {
     public:
-        surfel_disk_array run;
-        surfel_vector data;
-        size_t size;
-        size_t candidate_pos;
-        size_t file_offset;
-
-        buffer(const surfel_disk_array &array, const size_t buffer_size)
-            : run(array)
+        explicit io_queue(const uint32_t num_threads);
+        ~io_queue();
+
+        io_queue(const io_queue &) = delete;
+        io_queue &operator=(const io_queue &) = delete;
+
+        std::future<void> submit(const std::function<void()> &job);
+
+    private:
+        void run();
+
+        std::vector<std::thread> threads_;
+        std::deque<std::packaged_task<void()>> jobs_;
+        std::mutex mutex_;
+        std::condition_variable signal_;
+        bool shutdown_;
+    };
+
+    /**
+    * Double-buffered reader of a single sorted run. While the merge consumes
+    * the front buffer, the next chunk of the run is read into the back
+    * buffer by a background task.
+    */
+    class run_reader
+    {
+    public:
+        run_reader(const surfel_disk_array &array,
+                   const size_t buffer_size,
+                   io_queue &io)
+            : run_(array),
+              io_(io),
+              buffer_size_(buffer_size),
+              front_(buffer_size),
+              back_(buffer_size),
+              front_size_(0),
+              back_size_(0),
+              pos_(0),
+              file_offset_(0)
         {
-            size = buffer_size;
-            candidate_pos = size;
-            file_offset = 0;
-            data = surfel_vector(size);
+            prefetch();
+            swap_buffers();
         }
 
-        bool front(surfel &s)
+        run_reader(const run_reader &) = delete;
+        run_reader &operator=(const run_reader &) = delete;
+
+        ~run_reader()
         {
-            invalidate();
-            if (size > 0) {
-                s = data[candidate_pos];
-                return true;
-            }
-            else
-                return false;
+            if (pending_.valid())
+                pending_.wait();
         }
 
+        const bool empty() const { return pos_ >= front_size_; }
+        const surfel &front() const { return front_[pos_]; }
+
         void pop_front()
         {
-            assert(size > 0);
-            candidate_pos++;
+            assert(!empty());
+            if (++pos_ >= front_size_)
+                swap_buffers();
         }
 
     private:
-        void invalidate()
+        void prefetch();
+        void swap_buffers();
+
+        surfel_disk_array run_;
+        io_queue &io_;
+        size_t buffer_size_;
+
+        surfel_vector front_;
+        surfel_vector back_;
+        size_t front_size_;
+        size_t back_size_;
+        size_t pos_;
+        size_t file_offset_;
+
+        std::future<void> pending_;
+    };
+
+    /**
+    * Double-buffered writer of the merge output. A full buffer is handed
+    * over to a background task while the merge continues on the other one.
+    */
+    class run_writer
+    {
+    public:
+        run_writer(surfel_disk_array &array,
+                   const size_t buffer_size,
+                   io_queue &io)
+            : array_(array),
+              io_(io),
+              buffer_size_(buffer_size),
+              file_offset_(0)
+        {
+            front_.reserve(buffer_size_);
+            back_.reserve(buffer_size_);
+        }
+
+        run_writer(const run_writer &) = delete;
+        run_writer &operator=(const run_writer &) = delete;
+
+        ~run_writer()
         {
-            if (size > 0 && candidate_pos >= size) {
-                if (file_offset >= run.length()) {
-                    size = 0;
-                    return;
-                }
-
-                size = std::min(size, run.length() - file_offset);
-                run.get_file()->read(&data, 0, run.offset() + file_offset, size);
-                file_offset += size;
-                candidate_pos = 0;
-            }
+            if (pending_.valid())
+                pending_.wait();
         }
+
+        void push_back(const surfel &s)
+        {
+            front_.push_back(s);
+            if (front_.size() >= buffer_size_)
+                flush();
+        }
+
+        void flush();
+        const size_t finish();
+
+    private:
+        surfel_disk_array &array_;
+        io_queue &io_;
+        size_t buffer_size_;
+
+        surfel_vector front_;
+        surfel_vector back_;
+        size_t file_offset_;
+
+        std::future<void> pending_;
     };
 
     void create_runs(surfel_disk_array &array,
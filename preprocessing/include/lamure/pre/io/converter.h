@@ -8,8 +8,10 @@
 #ifndef PRE_CONVERTER_H_
 #define PRE_CONVERTER_H_
 
+#include <algorithm>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 
 #include <lamure/pre/platform.h>
 #include <lamure/pre/io/format_abstract.h>
@@ -37,7 +39,8 @@ public:
           override_color_(false),
           scale_factor_(1.0),
           new_radius_(0.0),
-          discarded_(0)
+          discarded_(0),
+          num_threads_(std::max(1u, std::thread::hardware_concurrency()))
     {
         surfels_in_buffer_ = buffer_size / sizeof(surfel);
     }
@@ -70,9 +73,15 @@ public:
     void set_translation(const vec3r &translation)
     { translation_ = translation; }
 
+    // if the input format supports chunked reads, the callback is called
+    // concurrently from several threads
     void set_surfel_callback(const surfel_modifier_function &callback)
     { surfel_callback_ = callback; }
 
+    // threads used to parse chunked input formats
+    void set_num_threads(const uint32_t num_threads)
+    { num_threads_ = std::max(1u, num_threads); }
+
 private:
 
     bool flush_ready_ = false;
@@ -81,7 +90,14 @@ private:
     std::mutex mtx_;
     std::condition_variable cv_;
 
+    // parses memory-mapped chunks of the input on several threads,
+    // returns false if the input format or file does not allow it
+    const bool convert_chunked(const std::string &input_filename,
+                               const std::string &output_filename);
+
     void append_surfel(const surfel &surfel);
+    // applies the callback and the transformations, returns false if the surfel is dropped
+    const bool prepare_surfel(surfel &s) const;
     void flush_buffer();
     const bool is_degenerate(const surfel &s) const;
 
@@ -100,6 +116,7 @@ private:
     real new_radius_;
     vec3b new_color_;
     size_t discarded_;
+    uint32_t num_threads_;
 
 };
 
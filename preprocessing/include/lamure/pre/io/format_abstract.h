@@ -47,11 +47,29 @@ public:
     const bool has_color() const
     { return has_color_; }
 
+    // byte range of the surfel records in a memory-mapped input file
+    struct chunk_layout
+    {
+        size_t begin_;
+        size_t end_;
+        size_t record_size_; // 0 for text records terminated by line breaks
+    };
+
 protected:
 
     virtual void read(const std::string &filename, surfel_callback_function callback) = 0;
     virtual void write(const std::string &filename, buffer_callback_function callback) = 0;
 
+    // Formats with a flat record layout can be parsed in independent chunks
+    // on several threads. prepare_chunked_read inspects the mapped file and
+    // returns false if the file has to be parsed by read() instead.
+    // read_chunk is called concurrently for disjoint chunks that start and
+    // end at record boundaries and appends the surfels of the chunk.
+    virtual const bool prepare_chunked_read(const char *data, const size_t size, chunk_layout &layout)
+    { return false; }
+    virtual void read_chunk(const char *begin, const char *end, surfel_vector &surfels) const
+    {}
+
     bool has_normals_;
     bool has_radii_;
     bool has_color_;
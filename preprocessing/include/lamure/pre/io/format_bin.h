@@ -31,6 +31,12 @@ protected:
     virtual void read(const std::string &filename, surfel_callback_function callback);
     virtual void write(const std::string &filename, buffer_callback_function callback);
 
+    virtual const bool prepare_chunked_read(const char *data, const size_t size, chunk_layout &layout);
+    virtual void read_chunk(const char *begin, const char *end, surfel_vector &surfels) const;
+
+    // x, y, z as real followed by r, g, b
+    static const size_t record_size = 3 * sizeof(real) + 3 * sizeof(uint8_t);
+
 };
 
 } // namespace pre
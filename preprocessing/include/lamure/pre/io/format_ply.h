@@ -9,6 +9,7 @@
 #define PRE_FORMAT_PLY_H_
 
 #include <functional>
+#include <vector>
 
 #include <lamure/pre/platform.h>
 #include <lamure/pre/io/format_abstract.h>
@@ -34,9 +35,30 @@ protected:
     virtual void read(const std::string &filename, surfel_callback_function callback) override;
     virtual void write(const std::string &filename, buffer_callback_function callback) override;
 
+    // ascii and binary_little_endian files whose first element are the vertices
+    virtual const bool prepare_chunked_read(const char *data, const size_t size, chunk_layout &layout) override;
+    virtual void read_chunk(const char *begin, const char *end, surfel_vector &surfels) const override;
+
 private:
+    enum class vertex_attribute: uint8_t
+    {
+        ignored, x, y, z, nx, ny, nz, red, green, blue
+    };
+
+    struct vertex_property
+    {
+        vertex_attribute attribute_;
+        uint8_t size_;   // bytes in binary files
+        bool is_float_;
+        bool is_signed_;
+        size_t offset_;  // bytes into the binary record
+    };
+
     surfel current_surfel_;
 
+    bool binary_chunks_ = false;
+    std::vector<vertex_property> vertex_properties_;
+
     template<typename ScalarType>
     std::function<void(ScalarType)> scalar_callback(const std::string &element_name,
                                                     const std::string &property_name);
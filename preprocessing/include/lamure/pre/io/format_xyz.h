@@ -31,6 +31,9 @@ protected:
     virtual void read(const std::string &filename, surfel_callback_function callback) override;
     virtual void write(const std::string &filename, buffer_callback_function callback) override;
 
+    virtual const bool prepare_chunked_read(const char *data, const size_t size, chunk_layout &layout) override;
+    virtual void read_chunk(const char *begin, const char *end, surfel_vector &surfels) const override;
+
 };
 
 } // namespace pre
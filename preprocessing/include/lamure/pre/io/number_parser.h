@@ -0,0 +1,145 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef PRE_NUMBER_PARSER_H_
+#define PRE_NUMBER_PARSER_H_
+
+#include <lamure/types.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace lamure
+{
+namespace pre
+{
+
+// Parsers for whitespace separated numbers in a memory range that is not
+// null-terminated. Tokens never extend across a line break.
+
+inline const bool is_blank(const char c)
+{ return c == ' ' || c == '\t' || c == '\r'; }
+
+inline void skip_blanks(const char *&cursor, const char *end)
+{
+    while (cursor != end && is_blank(*cursor))
+        ++cursor;
+}
+
+// moves the cursor behind the next line break
+inline void skip_line(const char *&cursor, const char *end)
+{
+    const char *line_break = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+    cursor = line_break ? line_break + 1 : end;
+}
+
+// Parses the next token of the current line as floating point number.
+// Decimal numbers with at most 19 significant digits and a small exponent
+// are exact in double precision and take the fast path, anything else
+// (long mantissas, nan, inf) goes through strtod on a copy of the token.
+// Returns false if the line has no further token.
+inline const bool parse_real(const char *&cursor, const char *end, real &value)
+{
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    skip_blanks(cursor, end);
+
+    const char *token_begin = cursor;
+    const char *token_end = cursor;
+    while (token_end != end && !is_blank(*token_end) && *token_end != '\n')
+        ++token_end;
+
+    if (token_begin == token_end)
+        return false;
+
+    cursor = token_end;
+
+    const char *c = token_begin;
+    const bool negative = *c == '-';
+    if (*c == '-' || *c == '+')
+        ++c;
+
+    uint64_t mantissa = 0;
+    int32_t num_digits = 0;
+    int32_t exponent = 0;
+    bool truncated = false;
+
+    const char *digits_begin = c;
+    for (; c != token_end && *c >= '0' && *c <= '9'; ++c) {
+        if (num_digits < 19) {
+            mantissa = mantissa * 10 + (*c - '0');
+            num_digits += mantissa != 0;
+        }
+        else {
+            ++exponent;
+            truncated = true;
+        }
+    }
+    bool has_digits = c != digits_begin;
+
+    if (c != token_end && *c == '.') {
+        const char *fraction_begin = ++c;
+        for (; c != token_end && *c >= '0' && *c <= '9'; ++c) {
+            if (num_digits < 19) {
+                mantissa = mantissa * 10 + (*c - '0');
+                num_digits += mantissa != 0;
+                --exponent;
+            }
+            else {
+                truncated = true;
+            }
+        }
+        has_digits = has_digits || c != fraction_begin;
+    }
+
+    if (has_digits && c != token_end && (*c == 'e' || *c == 'E')) {
+        ++c;
+        const bool negative_exponent = c != token_end && *c == '-';
+        if (c != token_end && (*c == '-' || *c == '+'))
+            ++c;
+
+        int32_t explicit_exponent = 0;
+        const char *exponent_begin = c;
+        for (; c != token_end && *c >= '0' && *c <= '9'; ++c) {
+            if (explicit_exponent < 100000)
+                explicit_exponent = explicit_exponent * 10 + (*c - '0');
+        }
+        has_digits = c != exponent_begin;
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+
+    if (has_digits && c == token_end && !truncated
+        && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        // both operands are exact, a single rounding gives the correct result
+        value = exponent < 0 ? double(mantissa) / powers_of_ten[-exponent]
+                             : double(mantissa) * powers_of_ten[exponent];
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    const std::string token(token_begin, token_end);
+    value = std::strtod(token.c_str(), nullptr);
+    return true;
+}
+
+// clamps a parsed colour channel to [0, 255], nan maps to 0
+inline const uint8_t to_color_channel(const real value)
+{
+    if (!(value > 0.0))
+        return 0;
+    return value < 255.0 ? uint8_t(value) : uint8_t(255);
+}
+
+} // namespace pre
+} // namespace lamure
+
+#endif // PRE_NUMBER_PARSER_H_
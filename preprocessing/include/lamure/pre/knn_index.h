@@ -0,0 +1,83 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef PRE_KNN_INDEX_H_
+#define PRE_KNN_INDEX_H_
+
+#include <lamure/pre/platform.h>
+#include <lamure/pre/surfel_mem_array.h>
+#include <lamure/types.h>
+
+#include <vector>
+
+namespace lamure
+{
+namespace pre
+{
+
+/**
+ * Compact k-d tree over the surfel positions of a surfel_mem_array.
+ *
+ * Neighbours are reported as (index into the array, squared distance),
+ * sorted by distance. Ties are broken by index, so results equal those
+ * of a linear scan over the array.
+ */
+class PREPROCESSING_DLL knn_index
+{
+  public:
+    using neighbour_t = std::pair<uint32_t, real>;
+
+    explicit knn_index(const surfel_mem_array &mem_array);
+    explicit knn_index(const std::vector<vec3r> &positions);
+
+    knn_index(const knn_index &other) = delete;
+    knn_index &operator=(const knn_index &other) = delete;
+
+    size_t size() const { return positions_.size(); }
+
+    /**
+     * Find the k nearest neighbours of the point with the given index,
+     * the point itself is excluded.
+     */
+    void nearest_neighbours(const uint32_t index, const uint32_t k, std::vector<neighbour_t> &result) const;
+
+    /**
+     * Find the k nearest neighbours of an arbitrary position.
+     */
+    void nearest_neighbours(const vec3r &position, const uint32_t k, std::vector<neighbour_t> &result) const;
+
+    /**
+     * Find the k nearest neighbours of every point at once.
+     * result[i] holds the neighbours of point i.
+     */
+    void all_nearest_neighbours(const uint32_t k, std::vector<std::vector<neighbour_t>> &result) const;
+
+  private:
+    struct node
+    {
+        real split_;
+        uint32_t begin_;
+        uint32_t end_;
+        uint32_t right_; // left child is the next node, 0 marks a leaf
+        uint8_t axis_;
+    };
+
+    void build();
+    uint32_t build(const uint32_t begin, const uint32_t end);
+
+    void search(const uint32_t node_id, const vec3r &position, const uint32_t excluded, const uint32_t k, std::vector<neighbour_t> &heap) const;
+
+    std::vector<vec3r> positions_;
+    std::vector<uint32_t> permutation_; // point indices in tree order
+    std::vector<vec3r> sorted_positions_;
+    std::vector<node> nodes_;
+};
+
+} // namespace pre
+} // namespace lamure
+
+#endif // PRE_KNN_INDEX_H_
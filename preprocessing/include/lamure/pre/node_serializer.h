@@ -9,6 +9,7 @@
 #define PRE_NODE_SERIALIZER_H_
 
 #include <lamure/pre/platform.h>
+#include <lamure/pre/common.h>
 #include <lamure/pre/surfel.h>
 #include <lamure/pre/bvh_node.h>
 #include <lamure/pre/logger.h>
@@ -25,12 +26,18 @@ namespace pre
 
 /**
 * serializes nodes to a LOD file that can be used in rendering application.
+*
+* Quantized nodes are padded with invalid surfels to surfels_per_node.
+* With lod_format::quantized_deflate every node is deflated on its own and
+* the file ends with a table of num_nodes + 1 uint64 node offsets, followed
+* by num_nodes as uint64.
 */
 class PREPROCESSING_DLL node_serializer
 {
 public:
     explicit node_serializer(const size_t surfels_per_node,
-                             const size_t buffer_size); // buffer_size - in bytes
+                             const size_t buffer_size, // buffer_size - in bytes
+                             const lod_format format = lod_format::surfels);
 
     node_serializer(const node_serializer &) = delete;
     node_serializer &operator=(const node_serializer &) = delete;
@@ -52,13 +59,19 @@ private:
 
     void write_node_streamed(const bvh_node &node);
     void flush_surfel_buffer();
+    void flush_quantized_buffer();
+    void write_node_offsets();
 
     mutable std::fstream stream_;
     std::string file_name_;
     size_t surfels_per_node_;
+    lod_format format_;
 
     std::deque<surfel_vector *> surfel_buffer_;
+    std::deque<const bvh_node *> node_buffer_;
     size_t max_nodes_in_buffer_;
+
+    std::vector<uint64_t> node_offsets_;
 };
 
 }
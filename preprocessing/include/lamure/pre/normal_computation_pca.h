@@ -0,0 +1,69 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+
+#ifndef  NORMAL_COMPUTATION_PCA_H_
+#define  NORMAL_COMPUTATION_PCA_H_
+
+#include <lamure/pre/normal_computation_strategy.h>
+
+#include <vector>
+
+namespace lamure
+{
+namespace pre
+{
+
+class bvh;
+
+// Fits the same covariance as normal_computation_plane_fitting, but gathers
+// the covariances of a whole node in SoA form and takes the eigenvector of
+// the smallest eigenvalue in closed form. The eigensolver runs on AVX-512 or
+// AVX2 lanes when the build targets them and falls back to scalar code.
+class normal_computation_pca: public normal_computation_strategy
+{
+public:
+    explicit normal_computation_pca(const uint16_t number_of_neighbours)
+    {
+        // base class attribute
+        number_of_neighbours_ = number_of_neighbours;
+    }
+
+    vec3f compute_normal(const bvh &tree,
+                         const surfel_id_t surfel,
+                         std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const override;
+
+    void compute_normals(const bvh &tree,
+                         const node_id_type node_id,
+                         std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                         std::vector<vec3f> &normals) const override;
+
+    // symmetric 3x3 matrices in SoA form, only the upper triangle is stored
+    struct covariances
+    {
+        std::vector<double> xx, xy, xz, yy, yz, zz;
+
+        void resize(const size_t size);
+    };
+
+    // unit eigenvectors of the smallest eigenvalues of all matrices
+    static void smallest_eigenvectors(const covariances &matrices,
+                                      std::vector<vec3f> &eigenvectors);
+
+private:
+    // returns false if the surfel has less than three neighbours
+    bool compute_covariance(const bvh &tree,
+                            const surfel_id_t surfel,
+                            std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours,
+                            covariances &matrices,
+                            const size_t index) const;
+};
+
+}// namespace pre
+}// namespace lamure
+
+#endif // NORMAL_COMPUTATION_PCA_H_
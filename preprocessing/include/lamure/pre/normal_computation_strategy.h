@@ -27,6 +27,19 @@ public:
     virtual vec3f compute_normal(const bvh &tree,
                                  const surfel_id_t surfel,
                                  std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const = 0;
+
+    // computes the normals of all surfels of a node at once,
+    // nearest_neighbours[i] belongs to surfel i of the node
+    virtual void compute_normals(const bvh &tree,
+                                 const node_id_type node_id,
+                                 std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                                 std::vector<vec3f> &normals) const
+    {
+        normals.resize(nearest_neighbours.size());
+        for (size_t i = 0; i < nearest_neighbours.size(); ++i) {
+            normals[i] = compute_normal(tree, surfel_id_t(node_id, i), nearest_neighbours[i]);
+        }
+    }
     uint16_t const number_of_neighbours() const
     { return number_of_neighbours_; }
 
@@ -0,0 +1,84 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef PRE_SERIALIZED_SURFEL_QZ_H_
+#define PRE_SERIALIZED_SURFEL_QZ_H_
+
+#include <lamure/bounding_box.h>
+#include <lamure/types.h>
+#include <lamure/pre/platform.h>
+#include <lamure/pre/surfel.h>
+#include <cstring>
+
+namespace lamure
+{
+namespace pre
+{
+
+/**
+* Quantized surfel as read by the renderer for bvh::POINTCLOUD_QZ:
+* 16 bit positions between the node extents, a 16 bit normal enumerated
+* on the faces of the unit cube, 7-7-7 bit colour and an 11 bit radius
+* between the node's avg radius -/+ its max radius deviation.
+* Surfels with a radius of zero are marked invalid.
+*/
+class PREPROCESSING_DLL serialized_surfel_qz /*final*/
+{
+public:
+    serialized_surfel_qz()
+    {
+        data_ = {{0u, 0u, 0u}, 0u, 0u};
+    }
+
+    serialized_surfel_qz(const surfel &surfel,
+                         const bounding_box &node_extents,
+                         const real avg_surfel_radius,
+                         const real max_surfel_radius_deviation)
+    {
+        set_surfel(surfel, node_extents, avg_surfel_radius, max_surfel_radius_deviation);
+    }
+
+    static const size_t get_size()
+    { return sizeof(data); };
+
+    void set_surfel(const surfel &surfel,
+                    const bounding_box &node_extents,
+                    const real avg_surfel_radius,
+                    const real max_surfel_radius_deviation);
+
+    void serialize(char *data)
+    {
+        std::memcpy(data, raw_data_, get_size());
+    }
+
+private:
+
+    void quantize_position(const surfel &surfel, const bounding_box &node_extents);
+    void quantize_radius(const surfel &surfel, const float avg_surfel_radius, const float max_surfel_radius_deviation);
+    void quantize_color(const surfel &surfel);
+    void quantize_normal(const surfel &surfel);
+
+    struct data
+    {
+        uint16_t pos[3];
+        uint16_t normal;
+        uint32_t color_777_radius_11;
+    };
+
+    union
+    {
+        data data_;
+        uint8_t raw_data_[sizeof(data)];
+    };
+
+};
+
+}
+} // namespace lamure
+
+
+#endif // PRE_SERIALIZED_SURFEL_QZ_H_
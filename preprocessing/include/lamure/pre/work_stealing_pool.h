@@ -0,0 +1,83 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef PRE_WORK_STEALING_POOL_H_
+#define PRE_WORK_STEALING_POOL_H_
+
+#include <lamure/pre/platform.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lamure
+{
+namespace pre
+{
+
+/**
+ * Persistent set of worker threads for task graphs.
+ *
+ * Every worker owns a queue. Tasks submitted from inside a task go to the
+ * queue of the submitting worker and are taken from its front, so a worker
+ * keeps working on the data it just produced. Idle workers steal from the
+ * back of the other queues.
+ */
+class PREPROCESSING_DLL work_stealing_pool
+{
+  public:
+    using task = std::function<void()>;
+
+    explicit work_stealing_pool(const uint32_t num_threads);
+    ~work_stealing_pool();
+
+    work_stealing_pool(const work_stealing_pool &other) = delete;
+    work_stealing_pool &operator=(const work_stealing_pool &other) = delete;
+
+    const uint32_t num_threads() const { return threads_.size(); }
+
+    void submit(task new_task);
+
+    /**
+     * Block until all submitted tasks and the tasks they submitted are done.
+     * The first exception thrown by a task is rethrown here.
+     */
+    void wait();
+
+  private:
+    struct worker_queue
+    {
+        std::mutex mutex_;
+        std::deque<task> tasks_;
+    };
+
+    void run(const uint32_t worker_index);
+    bool pop(const uint32_t worker_index, task &next_task);
+
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::condition_variable all_done_;
+
+    size_t num_queued_;
+    size_t num_pending_;
+    bool shutdown_;
+    std::exception_ptr exception_;
+};
+
+} // namespace pre
+} // namespace lamure
+
+#endif // PRE_WORK_STEALING_POOL_H_
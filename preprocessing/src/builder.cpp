@@ -22,6 +22,7 @@
 #include <lamure/pre/io/format_e57.h>
 #include <lamure/pre/io/converter.h>
 
+#include <lamure/pre/normal_computation_pca.h>
 #include <lamure/pre/normal_computation_plane_fitting.h>
 #include <lamure/pre/radius_computation_average_distance.h>
 #include <lamure/pre/radius_computation_natural_neighbours.h>
@@ -136,6 +137,7 @@ normal_computation_strategy *builder::get_normal_strategy(normal_computation_alg
 {
     switch (algo) {
         case normal_computation_algorithm::plane_fitting:return new normal_computation_plane_fitting(desc_.number_of_neighbours);
+        case normal_computation_algorithm::pca:return new normal_computation_pca(desc_.number_of_neighbours);
         default:LOGGER_ERROR("Non-implemented normal computation algorithm");
             return nullptr;
     };
@@ -195,6 +197,7 @@ boost::filesystem::path builder::convert_to_binary(std::string const &input_file
 
     // Konvertierung ausführen
     converter conv(*format_in, *format_out, desc_.buffer_size);
+    conv.set_num_threads(desc_.max_threads);
     conv.set_surfel_callback(
         [](surfel &s, bool &keep)
         {
@@ -210,103 +213,59 @@ boost::filesystem::path builder::convert_to_binary(std::string const &input_file
 
 boost::filesystem::path builder::downsweep(boost::filesystem::path input_file, uint16_t start_stage) const
 {
-    bool performed_outlier_removal = false;
-    do {
-        std::string status_suffix = "";
-        if (true == performed_outlier_removal) {
-            status_suffix = " (after outlier removal)";
-        }
-
-        std::cout << std::endl;
-        std::cout << "--------------------------------" << std::endl;
-        std::cout << "bvh properties" << status_suffix << std::endl;
-        std::cout << "--------------------------------" << std::endl;
-
-        lamure::pre::bvh bvh(memory_limit_, desc_.buffer_size, desc_.rep_radius_algo, desc_.max_threads);
-
-        bvh.init_tree(input_file.string(),
-                      desc_.max_fan_factor,
-                      desc_.surfels_per_node,
-                      base_path_);
-
-        bvh.print_tree_properties();
-        std::cout << std::endl;
-
-        std::cout << "--------------------------------" << std::endl;
-        std::cout << "downsweep" << status_suffix << std::endl;
-        std::cout << "--------------------------------" << std::endl;
-        LOGGER_TRACE("downsweep stage");
-
-        CPU_TIMER;
-        bvh.downsweep(desc_.translate_to_origin, input_file.string(), desc_.prov_file);
-
-        auto bvhd_file = add_to_path(base_path_, ".bvhd");
-
-        bvh.serialize_tree_to_file(bvhd_file.string(), true);
-
-        if ((!desc_.keep_intermediate_files) && (start_stage < 1)) {
-            // do not remove input file
-            std::remove(input_file.string().c_str());
-        }
-
-        input_file = bvhd_file;
-
-        // LOGGER_DEBUG("Used memory: " << GetProcessUsedMemory() / 1024 / 1024 << " MiB");
-
-        if (3 <= start_stage) {
-            break;
-        }
-
-        if (performed_outlier_removal) {
-            break;
-        }
-
-        if (start_stage <= 2) {
-
-            if (desc_.outlier_ratio != 0.0) {
-
-                size_t num_outliers = desc_.outlier_ratio * (bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node();
-                size_t ten_percent_of_surfels = std::max(size_t(0.1 * (bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node()), size_t(1));
-                num_outliers = std::min(std::max(num_outliers, size_t(1)), ten_percent_of_surfels); // remove at least 1 surfel, for any given ratio != 0.0
-
+    std::cout << std::endl;
+    std::cout << "--------------------------------" << std::endl;
+    std::cout << "bvh properties" << std::endl;
+    std::cout << "--------------------------------" << std::endl;
 
-                std::cout << std::endl;
-                std::cout << "--------------------------------" << std::endl;
-                std::cout << "outlier removal ( " << int(desc_.outlier_ratio * 100) << " percent = " << num_outliers << " surfels)" << std::endl;
-                std::cout << "--------------------------------" << std::endl;
-                LOGGER_TRACE("outlier removal stage");
+    lamure::pre::bvh bvh(memory_limit_, desc_.buffer_size, desc_.rep_radius_algo, desc_.max_threads);
 
-                surfel_vector kept_surfels = bvh.remove_outliers_statistically(num_outliers, desc_.number_of_outlier_neighbours);
+    bvh.init_tree(input_file.string(),
+                  desc_.max_fan_factor,
+                  desc_.surfels_per_node,
+                  base_path_);
 
-                format_bin format_out;
+    bvh.print_tree_properties();
+    std::cout << std::endl;
 
-                std::unique_ptr<format_abstract> dummy_format_in{new format_xyz()};
+    std::cout << "--------------------------------" << std::endl;
+    std::cout << "downsweep" << std::endl;
+    std::cout << "--------------------------------" << std::endl;
+    LOGGER_TRACE("downsweep stage");
 
-                converter conv(*dummy_format_in, format_out, desc_.buffer_size);
+    CPU_TIMER;
+    bvh.downsweep(desc_.translate_to_origin, input_file.string(), desc_.prov_file);
 
-                conv.set_surfel_callback([](surfel &s, bool &keep)
-                                         { if (s.pos() == vec3r(0.0, 0.0, 0.0)) keep = false; });
+    // outliers are removed from the leaf level in place, the tree is not rebuilt
+    if (start_stage <= 2 && desc_.outlier_ratio != 0.0) {
 
-                auto binary_outlier_removed_file = add_to_path(base_path_, ".bin_wo_outlier");
+        size_t num_outliers = desc_.outlier_ratio * (bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node();
+        size_t ten_percent_of_surfels = std::max(size_t(0.1 * (bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node()), size_t(1));
+        num_outliers = std::min(std::max(num_outliers, size_t(1)), ten_percent_of_surfels); // remove at least 1 surfel, for any given ratio != 0.0
 
-                conv.write_in_core_surfels_out(kept_surfels, binary_outlier_removed_file.string());
+        std::cout << std::endl;
+        std::cout << "--------------------------------" << std::endl;
+        std::cout << "outlier removal ( " << int(desc_.outlier_ratio * 100) << " percent = " << num_outliers << " surfels)" << std::endl;
+        std::cout << "--------------------------------" << std::endl;
+        LOGGER_TRACE("outlier removal stage");
 
-                bvh.reset_nodes();
+        size_t num_removed = bvh.remove_outliers_statistically(num_outliers, desc_.number_of_outlier_neighbours);
 
-                input_file = fs::canonical(binary_outlier_removed_file);
+        LOGGER_INFO("Removed outliers: " << num_removed);
+    }
 
-                performed_outlier_removal = true;
-            }
-            else {
-                break;
-            }
+    auto bvhd_file = add_to_path(base_path_, ".bvhd");
 
-        }
+    bvh.serialize_tree_to_file(bvhd_file.string(), true);
 
+    if ((!desc_.keep_intermediate_files) && (start_stage < 1)) {
+        // do not remove input file
+        std::remove(input_file.string().c_str());
     }
-    while (true);
 
-    return input_file;
+    // LOGGER_DEBUG("Used memory: " << GetProcessUsedMemory() / 1024 / 1024 << " MiB");
+
+    return bvhd_file;
 }
 
 boost::filesystem::path builder::upsweep(boost::filesystem::path input_file,
@@ -401,18 +360,25 @@ bool builder::reserialize(boost::filesystem::path const &input_file, uint16_t st
         return false;
     }
 
+    // the renderer looks for the .lodqz next to a .bvhqz
+    const bool quantized = desc_.output_format != lod_format::surfels;
+    if (quantized && bvh.nodes()[0].has_provenance()) {
+        LOGGER_ERROR("Quantized output does not support provenance data");
+        return false;
+    }
+
     CPU_TIMER;
-    auto lod_file = add_to_path(base_path_, ".lod");
+    auto lod_file = add_to_path(base_path_, quantized ? ".lodqz" : ".lod");
     auto prov_file = add_to_path(base_path_, ".lod_prov");
-    auto kdn_file = add_to_path(base_path_, ".bvh");
+    auto kdn_file = add_to_path(base_path_, quantized ? ".bvhqz" : ".bvh");
     auto json_file = add_to_path(base_path_, ".json");
 
     if (bvh.nodes()[0].has_provenance()) {
       std::cout << "write paradata json description: " << json_file << std::endl;
       prov::write_json(json_file.string());
     }
-    bvh.serialize_surfels_to_file(lod_file.string(), prov_file.string(), desc_.buffer_size);
-    bvh.serialize_tree_to_file(kdn_file.string(), false);
+    bvh.serialize_surfels_to_file(lod_file.string(), prov_file.string(), desc_.buffer_size, desc_.output_format);
+    bvh.serialize_tree_to_file(kdn_file.string(), false, desc_.output_format);
 
     if ((!desc_.keep_intermediate_files) && (start_stage < 3)) {
         std::remove(input_file.string().c_str());
@@ -17,20 +17,27 @@
 #include <lamure/pre/basic_algorithms.h>
 #include <lamure/pre/bvh.h>
 #include <lamure/pre/bvh_stream.h>
+#include <lamure/pre/knn_index.h>
 #include <lamure/pre/plane.h>
 #include <lamure/pre/serialized_surfel.h>
+#include <lamure/pre/work_stealing_pool.h>
 #include <lamure/sphere.h>
 #include <lamure/utils.h>
 
 #include <lamure/pre/normal_computation_plane_fitting.h>
 #include <lamure/pre/radius_computation_average_distance.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <math.h>
 #include <memory>
+#include <numeric>
 #include <set>
 #include <stdio.h>
 #include <stdlib.h>
@@ -419,6 +426,14 @@ void bvh::downsweep_subtree_in_core(const bvh_node &node, size_t &disk_leaf_dest
 
 void bvh::compute_normal_and_radius(const bvh_node *source_node, const normal_computation_strategy &normal_computation_strategy, const radius_computation_strategy &radius_computation_strategy)
 {
+    uint16_t num_nearest_neighbours_to_search = std::max(radius_computation_strategy.number_of_neighbours(), normal_computation_strategy.number_of_neighbours());
+
+    auto const all_nearest_neighbours = get_nearest_neighbours_of_node(source_node->node_id(), num_nearest_neighbours_to_search, true);
+
+    // normals only depend on the surfel positions, they are computed for the whole node at once
+    std::vector<vec3f> normals;
+    normal_computation_strategy.compute_normals(*this, source_node->node_id(), all_nearest_neighbours, normals);
+
     //real max_radius = 0.0;
     for(size_t k = 0; k < max_surfels_per_node_; ++k)
     {
@@ -434,18 +449,13 @@ void bvh::compute_normal_and_radius(const bvh_node *source_node, const normal_co
             //std::cin.ignore();
             //max_radius = std::max(max_radius, surf.radius());
 
-            uint16_t num_nearest_neighbours_to_search = std::max(radius_computation_strategy.number_of_neighbours(), normal_computation_strategy.number_of_neighbours());
-
-            auto const &max_nearest_neighbours = get_nearest_neighbours(surfel_id_t(source_node->node_id(), k), num_nearest_neighbours_to_search, true);
+            auto const &max_nearest_neighbours = all_nearest_neighbours[k];
             // compute radius
             real radius = radius_computation_strategy.compute_radius(*this, surfel_id_t(source_node->node_id(), k), max_nearest_neighbours);
 
-            // compute normal
-            vec3f normal = normal_computation_strategy.compute_normal(*this, surfel_id_t(source_node->node_id(), k), max_nearest_neighbours);
-
             // write surfel
             surf.radius() = radius;
-            surf.normal() = normal;
+            surf.normal() = normals[k];
             source_node->mem_array().write_surfel(surf, k);
         }
     }
@@ -470,35 +480,13 @@ void bvh::get_descendant_leaves(const node_id_type node, std::vector<node_id_typ
     }
 }
 
-void bvh::get_descendant_nodes(const node_id_type node, std::vector<node_id_type> &result, const node_id_type desired_depth, const std::unordered_set<size_t> &excluded_nodes) const
-{
-    size_t node_depth = std::log((node + 1) * (fan_factor_ - 1)) / std::log(fan_factor_);
-    if(node_depth == desired_depth)
-    {
-        if(excluded_nodes.find(node) == excluded_nodes.end())
-        {
-            result.push_back(node);
-        }
-    }
-    // node is above desired depth
-    else
-    {
-        for(uint16_t i = 0; i < fan_factor_; ++i)
-        {
-            get_descendant_nodes(get_child_id(node, i), result, desired_depth, excluded_nodes);
-        }
-    }
-}
-
 std::vector<std::pair<surfel_id_t, real>> bvh::get_nearest_neighbours(const surfel_id_t target_surfel, const uint32_t number_of_neighbours, const bool do_local_search) const
 {
     //std::cout << "bvh::get_nearest_neighbours" << std::endl;
     node_id_type current_node = target_surfel.node_idx;
-    std::unordered_set<size_t> processed_nodes;
     vec3r center = nodes_[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos();
 
     std::vector<std::pair<surfel_id_t, real>> candidates;
-    real max_candidate_distance = std::numeric_limits<real>::infinity();
 
     // check own node
     for(size_t i = 0; i < nodes_[current_node].mem_array().length(); ++i)
@@ -506,90 +494,123 @@ std::vector<std::pair<surfel_id_t, real>> bvh::get_nearest_neighbours(const surf
         if(i != target_surfel.surfel_idx)
         {
             const surfel &current_surfel = nodes_[current_node].mem_array().read_surfel_ref(i);
-            real distance_to_center = scm::math::length_sqr(center - current_surfel.pos());
+            insert_nearest_neighbour(candidates, number_of_neighbours, surfel_id_t{current_node, i}, scm::math::length_sqr(center - current_surfel.pos()));
+        }
+    }
 
-            if(candidates.size() < number_of_neighbours || (distance_to_center < max_candidate_distance))
-            {
-                if(candidates.size() == number_of_neighbours)
-                    candidates.pop_back();
+    if(!do_local_search)
+    {
+        expand_nearest_neighbours(target_surfel, number_of_neighbours, candidates);
+    }
 
-                candidates.emplace_back(surfel_id_t{current_node, i}, distance_to_center);
+    return candidates;
+}
 
-                for(uint16_t k = candidates.size() - 1; k > 0; --k)
-                {
-                    if(candidates[k].second < candidates[k - 1].second)
-                    {
-                        std::swap(candidates[k], candidates[k - 1]);
-                    }
-                    else
-                        break;
-                }
+std::vector<std::vector<std::pair<surfel_id_t, real>>> bvh::get_nearest_neighbours_of_node(const node_id_type node_id, const uint32_t number_of_neighbours, const bool do_local_search) const
+{
+    const knn_index index(nodes_[node_id].mem_array());
 
-                max_candidate_distance = candidates.back().second;
-            }
+    std::vector<std::vector<knn_index::neighbour_t>> local_neighbours;
+    index.all_nearest_neighbours(number_of_neighbours, local_neighbours);
+
+    std::vector<std::vector<std::pair<surfel_id_t, real>>> nearest_neighbours(local_neighbours.size());
+
+    for(size_t surfel_idx = 0; surfel_idx < local_neighbours.size(); ++surfel_idx)
+    {
+        std::vector<std::pair<surfel_id_t, real>> &candidates = nearest_neighbours[surfel_idx];
+        candidates.reserve(local_neighbours[surfel_idx].size());
+
+        for(const auto &neighbour : local_neighbours[surfel_idx])
+        {
+            candidates.emplace_back(surfel_id_t{node_id, neighbour.first}, neighbour.second);
+        }
+
+        if(!do_local_search)
+        {
+            expand_nearest_neighbours(surfel_id_t{node_id, surfel_idx}, number_of_neighbours, candidates);
         }
     }
 
-    if(do_local_search)
+    return nearest_neighbours;
+}
+
+void bvh::insert_nearest_neighbour(std::vector<std::pair<surfel_id_t, real>> &candidates, const uint32_t number_of_neighbours, const surfel_id_t &candidate_id, const real distance_to_center) const
+{
+    if(candidates.size() < number_of_neighbours || (distance_to_center < candidates.back().second))
     {
-        return candidates;
+        if(candidates.size() == number_of_neighbours)
+            candidates.pop_back();
+
+        candidates.emplace_back(candidate_id, distance_to_center);
+
+        for(uint16_t k = candidates.size() - 1; k > 0; --k)
+        {
+            if(candidates[k].second < candidates[k - 1].second)
+            {
+                std::swap(candidates[k], candidates[k - 1]);
+            }
+            else
+                break;
+        }
     }
+}
+
+void bvh::expand_nearest_neighbours(const surfel_id_t target_surfel, const uint32_t number_of_neighbours, std::vector<std::pair<surfel_id_t, real>> &candidates) const
+{
+    vec3r center = nodes_[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos();
+    const uint32_t target_depth = nodes_[target_surfel.node_idx].depth();
 
-    processed_nodes.insert(current_node);
+    real max_candidate_distance = candidates.size() < number_of_neighbours ? std::numeric_limits<real>::infinity() : candidates.back().second;
 
     // check rest of kd-bvh
     sphere candidates_sphere = sphere(center, sqrt(max_candidate_distance));
 
+    // the nodes of a subtree at the depth of the target form a contiguous range,
+    // the range of the previous subtree has been visited already
+    node_id_type current_node = target_surfel.node_idx;
+    node_id_type visited_begin = current_node;
+    node_id_type visited_end = current_node + 1;
+
     while((!nodes_[current_node].get_bounding_box().contains(candidates_sphere)) && (current_node != 0))
     {
         current_node = get_parent_id(current_node);
 
-        std::vector<node_id_type> unvisited_descendant_nodes;
-
-        get_descendant_nodes(current_node, unvisited_descendant_nodes, nodes_[target_surfel.node_idx].depth(), processed_nodes);
+        node_id_type range_begin = current_node;
+        node_id_type range_end = current_node + 1;
+        for(uint32_t depth = nodes_[current_node].depth(); depth < target_depth; ++depth)
+        {
+            range_begin = get_child_id(range_begin, 0);
+            range_end = get_child_id(range_end - 1, fan_factor_ - 1) + 1;
+        }
 
-        for(auto adjacent_node : unvisited_descendant_nodes)
+        for(node_id_type adjacent_node = range_begin; adjacent_node < range_end; ++adjacent_node)
         {
+            if(adjacent_node == visited_begin)
+            {
+                adjacent_node = visited_end - 1;
+                continue;
+            }
+
             if(candidates_sphere.intersects_or_contains(nodes_[adjacent_node].get_bounding_box()))
             {
                 // assert(nodes_[adjacent_node].is_out_of_core());
 
                 for(size_t i = 0; i < nodes_[adjacent_node].mem_array().length(); ++i)
                 {
-                    if(!(adjacent_node == target_surfel.node_idx && i == target_surfel.surfel_idx))
-                    {
-                        const surfel &current_surfel = nodes_[adjacent_node].mem_array().read_surfel_ref(i);
-                        real distance_to_center = scm::math::length_sqr(center - current_surfel.pos());
-
-                        if(candidates.size() < number_of_neighbours || (distance_to_center < max_candidate_distance))
-                        {
-                            if(candidates.size() == number_of_neighbours)
-                                candidates.pop_back();
-
-                            candidates.emplace_back(surfel_id_t{adjacent_node, i}, distance_to_center);
-
-                            for(uint16_t k = candidates.size() - 1; k > 0; --k)
-                            {
-                                if(candidates[k].second < candidates[k - 1].second)
-                                {
-                                    std::swap(candidates[k], candidates[k - 1]);
-                                }
-                                else
-                                    break;
-                            }
-
-                            max_candidate_distance = candidates.back().second;
-                        }
-                    }
+                    const surfel &current_surfel = nodes_[adjacent_node].mem_array().read_surfel_ref(i);
+                    insert_nearest_neighbour(candidates, number_of_neighbours, surfel_id_t{adjacent_node, i}, scm::math::length_sqr(center - current_surfel.pos()));
                 }
 
-                processed_nodes.insert(adjacent_node);
+                if(candidates.size() == number_of_neighbours)
+                    max_candidate_distance = candidates.back().second;
+
                 candidates_sphere = sphere(center, sqrt(max_candidate_distance));
             }
         }
-    }
 
-    return candidates;
+        visited_begin = range_begin;
+        visited_end = range_end;
+    }
 }
 
 std::vector<std::pair<surfel_id_t, real>> bvh::get_nearest_neighbours_in_nodes(const surfel_id_t target_surfel, const std::vector<node_id_type> &target_nodes,
@@ -841,27 +862,6 @@ std::vector<std::pair<surfel, real>> bvh::get_locally_natural_neighbours(std::ve
     return nni_weight_pairs;
 }
 
-void bvh::spawn_create_lod_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const reduction_strategy &reduction_strgy, const bool resample)
-{
-    std::cout << "bvh::spawn_create_lod_jobs" << std::endl;
-    uint32_t const hw = std::thread::hardware_concurrency();
-    uint32_t const num_threads = (max_threads_ > 0) ? std::min(max_threads_, hw) : hw;
-
-    working_queue_head_counter_.initialize(first_node_of_level);
-    std::vector<std::thread> threads;
-
-    for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
-    {
-        bool update_percentage = (0 == thread_idx);
-        threads.push_back(std::thread(&bvh::thread_create_lod, this, first_node_of_level, last_node_of_level, update_percentage, std::cref(reduction_strgy), resample));
-    }
-
-    for(auto &thread : threads)
-    {
-        thread.join();
-    }
-}
-
 void bvh::spawn_compute_attribute_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const normal_computation_strategy &normal_strategy,
                                        const radius_computation_strategy &radius_strategy, const bool is_leaf_level)
 {
@@ -1002,9 +1002,11 @@ std::vector<surfel_id_t> bvh::find_resample_candidates(const uint32_t node_idx)
     const uint16_t num_neighbours = 10;
     std::vector<surfel_id_t> surfel_id_vector;
 
-    for(size_t surfel_idx = 0; surfel_idx < node_mem_data->size(); ++surfel_idx)
+    auto const all_nearest_neighbours = get_nearest_neighbours_of_node(node_idx, num_neighbours, true);
+
+    for(size_t surfel_idx = 0; surfel_idx < all_nearest_neighbours.size(); ++surfel_idx)
     {
-        std::vector<std::pair<surfel_id_t, real>> const nearest_neighbour_vector = get_nearest_neighbours(surfel_id_t(node_idx, surfel_idx), num_neighbours, true);
+        std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbour_vector = all_nearest_neighbours[surfel_idx];
         int overlap_counter = 0;
 
         real current_radius = node_mem_data->at(surfel_idx).radius();
@@ -1033,25 +1035,6 @@ std::vector<surfel_id_t> bvh::find_resample_candidates(const uint32_t node_idx)
     return surfel_id_vector;
 }
 
-void bvh::spawn_compute_bounding_boxes_upsweep_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const int32_t level)
-{
-    std::cout << "bvh::spawn_compute_bounding_boxes_upsweep_jobs" << std::endl;
-    uint32_t const num_threads = std::thread::hardware_concurrency();
-    working_queue_head_counter_.initialize(0); // let the threads fetch a local thread idx
-    std::vector<std::thread> threads;
-
-    for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
-    {
-        bool update_percentage = (0 == thread_idx);
-        threads.push_back(std::thread(&bvh::thread_compute_bounding_boxes_upsweep, this, first_node_of_level, last_node_of_level, update_percentage, level, num_threads));
-    }
-
-    for(auto &thread : threads)
-    {
-        thread.join();
-    }
-}
-
 void bvh::spawn_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t &new_slice_left, size_t &new_slice_right, const uint32_t level)
 {
     std::cout << "bvh::spawn_split_node_jobs" << std::endl;
@@ -1072,90 +1055,95 @@ void bvh::spawn_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t
     }
 }
 
-void bvh::thread_create_lod(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const reduction_strategy &reduction_strgy, const bool do_resample)
+void bvh::create_lod(const uint32_t node_index, const reduction_strategy &reduction_strgy, const bool do_resample)
 {
-    uint32_t node_index = working_queue_head_counter_.increment_head();
-
-    while(node_index < end_marker)
+    bvh_node *current_node = &nodes_.at(node_index);
+    // If a node has no data yet, calculate it based on child nodes.
+    if(!current_node->is_in_core() && !current_node->is_out_of_core())
     {
-        bvh_node *current_node = &nodes_.at(node_index);
-        // If a node has no data yet, calculate it based on child nodes.
-        if(!current_node->is_in_core() && !current_node->is_out_of_core())
+        // children flushed by a previous batch are reloaded, the level files guard their streams
+        for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
         {
-            std::vector<surfel_mem_array> resampled_arrays;
-            std::vector<surfel_mem_array *> input_mem_arrays;
-            surfel_mem_array reduction_result = surfel_mem_array(std::make_shared<surfel_vector>(surfel_vector()), 0, 0);
+            bvh_node &child_node = nodes_.at(this->get_child_id(current_node->node_id(), child_index));
 
-            if(do_resample)
+            if(!child_node.is_in_core() && child_node.is_out_of_core())
             {
-                if (current_node->has_provenance()) {
-                    throw std::runtime_error("resampling not supported for PROVENANCE");
-                }
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    size_t child_id = this->get_child_id(current_node->node_id(), child_index);
-                    resampled_arrays.push_back(resample_node(child_id));
-                }
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    input_mem_arrays.push_back(&resampled_arrays[child_index]);
-                }
-            }
-            else
-            {
-                bool child_has_provenance = false;
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    size_t child_id = this->get_child_id(current_node->node_id(), child_index);
-                    bvh_node *child_node = &nodes_.at(child_id);
-
-                    input_mem_arrays.push_back(&child_node->mem_array());
-                    child_has_provenance = child_node->has_provenance();
-                }
-                if (child_has_provenance) {
-                    reduction_result = surfel_mem_array(
-                        std::make_shared<surfel_vector>(surfel_vector()),
-                        std::make_shared<prov_vector>(prov_vector()), 0, 0);
-                }
+                child_node.load_from_disk();
             }
+        }
 
-            real reduction_error;
+        std::vector<surfel_mem_array> resampled_arrays;
+        std::vector<surfel_mem_array *> input_mem_arrays;
+        surfel_mem_array reduction_result = surfel_mem_array(std::make_shared<surfel_vector>(surfel_vector()), 0, 0);
 
-            reduction_strategy *p_reduction_strgy = (reduction_strategy *)&reduction_strgy;
-            if(reduction_strategy_provenance *cast = dynamic_cast<reduction_strategy_provenance *>(p_reduction_strgy))
+        if(do_resample)
+        {
+            if (current_node->has_provenance()) {
+                throw std::runtime_error("resampling not supported for PROVENANCE");
+            }
+            for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
             {
-                std::vector<reduction_strategy_provenance::LoDMetaData> deviations;
-                reduction_result = cast->create_lod(reduction_error, input_mem_arrays, deviations, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
-                cast->output_lod(deviations, node_index);
+                size_t child_id = this->get_child_id(current_node->node_id(), child_index);
+                resampled_arrays.push_back(resample_node(child_id));
             }
-            else
+            for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
             {
-                if (reduction_result.has_provenance()) {
-                    std::cout << "ERROR: Only reduction_strategy_provenance supported for PROVENANCE" << std::endl;
-                    throw std::runtime_error("Only reduction_strategy_provenance supported for PROVENANCE");
-                }
-                reduction_result = reduction_strgy.create_lod(reduction_error, input_mem_arrays, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
+                input_mem_arrays.push_back(&resampled_arrays[child_index]);
+            }
+        }
+        else
+        {
+            bool child_has_provenance = false;
+            for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
+            {
+                size_t child_id = this->get_child_id(current_node->node_id(), child_index);
+                bvh_node *child_node = &nodes_.at(child_id);
+
+                input_mem_arrays.push_back(&child_node->mem_array());
+                child_has_provenance = child_node->has_provenance();
             }
+            if (child_has_provenance) {
+                reduction_result = surfel_mem_array(
+                    std::make_shared<surfel_vector>(surfel_vector()),
+                    std::make_shared<prov_vector>(prov_vector()), 0, 0);
+            }
+        }
 
-            current_node->reset(reduction_result);
-            current_node->set_reduction_error(reduction_error);
+        real reduction_error;
 
-            // Unload all child nodes, if not in leaf level
-            if(get_depth_of_node(current_node->node_id()) != depth())
+        reduction_strategy *p_reduction_strgy = (reduction_strategy *)&reduction_strgy;
+        if(reduction_strategy_provenance *cast = dynamic_cast<reduction_strategy_provenance *>(p_reduction_strgy))
+        {
+            std::vector<reduction_strategy_provenance::LoDMetaData> deviations;
+            reduction_result = cast->create_lod(reduction_error, input_mem_arrays, deviations, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
+            cast->output_lod(deviations, node_index);
+        }
+        else
+        {
+            if (reduction_result.has_provenance()) {
+                std::cout << "ERROR: Only reduction_strategy_provenance supported for PROVENANCE" << std::endl;
+                throw std::runtime_error("Only reduction_strategy_provenance supported for PROVENANCE");
+            }
+            reduction_result = reduction_strgy.create_lod(reduction_error, input_mem_arrays, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
+        }
+
+        current_node->reset(reduction_result);
+        current_node->set_reduction_error(reduction_error);
+
+        // Unload all child nodes, if not in leaf level
+        if(get_depth_of_node(current_node->node_id()) != depth())
+        {
+            for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
             {
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    size_t child_id = get_child_id(current_node->node_id(), child_index);
-                    bvh_node &child_node = nodes_.at(child_id);
+                size_t child_id = get_child_id(current_node->node_id(), child_index);
+                bvh_node &child_node = nodes_.at(child_id);
 
-                    if(child_node.is_in_core())
-                    {
-                        child_node.mem_array().reset();
-                    }
+                if(child_node.is_in_core())
+                {
+                    child_node.mem_array().reset();
                 }
             }
         }
-        node_index = working_queue_head_counter_.increment_head();
     }
 }
 
@@ -1215,21 +1203,7 @@ void bvh::thread_compute_attributes(const uint32_t start_marker, const uint32_t
 
     while(node_index < end_marker)
     {
-        // std::cout << node_index << std::endl;
-        bvh_node *current_node = &nodes_.at(node_index);
-
-        // Calculate and set node properties.
-        if(is_leaf_level)
-        {
-            uint16_t number_of_neighbours = 10;
-            auto normal_comp_algo = normal_computation_plane_fitting(number_of_neighbours);
-            auto radius_comp_algo = radius_computation_average_distance(number_of_neighbours, 1.0f);
-            compute_normal_and_radius(current_node, normal_comp_algo, radius_comp_algo);
-        }
-        else
-        {
-            compute_normal_and_radius(current_node, normal_strategy, radius_strategy);
-        }
+        compute_attributes(node_index, normal_strategy, radius_strategy, is_leaf_level);
 
         if(update_percentage)
         {
@@ -1249,6 +1223,24 @@ void bvh::thread_compute_attributes(const uint32_t start_marker, const uint32_t
     }
 };
 
+void bvh::compute_attributes(const uint32_t node_index, const normal_computation_strategy &normal_strategy, const radius_computation_strategy &radius_strategy, const bool is_leaf_level)
+{
+    bvh_node *current_node = &nodes_.at(node_index);
+
+    // Calculate and set node properties.
+    if(is_leaf_level)
+    {
+        uint16_t number_of_neighbours = 10;
+        auto normal_comp_algo = normal_computation_plane_fitting(number_of_neighbours);
+        auto radius_comp_algo = radius_computation_average_distance(number_of_neighbours, 1.0f);
+        compute_normal_and_radius(current_node, normal_comp_algo, radius_comp_algo);
+    }
+    else
+    {
+        compute_normal_and_radius(current_node, normal_strategy, radius_strategy);
+    }
+}
+
 void bvh::thread_compute_bounding_boxes_downsweep(const uint32_t slice_left, const uint32_t slice_right, const bool update_percentage, const uint32_t num_threads)
 {
     //std::cout << "bvh::thread_compute_bounding_boxes_downsweep" << std::endl;
@@ -1279,70 +1271,52 @@ void bvh::thread_compute_bounding_boxes_downsweep(const uint32_t slice_left, con
     }
 }
 
-void bvh::thread_compute_bounding_boxes_upsweep(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const int32_t level, const uint32_t num_threads)
+void bvh::compute_bounding_box_upsweep(const uint32_t node_index, const int32_t level)
 {
-    uint32_t thread_idx = working_queue_head_counter_.increment_head();
+    bvh_node *current_node = &nodes_.at(node_index);
 
-    uint32_t total_num_nodes = (end_marker - start_marker) + 1;
-    uint32_t num_nodes_per_thread = std::ceil(float(total_num_nodes) / num_threads);
+    basic_algorithms::surfel_group_properties props = basic_algorithms::compute_properties(current_node->mem_array(), rep_radius_algo_);
 
-    uint32_t local_start_index = start_marker + thread_idx * num_nodes_per_thread;
-    uint32_t local_end_index = start_marker + (thread_idx + 1) * num_nodes_per_thread;
+    current_node->set_max_surfel_radius_deviation(props.max_radius_deviation);
 
-    for(uint32_t node_index = local_start_index; node_index < local_end_index; ++node_index)
-    {
-        // early termination if number of nodes could not be evenly divided
-        if(node_index >= end_marker)
-        {
-            break;
-        }
+    bounding_box node_bounding_box;
+    node_bounding_box.expand(props.bbox);
 
-        bvh_node *current_node = &nodes_.at(node_index);
-
-        basic_algorithms::surfel_group_properties props = basic_algorithms::compute_properties(current_node->mem_array(), rep_radius_algo_);
-
-        current_node->set_max_surfel_radius_deviation(props.max_radius_deviation);
-
-        bounding_box node_bounding_box;
-        node_bounding_box.expand(props.bbox);
-
-        if(level < int32_t(depth_))
+    if(level < int32_t(depth_))
+    {
+        for(int32_t child_index = 0; child_index < fan_factor_; ++child_index)
         {
-            for(int32_t child_index = 0; child_index < fan_factor_; ++child_index)
-            {
-                uint32_t child_id = this->get_child_id(current_node->node_id(), child_index);
-                bvh_node *child_node = &nodes_.at(child_id);
+            uint32_t child_id = this->get_child_id(current_node->node_id(), child_index);
+            bvh_node *child_node = &nodes_.at(child_id);
 
-                node_bounding_box.expand(child_node->get_bounding_box());
-            }
+            node_bounding_box.expand(child_node->get_bounding_box());
         }
+    }
 
-        current_node->set_avg_surfel_radius(props.rep_radius);
-        current_node->set_centroid(props.centroid);
+    current_node->set_avg_surfel_radius(props.rep_radius);
+    current_node->set_centroid(props.centroid);
 
-        current_node->set_bounding_box(node_bounding_box);
-        current_node->calculate_statistics();
+    current_node->set_bounding_box(node_bounding_box);
+    current_node->calculate_statistics();
 
-        if (node_index == 0) {
-            std::cout << "min: " << node_bounding_box.min() << std::endl;
-            std::cout << "max: " << node_bounding_box.max() << std::endl;
-        }
+    if (node_index == 0) {
+        std::cout << "min: " << node_bounding_box.min() << std::endl;
+        std::cout << "max: " << node_bounding_box.max() << std::endl;
     }
 }
 
 void bvh::thread_remove_outlier_jobs(const uint32_t start_marker, const uint32_t end_marker, const uint32_t num_outliers, const uint16_t num_neighbours,
                                      std::vector<std::pair<surfel_id_t, real>> &intermediate_outliers_for_thread)
 {
-    std::cout << "bvh::thread_remove_outlier_jobs" << std::endl;
     uint32_t node_idx = working_queue_head_counter_.increment_head();
 
     while(node_idx < end_marker)
     {
-        bvh_node *current_node = &nodes_.at(node_idx);
+        auto const all_nearest_neighbours = get_nearest_neighbours_of_node(node_idx, num_neighbours, false);
 
-        for(size_t surfel_idx = 0; surfel_idx < current_node->mem_array().length(); ++surfel_idx)
+        for(size_t surfel_idx = 0; surfel_idx < all_nearest_neighbours.size(); ++surfel_idx)
         {
-            std::vector<std::pair<surfel_id_t, real>> const nearest_neighbour_vector = get_nearest_neighbours(surfel_id_t(node_idx, surfel_idx), num_neighbours);
+            std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbour_vector = all_nearest_neighbours[surfel_idx];
 
             double avg_dist = 0.0;
 
@@ -1469,50 +1443,118 @@ void bvh::upsweep(const reduction_strategy &reduction_strgy, const normal_comput
     }
 
 
-    // Start at bottom level and move up towards root.
-    for(int32_t level = depth_; level >= 0; --level)
+    // Subtrees whose leaves do not fit into memory together are reduced in
+    // batches of subtrees rooted at batch_level, the levels above follow once
+    // all batches are done. Flushed nodes are reloaded by their parents then.
+    std::vector<size_t> subtree_surfels(nodes_.size(), 0);
+    for(size_t node_index = nodes_.size(); node_index-- > 0;)
     {
-        LOGGER_TRACE("Entering level: " << level);
+        if(node_index >= first_leaf_)
+        {
+            subtree_surfels[node_index] = nodes_[node_index].is_in_core() ? nodes_[node_index].mem_array().length() : nodes_[node_index].disk_array().length();
+        }
+        else
+        {
+            for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
+            {
+                subtree_surfels[node_index] += subtree_surfels[get_child_id(node_index, child_index)];
+            }
+        }
+    }
 
-        uint32_t first_node_of_level = get_first_node_id_of_depth(level);
-        uint32_t last_node_of_level = get_first_node_id_of_depth(level) + get_length_of_depth(level);
+    // the reductions of a subtree add at most 1 / (fan_factor - 1) of its leaf surfels
+    const size_t in_core_surfel_capacity = std::floor((memory_limit_ * 1024 * 1024 * 1024) / sizeof(surfel));
+    const size_t leaf_surfel_capacity = in_core_surfel_capacity / fan_factor_ * (fan_factor_ - 1);
 
-        // Loading is not thread-safe, so load everything before starting parallel operations.
-        for(uint32_t node_index = first_node_of_level; node_index < last_node_of_level; ++node_index)
+    uint32_t batch_level = 0;
+    while(batch_level < depth_)
+    {
+        const uint32_t first_node_of_level = get_first_node_id_of_depth(batch_level);
+        const auto first = subtree_surfels.begin() + first_node_of_level;
+        if(*std::max_element(first, first + get_length_of_depth(batch_level)) <= leaf_surfel_capacity)
+            break;
+        ++batch_level;
+    }
+
+    const bool unload_flushed_nodes = batch_level > 0;
+    if(unload_flushed_nodes)
+    {
+        LOGGER_INFO("Leaf level exceeds the memory limit, upsweep in batches of subtrees rooted at level " << batch_level);
+    }
+
+    std::vector<real> mean_radius_sd(depth_ + 1, 0.0);
+    std::vector<unsigned> counter(depth_ + 1, 1);
+
+    // Every node is one task: leaves are loaded, inner nodes reduce their children.
+    // A parent is submitted as soon as its last child is flushed, so the levels
+    // overlap instead of waiting for each other.
+    enum upsweep_stage { load_stage, lod_stage, attribute_stage, bounding_box_stage, flush_stage, num_upsweep_stages };
+    const char *stage_names[num_upsweep_stages] = {"load", "create lod", "attributes", "bounding boxes", "flush"};
+    using stage_times = std::array<double, num_upsweep_stages>;
+
+    auto sum_of = [](const stage_times &times) { return std::accumulate(times.begin(), times.end(), 0.0); };
+
+    // summed over all tasks, and along the longest chain of tasks ending in each node
+    stage_times total_stage_seconds{};
+    stage_times critical_path_seconds{};
+    std::vector<stage_times> node_path_seconds(nodes_.size());
+    double wall_seconds = 0.0;
+
+    std::vector<std::atomic<uint8_t>> num_pending_children(first_leaf_);
+    std::mutex statistics_mutex;
+    size_t num_processed_nodes = 0;
+    uint16_t percent_processed = 0;
+
+    uint32_t const hw = std::thread::hardware_concurrency();
+    work_stealing_pool pool((max_threads_ > 0) ? std::min(max_threads_, hw) : hw);
+
+    std::function<void(const uint32_t, const int32_t, const uint32_t, const uint32_t)> upsweep_node;
+    upsweep_node = [&](const uint32_t node_index, const int32_t level, const uint32_t root_level, const uint32_t bottom_level)
+    {
+        bvh_node *current_node = &nodes_.at(node_index);
+
+        stage_times stage_seconds{};
+        auto stage_begin = std::chrono::steady_clock::now();
+        auto finish_stage = [&](const upsweep_stage stage) {
+            const auto stage_end = std::chrono::steady_clock::now();
+            stage_seconds[stage] += std::chrono::duration<double>(stage_end - stage_begin).count();
+            stage_begin = stage_end;
+        };
+
+        if(level == int32_t(depth_))
+        {
+            if(!current_node->is_in_core() && current_node->is_out_of_core())
             {
-            bvh_node *current_node = &nodes_.at(node_index);
-            // if necessary, load leaf-level nodes from disk
-            if(level == int32_t(depth_) && current_node->is_out_of_core())
-                {
                 current_node->load_from_disk();
             }
+            finish_stage(load_stage);
         }
-
-        // Iterate over nodes of current tree level.
-        // First apply reduction strategy, since calculation of attributes might depend on surfel data of nodes in same level.
-        if(level != int32_t(depth_))
+        else
         {
-            spawn_create_lod_jobs(first_node_of_level, last_node_of_level, reduction_strgy, resample);
+            create_lod(node_index, reduction_strgy, resample);
+            finish_stage(lod_stage);
         }
 
         // skip the leaf level attribute computation if it was not requested or necessary
-        if((level != int32_t(depth_) || recompute_leaf_level))
+        if(level != int32_t(depth_) || recompute_leaf_level)
         {
-            spawn_compute_attribute_jobs(first_node_of_level, last_node_of_level, normal_strategy, radius_strategy, recompute_leaf_level);
+            compute_attributes(node_index, normal_strategy, radius_strategy, recompute_leaf_level);
+            finish_stage(attribute_stage);
         }
 
-        spawn_compute_bounding_boxes_upsweep_jobs(first_node_of_level, last_node_of_level, level);
+        compute_bounding_box_upsweep(node_index, level);
+        finish_stage(bounding_box_stage);
 
+        // nodes below the batch roots are released by their parents
+        const bool dealloc_mem_array = unload_flushed_nodes && level == int32_t(batch_level);
 
-        real mean_radius_sd = 0.0;
-        unsigned counter = 1;
-        for(uint32_t node_index = first_node_of_level; node_index < last_node_of_level; ++node_index)
+        // leaves are written back in place, their offsets in the leaf level file are not uniform
+        if(level == int32_t(depth_) && current_node->is_out_of_core())
+        {
+            current_node->flush_to_disk(dealloc_mem_array);
+        }
+        else
         {
-            bvh_node *current_node = &nodes_.at(node_index);
-
-            mean_radius_sd = mean_radius_sd + (*current_node).node_stats().radius_sd();
-            counter++;
-
             // compute node offset in file
             int32_t nid = current_node->node_id();
             for(uint32_t write_level = 0; write_level < uint32_t(level); ++write_level)
@@ -1521,16 +1563,147 @@ void bvh::upsweep(const reduction_strategy &reduction_strgy, const normal_comput
 
             // save computed node to disk
             if (current_node->has_provenance()) {
-                current_node->flush_to_disk(level_temp_files[level], prov_temp_files[level], size_t(nid) * max_surfels_per_node_, false);
+                current_node->flush_to_disk(level_temp_files[level], prov_temp_files[level], size_t(nid) * max_surfels_per_node_, dealloc_mem_array);
             }
             else {
-                current_node->flush_to_disk(level_temp_files[level], size_t(nid) * max_surfels_per_node_, false);
+                current_node->flush_to_disk(level_temp_files[level], size_t(nid) * max_surfels_per_node_, dealloc_mem_array);
             }
         }
-        mean_radius_sd = mean_radius_sd / counter;
-        std::cout << "average radius deviation (level " << level << "): " << mean_radius_sd << "\n\n";
+        finish_stage(flush_stage);
+
+        // extend the longest chain of the children, children of the bottom level belong to an earlier pass
+        stage_times path_seconds = stage_seconds;
+        if(level < int32_t(bottom_level))
+        {
+            const stage_times *longest_child_path = &node_path_seconds[get_child_id(node_index, 0)];
+            for(uint8_t child_index = 1; child_index < fan_factor_; ++child_index)
+            {
+                const stage_times &child_path = node_path_seconds[get_child_id(node_index, child_index)];
+                if(sum_of(child_path) > sum_of(*longest_child_path))
+                {
+                    longest_child_path = &child_path;
+                }
+            }
+            for(uint32_t stage = 0; stage < num_upsweep_stages; ++stage)
+            {
+                path_seconds[stage] += (*longest_child_path)[stage];
+            }
+        }
+        node_path_seconds[node_index] = path_seconds;
+
+        {
+            std::lock_guard<std::mutex> lock(statistics_mutex);
+            mean_radius_sd[level] = mean_radius_sd[level] + current_node->node_stats().radius_sd();
+            counter[level]++;
+
+            for(uint32_t stage = 0; stage < num_upsweep_stages; ++stage)
+            {
+                total_stage_seconds[stage] += stage_seconds[stage];
+            }
+
+            // batched runs report the reduced subtrees instead
+            ++num_processed_nodes;
+            const uint16_t new_percent_processed = uint16_t(100 * num_processed_nodes / nodes_.size());
+            if(!unload_flushed_nodes && new_percent_processed > percent_processed)
+            {
+                percent_processed = new_percent_processed;
+                std::cout << "\r" << percent_processed << "% nodes processed" << std::flush;
+            }
+        }
+
+        // the children of a node are finished in any order, the last one submits the parent
+        if(level > int32_t(root_level))
+        {
+            const uint32_t parent_index = get_parent_id(node_index);
+            if(num_pending_children[parent_index].fetch_sub(1) == 1)
+            {
+                pool.submit([&, parent_index, level, root_level, bottom_level]() { upsweep_node(parent_index, level - 1, root_level, bottom_level); });
+            }
+        }
+    };
+
+    // Reduces the subtrees rooted at [first_root, last_root) from bottom_level up to root_level.
+    auto upsweep_subtrees = [&](const uint32_t first_root, const uint32_t last_root, const uint32_t root_level, const uint32_t bottom_level)
+    {
+        uint32_t first_node_of_level = first_root;
+        uint32_t last_node_of_level = last_root;
+        for(uint32_t level = root_level; level < bottom_level; ++level)
+        {
+            for(uint32_t node_index = first_node_of_level; node_index < last_node_of_level; ++node_index)
+            {
+                num_pending_children[node_index].store(fan_factor_);
+            }
+            first_node_of_level = get_child_id(first_node_of_level, 0);
+            last_node_of_level = get_child_id(last_node_of_level - 1, fan_factor_ - 1) + 1;
+        }
+
+        const auto pass_begin = std::chrono::steady_clock::now();
+
+        for(uint32_t node_index = first_node_of_level; node_index < last_node_of_level; ++node_index)
+        {
+            pool.submit([&, node_index, root_level, bottom_level]() { upsweep_node(node_index, bottom_level, root_level, bottom_level); });
+        }
+        pool.wait();
+
+        wall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - pass_begin).count();
+
+        // passes run one after another, their critical paths add up
+        const stage_times *longest_root_path = &node_path_seconds[first_root];
+        for(uint32_t root_index = first_root + 1; root_index < last_root; ++root_index)
+        {
+            if(sum_of(node_path_seconds[root_index]) > sum_of(*longest_root_path))
+            {
+                longest_root_path = &node_path_seconds[root_index];
+            }
+        }
+        for(uint32_t stage = 0; stage < num_upsweep_stages; ++stage)
+        {
+            critical_path_seconds[stage] += (*longest_root_path)[stage];
+        }
+    };
+
+    const uint32_t first_batch_root = get_first_node_id_of_depth(batch_level);
+    const uint32_t last_batch_root = first_batch_root + get_length_of_depth(batch_level);
+    uint32_t batch_begin = first_batch_root;
+
+    while(batch_begin < last_batch_root)
+    {
+        uint32_t batch_end = batch_begin;
+        size_t num_batch_surfels = 0;
+        do
+        {
+            num_batch_surfels += subtree_surfels[batch_end];
+            ++batch_end;
+        } while(batch_end < last_batch_root && num_batch_surfels + subtree_surfels[batch_end] <= leaf_surfel_capacity);
+
+        upsweep_subtrees(batch_begin, batch_end, batch_level, depth_);
+
+        if(unload_flushed_nodes)
+        {
+            std::cout << "\r" << int(100 * (batch_end - first_batch_root) / (last_batch_root - first_batch_root)) << "% subtrees reduced" << std::flush;
+        }
+        batch_begin = batch_end;
+    }
+
+    std::cout << std::endl;
+
+    if(unload_flushed_nodes)
+    {
+        upsweep_subtrees(0, 1, 0, batch_level - 1);
+    }
+
+    for(int32_t level = depth_; level >= 0; --level)
+    {
+        std::cout << "average radius deviation (level " << level << "): " << mean_radius_sd[level] / counter[level] << "\n\n";
     }
 
+    std::cout << "upsweep stage times on " << pool.num_threads() << " threads (summed over all nodes / on the critical path):" << std::endl;
+    for(uint32_t stage = 0; stage < num_upsweep_stages; ++stage)
+    {
+        std::cout << "  " << stage_names[stage] << ": " << total_stage_seconds[stage] << " s / " << critical_path_seconds[stage] << " s" << std::endl;
+    }
+    std::cout << "  wall time: " << wall_seconds << " s, critical path: " << sum_of(critical_path_seconds) << " s" << std::endl;
+
     // TODO: Inject a call to provenance method, collecting level data into one file
 
     reduction_strategy *p_reduction_strgy = (reduction_strategy *)&reduction_strgy;
@@ -1634,36 +1807,125 @@ void bvh::resample()
     state_ = state_type::after_upsweep;
 }
 
-surfel_vector bvh::remove_outliers_statistically(uint32_t num_outliers, uint16_t num_neighbours)
+size_t bvh::remove_outliers_statistically(const uint32_t num_outliers, const uint16_t num_neighbours)
 {
-    std::vector<std::vector<std::pair<surfel_id_t, real>>> intermediate_outliers;
+    const size_t in_core_surfel_capacity = std::max(size_t(1), size_t(std::floor((memory_limit_ * 1024 * 1024 * 1024) / sizeof(surfel))));
 
     uint32_t const num_threads = std::thread::hardware_concurrency();
-    intermediate_outliers.resize(num_threads);
-    // already_resized.resize(omp_get_max_threads())
+    std::vector<std::vector<std::pair<surfel_id_t, real>>> intermediate_outliers(num_threads);
 
-    for(uint32_t node_idx = first_leaf_; node_idx < nodes_.size(); ++node_idx)
+    // leaves that were in-core before stay in-core
+    std::vector<node_id_type> loaded_leaves;
+
+    auto load_leaf = [&](const node_id_type leaf)
     {
-        bvh_node *current_node = &nodes_.at(node_idx);
+        if(!nodes_[leaf].is_in_core() && nodes_[leaf].is_out_of_core())
+        {
+            nodes_[leaf].load_from_disk();
+            loaded_leaves.push_back(leaf);
+        }
+    };
 
-        if(current_node->is_out_of_core())
+    auto unload_leaves = [&](const std::vector<node_id_type> &keep)
+    {
+        std::vector<node_id_type> still_loaded;
+        for(const auto leaf : loaded_leaves)
         {
-            current_node->load_from_disk();
+            if(std::binary_search(keep.begin(), keep.end(), leaf))
+                still_loaded.push_back(leaf);
+            else
+                nodes_[leaf].mem_array().reset();
         }
-    }
+        loaded_leaves.swap(still_loaded);
+    };
 
-    working_queue_head_counter_.initialize(first_leaf_);
-    std::vector<std::thread> threads;
+    node_id_type batch_begin = first_leaf_;
 
-    for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+    while(batch_begin < nodes_.size())
     {
-        threads.push_back(std::thread(&bvh::thread_remove_outlier_jobs, this, first_leaf_, nodes_.size(), num_outliers, num_neighbours, std::ref(intermediate_outliers[thread_idx])));
-    }
+        // the batch takes up to half of the memory, its neighbourhood the rest
+        node_id_type batch_end = batch_begin;
+        size_t num_batch_surfels = 0;
+        do
+        {
+            num_batch_surfels += nodes_[batch_end].disk_array().length();
+            ++batch_end;
+        } while(batch_end < nodes_.size() && num_batch_surfels + nodes_[batch_end].disk_array().length() <= in_core_surfel_capacity / 2);
 
-    for(auto &thread : threads)
-    {
-        thread.join();
+        for(node_id_type leaf = batch_begin; leaf < batch_end; ++leaf)
+        {
+            load_leaf(leaf);
+        }
+
+        std::vector<real> search_bounds(batch_end - batch_begin);
+
+        working_queue_head_counter_.initialize(0);
+        std::vector<std::thread> threads;
+        for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+        {
+            threads.push_back(std::thread([&]() {
+                for(uint32_t i = working_queue_head_counter_.increment_head(); i < search_bounds.size(); i = working_queue_head_counter_.increment_head())
+                {
+                    search_bounds[i] = get_neighbour_search_bound(batch_begin + i, num_neighbours);
+                }
+            }));
+        }
+        for(auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        // leaves within reach of the neighbour searches, the batch shrinks if they do not fit
+        std::vector<node_id_type> required_leaves;
+        while(true)
+        {
+            required_leaves.clear();
+            for(node_id_type leaf = batch_begin; leaf < batch_end; ++leaf)
+            {
+                // a sphere around a surfel of the leaf only reaches leaves that intersect the enlarged leaf box
+                const real reach = std::sqrt(search_bounds[leaf - batch_begin]) * (1.0 + 1e-9) + std::numeric_limits<real>::min();
+                const bounding_box &leaf_box = nodes_[leaf].get_bounding_box();
+                get_intersecting_leaves(0, bounding_box(leaf_box.min() - vec3r(reach), leaf_box.max() + vec3r(reach)), required_leaves);
+                required_leaves.push_back(leaf);
+            }
+            std::sort(required_leaves.begin(), required_leaves.end());
+            required_leaves.erase(std::unique(required_leaves.begin(), required_leaves.end()), required_leaves.end());
+
+            size_t num_required_surfels = 0;
+            for(const auto leaf : required_leaves)
+            {
+                num_required_surfels += nodes_[leaf].disk_array().length();
+            }
+
+            if(num_required_surfels <= in_core_surfel_capacity || batch_end - batch_begin == 1)
+                break;
+
+            batch_end = batch_begin + (batch_end - batch_begin) / 2;
+        }
+
+        unload_leaves(required_leaves);
+        for(const auto leaf : required_leaves)
+        {
+            load_leaf(leaf);
+        }
+        std::sort(loaded_leaves.begin(), loaded_leaves.end());
+
+        working_queue_head_counter_.initialize(batch_begin);
+        threads.clear();
+        for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+        {
+            threads.push_back(std::thread(&bvh::thread_remove_outlier_jobs, this, batch_begin, batch_end, num_outliers, num_neighbours, std::ref(intermediate_outliers[thread_idx])));
+        }
+        for(auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        std::cout << "\r" << int(100 * (batch_end - first_leaf_) / (nodes_.size() - first_leaf_)) << "% leaves scored" << std::flush;
+
+        batch_begin = batch_end;
     }
+    std::cout << std::endl;
 
     std::vector<std::pair<surfel_id_t, real>> final_outliers;
 
@@ -1701,36 +1963,138 @@ surfel_vector bvh::remove_outliers_statistically(uint32_t num_outliers, uint16_t
 
     intermediate_outliers.clear();
 
-    std::set<surfel_id_t> outlier_ids;
-    for(auto const &el : final_outliers)
-    {
-        outlier_ids.insert(el.first);
-    }
+    // compact the leaves that contain outliers one at a time
+    std::sort(final_outliers.begin(), final_outliers.end(),
+              [](const std::pair<surfel_id_t, real> &lhs, const std::pair<surfel_id_t, real> &rhs) { return lhs.first < rhs.first; });
 
-    surfel_vector cleaned_surfels;
+    size_t num_removed = 0;
 
-    for(uint32_t node_idx = first_leaf_; node_idx < nodes_.size(); ++node_idx)
+    for(size_t group_begin = 0; group_begin < final_outliers.size();)
     {
-        bvh_node *current_node = &nodes_.at(node_idx);
+        const node_id_type node_idx = final_outliers[group_begin].first.node_idx;
+        size_t group_end = group_begin;
+        while(group_end < final_outliers.size() && final_outliers[group_end].first.node_idx == node_idx)
+        {
+            ++group_end;
+        }
 
-        if(current_node->is_out_of_core())
+        bvh_node &current_node = nodes_.at(node_idx);
+        const bool was_in_core = current_node.is_in_core();
+        if(!was_in_core)
         {
-            current_node->load_from_disk();
+            current_node.load_from_disk();
+        }
+
+        const size_t num_surfels = current_node.mem_array().length();
+        std::vector<bool> is_outlier(num_surfels, false);
+        size_t least_outlying = group_begin;
+        for(size_t i = group_begin; i < group_end; ++i)
+        {
+            is_outlier[final_outliers[i].first.surfel_idx] = true;
+            if(final_outliers[i].second < final_outliers[least_outlying].second)
+                least_outlying = i;
         }
 
-        for(uint32_t surfel_idx = 0; surfel_idx < current_node->mem_array().length(); ++surfel_idx)
+        if(group_end - group_begin == num_surfels)
         {
-            if(outlier_ids.end() == outlier_ids.find(surfel_id_t(node_idx, surfel_idx)))
+            is_outlier[final_outliers[least_outlying].first.surfel_idx] = false;
+        }
+
+        surfel_vector &surfels = *current_node.mem_array().surfel_mem_data();
+        std::vector<prov> *provs = current_node.mem_array().has_provenance() ? current_node.mem_array().prov_mem_data().get() : nullptr;
+        const size_t offset = current_node.mem_array().offset();
+
+        size_t num_kept = 0;
+        for(size_t i = 0; i < num_surfels; ++i)
+        {
+            if(!is_outlier[i])
             {
-                cleaned_surfels.emplace_back(current_node->mem_array().read_surfel(surfel_idx));
+                surfels[offset + num_kept] = surfels[offset + i];
+                if(provs)
+                    (*provs)[offset + num_kept] = (*provs)[offset + i];
+                ++num_kept;
             }
         }
+
+        num_removed += num_surfels - num_kept;
+
+        current_node.mem_array().set_length(num_kept);
+        current_node.disk_array().set_length(num_kept);
+        current_node.flush_to_disk(!was_in_core);
+
+        group_begin = group_end;
     }
 
-    return cleaned_surfels;
+    unload_leaves(std::vector<node_id_type>());
+
+    return num_removed;
+}
+
+const real bvh::get_neighbour_search_bound(const node_id_type leaf, const uint32_t num_neighbours) const
+{
+    const size_t num_surfels = nodes_[leaf].mem_array().length();
+
+    if(num_surfels > num_neighbours)
+    {
+        // the search of a surfel starts at the distance of its farthest local neighbour
+        const knn_index index(nodes_[leaf].mem_array());
+        std::vector<knn_index::neighbour_t> neighbours;
+        real bound = 0.0;
+
+        for(uint32_t surfel_idx = 0; surfel_idx < num_surfels; ++surfel_idx)
+        {
+            index.nearest_neighbours(surfel_idx, num_neighbours, neighbours);
+            bound = std::max(bound, neighbours.back().second);
+        }
+
+        return bound;
+    }
+
+    // otherwise all neighbours lie within the smallest subtree that holds enough surfels
+    node_id_type ancestor = leaf;
+    size_t num_subtree_surfels = num_surfels;
+
+    while(num_subtree_surfels <= num_neighbours && ancestor != 0)
+    {
+        ancestor = get_parent_id(ancestor);
+
+        node_id_type range_begin = ancestor;
+        node_id_type range_end = ancestor + 1;
+        for(uint32_t depth = nodes_[ancestor].depth(); depth < nodes_[leaf].depth(); ++depth)
+        {
+            range_begin = get_child_id(range_begin, 0);
+            range_end = get_child_id(range_end - 1, fan_factor_ - 1) + 1;
+        }
+
+        num_subtree_surfels = 0;
+        for(node_id_type node = range_begin; node < range_end; ++node)
+        {
+            num_subtree_surfels += nodes_[node].disk_array().length();
+        }
+    }
+
+    const bounding_box &ancestor_box = nodes_[ancestor].get_bounding_box();
+    return scm::math::length_sqr(ancestor_box.max() - ancestor_box.min());
+}
+
+void bvh::get_intersecting_leaves(const node_id_type node, const bounding_box &box, std::vector<node_id_type> &result) const
+{
+    if(nodes_[node].get_bounding_box().is_valid() && !nodes_[node].get_bounding_box().intersects(box))
+        return;
+
+    if(node >= first_leaf_)
+    {
+        result.push_back(node);
+        return;
+    }
+
+    for(uint16_t i = 0; i < fan_factor_; ++i)
+    {
+        get_intersecting_leaves(get_child_id(node, i), box, result);
+    }
 }
 
-void bvh::serialize_tree_to_file(const std::string &output_file, bool write_intermediate_data)
+void bvh::serialize_tree_to_file(const std::string &output_file, bool write_intermediate_data, const lod_format format)
 {
     LOGGER_TRACE("Serialize bvh to file: \"" << output_file << "\"");
 
@@ -1741,13 +2105,13 @@ void bvh::serialize_tree_to_file(const std::string &output_file, bool write_inte
     }
 
     bvh_stream bvh_strm;
-    bvh_strm.write_bvh(output_file, *this, write_intermediate_data);
+    bvh_strm.write_bvh(output_file, *this, write_intermediate_data, format);
 }
 
-void bvh::serialize_surfels_to_file(const std::string &lod_output_file, const std::string &prov_output_file, const size_t buffer_size) const
+void bvh::serialize_surfels_to_file(const std::string &lod_output_file, const std::string &prov_output_file, const size_t buffer_size, const lod_format format) const
 {
     LOGGER_TRACE("Serialize surfels to file: \"" << lod_output_file << "\"");
-    node_serializer serializer(max_surfels_per_node_, buffer_size);
+    node_serializer serializer(max_surfels_per_node_, buffer_size, format);
     serializer.open(lod_output_file);
     serializer.serialize_nodes(nodes_);
     serializer.close();
@@ -8,6 +8,7 @@
 #include <lamure/pre/bvh_stream.h>
 
 #include <lamure/pre/serialized_surfel.h>
+#include <lamure/pre/serialized_surfel_qz.h>
 
 namespace lamure
 {
@@ -377,7 +378,7 @@ read_bvh(const std::string &filename, bvh &bvh)
 }
 
 void bvh_stream::
-write_bvh(const std::string& filename, bvh& bvh, const bool intermediate) {
+write_bvh(const std::string& filename, bvh& bvh, const bool intermediate, const lod_format format) {
 
    open_stream(filename, bvh_stream_type::BVH_STREAM_OUT);
 
@@ -407,8 +408,15 @@ write_bvh(const std::string& filename, bvh& bvh, const bool intermediate) {
    tree.num_nodes_ = bvh.nodes().size();
    tree.fan_factor_ = bvh.fan_factor();
    tree.max_surfels_per_node_ = bvh.max_surfels_per_node();
-   tree.serialized_surfel_size_ = serialized_surfel::get_size();
-   tree.reserved_0_ = 0;
+   if (format == lod_format::surfels) {
+       tree.serialized_surfel_size_ = serialized_surfel::get_size();
+       tree.primitive_ = BVH_POINTCLOUD;
+   }
+   else {
+       tree.serialized_surfel_size_ = serialized_surfel_qz::get_size();
+       tree.primitive_ = BVH_POINTCLOUD_QZ;
+   }
+   tree.compression_ = format == lod_format::quantized_deflate ? BVH_DEFLATE : BVH_UNCOMPRESSED;
    tree.state_ = (bvh_stream::bvh_tree_state)bvh.state();
    tree.reserved_1_ = 0;
    tree.reserved_2_ = 0;
@@ -14,6 +14,7 @@
 #endif
 
 #include <numeric>
+#include <chrono>
 
 namespace lamure
 {
@@ -37,7 +38,8 @@ external_sort(const size_t memory_limit,
 void external_sort::
 sort(surfel_disk_array &array,
      const size_t memory_limit,
-     const surfel::compare_function &compare)
+     const surfel::compare_function &compare,
+     statistics *stats)
 {
     assert(!array.is_empty());
     assert(array.get_file());
@@ -50,7 +52,8 @@ sort(surfel_disk_array &array,
     // compute sort parameters
     const size_t run_length = memory_limit / sizeof(surfel) / 3u;
     const uint32_t runs_count = std::ceil(array.length() / double(run_length));
-    const size_t merge_buffer_size = memory_limit / sizeof(surfel) / (runs_count + 1u);
+    // every run and the output are double-buffered during the merge
+    const size_t merge_buffer_size = memory_limit / sizeof(surfel) / (2u * (runs_count + 1u));
 
     LOGGER_INFO("External sort. Length: " << array.length());
     LOGGER_INFO("Max run length: " << run_length <<
@@ -70,15 +73,26 @@ sort(surfel_disk_array &array,
                         "buffers that store less than " <<
                                                         MIN_MERGE_BUFFER_SIZE << " surfels.");
 
+    if (stats)
+        stats->runs_count = runs_count;
+
     if (runs_count > 1u) {
         // external sort
         es.runs_file_->open(array.get_file()->file_name() + TEMP_FILE_EXT, true);
         LOGGER_TRACE("create runs");
+        auto start = std::chrono::steady_clock::now();
         es.create_runs(array, run_length, runs_count);
+        auto runs_done = std::chrono::steady_clock::now();
         LOGGER_TRACE("merge");
-        es.merge(array, merge_buffer_size);
+        es.merge(array, std::max(merge_buffer_size, MIN_MERGE_BUFFER_SIZE));
+        auto merge_done = std::chrono::steady_clock::now();
         es.runs_file_->close(true);
         es.runs_.clear();
+
+        if (stats) {
+            stats->create_runs_time = std::chrono::duration<double>(runs_done - start).count();
+            stats->merge_time = std::chrono::duration<double>(merge_done - runs_done).count();
+        }
     }
     else {
         // internal sort for a single run
@@ -153,51 +167,177 @@ create_runs(surfel_disk_array &array,
     }
 }
 
+external_sort::io_queue::
+io_queue(const uint32_t num_threads)
+    : shutdown_(false)
+{
+    for (uint32_t i = 0; i < num_threads; ++i)
+        threads_.push_back(std::thread(&io_queue::run, this));
+}
+
+external_sort::io_queue::
+~io_queue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    signal_.notify_all();
+    for (auto &t: threads_)
+        t.join();
+}
+
+std::future<void> external_sort::io_queue::
+submit(const std::function<void()> &job)
+{
+    std::packaged_task<void()> task(job);
+    std::future<void> result = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(task));
+    }
+    signal_.notify_one();
+    return result;
+}
+
+void external_sort::io_queue::
+run()
+{
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            signal_.wait(lock, [this] { return shutdown_ || !jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            task = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        task();
+    }
+}
+
+void external_sort::run_reader::
+prefetch()
+{
+    if (file_offset_ >= run_.length())
+        return;
+
+    const size_t length = std::min(buffer_size_, run_.length() - file_offset_);
+    const size_t offset = run_.offset() + file_offset_;
+    file_offset_ += length;
+
+    back_size_ = length;
+    pending_ = io_.submit([this, offset, length]
+    {
+        run_.get_file()->read(&back_, 0, offset, length);
+    });
+}
+
+void external_sort::run_reader::
+swap_buffers()
+{
+    pos_ = 0;
+    if (!pending_.valid()) {
+        front_size_ = 0;
+        return;
+    }
+    pending_.get();
+    front_size_ = back_size_;
+    std::swap(front_, back_);
+    prefetch();
+}
+
+void external_sort::run_writer::
+flush()
+{
+    if (front_.empty())
+        return;
+
+    if (pending_.valid())
+        pending_.get();
+
+    std::swap(front_, back_);
+    front_.clear();
+
+    const size_t offset = array_.offset() + file_offset_;
+    file_offset_ += back_.size();
+
+    pending_ = io_.submit([this, offset]
+    {
+        array_.get_file()->write(&back_, 0, offset, back_.size());
+    });
+}
+
+const size_t external_sort::run_writer::
+finish()
+{
+    flush();
+    if (pending_.valid())
+        pending_.get();
+    return file_offset_;
+}
+
 void external_sort::
 merge(surfel_disk_array &array, const size_t buffer_size)
 {
-    size_t file_offset = 0;
-    surfel_vector output;
-    output.reserve(buffer_size);
-
-    std::vector<buffer> buffers;
-    for (auto r: runs_)
-        buffers.push_back(buffer(r, buffer_size));
-
-    surfel least;
-    int least_idx;
-
-    do {
-        least_idx = -1;
-        for (size_t i = 0; i < buffers.size(); ++i) {
-            surfel current_surfel;
-
-            if (buffers[i].front(current_surfel) && (least_idx == -1 ||
-                compare_(current_surfel, least))) {
-                least = current_surfel;
-                least_idx = i;
-            }
-        }
-        if (least_idx != -1) {
-            buffers[least_idx].pop_front();
-            output.push_back(least);
-            if (output.size() >= buffer_size) {
-                array.get_file()->write(&output, 0, array.offset() + file_offset,
-                                    output.size());
-                file_offset += output.size();
-                output.clear();
-            }
+    const uint32_t k = runs_.size();
+    assert(k > 0);
+
+    // runs share a single file, so one thread suffices for all reads;
+    // the output is written by a second one
+    io_queue read_io(1);
+    io_queue write_io(1);
+
+    std::vector<std::unique_ptr<run_reader>> readers;
+    readers.reserve(k);
+    for (const auto &r: runs_)
+        readers.emplace_back(new run_reader(r, buffer_size, read_io));
+
+    run_writer writer(array, buffer_size, write_io);
+
+    // loser tree: tree[0] holds the index of the current winner,
+    // tree[1..k-1] the losers of the inner matches. Index k denotes a
+    // virtual run that wins against everything and is only used to
+    // build the tree. Exhausted runs lose against everything else, ties
+    // are broken by run index to keep the merge stable.
+    auto wins = [&](const uint32_t a, const uint32_t b) -> bool
+    {
+        if (a == k) return true;
+        if (b == k) return false;
+        const bool a_empty = readers[a]->empty();
+        const bool b_empty = readers[b]->empty();
+        if (a_empty || b_empty)
+            return a_empty == b_empty ? a < b : b_empty;
+        if (compare_(readers[a]->front(), readers[b]->front())) return true;
+        if (compare_(readers[b]->front(), readers[a]->front())) return false;
+        return a < b;
+    };
+
+    std::vector<uint32_t> tree(k, k);
+
+    auto adjust = [&](uint32_t s)
+    {
+        for (uint32_t t = (s + k) / 2; t > 0; t /= 2) {
+            if (wins(tree[t], s))
+                std::swap(s, tree[t]);
         }
-    }
-    while (least_idx != -1);
+        tree[0] = s;
+    };
+
+    for (uint32_t i = k; i-- > 0;)
+        adjust(i);
 
-    if (output.size() > 0) {
-        array.get_file()->write(&output, 0, array.offset() + file_offset,
-                            output.size());
-        file_offset += output.size();
-        output.clear();
+    while (!readers[tree[0]]->empty()) {
+        const uint32_t winner = tree[0];
+        writer.push_back(readers[winner]->front());
+        readers[winner]->pop_front();
+        adjust(winner);
     }
-    assert(file_offset == array.length());
+
+    const size_t written = writer.finish();
+    assert(written == array.length());
+    (void) written;
 }
 
 }
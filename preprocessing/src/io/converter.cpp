@@ -6,6 +6,13 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/pre/io/converter.h>
+#include <lamure/pre/io/number_parser.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <atomic>
+#include <exception>
 #include <thread>
 #include <cmath>
 
@@ -18,45 +25,49 @@ void converter::
 convert(const std::string &input_filename, const std::string &output_filename)
 {
     discarded_ = 0;
-    flush_ready_ = false;
-    flush_done_ = false;
-
-    auto buf_callback = [&](surfel_vector &surfels)
-    {
-        std::unique_lock<std::mutex> lk(mtx_);
-        cv_.wait(lk, [this]
-        { return flush_ready_; });
 
-        surfels = buffer_;
+    if (!convert_chunked(input_filename, output_filename)) {
         flush_ready_ = false;
-        bool has_data = !buffer_.empty();
-
-        // notify main thread
-        flush_done_ = true;
-        lk.unlock();
-        cv_.notify_one();
-        return has_data;
-    };
+        flush_done_ = false;
 
-    // output thread
-    std::thread tr([&] 
+        auto buf_callback = [&](surfel_vector &surfels)
         {
-            out_format_.write(output_filename, buf_callback);
-        });
+            std::unique_lock<std::mutex> lk(mtx_);
+            cv_.wait(lk, [this]
+            { return flush_ready_; });
 
-    // read input
-    in_format_.read(input_filename, [&](const surfel &s) 
-        { 
-            this->append_surfel(s);
-        });
+            surfels.swap(buffer_);
+            buffer_.clear();
+            flush_ready_ = false;
+            bool has_data = !surfels.empty();
 
-    flush_buffer();
-    {
-        std::lock_guard<std::mutex> lk(mtx_);
-        flush_ready_ = true;
+            // notify main thread
+            flush_done_ = true;
+            lk.unlock();
+            cv_.notify_one();
+            return has_data;
+        };
+
+        // output thread
+        std::thread tr([&]
+            {
+                out_format_.write(output_filename, buf_callback);
+            });
+
+        // read input
+        in_format_.read(input_filename, [&](const surfel &s)
+            {
+                this->append_surfel(s);
+            });
+
+        flush_buffer();
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            flush_ready_ = true;
+        }
+        cv_.notify_one();
+        tr.join();
     }
-    cv_.notify_one();
-    tr.join();
 
     if (discarded_ > 0) {
         LOGGER_WARN("Discarded degenerate surfels: " << discarded_);
@@ -107,44 +118,222 @@ write_in_core_surfels_out(const surfel_vector &surf_vec, const std::string &outp
     if (discarded_ > 0) { LOGGER_WARN("Discarded degenerate surfels: " << discarded_); }
 }
 
+const bool converter::
+convert_chunked(const std::string &input_filename, const std::string &output_filename)
+{
+    boost::system::error_code error_code;
+    const uintmax_t file_size = boost::filesystem::file_size(input_filename, error_code);
+
+    if (error_code || file_size == 0)
+        return false;
+
+    boost::iostreams::mapped_file_source input;
+    try {
+        input.open(input_filename);
+    }
+    catch (const std::exception &e) {
+        LOGGER_WARN("Unable to map input file, reading it sequentially: " << e.what());
+        return false;
+    }
+
+    const char *data = input.data();
+    format_abstract::chunk_layout layout;
+
+    if (!in_format_.prepare_chunked_read(data, input.size(), layout))
+        return false;
+
+    // the parsed chunks waiting for the writer take about one buffer
+    const size_t max_chunks_in_flight = 2 * num_threads_;
+    const size_t surfels_per_chunk = std::max(size_t(4096), surfels_in_buffer_ / max_chunks_in_flight);
+    const size_t bytes_per_chunk = layout.record_size_ > 0
+                                   ? surfels_per_chunk * layout.record_size_
+                                   : surfels_per_chunk * 48; // typical length of an xyz line
+
+    // text chunks end behind the first line break after the nominal size
+    std::vector<size_t> chunk_begins {layout.begin_};
+    while (chunk_begins.back() < layout.end_) {
+        size_t chunk_end = std::min(chunk_begins.back() + bytes_per_chunk, layout.end_);
+
+        if (layout.record_size_ == 0 && chunk_end < layout.end_) {
+            const char *cursor = data + chunk_end - 1;
+            skip_line(cursor, data + layout.end_);
+            chunk_end = cursor - data;
+        }
+
+        chunk_begins.push_back(chunk_end);
+    }
+    const size_t num_chunks = chunk_begins.size() - 1;
+
+    // chunk i is parsed into slot i % max_chunks_in_flight and written in order
+    std::vector<surfel_vector> slots(max_chunks_in_flight);
+    std::vector<uint8_t> slot_ready(max_chunks_in_flight, false);
+    size_t next_chunk = 0;
+    size_t next_written = 0;
+    bool aborted = false;
+    std::exception_ptr error;
+    std::atomic<size_t> discarded(0);
+
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    auto abort = [&](std::exception_ptr e)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (!error)
+                error = e;
+            aborted = true;
+        }
+        cv.notify_all();
+    };
+
+    auto parse_chunks = [&]()
+    {
+        while (true) {
+            size_t chunk;
+            {
+                // do not run further ahead of the writer than there are slots
+                std::unique_lock<std::mutex> lk(mtx);
+                cv.wait(lk, [&]
+                { return aborted || next_chunk >= num_chunks || next_chunk < next_written + max_chunks_in_flight; });
+
+                if (aborted || next_chunk >= num_chunks)
+                    return;
+                chunk = next_chunk++;
+            }
+
+            surfel_vector surfels;
+            try {
+                in_format_.read_chunk(data + chunk_begins[chunk], data + chunk_begins[chunk + 1], surfels);
+
+                size_t num_kept = 0;
+                for (auto &s : surfels) {
+                    if (is_degenerate(s)) {
+                        ++discarded;
+                        continue;
+                    }
+                    if (prepare_surfel(s))
+                        surfels[num_kept++] = s;
+                }
+                surfels.resize(num_kept);
+            }
+            catch (...) {
+                abort(std::current_exception());
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                slots[chunk % max_chunks_in_flight].swap(surfels);
+                slot_ready[chunk % max_chunks_in_flight] = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    uint8_t percent_processed = 0;
+
+    auto buf_callback = [&](surfel_vector &surfels)
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        if (next_written == num_chunks)
+            return false;
+
+        const size_t slot = next_written % max_chunks_in_flight;
+        cv.wait(lk, [&]
+        { return aborted || slot_ready[slot]; });
+
+        if (aborted)
+            return false;
+
+        surfels.swap(slots[slot]);
+        slots[slot] = surfel_vector();
+        slot_ready[slot] = false;
+        ++next_written;
+
+        const uint8_t new_percent_processed = uint8_t(100 * (chunk_begins[next_written] - layout.begin_) / (layout.end_ - layout.begin_));
+        if (new_percent_processed != percent_processed) {
+            percent_processed = new_percent_processed;
+            std::cout << "\r" << (int) percent_processed << "% processed" << std::flush;
+        }
+
+        lk.unlock();
+        cv.notify_all();
+        return true;
+    };
+
+    // output thread
+    std::thread tr([&]
+        {
+            try {
+                out_format_.write(output_filename, buf_callback);
+            }
+            catch (...) {
+                abort(std::current_exception());
+            }
+        });
+
+    std::vector<std::thread> parsers;
+    for (uint32_t i = 0; i < num_threads_; ++i)
+        parsers.emplace_back(parse_chunks);
+
+    for (auto &parser : parsers)
+        parser.join();
+    tr.join();
+
+    discarded_ += discarded;
+
+    if (error)
+        std::rethrow_exception(error);
+
+    return true;
+}
+
 void converter::
 append_surfel(const surfel &surf)
 {
-    // std::cout << "append_surfel" << std::endl;
     if (is_degenerate(surf)) {
         ++discarded_;
         return;
     }
 
     surfel s(surf);
+
+    if (prepare_surfel(s)) {
+        buffer_.push_back(s);
+
+        if (buffer_.size() > surfels_in_buffer_)
+            flush_buffer();
+    }
+}
+
+const bool converter::
+prepare_surfel(surfel &s) const
+{
     bool keep = true;
 
     if (surfel_callback_)
         surfel_callback_(s, keep);
 
-    if (keep) {
-        if (scale_factor_ != 1.0) {
-            s.pos() *= scale_factor_;
-            s.radius() *= scale_factor_;
-        }
-
-        if (translation_ != vec3r(0.0)) {
-            s.pos() += translation_;
-        }
+    if (!keep)
+        return false;
 
-        if (override_radius_)
-            s.radius() = new_radius_;
+    if (scale_factor_ != 1.0) {
+        s.pos() *= scale_factor_;
+        s.radius() *= scale_factor_;
+    }
 
-        if (override_color_)
-            s.color() = new_color_;
+    if (translation_ != vec3r(0.0)) {
+        s.pos() += translation_;
+    }
 
-        //LOGGER_DEBUG("Pos: " << s.pos());
+    if (override_radius_)
+        s.radius() = new_radius_;
 
-        buffer_.push_back(s);
+    if (override_color_)
+        s.color() = new_color_;
 
-        if (buffer_.size() > surfels_in_buffer_)
-            flush_buffer();
-    }
+    return true;
 }
 
 void converter::
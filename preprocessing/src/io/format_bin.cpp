@@ -8,6 +8,7 @@
 #include <lamure/pre/io/format_bin.h>
 #include <lamure/pre/node_serializer.h>
 #include <stdexcept>
+#include <cstring>
 #include <lamure/pre/io/file.h>
 #include <lamure/pre/surfel_disk_array.h>
 
@@ -48,6 +49,30 @@ void format_bin::read(const std::string &filename, surfel_callback_function call
     file.close();
 }
 
+const bool format_bin::prepare_chunked_read(const char *data, const size_t size, chunk_layout &layout)
+{
+    layout.begin_ = 0;
+    layout.end_ = size - size % record_size;
+    layout.record_size_ = record_size;
+    return true;
+}
+
+void format_bin::read_chunk(const char *begin, const char *end, surfel_vector &surfels) const
+{
+    surfels.reserve(surfels.size() + (end - begin) / record_size);
+
+    for(const char *record = begin; record + record_size <= end; record += record_size)
+    {
+        vec3r pos;
+        std::memcpy(&pos.x, record, sizeof(real));
+        std::memcpy(&pos.y, record + sizeof(real), sizeof(real));
+        std::memcpy(&pos.z, record + 2 * sizeof(real), sizeof(real));
+
+        const uint8_t *color = reinterpret_cast<const uint8_t *>(record + 3 * sizeof(real));
+
+        surfels.emplace_back(pos, vec3b(color[0], color[1], color[2]));
+    }
+}
 
 void format_bin::write(const std::string &filename, buffer_callback_function callback)
 {
@@ -57,6 +82,7 @@ void format_bin::write(const std::string &filename, buffer_callback_function cal
         throw std::runtime_error("Unable to open file: " + filename);
 
     surfel_vector buffer;
+    std::vector<char> records;
     size_t counter = 0;
 
     while(true)
@@ -65,16 +91,26 @@ void format_bin::write(const std::string &filename, buffer_callback_function cal
         if(!ret)
             break;
 
-        for(int i = 0; i < buffer.size(); i++)
+        // pack the batch and write it at once
+        records.resize(buffer.size() * record_size);
+        char *record = records.data();
+
+        for(const auto &s : buffer)
         {
-            file.write((char *)&(buffer.at(i).pos().x), sizeof(real));
-            file.write((char *)&(buffer.at(i).pos().y), sizeof(real));
-            file.write((char *)&(buffer.at(i).pos().z), sizeof(real));
+            const vec3r pos = s.pos();
+            const vec3b color = s.color();
+
+            std::memcpy(record, &pos.x, sizeof(real));
+            std::memcpy(record + sizeof(real), &pos.y, sizeof(real));
+            std::memcpy(record + 2 * sizeof(real), &pos.z, sizeof(real));
 
-            file.write((char *)&(buffer.at(i).color().r), sizeof(uint8_t));
-            file.write((char *)&(buffer.at(i).color().g), sizeof(uint8_t));
-            file.write((char *)&(buffer.at(i).color().b), sizeof(uint8_t));
+            record[3 * sizeof(real)] = color.r;
+            record[3 * sizeof(real) + 1] = color.g;
+            record[3 * sizeof(real) + 2] = color.b;
+            record += record_size;
         }
+
+        file.write(records.data(), records.size());
         counter += buffer.size();
     }
 
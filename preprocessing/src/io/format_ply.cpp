@@ -10,7 +10,11 @@
 #include <lamure/pre/io/ply/ply.h>
 #include <lamure/pre/io/ply/ply_parser.h>
 
+#include <lamure/pre/io/number_parser.h>
+
 #include <boost/filesystem.hpp>
+#include <cstring>
+#include <sstream>
 #include <stdexcept>
 #include <tuple>
 #include <memory>
@@ -75,6 +79,207 @@ read(const std::string &filename, surfel_callback_function callback)
     ply_parser.parse(filename);
 }
 
+const bool format_ply::
+prepare_chunked_read(const char *data, const size_t size, chunk_layout &layout)
+{
+    vertex_properties_.clear();
+
+    const char *cursor = data;
+    const char *end = data + size;
+
+    bool is_ply = false;
+    bool in_vertex_element = false;
+    bool has_further_elements = false;
+    size_t num_vertices = 0;
+    size_t record_size = 0;
+    std::string format;
+
+    while (cursor != end) {
+        const char *line_begin = cursor;
+        skip_line(cursor, end);
+
+        std::istringstream line(std::string(line_begin, cursor));
+        std::string keyword;
+        line >> keyword;
+
+        if (!is_ply) {
+            if (keyword != "ply")
+                return false;
+            is_ply = true;
+        }
+        else if (keyword == "format") {
+            line >> format;
+        }
+        else if (keyword == "element") {
+            std::string element_name;
+            line >> element_name;
+
+            if (element_name == "vertex" && vertex_properties_.empty() && !in_vertex_element) {
+                line >> num_vertices;
+                in_vertex_element = true;
+            }
+            else {
+                // the vertices have to be the first element
+                if (!in_vertex_element)
+                    return false;
+                in_vertex_element = false;
+                has_further_elements = true;
+            }
+        }
+        else if (keyword == "property" && in_vertex_element) {
+            std::string type, name;
+            line >> type >> name;
+
+            // list properties cannot be split into fixed records
+            if (type == "list")
+                return false;
+
+            vertex_property property;
+            property.offset_ = record_size;
+            property.is_float_ = type == "float" || type == "float32" || type == "double" || type == "float64";
+            property.is_signed_ = property.is_float_ || type == "char" || type == "int8" || type == "short" || type == "int16" || type == "int" || type == "int32";
+
+            if (type == "char" || type == "int8" || type == "uchar" || type == "uint8")
+                property.size_ = 1;
+            else if (type == "short" || type == "int16" || type == "ushort" || type == "uint16")
+                property.size_ = 2;
+            else if (type == "int" || type == "int32" || type == "uint" || type == "uint32" || type == "float" || type == "float32")
+                property.size_ = 4;
+            else if (type == "double" || type == "float64")
+                property.size_ = 8;
+            else
+                return false;
+
+            if (name == "x")
+                property.attribute_ = vertex_attribute::x;
+            else if (name == "y")
+                property.attribute_ = vertex_attribute::y;
+            else if (name == "z")
+                property.attribute_ = vertex_attribute::z;
+            else if (name == "nx")
+                property.attribute_ = vertex_attribute::nx;
+            else if (name == "ny")
+                property.attribute_ = vertex_attribute::ny;
+            else if (name == "nz")
+                property.attribute_ = vertex_attribute::nz;
+            else if (name == "red" || name == "diffuse_red")
+                property.attribute_ = vertex_attribute::red;
+            else if (name == "green" || name == "diffuse_green")
+                property.attribute_ = vertex_attribute::green;
+            else if (name == "blue" || name == "diffuse_blue")
+                property.attribute_ = vertex_attribute::blue;
+            else
+                property.attribute_ = vertex_attribute::ignored;
+
+            record_size += property.size_;
+            vertex_properties_.push_back(property);
+        }
+        else if (keyword == "end_header") {
+            break;
+        }
+    }
+
+    if (!is_ply || vertex_properties_.empty())
+        return false;
+
+    layout.begin_ = cursor - data;
+
+    if (format == "binary_little_endian") {
+        if (layout.begin_ + num_vertices * record_size > size)
+            return false;
+
+        binary_chunks_ = true;
+        layout.end_ = layout.begin_ + num_vertices * record_size;
+        layout.record_size_ = record_size;
+        return true;
+    }
+
+    // the end of the vertex lines is only known if nothing follows them
+    if (format == "ascii" && !has_further_elements) {
+        binary_chunks_ = false;
+        layout.end_ = size;
+        layout.record_size_ = 0;
+        return true;
+    }
+
+    return false;
+}
+
+void format_ply::
+read_chunk(const char *begin, const char *end, surfel_vector &surfels) const
+{
+    auto assign = [](surfel &s, const vertex_attribute attribute, const real value)
+    {
+        switch (attribute) {
+            case vertex_attribute::x: s.pos().x = value; break;
+            case vertex_attribute::y: s.pos().y = value; break;
+            case vertex_attribute::z: s.pos().z = value; break;
+            case vertex_attribute::nx: s.normal().x = value; break;
+            case vertex_attribute::ny: s.normal().y = value; break;
+            case vertex_attribute::nz: s.normal().z = value; break;
+            case vertex_attribute::red: s.color().x = to_color_channel(value); break;
+            case vertex_attribute::green: s.color().y = to_color_channel(value); break;
+            case vertex_attribute::blue: s.color().z = to_color_channel(value); break;
+            default: break;
+        }
+    };
+
+    const char *cursor = begin;
+
+    while (cursor != end) {
+        surfel s;
+
+        if (binary_chunks_) {
+            for (const auto &property : vertex_properties_) {
+                if (property.attribute_ == vertex_attribute::ignored)
+                    continue;
+
+                const char *field = cursor + property.offset_;
+                real value = 0.0;
+
+                if (property.is_float_) {
+                    if (property.size_ == 4) {
+                        float f; std::memcpy(&f, field, 4); value = f;
+                    }
+                    else {
+                        double d; std::memcpy(&d, field, 8); value = d;
+                    }
+                }
+                else {
+                    switch (property.size_) {
+                        case 1: value = property.is_signed_ ? real(int8_t(*field)) : real(uint8_t(*field)); break;
+                        case 2: { int16_t i; std::memcpy(&i, field, 2); value = property.is_signed_ ? real(i) : real(uint16_t(i)); } break;
+                        default: { int32_t i; std::memcpy(&i, field, 4); value = property.is_signed_ ? real(i) : real(uint32_t(i)); } break;
+                    }
+                }
+
+                assign(s, property.attribute_, value);
+            }
+
+            cursor += vertex_properties_.back().offset_ + vertex_properties_.back().size_;
+        }
+        else {
+            bool complete = true;
+            for (const auto &property : vertex_properties_) {
+                real value;
+                if (!parse_real(cursor, end, value)) {
+                    complete = false;
+                    break;
+                }
+                assign(s, property.attribute_, value);
+            }
+
+            skip_line(cursor, end);
+
+            // skip empty lines
+            if (!complete)
+                continue;
+        }
+
+        surfels.push_back(s);
+    }
+}
+
 void format_ply::
 write(const std::string &filename, buffer_callback_function callback)
 {
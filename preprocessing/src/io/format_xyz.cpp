@@ -6,6 +6,8 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/pre/io/format_xyz.h>
+#include <lamure/pre/io/number_parser.h>
+
 
 #include <stdexcept>
 #include <fstream>
@@ -62,6 +64,46 @@ read(const std::string &filename, surfel_callback_function callback)
     xyz_file_stream.close();
 }
 
+const bool format_xyz::
+prepare_chunked_read(const char *data, const size_t size, chunk_layout &layout)
+{
+    layout.begin_ = 0;
+    layout.end_ = size;
+    layout.record_size_ = 0;
+    return true;
+}
+
+void format_xyz::
+read_chunk(const char *begin, const char *end, surfel_vector &surfels) const
+{
+    const char *cursor = begin;
+
+    while (cursor != end) {
+        real pos[3];
+
+        // skip empty lines and lines with less than three coordinates
+        if (!parse_real(cursor, end, pos[0]) ||
+            !parse_real(cursor, end, pos[1]) ||
+            !parse_real(cursor, end, pos[2])) {
+            skip_line(cursor, end);
+            continue;
+        }
+
+        real color[3] = {0.0, 0.0, 0.0};
+        for (uint8_t i = 0; i < 3; ++i) {
+            if (!parse_real(cursor, end, color[i]))
+                break;
+        }
+
+        skip_line(cursor, end);
+
+        surfels.emplace_back(vec3r(pos[0], pos[1], pos[2]),
+                             vec3b(to_color_channel(color[0]),
+                                   to_color_channel(color[1]),
+                                   to_color_channel(color[2])));
+    }
+}
+
 void format_xyz::
 write(const std::string &filename, buffer_callback_function callback)
 {
@@ -0,0 +1,193 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/knn_index.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace lamure
+{
+namespace pre
+{
+namespace
+{
+const uint32_t max_leaf_size = 8;
+const uint32_t no_exclusion = std::numeric_limits<uint32_t>::max();
+
+// strict order on (distance, index), the heap keeps its largest element on top
+inline bool closer(const knn_index::neighbour_t &lhs, const knn_index::neighbour_t &rhs)
+{
+    return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+}
+} // namespace
+
+knn_index::knn_index(const surfel_mem_array &mem_array)
+{
+    positions_.reserve(mem_array.length());
+
+    for(size_t i = 0; i < mem_array.length(); ++i)
+    {
+        positions_.push_back(mem_array.read_surfel_ref(i).pos());
+    }
+
+    build();
+}
+
+knn_index::knn_index(const std::vector<vec3r> &positions) : positions_(positions) { build(); }
+
+void knn_index::build()
+{
+    const uint32_t num_points = positions_.size();
+
+    permutation_.resize(num_points);
+    std::iota(permutation_.begin(), permutation_.end(), 0);
+
+    if(num_points > 0)
+    {
+        nodes_.reserve(2 * (num_points / max_leaf_size + 1));
+        build(0, num_points);
+    }
+
+    // keep the points of a leaf next to each other
+    sorted_positions_.resize(num_points);
+    for(uint32_t i = 0; i < num_points; ++i)
+    {
+        sorted_positions_[i] = positions_[permutation_[i]];
+    }
+}
+
+uint32_t knn_index::build(const uint32_t begin, const uint32_t end)
+{
+    const uint32_t node_id = nodes_.size();
+    nodes_.push_back(node{real(0), begin, end, 0, 0});
+
+    if(end - begin <= max_leaf_size)
+    {
+        return node_id;
+    }
+
+    // split along the widest extent at the median
+    vec3r min_vertex = positions_[permutation_[begin]];
+    vec3r max_vertex = min_vertex;
+
+    for(uint32_t i = begin + 1; i < end; ++i)
+    {
+        const vec3r &position = positions_[permutation_[i]];
+        min_vertex = vec3r(std::min(min_vertex.x, position.x), std::min(min_vertex.y, position.y), std::min(min_vertex.z, position.z));
+        max_vertex = vec3r(std::max(max_vertex.x, position.x), std::max(max_vertex.y, position.y), std::max(max_vertex.z, position.z));
+    }
+
+    const vec3r extent = max_vertex - min_vertex;
+    uint8_t axis = 0;
+    if(extent.y > extent[axis])
+        axis = 1;
+    if(extent.z > extent[axis])
+        axis = 2;
+
+    // coincident points
+    if(extent[axis] <= real(0))
+    {
+        return node_id;
+    }
+
+    const uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(permutation_.begin() + begin, permutation_.begin() + mid, permutation_.begin() + end,
+                     [&](const uint32_t lhs, const uint32_t rhs) { return positions_[lhs][axis] < positions_[rhs][axis]; });
+
+    nodes_[node_id].split_ = positions_[permutation_[mid]][axis];
+    nodes_[node_id].axis_ = axis;
+
+    build(begin, mid);
+    const uint32_t right = build(mid, end);
+    nodes_[node_id].right_ = right;
+
+    return node_id;
+}
+
+void knn_index::search(const uint32_t node_id, const vec3r &position, const uint32_t excluded, const uint32_t k, std::vector<neighbour_t> &heap) const
+{
+    const node &current = nodes_[node_id];
+
+    if(current.right_ == 0)
+    {
+        for(uint32_t i = current.begin_; i < current.end_; ++i)
+        {
+            const uint32_t index = permutation_[i];
+
+            if(index == excluded)
+                continue;
+
+            const neighbour_t candidate(index, scm::math::length_sqr(position - sorted_positions_[i]));
+
+            if(heap.size() < k)
+            {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end(), closer);
+            }
+            else if(closer(candidate, heap.front()))
+            {
+                std::pop_heap(heap.begin(), heap.end(), closer);
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end(), closer);
+            }
+        }
+
+        return;
+    }
+
+    const real offset = position[current.axis_] - current.split_;
+    const uint32_t near_child = offset <= real(0) ? node_id + 1 : current.right_;
+    const uint32_t far_child = offset <= real(0) ? current.right_ : node_id + 1;
+
+    search(near_child, position, excluded, k, heap);
+
+    // points on the splitting plane may lie on either side
+    if(heap.size() < k || offset * offset <= heap.front().second)
+    {
+        search(far_child, position, excluded, k, heap);
+    }
+}
+
+void knn_index::nearest_neighbours(const uint32_t index, const uint32_t k, std::vector<neighbour_t> &result) const
+{
+    result.clear();
+
+    if(k == 0 || nodes_.empty())
+        return;
+
+    result.reserve(k);
+    search(0, positions_[index], index, k, result);
+    std::sort_heap(result.begin(), result.end(), closer);
+}
+
+void knn_index::nearest_neighbours(const vec3r &position, const uint32_t k, std::vector<neighbour_t> &result) const
+{
+    result.clear();
+
+    if(k == 0 || nodes_.empty())
+        return;
+
+    result.reserve(k);
+    search(0, position, no_exclusion, k, result);
+    std::sort_heap(result.begin(), result.end(), closer);
+}
+
+void knn_index::all_nearest_neighbours(const uint32_t k, std::vector<std::vector<neighbour_t>> &result) const
+{
+    result.resize(positions_.size());
+
+    // query in tree order, consecutive queries then visit the same leaves
+    for(const auto index : permutation_)
+    {
+        nearest_neighbours(index, k, result[index]);
+    }
+}
+
+} // namespace pre
+} // namespace lamure
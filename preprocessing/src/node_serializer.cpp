@@ -7,7 +7,9 @@
 
 #include <lamure/pre/node_serializer.h>
 #include <lamure/pre/serialized_surfel.h>
+#include <lamure/pre/serialized_surfel_qz.h>
 #include <cstring>
+#include <zlib.h>
 #include <windows.h>
 #include <psapi.h>
 
@@ -18,8 +20,10 @@ namespace pre
 
 node_serializer::
 node_serializer(const size_t surfels_per_node,
-                const size_t buffer_size)
-    : surfels_per_node_(surfels_per_node)
+                const size_t buffer_size,
+                const lod_format format)
+    : surfels_per_node_(surfels_per_node),
+      format_(format)
 {
     max_nodes_in_buffer_ = buffer_size / sizeof(surfel) / surfels_per_node;
 }
@@ -38,6 +42,8 @@ open(const std::string &file_name, const bool read_write_mode)
 {
     file_name_ = file_name;
     surfel_buffer_.clear();
+    node_buffer_.clear();
+    node_offsets_.clear();
 
     if (read_write_mode)
         stream_.open(file_name, std::ios::in | std::ios::out | std::ios::binary);
@@ -58,6 +64,8 @@ close()
     if (is_open()) {
         flush_surfel_buffer();
         surfel_buffer_.clear();
+        node_buffer_.clear();
+        write_node_offsets();
         stream_.close();
         if (stream_.fail()) {
             LOGGER_ERROR("Failed to close file: \"" << file_name_ <<
@@ -176,6 +184,7 @@ write_node_streamed(const bvh_node &node)
                                    node.disk_array().offset(),
                                    read_length);
     surfel_buffer_.push_back(surfel_buffer);
+    node_buffer_.push_back(&node);
 
     if (surfel_buffer_.size() >= max_nodes_in_buffer_)
         flush_surfel_buffer();
@@ -194,6 +203,11 @@ size_t get_current_rss()
 
 void node_serializer::flush_surfel_buffer()
 {
+    if (format_ != lod_format::surfels) {
+        flush_quantized_buffer();
+        return;
+    }
+
     if (surfel_buffer_.size()) {
         const size_t output_buffer_size = serialized_surfel::get_size() * surfels_per_node_ * surfel_buffer_.size();
         char *output_buffer = new char[output_buffer_size];
@@ -221,12 +235,93 @@ void node_serializer::flush_surfel_buffer()
                                                   "\". " << strerror(errno));
         }
         surfel_buffer_.clear();
+        node_buffer_.clear();
         delete[] output_buffer;
 
         stream_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     }
 }
 
+void node_serializer::flush_quantized_buffer()
+{
+    if (surfel_buffer_.empty())
+        return;
+
+    const size_t node_size = serialized_surfel_qz::get_size() * surfels_per_node_;
+    const bool deflate = format_ == lod_format::quantized_deflate;
+
+    // padding surfels have a radius of zero and are discarded by the renderer
+    const surfel invalid_surfel(vec3r(0.0), vec3b(0), 0.0, vec3f(0.f));
+
+    std::vector<char> node_buffer(node_size);
+    std::vector<char> output_buffer;
+    output_buffer.reserve(deflate ? surfel_buffer_.size() * compressBound(uLong(node_size)) : surfel_buffer_.size() * node_size);
+
+    if (deflate && node_offsets_.empty())
+        node_offsets_.push_back(0);
+
+    for (size_t k = 0; k < surfel_buffer_.size(); ++k) {
+        const bvh_node &node = *node_buffer_[k];
+
+        for (size_t i = 0; i < surfels_per_node_; ++i) {
+            char *buf = node_buffer.data() + i * serialized_surfel_qz::get_size();
+            const surfel s = i < surfel_buffer_[k]->size() ? surfel_buffer_[k]->at(i) : invalid_surfel;
+            serialized_surfel_qz(s, node.get_bounding_box(), node.avg_surfel_radius(), node.max_surfel_radius_deviation()).serialize(buf);
+        }
+        delete surfel_buffer_[k];
+
+        if (deflate) {
+            const size_t begin = output_buffer.size();
+            uLongf compressed_size = compressBound(uLong(node_size));
+            output_buffer.resize(begin + compressed_size);
+
+            if (compress2(reinterpret_cast<Bytef *>(&output_buffer[begin]), &compressed_size,
+                          reinterpret_cast<const Bytef *>(node_buffer.data()), uLong(node_size), Z_DEFAULT_COMPRESSION) != Z_OK) {
+                throw std::runtime_error("PLOD: node_serializer::Unable to compress node " + std::to_string(node.node_id()));
+            }
+
+            output_buffer.resize(begin + compressed_size);
+            node_offsets_.push_back(node_offsets_.back() + compressed_size);
+        }
+        else {
+            output_buffer.insert(output_buffer.end(), node_buffer.begin(), node_buffer.end());
+        }
+    }
+
+    LOGGER_INFO("Flush quantized buffer to disk. buffer size: " <<
+                                                                surfel_buffer_.size() << " nodes (" <<
+                                                                output_buffer.size() / 1024 / 1024 << " MiB)");
+
+    stream_.seekp(0, stream_.end);
+    stream_.write(output_buffer.data(), output_buffer.size());
+    if (stream_.fail() || stream_.bad()) {
+        LOGGER_ERROR("write failed. file: \"" << file_name_ <<
+                                              "\". " << strerror(errno));
+    }
+    surfel_buffer_.clear();
+    node_buffer_.clear();
+}
+
+void node_serializer::write_node_offsets()
+{
+    if (node_offsets_.empty())
+        return;
+
+    const uint64_t num_nodes = node_offsets_.size() - 1;
+
+    stream_.seekp(0, stream_.end);
+    stream_.write(reinterpret_cast<const char *>(node_offsets_.data()), node_offsets_.size() * sizeof(uint64_t));
+    stream_.write(reinterpret_cast<const char *>(&num_nodes), sizeof(num_nodes));
+    if (stream_.fail() || stream_.bad()) {
+        LOGGER_ERROR("write failed. file: \"" << file_name_ <<
+                                              "\". " << strerror(errno));
+    }
+
+    LOGGER_INFO("Compressed nodes: " << node_offsets_.back() / 1024 / 1024 << " MiB, uncompressed " <<
+                num_nodes * serialized_surfel_qz::get_size() * surfels_per_node_ / 1024 / 1024 << " MiB");
+    node_offsets_.clear();
+}
+
 
 }
 } // namespace lamure
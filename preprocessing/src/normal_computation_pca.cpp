@@ -0,0 +1,397 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/bvh.h>
+#include <lamure/pre/normal_computation_pca.h>
+
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace lamure
+{
+namespace pre
+{
+
+namespace
+{
+
+// lane-wise operations, the eigensolver below is written once against these
+template <typename V>
+struct lanes;
+
+template <>
+struct lanes<double>
+{
+    using mask = bool;
+    static const size_t width = 1;
+
+    static double load(const double *p) { return *p; }
+    static void store(double *p, const double v) { *p = v; }
+    static double set(const double v) { return v; }
+
+    static double add(const double a, const double b) { return a + b; }
+    static double sub(const double a, const double b) { return a - b; }
+    static double mul(const double a, const double b) { return a * b; }
+    static double div(const double a, const double b) { return a / b; }
+    static double sqrt(const double a) { return std::sqrt(a); }
+    static double abs(const double a) { return std::abs(a); }
+    static double min(const double a, const double b) { return a < b ? a : b; }
+
+    static mask gt(const double a, const double b) { return a > b; }
+    static mask both(const mask a, const mask b) { return a && b; }
+    static mask all() { return true; }
+    static bool any(const mask m) { return m; }
+    static double select(const mask m, const double a, const double b) { return m ? a : b; }
+};
+
+#if defined(__AVX2__)
+template <>
+struct lanes<__m256d>
+{
+    using mask = __m256d;
+    static const size_t width = 4;
+
+    static __m256d load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, const __m256d v) { _mm256_storeu_pd(p, v); }
+    static __m256d set(const double v) { return _mm256_set1_pd(v); }
+
+    static __m256d add(const __m256d a, const __m256d b) { return _mm256_add_pd(a, b); }
+    static __m256d sub(const __m256d a, const __m256d b) { return _mm256_sub_pd(a, b); }
+    static __m256d mul(const __m256d a, const __m256d b) { return _mm256_mul_pd(a, b); }
+    static __m256d div(const __m256d a, const __m256d b) { return _mm256_div_pd(a, b); }
+    static __m256d sqrt(const __m256d a) { return _mm256_sqrt_pd(a); }
+    static __m256d abs(const __m256d a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static __m256d min(const __m256d a, const __m256d b) { return _mm256_min_pd(a, b); }
+
+    static mask gt(const __m256d a, const __m256d b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static mask both(const mask a, const mask b) { return _mm256_and_pd(a, b); }
+    static mask all() { return _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); }
+    static bool any(const mask m) { return _mm256_movemask_pd(m) != 0; }
+    static __m256d select(const mask m, const __m256d a, const __m256d b) { return _mm256_blendv_pd(b, a, m); }
+};
+#endif
+
+#if defined(__AVX512F__)
+template <>
+struct lanes<__m512d>
+{
+    using mask = __mmask8;
+    static const size_t width = 8;
+
+    static __m512d load(const double *p) { return _mm512_loadu_pd(p); }
+    static void store(double *p, const __m512d v) { _mm512_storeu_pd(p, v); }
+    static __m512d set(const double v) { return _mm512_set1_pd(v); }
+
+    static __m512d add(const __m512d a, const __m512d b) { return _mm512_add_pd(a, b); }
+    static __m512d sub(const __m512d a, const __m512d b) { return _mm512_sub_pd(a, b); }
+    static __m512d mul(const __m512d a, const __m512d b) { return _mm512_mul_pd(a, b); }
+    static __m512d div(const __m512d a, const __m512d b) { return _mm512_div_pd(a, b); }
+    static __m512d sqrt(const __m512d a) { return _mm512_sqrt_pd(a); }
+    static __m512d abs(const __m512d a) { return _mm512_abs_pd(a); }
+    static __m512d min(const __m512d a, const __m512d b) { return _mm512_min_pd(a, b); }
+
+    static mask gt(const __m512d a, const __m512d b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static mask both(const mask a, const mask b) { return a & b; }
+    static mask all() { return 0xFF; }
+    static bool any(const mask m) { return m != 0; }
+    static __m512d select(const mask m, const __m512d a, const __m512d b) { return _mm512_mask_blend_pd(m, b, a); }
+};
+#endif
+
+const uint32_t max_newton_iterations = 64;
+
+// Smallest eigenvalue and its eigenvector for width matrices starting at index.
+// The eigenvalue is the smallest root of the characteristic polynomial, found by
+// Newton's method from a Gershgorin lower bound: left of the smallest root the
+// polynomial is increasing and concave, so the iteration approaches it from below.
+// The eigenvector is the largest cross product of two rows of (A - lambda I).
+// Lanes without a unique eigenvector are written as zero vectors.
+template <typename V>
+void solve(const normal_computation_pca::covariances &m, const size_t index, double *lambdas, double *nx, double *ny, double *nz)
+{
+    using L = lanes<V>;
+
+    const V a = L::load(&m.xx[index]);
+    const V b = L::load(&m.xy[index]);
+    const V c = L::load(&m.xz[index]);
+    const V d = L::load(&m.yy[index]);
+    const V e = L::load(&m.yz[index]);
+    const V f = L::load(&m.zz[index]);
+
+    // characteristic polynomial lambda^3 - trace lambda^2 + c1 lambda - c0
+    const V trace = L::add(L::add(a, d), f);
+    const V c1 = L::sub(L::sub(L::sub(L::add(L::add(L::mul(a, d), L::mul(a, f)), L::mul(d, f)), L::mul(b, b)), L::mul(c, c)), L::mul(e, e));
+    const V c0 = L::add(L::sub(L::mul(a, L::sub(L::mul(d, f), L::mul(e, e))), L::mul(b, L::sub(L::mul(b, f), L::mul(c, e)))), L::mul(c, L::sub(L::mul(b, e), L::mul(c, d))));
+
+    const V abs_b = L::abs(b);
+    const V abs_c = L::abs(c);
+    const V abs_e = L::abs(e);
+
+    V lambda = L::min(L::sub(L::sub(a, abs_b), abs_c), L::min(L::sub(L::sub(d, abs_b), abs_e), L::sub(L::sub(f, abs_c), abs_e)));
+
+    const V tolerance = L::mul(L::set(1e-15), L::add(L::abs(trace), L::abs(lambda)));
+    const V two = L::set(2.0);
+    const V three = L::set(3.0);
+
+    typename L::mask active = L::all();
+
+    for(uint32_t iteration = 0; iteration < max_newton_iterations; ++iteration)
+    {
+        const V p = L::sub(L::mul(L::add(L::mul(L::sub(lambda, trace), lambda), c1), lambda), c0);
+        const V dp = L::add(L::mul(L::sub(L::mul(three, lambda), L::mul(two, trace)), lambda), c1);
+
+        active = L::both(active, L::gt(dp, L::set(0.0)));
+
+        const V step = L::div(p, dp);
+        lambda = L::select(active, L::sub(lambda, step), lambda);
+
+        active = L::both(active, L::gt(L::abs(step), tolerance));
+
+        if(!L::any(active))
+            break;
+    }
+
+    // rows of A - lambda I
+    const V r0x = L::sub(a, lambda), r0y = b, r0z = c;
+    const V r1x = b, r1y = L::sub(d, lambda), r1z = e;
+    const V r2x = c, r2y = e, r2z = L::sub(f, lambda);
+
+    V vx = L::sub(L::mul(r0y, r1z), L::mul(r0z, r1y));
+    V vy = L::sub(L::mul(r0z, r1x), L::mul(r0x, r1z));
+    V vz = L::sub(L::mul(r0x, r1y), L::mul(r0y, r1x));
+    V length_sqr = L::add(L::add(L::mul(vx, vx), L::mul(vy, vy)), L::mul(vz, vz));
+
+    const V wx = L::sub(L::mul(r0y, r2z), L::mul(r0z, r2y));
+    const V wy = L::sub(L::mul(r0z, r2x), L::mul(r0x, r2z));
+    const V wz = L::sub(L::mul(r0x, r2y), L::mul(r0y, r2x));
+    const V w_length_sqr = L::add(L::add(L::mul(wx, wx), L::mul(wy, wy)), L::mul(wz, wz));
+
+    typename L::mask larger = L::gt(w_length_sqr, length_sqr);
+    vx = L::select(larger, wx, vx);
+    vy = L::select(larger, wy, vy);
+    vz = L::select(larger, wz, vz);
+    length_sqr = L::select(larger, w_length_sqr, length_sqr);
+
+    const V ux = L::sub(L::mul(r1y, r2z), L::mul(r1z, r2y));
+    const V uy = L::sub(L::mul(r1z, r2x), L::mul(r1x, r2z));
+    const V uz = L::sub(L::mul(r1x, r2y), L::mul(r1y, r2x));
+    const V u_length_sqr = L::add(L::add(L::mul(ux, ux), L::mul(uy, uy)), L::mul(uz, uz));
+
+    larger = L::gt(u_length_sqr, length_sqr);
+    vx = L::select(larger, ux, vx);
+    vy = L::select(larger, uy, vy);
+    vz = L::select(larger, uz, vz);
+    length_sqr = L::select(larger, u_length_sqr, length_sqr);
+
+    // the cross products vanish if the smallest eigenvalue is not simple
+    const V trace_sqr = L::mul(trace, trace);
+    const typename L::mask unique = L::gt(length_sqr, L::mul(L::set(1e-24), L::mul(trace_sqr, trace_sqr)));
+
+    const V inverse_length = L::div(L::set(1.0), L::sqrt(L::select(unique, length_sqr, L::set(1.0))));
+    const V zero = L::set(0.0);
+
+    L::store(lambdas + index, lambda);
+    L::store(nx + index, L::select(unique, L::mul(vx, inverse_length), zero));
+    L::store(ny + index, L::select(unique, L::mul(vy, inverse_length), zero));
+    L::store(nz + index, L::select(unique, L::mul(vz, inverse_length), zero));
+}
+
+// the smallest eigenvalue is (at least) a double root: every vector orthogonal
+// to the remaining row space is an eigenvector
+vec3f degenerate_eigenvector(const normal_computation_pca::covariances &m, const size_t index, const double lambda)
+{
+    const vec3r rows[3] = {vec3r(m.xx[index] - lambda, m.xy[index], m.xz[index]), vec3r(m.xy[index], m.yy[index] - lambda, m.yz[index]),
+                           vec3r(m.xz[index], m.yz[index], m.zz[index] - lambda)};
+
+    vec3r row = rows[0];
+    for(const auto &candidate : rows)
+    {
+        if(scm::math::length_sqr(candidate) > scm::math::length_sqr(row))
+            row = candidate;
+    }
+
+    const real row_length_sqr = scm::math::length_sqr(row);
+    const real trace = m.xx[index] + m.yy[index] + m.zz[index];
+
+    // isotropic, any direction will do, the jacobi solver reports the x axis
+    if(row_length_sqr <= 1e-24 * trace * trace || row_length_sqr == 0.0)
+    {
+        return vec3f(1.f, 0.f, 0.f);
+    }
+
+    // cross with the axis least aligned with the row
+    const vec3r abs_row(std::abs(row.x), std::abs(row.y), std::abs(row.z));
+    vec3r axis(1.0, 0.0, 0.0);
+    if(abs_row.y < abs_row.x && abs_row.y <= abs_row.z)
+        axis = vec3r(0.0, 1.0, 0.0);
+    else if(abs_row.z < abs_row.x && abs_row.z < abs_row.y)
+        axis = vec3r(0.0, 0.0, 1.0);
+
+    return vec3f(scm::math::normalize(scm::math::cross(row, axis)));
+}
+
+} // namespace
+
+void normal_computation_pca::covariances::resize(const size_t size)
+{
+    xx.assign(size, 0.0);
+    xy.assign(size, 0.0);
+    xz.assign(size, 0.0);
+    yy.assign(size, 0.0);
+    yz.assign(size, 0.0);
+    zz.assign(size, 0.0);
+}
+
+void normal_computation_pca::smallest_eigenvectors(const covariances &matrices, std::vector<vec3f> &eigenvectors)
+{
+    const size_t num_matrices = matrices.xx.size();
+
+    std::vector<double> lambdas(num_matrices);
+    std::vector<double> nx(num_matrices);
+    std::vector<double> ny(num_matrices);
+    std::vector<double> nz(num_matrices);
+
+    size_t index = 0;
+
+#if defined(__AVX512F__)
+    for(; index + lanes<__m512d>::width <= num_matrices; index += lanes<__m512d>::width)
+    {
+        solve<__m512d>(matrices, index, lambdas.data(), nx.data(), ny.data(), nz.data());
+    }
+#endif
+
+#if defined(__AVX2__)
+    for(; index + lanes<__m256d>::width <= num_matrices; index += lanes<__m256d>::width)
+    {
+        solve<__m256d>(matrices, index, lambdas.data(), nx.data(), ny.data(), nz.data());
+    }
+#endif
+
+    for(; index < num_matrices; ++index)
+    {
+        solve<double>(matrices, index, lambdas.data(), nx.data(), ny.data(), nz.data());
+    }
+
+    eigenvectors.resize(num_matrices);
+
+    for(size_t i = 0; i < num_matrices; ++i)
+    {
+        if(nx[i] == 0.0 && ny[i] == 0.0 && nz[i] == 0.0)
+        {
+            eigenvectors[i] = degenerate_eigenvector(matrices, i, lambdas[i]);
+        }
+        else
+        {
+            eigenvectors[i] = vec3f(nx[i], ny[i], nz[i]);
+        }
+    }
+}
+
+bool normal_computation_pca::
+compute_covariance(const bvh &tree,
+                   const surfel_id_t target_surfel,
+                   std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours,
+                   covariances &matrices,
+                   const size_t index) const
+{
+    // same neighbourhood and centroid as normal_computation_plane_fitting
+    const uint32_t num_neighbours = std::min(nearest_neighbours.size(), size_t(number_of_neighbours_));
+    if (num_neighbours < 3) {
+        return false;
+    }
+
+    auto &bvh_nodes = tree.nodes();
+    const vec3r poi = bvh_nodes[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos();
+
+    vec3r cen = vec3r(0.0, 0.0, 0.0);
+
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        const surfel_id_t &neighbour_id = nearest_neighbours[i].first;
+        const vec3r &neighbour_pos = bvh_nodes[neighbour_id.node_idx].mem_array().read_surfel_ref(neighbour_id.surfel_idx).pos();
+        if (neighbour_pos != poi) {
+            cen += neighbour_pos;
+        }
+    }
+
+    const vec3r centroid = cen * (1.0 / (real) num_neighbours);
+
+    double xx = 0.0, xy = 0.0, xz = 0.0, yy = 0.0, yz = 0.0, zz = 0.0;
+
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        const surfel_id_t &neighbour_id = nearest_neighbours[i].first;
+        const vec3r &neighbour_pos = bvh_nodes[neighbour_id.node_idx].mem_array().read_surfel_ref(neighbour_id.surfel_idx).pos();
+        if (neighbour_pos == poi) {
+            continue;
+        }
+
+        const vec3r delta = neighbour_pos - centroid;
+        xx += delta.x * delta.x;
+        xy += delta.x * delta.y;
+        xz += delta.x * delta.z;
+        yy += delta.y * delta.y;
+        yz += delta.y * delta.z;
+        zz += delta.z * delta.z;
+    }
+
+    matrices.xx[index] = xx;
+    matrices.xy[index] = xy;
+    matrices.xz[index] = xz;
+    matrices.yy[index] = yy;
+    matrices.yz[index] = yz;
+    matrices.zz[index] = zz;
+
+    return true;
+}
+
+vec3f normal_computation_pca::
+compute_normal(const bvh &tree,
+               const surfel_id_t target_surfel,
+               std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const
+{
+    covariances matrices;
+    matrices.resize(1);
+
+    if (!compute_covariance(tree, target_surfel, nearest_neighbours, matrices, 0)) {
+        return vec3f(0.0, 0.0, 0.0);
+    }
+
+    std::vector<vec3f> normals;
+    smallest_eigenvectors(matrices, normals);
+
+    return normals[0];
+}
+
+void normal_computation_pca::
+compute_normals(const bvh &tree,
+                const node_id_type node_id,
+                std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                std::vector<vec3f> &normals) const
+{
+    const size_t num_surfels = nearest_neighbours.size();
+
+    covariances matrices;
+    matrices.resize(num_surfels);
+
+    std::vector<bool> valid(num_surfels);
+    for (size_t i = 0; i < num_surfels; ++i) {
+        valid[i] = compute_covariance(tree, surfel_id_t(node_id, i), nearest_neighbours[i], matrices, i);
+    }
+
+    smallest_eigenvectors(matrices, normals);
+
+    for (size_t i = 0; i < num_surfels; ++i) {
+        if (!valid[i]) {
+            normals[i] = vec3f(0.0, 0.0, 0.0);
+        }
+    }
+}
+
+}// namespace pre
+}// namespace lamure
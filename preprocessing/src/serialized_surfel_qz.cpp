@@ -0,0 +1,121 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/serialized_surfel_qz.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lamure
+{
+namespace pre
+{
+
+// The layout follows point_cloud_compression_app, the renderer decodes
+// against the single precision node attributes stored in the .bvhqz.
+
+void serialized_surfel_qz::
+set_surfel(const surfel &surfel,
+           const bounding_box &node_extents,
+           const real avg_surfel_radius,
+           const real max_surfel_radius_deviation)
+{
+    data_ = {{0u, 0u, 0u}, 0u, 0u};
+
+    quantize_position(surfel, node_extents);
+    quantize_radius(surfel, float(avg_surfel_radius), float(max_surfel_radius_deviation));
+    quantize_color(surfel);
+    quantize_normal(surfel);
+}
+
+void serialized_surfel_qz::
+quantize_position(const surfel &surfel, const bounding_box &node_extents)
+{
+    const double num_steps = 65536.0;
+
+    for (int dim_idx = 0; dim_idx < 3; ++dim_idx) {
+        const double min_vertex = float(node_extents.min()[dim_idx]);
+        const double range = float(node_extents.max()[dim_idx]) - min_vertex;
+        const double step = range / num_steps;
+
+        int32_t index = 0;
+        if (step > 0.0)
+            index = int32_t(std::round((double(float(surfel.pos()[dim_idx])) - min_vertex) / step));
+
+        data_.pos[dim_idx] = uint16_t(std::min(int32_t(std::numeric_limits<uint16_t>::max()), std::max(0, index)));
+    }
+}
+
+void serialized_surfel_qz::
+quantize_radius(const surfel &surfel, const float avg_surfel_radius, const float max_surfel_radius_deviation)
+{
+    const uint32_t max_quantization_idx = 1u << 11;
+    const uint32_t half_range_minus_one = max_quantization_idx / 2 - 1;
+    const float radius = float(surfel.radius());
+
+    uint32_t quantized_radius = 0;
+
+    if (radius == 0.f) {
+        // marks invalid surfels
+        quantized_radius = max_quantization_idx - 1;
+    }
+    else if (max_surfel_radius_deviation <= 0.f) {
+        quantized_radius = half_range_minus_one;
+    }
+    else {
+        // subtracted in single precision, as in point_cloud_compression_app
+        const double reference_min_radius = avg_surfel_radius - max_surfel_radius_deviation;
+        const double normalized_radius = (double(radius) - reference_min_radius) / (2.0 * max_surfel_radius_deviation);
+        const int32_t index = int32_t(std::round(normalized_radius * half_range_minus_one * 2));
+        quantized_radius = uint32_t(std::min(int32_t(half_range_minus_one * 2), std::max(0, index)));
+    }
+
+    data_.color_777_radius_11 = (data_.color_777_radius_11 & 0xFFFFF800) | quantized_radius;
+}
+
+void serialized_surfel_qz::
+quantize_color(const surfel &surfel)
+{
+    const uint32_t r7 = std::min(127, int32_t(std::round(surfel.color().x / 2.0)));
+    const uint32_t g7 = std::min(127, int32_t(std::round(surfel.color().y / 2.0)));
+    const uint32_t b7 = std::min(127, int32_t(std::round(surfel.color().z / 2.0)));
+
+    const uint32_t color = (r7 << 14) | (g7 << 7) | b7;
+
+    data_.color_777_radius_11 = (data_.color_777_radius_11 & 0x7FF) | (color << 11);
+}
+
+void serialized_surfel_qz::
+quantize_normal(const surfel &surfel)
+{
+    // 104 * 105 positions per face, 6 * 104 * 105 is slightly less than 2^16
+    const int32_t face_positions_u = 104;
+    const int32_t face_positions_v = 105;
+
+    const vec3f &normal = surfel.normal();
+
+    int32_t dominant_axis = 0;
+    for (int32_t dim_idx = 1; dim_idx < 3; ++dim_idx) {
+        if (std::fabs(normal[dim_idx]) > std::fabs(normal[dominant_axis]))
+            dominant_axis = dim_idx;
+    }
+
+    // faces: +x = 0, -x = 1, +y = 2, -y = 3, +z = 4, -z = 5
+    const int32_t face_idx = dominant_axis * 2 + (normal[dominant_axis] < 0.f ? 1 : 0);
+
+    const double u = (double(normal[(dominant_axis + 1) % 3]) + 1.0) / 2.0;
+    const double v = (double(normal[(dominant_axis + 2) % 3]) + 1.0) / 2.0;
+
+    const int32_t offset_u = std::min(face_positions_u, std::max(0, int32_t(std::round(u * face_positions_u))));
+    const int32_t offset_v = std::min(face_positions_v, std::max(0, int32_t(std::round(v * face_positions_v))));
+
+    data_.normal = uint16_t(face_idx * face_positions_u * face_positions_v + offset_v * face_positions_u + offset_u);
+}
+
+}
+} // namespace lamure
@@ -0,0 +1,167 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/work_stealing_pool.h>
+
+#include <algorithm>
+
+namespace lamure
+{
+namespace pre
+{
+namespace
+{
+// pool and queue of the calling thread, if it is a worker
+thread_local const work_stealing_pool *current_pool = nullptr;
+thread_local uint32_t current_worker = 0;
+} // namespace
+
+work_stealing_pool::work_stealing_pool(const uint32_t num_threads) : num_queued_(0), num_pending_(0), shutdown_(false)
+{
+    const uint32_t num_workers = std::max(num_threads, 1u);
+
+    for(uint32_t worker_index = 0; worker_index < num_workers; ++worker_index)
+    {
+        queues_.emplace_back(new worker_queue);
+    }
+
+    for(uint32_t worker_index = 0; worker_index < num_workers; ++worker_index)
+    {
+        threads_.push_back(std::thread(&work_stealing_pool::run, this, worker_index));
+    }
+}
+
+work_stealing_pool::~work_stealing_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    task_available_.notify_all();
+
+    for(auto &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void work_stealing_pool::submit(task new_task)
+{
+    uint32_t queue_index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // tasks from outside are spread over the queues
+        queue_index = current_pool == this ? current_worker : num_pending_ % queues_.size();
+        ++num_queued_;
+        ++num_pending_;
+    }
+
+    {
+        worker_queue &queue = *queues_[queue_index];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        queue.tasks_.push_front(std::move(new_task));
+    }
+    task_available_.notify_one();
+}
+
+void work_stealing_pool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    all_done_.wait(lock, [this] { return num_pending_ == 0; });
+
+    if(exception_)
+    {
+        std::exception_ptr exception = exception_;
+        exception_ = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+bool work_stealing_pool::pop(const uint32_t worker_index, task &next_task)
+{
+    {
+        worker_queue &queue = *queues_[worker_index];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if(!queue.tasks_.empty())
+        {
+            next_task = std::move(queue.tasks_.front());
+            queue.tasks_.pop_front();
+            return true;
+        }
+    }
+
+    for(uint32_t offset = 1; offset < queues_.size(); ++offset)
+    {
+        worker_queue &queue = *queues_[(worker_index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if(!queue.tasks_.empty())
+        {
+            next_task = std::move(queue.tasks_.back());
+            queue.tasks_.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void work_stealing_pool::run(const uint32_t worker_index)
+{
+    current_pool = this;
+    current_worker = worker_index;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_available_.wait(lock, [this] { return num_queued_ > 0 || shutdown_; });
+            if(num_queued_ == 0)
+            {
+                return;
+            }
+        }
+
+        // the counter is raised before the task is queued, it may not be visible yet
+        task next_task;
+        if(!pop(worker_index, next_task))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --num_queued_;
+        }
+
+        try
+        {
+            next_task();
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!exception_)
+            {
+                exception_ = std::current_exception();
+            }
+        }
+
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done = --num_pending_ == 0;
+        }
+        if(done)
+        {
+            all_done_.notify_all();
+        }
+    }
+}
+
+} // namespace pre
+} // namespace lamure
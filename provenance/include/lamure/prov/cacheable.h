@@ -13,6 +13,8 @@
 #include <lamure/prov/point.h>
 #include <lamure/prov/cacheable.h>
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
 namespace lamure {
 namespace prov
 {
@@ -47,6 +49,9 @@ class Cacheable : public Readable
         // if(DEBUG)
         //             printf("\nPoints meta data length: %i ", meta_data_length);
 
+        _points.reserve(_points.size() + points_length);
+        _points_metadata.reserve(_points_metadata.size() + points_length);
+
         for(uint32_t i = 0; i < points_length; i++)
         {
             TPoint point = TPoint();
@@ -59,6 +64,66 @@ class Cacheable : public Readable
         }
     }
 
+    // Decodes the points of files mapped into memory in parallel chunks, returns the offsets of the first bytes after the points
+    pair<uint64_t, uint64_t> cache_points(const char *data_prov, uint64_t size_prov, const char *data_meta, uint64_t size_meta)
+    {
+        if(size_prov < HEADER_LENGTH + 8)
+        {
+            throw std::out_of_range("Points length is missing");
+        }
+
+        uint32_t points_length = read_swapped<uint32_t>(data_prov + HEADER_LENGTH, true);
+        uint32_t meta_data_length = read_swapped<uint32_t>(data_prov + HEADER_LENGTH + 4, true);
+
+        if((size_meta - HEADER_LENGTH) / std::max(meta_data_length, 1u) < points_length)
+        {
+            throw std::out_of_range("Meta data is shorter than declared by the points");
+        }
+
+        // Points may differ in length, so find where each chunk starts before decoding the chunks in parallel
+        const uint32_t chunk_length = 1 << 16;
+        vec<uint64_t> chunk_offsets;
+        chunk_offsets.reserve(points_length / chunk_length + 2);
+
+        uint64_t offset = HEADER_LENGTH + 8;
+        for(uint32_t i = 0; i < points_length; i++)
+        {
+            if(i % chunk_length == 0)
+            {
+                chunk_offsets.push_back(offset);
+            }
+
+            uint64_t entity_length = TPoint::get_entity_length(data_prov + offset, size_prov - offset);
+            if(entity_length == 0)
+            {
+                throw std::out_of_range("Points are shorter than declared");
+            }
+            offset += entity_length;
+        }
+
+        size_t first_point = _points.size();
+        _points.resize(first_point + points_length);
+        _points_metadata.resize(first_point + points_length);
+
+        int64_t num_chunks = (int64_t)chunk_offsets.size();
+
+#pragma omp parallel for schedule(dynamic)
+        for(int64_t chunk = 0; chunk < num_chunks; chunk++)
+        {
+            uint64_t begin = (uint64_t)chunk * chunk_length;
+            uint64_t end = std::min((uint64_t)points_length, begin + chunk_length);
+            const char *point_data = data_prov + chunk_offsets[chunk];
+
+            for(uint64_t i = begin; i < end; i++)
+            {
+                point_data = _points[first_point + i].read(point_data);
+                _points_metadata[first_point + i].read_metadata(data_meta + HEADER_LENGTH + (uint64_t)meta_data_length * i, meta_data_length);
+            }
+        }
+
+        return pair<uint64_t, uint64_t>(offset, HEADER_LENGTH + (uint64_t)meta_data_length * points_length);
+    }
+
     const vec<TPoint> &get_points() const { return _points; }
     const vec<TMetaData> &get_points_metadata() const { return _points_metadata; }
     virtual void cache()
@@ -68,6 +133,23 @@ class Cacheable : public Readable
 
         cache_points();
     }
+    // Same as cache, but maps the files into memory instead of reading the streams point by point
+    virtual void cache_mapped(const string &name_file_prov, const string &name_file_meta)
+    {
+        boost::iostreams::mapped_file_source file_prov(name_file_prov);
+        boost::iostreams::mapped_file_source file_meta(name_file_meta);
+
+        read_header(file_prov.data(), file_prov.size());
+        read_header(file_meta.data(), file_meta.size());
+
+        pair<uint64_t, uint64_t> end_offsets = cache_points(file_prov.data(), file_prov.size(), file_meta.data(), file_meta.size());
+
+        // Leave the streams where cache would have left them, so further data can be read from them
+        (*is_prov).clear();
+        (*is_prov).seekg(end_offsets.first);
+        (*is_meta).clear();
+        (*is_meta).seekg(end_offsets.second);
+    }
 
   protected:
     ifstream *is_prov, *is_meta;
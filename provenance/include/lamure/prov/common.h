@@ -17,6 +17,7 @@
 #include <boost/serialization/vector.hpp>
 #include <boost/sort/spreadsort/float_sort.hpp>
 #include <boost/sort/spreadsort/spreadsort.hpp>
+#include <cstring>
 #include <fstream>
 #include <lamure/prov/3rd_party/exif.h>
 #include <lamure/prov/3rd_party/pdqsort.h>
@@ -91,6 +92,14 @@ T swap(const T &arg, bool big_in_mem)
     }
 }
 
+template <typename T>
+T read_swapped(const char *data, bool big_in_mem)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return swap(value, big_in_mem);
+}
+
 static inline std::string &ltrim(std::string &s)
 {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun<int, int>(std::isspace))));
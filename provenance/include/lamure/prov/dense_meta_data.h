@@ -27,53 +27,12 @@ class DenseMetaData : public MetaData
     virtual void read_metadata(ifstream &is, uint32_t meta_data_length) override
     {
         MetaData::read_metadata(is, meta_data_length);
-
-        uint32_t data_pointer = 0;
-
-        float buffer = 0;
-        memcpy(&buffer, &_metadata[data_pointer], 4);
-        _photometric_consistency = (float)swap(buffer, true);
-        data_pointer += 4;
-
-        // printf("\nNCC: %f", _photometric_consistency);
-
-        uint32_t num_seen = 0;
-        memcpy(&num_seen, &_metadata[data_pointer], 4);
-        num_seen = swap(num_seen, true);
-        data_pointer += 4;
-
-        // printf("\nNum seen: %i", num_seen);
-
-        for(uint32_t i = 0; i < num_seen; i++)
-        {
-            uint32_t image_seen = 0;
-            memcpy(&image_seen, &_metadata[data_pointer], 4);
-            image_seen = swap(image_seen, true);
-            data_pointer += 4;
-
-            //            printf("\nImage seen: %i", image_seen);
-
-            _images_seen.push_back(image_seen);
-        }
-
-        uint32_t num_not_seen = 0;
-        memcpy(&num_not_seen, &_metadata[data_pointer], 4);
-        num_not_seen = swap(num_not_seen, true);
-        data_pointer += 4;
-
-        // printf("\nNum not seen: %i", num_not_seen);
-
-        for(uint32_t i = 0; i < num_not_seen; i++)
-        {
-            uint32_t image_not_seen = 0;
-            memcpy(&image_not_seen, &_metadata[data_pointer], 4);
-            image_not_seen = swap(image_not_seen, true);
-            data_pointer += 4;
-
-            //            printf("\nImage not seen: %i", image_not_seen);
-
-            _images_not_seen.push_back(image_not_seen);
-        }
+        parse_metadata();
+    }
+    virtual void read_metadata(const char *data, uint32_t meta_data_length) override
+    {
+        MetaData::read_metadata(data, meta_data_length);
+        parse_metadata();
     }
 
     float get_photometric_consistency() const { return _photometric_consistency; }
@@ -93,6 +52,43 @@ class DenseMetaData : public MetaData
     }
 
   private:
+    void parse_metadata()
+    {
+        // Layout: photometric consistency, number and indices of images seen, number and indices of images not seen
+        uint32_t data_pointer = 0;
+        uint32_t data_length = (uint32_t)_metadata.size();
+
+        if(data_length < 4)
+        {
+            return;
+        }
+
+        _photometric_consistency = read_swapped<float>(&_metadata[data_pointer], true);
+        data_pointer += 4;
+
+        read_image_indices(_images_seen, data_pointer, data_length);
+        read_image_indices(_images_not_seen, data_pointer, data_length);
+    }
+    void read_image_indices(vec<uint32_t> &image_indices, uint32_t &data_pointer, uint32_t data_length)
+    {
+        if(data_length - data_pointer < 4)
+        {
+            return;
+        }
+
+        uint32_t num_images = read_swapped<uint32_t>(&_metadata[data_pointer], true);
+        data_pointer += 4;
+
+        num_images = std::min(num_images, (data_length - data_pointer) / 4);
+        image_indices.resize(num_images);
+
+        for(uint32_t i = 0; i < num_images; i++)
+        {
+            image_indices[i] = read_swapped<uint32_t>(&_metadata[data_pointer], true);
+            data_pointer += 4;
+        }
+    }
+
     float _photometric_consistency;
     vec<uint32_t> _images_seen;
     vec<uint32_t> _images_not_seen;
@@ -37,6 +37,19 @@ class DensePoint : public Point
 
         return is;
     }
+    const char *read(const char *data)
+    {
+        data = read_essentials(data);
+
+        for(int i = 0; i < 3; i++)
+        {
+            _normal[i] = read_swapped<float>(data + 4 * i, true);
+        }
+
+        return data + 12;
+    }
+    // Length of the point at the given position in a provenance file, 0 if it exceeds the available bytes
+    static uint64_t get_entity_length(const char *data, uint64_t available) { return available < 36 ? 0 : 36; }
     static const uint32_t ENTITY_LENGTH = 72;
 
   protected:
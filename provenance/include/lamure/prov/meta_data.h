@@ -24,6 +24,7 @@ class MetaData
         _metadata = vec<char>(meta_data_length, 0);
         is.read(&_metadata[0], meta_data_length);
     }
+    virtual void read_metadata(const char *data, uint32_t meta_data_length) { _metadata = vec<char>(data, data + meta_data_length); }
 
   protected:
     vec<char> _metadata;
@@ -50,6 +50,16 @@ class Point
 
         return is;
     }
+    const char *read_essentials(const char *data)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            _position[i] = read_swapped<float>(data + 4 * i, true);
+            _color[i] = read_swapped<float>(data + 12 + 4 * i, true);
+        }
+
+        return data + 24;
+    }
 
   protected:
     vec3f _position;
@@ -72,6 +72,35 @@ class Readable
 
         return true;
     }
+
+    // Checks the header of a file mapped into memory, the data starts at HEADER_LENGTH
+    static bool read_header(const char *data, uint64_t size)
+    {
+        if(size < HEADER_LENGTH)
+        {
+            throw std::out_of_range("Readable is shorter than its header");
+        }
+
+        uint16_t magic_bytes = read_swapped<uint16_t>(data, true);
+        if(magic_bytes != 0xAFFE)
+        {
+            std::stringstream sstr;
+            sstr << "0x" << std::uppercase << std::hex << magic_bytes;
+            throw std::runtime_error("File format is incompatible: magic bytes " + sstr.str() + " not equal 0xAFFE");
+        }
+
+        uint64_t data_length = read_swapped<uint64_t>(data + 2, true);
+        if(size - HEADER_LENGTH != data_length)
+        {
+            std::stringstream istr;
+            istr << size - HEADER_LENGTH;
+            std::stringstream dstr;
+            dstr << data_length;
+            throw std::out_of_range("Readable length not equal to declared: " + istr.str() + " instead of " + dstr.str());
+        }
+
+        return true;
+    }
 };
 }
 }
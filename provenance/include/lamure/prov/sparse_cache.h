@@ -34,6 +34,16 @@ class SparseCache : public Cacheable<SparsePoint, MetaData>
         cache_cameras(true, "");
     }
 
+    void cache_mapped(const string& name_file_prov, const string& name_file_meta, bool load_images, const std::string& fotos_directory) {
+        Cacheable::cache_mapped(name_file_prov, name_file_meta);
+        cache_cameras(load_images, fotos_directory);
+    }
+
+    void cache_mapped(const string& name_file_prov, const string& name_file_meta) override {
+        Cacheable::cache_mapped(name_file_prov, name_file_meta);
+        cache_cameras(true, "");
+    }
+
 
     const vec<prov::Camera> get_cameras() const { return _cameras; }
     const vec<prov::MetaData> get_cameras_metadata() const { return _cameras_metadata; }
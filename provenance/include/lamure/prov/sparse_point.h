@@ -46,6 +46,14 @@ class SparsePoint : public Point
 
             return is;
         }
+        const char *read(const char *data)
+        {
+            _camera_index = read_swapped<uint16_t>(data, true);
+            _occurence.x = read_swapped<float>(data + 2, true);
+            _occurence.y = read_swapped<float>(data + 6, true);
+
+            return data + 10;
+        }
 
       private:
         uint16_t _camera_index;
@@ -87,6 +95,34 @@ class SparsePoint : public Point
         return is;
     }
 
+    const char *read(const char *data)
+    {
+        _index = read_swapped<uint32_t>(data, true);
+        data = read_essentials(data + 4);
+
+        uint16_t measurements_length = read_swapped<uint16_t>(data, true);
+        data += 2;
+
+        _measurements.resize(measurements_length);
+        for(uint16_t i = 0; i < measurements_length; i++)
+        {
+            data = _measurements[i].read(data);
+        }
+
+        return data;
+    }
+    // Length of the point at the given position in a provenance file, 0 if it exceeds the available bytes
+    static uint64_t get_entity_length(const char *data, uint64_t available)
+    {
+        if(available < 30)
+        {
+            return 0;
+        }
+
+        uint64_t length = 30 + 10 * (uint64_t)read_swapped<uint16_t>(data + 28, true);
+        return available < length ? 0 : length;
+    }
+
     uint32_t get_index() const { return _index; }
 
   protected:
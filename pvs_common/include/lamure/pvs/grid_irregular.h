@@ -66,6 +66,9 @@ public:
 	const view_cell* get_original_cell_at_position(const scm::math::vec3d& position, size_t* cell_index) const;
 	bool is_cell_at_index_original(const size_t& index) const;
 
+	// Index of the view cell that currently represents the given original cell (either the cell itself or the managing cell it was joined into).
+	size_t get_cell_index_of_original_cell(const size_t& original_index) const;
+
 protected:
 	void create_grid(const size_t& number_cells_x, const size_t& number_cells_y, const size_t& number_cells_z, const double& cell_size, const scm::math::vec3d& position_center);
 
@@ -100,6 +103,9 @@ protected:
 	// If an original cell is not active, it was joined and is part of a managing vew cell. The key is the original view cell index, the value the index of the proper managing view cell.
 	std::map<size_t, size_t> original_index_to_cell_mapping_;
 
+	// Current view cell index of each original cell, updated along with the index access.
+	std::vector<size_t> cell_indices_of_original_cells_;
+
 	std::vector<node_t> ids_;
 
 	mutable std::mutex mutex_;
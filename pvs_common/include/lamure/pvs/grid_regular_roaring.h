@@ -0,0 +1,59 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef LAMURE_PVS_REGULAR_GRID_ROARING_H
+#define LAMURE_PVS_REGULAR_GRID_ROARING_H
+
+#include <lamure/pvs/pvs.h>
+#include "lamure/pvs/grid_regular.h"
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace lamure
+{
+namespace pvs
+{
+
+// Regular grid which stores the visibility of each view cell as compressed bitmaps (see roaring_bitmap).
+// The visibility file starts with the number of cells and models, followed by the file offsets of all cell blocks,
+// so a single cell is decoded straight from the memory mapped file without touching the others.
+class PVS_COMMON_DLL grid_regular_roaring : public grid_regular
+{
+public:
+	grid_regular_roaring();
+	grid_regular_roaring(const size_t& number_cells, const double& cell_size, const scm::math::vec3d& position_center, const std::vector<node_t>& ids);
+	~grid_regular_roaring();
+
+	virtual std::string get_grid_type() const;
+	static std::string get_grid_identifier();
+
+	virtual void save_grid_to_file(const std::string& file_path) const;
+	virtual void save_visibility_to_file(const std::string& file_path) const;
+
+	virtual bool load_grid_from_file(const std::string& file_path);
+	virtual bool load_visibility_from_file(const std::string& file_path);
+
+	virtual bool load_cell_visibility_from_file(const std::string& file_path, const size_t& cell_index);
+
+protected:
+	void create_roaring_cells();
+
+	bool map_visibility_file(const std::string& file_path);
+	void unmap_visibility_file() const;
+	bool decode_cell_visibility(const size_t& cell_index);
+
+	mutable boost::iostreams::mapped_file_source visibility_file_;
+	mutable std::string visibility_file_path_;
+
+	// File offsets of the cell blocks, the last entry marks the end of the last block.
+	mutable std::vector<uint64_t> visibility_block_offsets_;
+};
+
+}
+}
+
+#endif
@@ -8,12 +8,15 @@
 #ifndef LAMURE_PVS_PVS_DATABASE_H
 #define LAMURE_PVS_PVS_DATABASE_H
 
+#include <atomic>
+#include <deque>
+#include <list>
+#include <map>
 #include <set>
 #include <string>
 #include <thread>
 #include <vector>
 #include <mutex>
-#include <queue>
 
 #include <lamure/pvs/pvs.h>
 #include "lamure/pvs/grid.h"
@@ -49,6 +52,22 @@ public:
 	const grid* get_bounding_grid() const;
 	void clear_visibility_grid();
 
+	// Loaded view cells are kept until their visibility data exceeds the budget, then the least recently used ones are released.
+	// Cells around the viewer are never released.
+	void set_memory_budget(const size_t& budget_in_bytes);
+	size_t get_memory_budget() const;
+	size_t get_memory_usage() const;
+
+	// Visibility requests answered from loaded data (hits) or answered with true since the data of the viewer cell was missing (misses).
+	uint64_t get_num_visibility_hits() const;
+	uint64_t get_num_visibility_misses() const;
+
+	// Cells whose visibility data was already loaded when the viewer entered them (hits) and cells that were entered before (misses).
+	uint64_t get_num_cell_hits() const;
+	uint64_t get_num_cell_misses() const;
+
+	void reset_statistics();
+
 protected:
 	pvs_database();
 
@@ -57,7 +76,13 @@ protected:
 private:
 	void loading_thread_loop();
 	void load_visibility_data_async(uint64_t cell_index);
-	std::queue<uint64_t> loading_queue_;
+	std::set<size_t> request_cells_around(const view_cell* cell, const scm::math::vec3d& motion_direction);
+	void touch_cell(const size_t& cell_index);
+	void evict_cells();
+
+	// Cells to load, the viewer cell first, followed by the cells along the motion direction and the remaining neighbours.
+	std::deque<uint64_t> loading_queue_;
+	std::set<uint64_t> loading_cell_indices_;
 	semaphore semaphore_;
 
 	// Grid storing the major visibility data of the scene.
@@ -80,9 +105,25 @@ private:
 	std::string pvs_file_path_;
 
 	scm::math::vec3d smallest_cell_size_;
-	std::set<size_t> previously_loaded_cell_indices_;
 
-	std::thread visibility_data_loading_thread_;
+	// Cells around the viewer, which are never released.
+	std::set<size_t> pinned_cell_indices_;
+
+	// Loaded cells, most recently used first.
+	std::list<size_t> loaded_cells_;
+	std::map<size_t, std::list<size_t>::iterator> loaded_cell_iterators_;
+	size_t cell_visibility_bytes_;
+	size_t memory_budget_;
+
+	// Number of cells along the motion direction that are prefetched.
+	size_t num_prefetched_cells_along_motion_;
+
+	mutable std::atomic<uint64_t> num_visibility_hits_;
+	mutable std::atomic<uint64_t> num_visibility_misses_;
+	std::atomic<uint64_t> num_cell_hits_;
+	std::atomic<uint64_t> num_cell_misses_;
+
+	std::vector<std::thread> visibility_data_loading_threads_;
 
 	// Used to achieve thread safety.
 	mutable std::mutex mutex_;
@@ -0,0 +1,76 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef LAMURE_PVS_ROARING_BITMAP_H
+#define LAMURE_PVS_ROARING_BITMAP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <lamure/pvs/pvs.h>
+#include <lamure/types.h>
+
+#include <boost/dynamic_bitset.hpp>
+
+namespace lamure
+{
+namespace pvs
+{
+
+// Compressed set of node ids, split into chunks of 2^16 ids.
+// Each chunk is stored as a sorted array of ids, as a plain bitmap or as runs of consecutive ids, whichever is smallest.
+// Chunks are addressed directly by the upper bits of the id, so a lookup touches a single container.
+class PVS_COMMON_DLL roaring_bitmap
+{
+public:
+	roaring_bitmap();
+	roaring_bitmap(const boost::dynamic_bitset<>& bitset);
+	~roaring_bitmap();
+
+	bool contains(const node_t& node_id) const;
+	bool empty() const;
+
+	size_t get_cardinality() const;
+	std::vector<node_t> get_indices() const;
+	boost::dynamic_bitset<> get_bitset(const size_t& num_bits) const;
+
+	// Memory used by the containers.
+	size_t get_byte_size() const;
+
+	// Appends the binary representation to the given string.
+	void serialize(std::string& output) const;
+
+	// Reads the binary representation and returns the number of bytes used, or 0 if the data is invalid.
+	size_t deserialize(const char* data, const size_t& data_size);
+
+private:
+	enum container_type : uint32_t
+	{
+		CONTAINER_EMPTY = 0,
+		CONTAINER_ARRAY = 1,
+		CONTAINER_BITMAP = 2,
+		CONTAINER_RUN = 3
+	};
+
+	struct container
+	{
+		uint32_t type;
+
+		// Position and number of 16 bit words in the data.
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	std::vector<container> containers_;
+	std::vector<uint16_t> data_;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,63 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef LAMURE_PVS_VIEW_CELL_REGULAR_ROARING_H
+#define LAMURE_PVS_VIEW_CELL_REGULAR_ROARING_H
+
+#include <vector>
+#include <map>
+
+#include <lamure/pvs/pvs.h>
+#include "lamure/pvs/view_cell_regular.h"
+#include "lamure/pvs/roaring_bitmap.h"
+
+namespace lamure
+{
+namespace pvs
+{
+
+// Keeps visibility loaded from file as compressed bitmaps.
+// Writing visibility (e.g. during generation or conversion) falls back to the uncompressed bitsets of the regular view cell.
+class PVS_COMMON_DLL view_cell_regular_roaring : public view_cell_regular
+{
+public:
+	view_cell_regular_roaring();
+	view_cell_regular_roaring(const double& cell_size, const scm::math::vec3d& position_center);
+	~view_cell_regular_roaring();
+
+	virtual std::string get_cell_type() const;
+	static std::string get_cell_identifier();
+
+	virtual void set_visibility(const model_t& object_id, const node_t& node_id, const bool& visible);
+	virtual bool get_visibility(const model_t& object_id, const node_t& node_id) const;
+
+	virtual bool contains_visibility_data() const;
+	virtual std::map<model_t, std::vector<node_t>> get_visible_indices() const;
+	virtual void clear_visibility_data();
+
+	virtual boost::dynamic_bitset<> get_bitset(const model_t& object_id) const;
+	virtual void set_bitset(const model_t& object_id, const boost::dynamic_bitset<>& bitset);
+
+	void set_compressed_visibility(std::vector<roaring_bitmap> compressed_visibility, const std::vector<node_t>& ids);
+	const std::vector<roaring_bitmap>& get_compressed_visibility() const;
+
+	// Memory used by the compressed visibility data.
+	size_t get_compressed_byte_size() const;
+
+private:
+	void decompress();
+
+	std::vector<roaring_bitmap> compressed_visibility_;
+
+	// Number of nodes per model, required to restore the bitsets.
+	std::vector<node_t> ids_;
+};
+
+}
+}
+
+#endif
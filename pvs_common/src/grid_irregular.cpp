@@ -519,10 +519,7 @@ create_grid(const size_t& number_cells_x, const size_t& number_cells_y, const si
 		}
 	}
 
-	for(size_t original_cell_index = 0; original_cell_index < original_cells_.size(); ++original_cell_index)
-	{
-		cells_by_indices_.push_back(&original_cells_[original_cell_index]);
-	}
+	this->compute_index_access();
 
 	number_cells_x_ = number_cells_x;
 	number_cells_y_ = number_cells_y;
@@ -549,19 +546,29 @@ void grid_irregular::
 compute_index_access()
 {
 	cells_by_indices_.clear();
+	cell_indices_of_original_cells_.resize(original_cells_.size());
 
 	for(size_t original_cell_index = 0; original_cell_index < original_cells_.size(); ++original_cell_index)
 	{
 		if(cells_active_states_[original_cell_index])
 		{
+			cell_indices_of_original_cells_[original_cell_index] = cells_by_indices_.size();
 			cells_by_indices_.push_back(&original_cells_[original_cell_index]);
 		}
 	}
 
+	size_t num_active_original_cells = cells_by_indices_.size();
+
 	for(size_t managing_cell_index = 0; managing_cell_index < managing_cells_.size(); ++managing_cell_index)
 	{
 		cells_by_indices_.push_back(&managing_cells_[managing_cell_index]);
 	}
+
+	// Managing cells follow the active original cells.
+	for(std::map<size_t, size_t>::const_iterator iter = original_index_to_cell_mapping_.begin(); iter != original_index_to_cell_mapping_.end(); ++iter)
+	{
+		cell_indices_of_original_cells_[iter->first] = num_active_original_cells + iter->second;
+	}
 }
 
 size_t grid_irregular::
@@ -763,7 +770,10 @@ join_cells(const size_t& index_one, const size_t& index_two, const float& error,
 	}
 
 	// Keep indices for access up to date.
-	this->compute_index_access();
+	if(result)
+	{
+		this->compute_index_access();
+	}
 
 	return result;
 }
@@ -816,6 +826,12 @@ is_cell_at_index_original(const size_t& index) const
 	return cells_by_indices_[index]->get_cell_type() == view_cell_regular::get_cell_identifier();
 }
 
+size_t grid_irregular::
+get_cell_index_of_original_cell(const size_t& original_index) const
+{
+	return cell_indices_of_original_cells_[original_index];
+}
+
 size_t grid_irregular::
 get_original_index_of_cell(const view_cell* cell) const
 {
@@ -613,7 +613,7 @@ load_cell_visibility_from_file(const std::string& file_path, const size_t& cell_
 void grid_octree::
 clear_cell_visibility(const size_t& cell_index)
 {
-	if(this->get_num_models() <= cell_index)
+	if(this->get_cell_count() <= cell_index)
 	{
 		return;
 	}
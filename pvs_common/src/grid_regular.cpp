@@ -354,7 +354,7 @@ load_visibility_from_file(const std::string& file_path)
 void grid_regular::
 clear_cell_visibility(const size_t& cell_index)
 {
-	if(this->get_num_models() <= cell_index)
+	if(this->get_cell_count() <= cell_index)
 	{
 		return;
 	}
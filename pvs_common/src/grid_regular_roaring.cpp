@@ -0,0 +1,284 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include "lamure/pvs/grid_regular_roaring.h"
+#include "lamure/pvs/view_cell_regular_roaring.h"
+#include "lamure/pvs/roaring_bitmap.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace lamure
+{
+namespace pvs
+{
+
+grid_regular_roaring::
+grid_regular_roaring() : grid_regular_roaring(1, 1.0, scm::math::vec3d(0.0, 0.0, 0.0), std::vector<node_t>())
+{
+}
+
+grid_regular_roaring::
+grid_regular_roaring(const size_t& number_cells, const double& cell_size, const scm::math::vec3d& position_center, const std::vector<node_t>& ids) : grid_regular(number_cells, cell_size, position_center, ids)
+{
+	create_roaring_cells();
+}
+
+grid_regular_roaring::
+~grid_regular_roaring()
+{
+	unmap_visibility_file();
+}
+
+std::string grid_regular_roaring::
+get_grid_type() const
+{
+	return get_grid_identifier();
+}
+
+std::string grid_regular_roaring::
+get_grid_identifier()
+{
+	return "regular_roaring";
+}
+
+void grid_regular_roaring::
+create_roaring_cells()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// The regular grid creates regular view cells, replace them by cells able to hold compressed visibility.
+	for(size_t cell_index = 0; cell_index < cells_.size(); ++cell_index)
+	{
+		view_cell_regular* regular_cell = cells_[cell_index];
+		cells_[cell_index] = new view_cell_regular_roaring(cell_size_, regular_cell->get_position_center());
+		delete regular_cell;
+	}
+}
+
+void grid_regular_roaring::
+save_grid_to_file(const std::string& file_path) const
+{
+	save_regular_grid(file_path, get_grid_identifier());
+}
+
+void grid_regular_roaring::
+save_visibility_to_file(const std::string& file_path) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// The file may be the one currently mapped.
+	unmap_visibility_file();
+
+	std::fstream file_out;
+	file_out.open(file_path, std::ios::out | std::ios::binary);
+
+	if(!file_out.is_open())
+	{
+		throw std::invalid_argument("invalid file path: " + file_path);
+	}
+
+	uint64_t num_cells = cells_.size();
+	uint64_t num_models = ids_.size();
+	file_out.write(reinterpret_cast<char*>(&num_cells), sizeof(num_cells));
+	file_out.write(reinterpret_cast<char*>(&num_models), sizeof(num_models));
+
+	// Reserve the offset table, it is written once all block sizes are known.
+	std::vector<uint64_t> block_offsets(cells_.size() + 1, 0);
+	uint64_t offset_table_position = file_out.tellp();
+	file_out.write(reinterpret_cast<char*>(&block_offsets[0]), block_offsets.size() * sizeof(uint64_t));
+
+	block_offsets[0] = offset_table_position + block_offsets.size() * sizeof(uint64_t);
+
+	for(size_t cell_index = 0; cell_index < cells_.size(); ++cell_index)
+	{
+		const view_cell_regular_roaring* current_cell = static_cast<const view_cell_regular_roaring*>(cells_[cell_index]);
+		const std::vector<roaring_bitmap>& compressed_visibility = current_cell->get_compressed_visibility();
+
+		std::string current_cell_data;
+
+		for(model_t model_index = 0; model_index < ids_.size(); ++model_index)
+		{
+			if(model_index < compressed_visibility.size())
+			{
+				compressed_visibility[model_index].serialize(current_cell_data);
+			}
+			else
+			{
+				roaring_bitmap(current_cell->get_bitset(model_index)).serialize(current_cell_data);
+			}
+		}
+
+		file_out.write(current_cell_data.c_str(), current_cell_data.length());
+		block_offsets[cell_index + 1] = block_offsets[cell_index] + current_cell_data.length();
+	}
+
+	file_out.seekp(offset_table_position);
+	file_out.write(reinterpret_cast<char*>(&block_offsets[0]), block_offsets.size() * sizeof(uint64_t));
+
+	file_out.close();
+}
+
+bool grid_regular_roaring::
+load_grid_from_file(const std::string& file_path)
+{
+	if(!load_regular_grid(file_path, get_grid_identifier()))
+	{
+		return false;
+	}
+
+	create_roaring_cells();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	unmap_visibility_file();
+
+	return true;
+}
+
+bool grid_regular_roaring::
+load_visibility_from_file(const std::string& file_path)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(!map_visibility_file(file_path))
+	{
+		return false;
+	}
+
+	for(size_t cell_index = 0; cell_index < cells_.size(); ++cell_index)
+	{
+		if(!decode_cell_visibility(cell_index))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool grid_regular_roaring::
+load_cell_visibility_from_file(const std::string& file_path, const size_t& cell_index)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// First check if visibility data is already loaded.
+	if(cells_[cell_index]->contains_visibility_data())
+	{
+		return true;
+	}
+
+	if(!map_visibility_file(file_path))
+	{
+		return false;
+	}
+
+	return decode_cell_visibility(cell_index);
+}
+
+bool grid_regular_roaring::
+map_visibility_file(const std::string& file_path)
+{
+	if(visibility_file_.is_open() && visibility_file_path_ == file_path)
+	{
+		return true;
+	}
+
+	unmap_visibility_file();
+
+	try
+	{
+		visibility_file_.open(file_path);
+	}
+	catch(const std::exception&)
+	{
+		return false;
+	}
+
+	if(!visibility_file_.is_open())
+	{
+		return false;
+	}
+
+	const char* data = visibility_file_.data();
+	size_t data_size = visibility_file_.size();
+
+	// Header: number of cells and models, which must match the grid.
+	uint64_t num_cells = 0;
+	uint64_t num_models = 0;
+
+	if(data_size >= 2 * sizeof(uint64_t))
+	{
+		std::memcpy(&num_cells, data, sizeof(num_cells));
+		std::memcpy(&num_models, data + sizeof(num_cells), sizeof(num_models));
+	}
+
+	if(num_cells != cells_.size() || num_models != ids_.size() ||
+		(data_size - 2 * sizeof(uint64_t)) / sizeof(uint64_t) < num_cells + 1)
+	{
+		unmap_visibility_file();
+		return false;
+	}
+
+	visibility_block_offsets_.resize(num_cells + 1);
+	std::memcpy(&visibility_block_offsets_[0], data + 2 * sizeof(uint64_t), visibility_block_offsets_.size() * sizeof(uint64_t));
+
+	for(size_t cell_index = 0; cell_index < num_cells; ++cell_index)
+	{
+		if(visibility_block_offsets_[cell_index] > visibility_block_offsets_[cell_index + 1] || visibility_block_offsets_[cell_index + 1] > data_size)
+		{
+			unmap_visibility_file();
+			return false;
+		}
+	}
+
+	visibility_file_path_ = file_path;
+	return true;
+}
+
+void grid_regular_roaring::
+unmap_visibility_file() const
+{
+	if(visibility_file_.is_open())
+	{
+		visibility_file_.close();
+	}
+
+	visibility_file_path_ = "";
+	visibility_block_offsets_.clear();
+}
+
+bool grid_regular_roaring::
+decode_cell_visibility(const size_t& cell_index)
+{
+	// Expects the mutex to be locked and the visibility file to be mapped.
+	const char* block_data = visibility_file_.data() + visibility_block_offsets_[cell_index];
+	size_t block_size = visibility_block_offsets_[cell_index + 1] - visibility_block_offsets_[cell_index];
+
+	std::vector<roaring_bitmap> compressed_visibility(ids_.size());
+	size_t position = 0;
+
+	for(model_t model_index = 0; model_index < ids_.size(); ++model_index)
+	{
+		size_t bytes_read = compressed_visibility[model_index].deserialize(block_data + position, block_size - position);
+
+		if(bytes_read == 0)
+		{
+			return false;
+		}
+
+		position += bytes_read;
+	}
+
+	static_cast<view_cell_regular_roaring*>(cells_[cell_index])->set_compressed_visibility(std::move(compressed_visibility), ids_);
+	return true;
+}
+
+}
+}
@@ -5,12 +5,15 @@
 // Faculty of Media, Bauhaus-Universitaet Weimar
 // http://www.uni-weimar.de/medien/vr
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <string>
 
 #include "lamure/pvs/pvs_database.h"
 #include "lamure/pvs/grid_regular.h"
 #include "lamure/pvs/grid_regular_compressed.h"
+#include "lamure/pvs/grid_regular_roaring.h"
 #include "lamure/pvs/grid_octree.h"
 #include "lamure/pvs/grid_octree_compressed.h"
 #include "lamure/pvs/grid_octree_hierarchical.h"
@@ -38,13 +41,23 @@ pvs_database()
 	activated_ = true;
 	do_preload_ = false;
 	shutdown_ = false;
+
+	cell_visibility_bytes_ = 0;
+	memory_budget_ = 256 * 1024 * 1024;
+	num_prefetched_cells_along_motion_ = 2;
+	reset_statistics();
 	
 	//configure semaphore
   semaphore_.set_min_signal_count(1);
   semaphore_.set_max_signal_count(std::numeric_limits<size_t>::max());
 	
-	visibility_data_loading_thread_ = std::thread(&pvs_database::loading_thread_loop, this);
-	
+	// Cell files are small, a few threads are enough to keep the neighbourhood of the viewer loaded.
+	const size_t num_loading_threads = 2;
+
+	for(size_t thread_index = 0; thread_index < num_loading_threads; ++thread_index)
+	{
+		visibility_data_loading_threads_.push_back(std::thread(&pvs_database::loading_thread_loop, this));
+	}
 }
 
 pvs_database::
@@ -53,9 +66,12 @@ pvs_database::
   shutdown_ = true;
   semaphore_.shutdown();
 
-	if(visibility_data_loading_thread_.joinable())
+	for(std::thread& loading_thread : visibility_data_loading_threads_)
 	{
-		visibility_data_loading_thread_.join();
+		if(loading_thread.joinable())
+		{
+			loading_thread.join();
+		}
 	}
 	
 	if(visibility_grid_ != nullptr)
@@ -110,6 +126,18 @@ load_pvs_from_file(const std::string& grid_file_path, const std::string& pvs_fil
 		}
 	}
 
+	// Estimate the memory of a single loaded cell, which stores one bit per node.
+	cell_visibility_bytes_ = 0;
+
+	for(model_t model_index = 0; model_index < visibility_grid_->get_num_models(); ++model_index)
+	{
+		cell_visibility_bytes_ += (visibility_grid_->get_num_nodes(model_index) + 7) / 8;
+	}
+
+	pinned_cell_indices_.clear();
+	loaded_cells_.clear();
+	loaded_cell_iterators_.clear();
+
 	// Force preload on certain grid types since runtime access is not working properly.
 	if(visibility_grid_->get_grid_type() == grid_octree_hierarchical::get_grid_identifier() ||
 		visibility_grid_->get_grid_type() == grid_octree_hierarchical_v2::get_grid_identifier())
@@ -220,6 +248,10 @@ create_grid_by_type(const std::string& grid_type) const
     {
         output_grid = new grid_regular_compressed();
     }
+    else if(grid_type == grid_regular_roaring::get_grid_identifier())
+    {
+        output_grid = new grid_regular_roaring();
+    }
     else if(grid_type == grid_octree::get_grid_identifier())
     {   
         output_grid = new grid_octree();
@@ -267,6 +299,10 @@ create_grid_by_type(const std::string& grid_type, const size_t& num_cells_x, con
     {
         output_grid = new grid_regular_compressed(max_num_cells, bounds_size, position_center, ids);
     }
+    else if(grid_type == grid_regular_roaring::get_grid_identifier())
+    {
+        output_grid = new grid_regular_roaring(max_num_cells, bounds_size, position_center, ids);
+    }
     else if(grid_type == grid_octree::get_grid_identifier())
     {   
         output_grid = new grid_octree(max_num_cells, bounds_size, position_center, ids);
@@ -311,17 +347,20 @@ loading_thread_loop() {
     }
     
     int64_t cell_index = -1;
+    loading_mutex_.lock();
     if (loading_queue_.size() > 0) {
-      loading_mutex_.lock();
-      if (loading_queue_.size() > 0) {
-        cell_index = loading_queue_.front();
-        loading_queue_.pop();
-      }
-      loading_mutex_.unlock();
+      cell_index = loading_queue_.front();
+      loading_queue_.pop_front();
     }
+    loading_mutex_.unlock();
     
     if (cell_index >= 0) {
       load_visibility_data_async(cell_index);
+
+      // The cell may be requested again once it is released.
+      loading_mutex_.lock();
+      loading_cell_indices_.erase(cell_index);
+      loading_mutex_.unlock();
     }
   }
 
@@ -336,6 +375,7 @@ set_viewer_position(const scm::math::vec3d& position)
 	{
 		if(position != position_viewer_)
 		{
+			scm::math::vec3d motion_direction = position - position_viewer_;
 			position_viewer_ = position;
 			size_t cell_index = 0;
 			const view_cell* view_cell_at_position = visibility_grid_->get_cell_at_position(position, &cell_index);
@@ -346,18 +386,21 @@ set_viewer_position(const scm::math::vec3d& position)
 				// Only set viewer cell if it changed.
 				if(view_cell_at_position != viewer_cell_)
 				{
-					viewer_cell_ = view_cell_at_position;
-
 					// If the view cell changed and the visibility data is not preloaded, it should be loaded now.
+					// The neighbourhood is pinned before the cell is entered, so the loading threads will not release it.
+					// The previous viewer cell stays pinned until the viewer cell is switched.
 					if(!do_preload_)
 					{
-					
-            loading_mutex_.lock();
-            loading_queue_.push(cell_index);
-            //std::cout << "add cell " << cell_index << std::endl;
-						loading_mutex_.unlock();
-						semaphore_.signal(1);
-						
+						std::set<size_t> cell_indices_around = request_cells_around(view_cell_at_position, motion_direction);
+
+						viewer_cell_ = view_cell_at_position;
+
+						std::lock_guard<std::mutex> lock(mutex_);
+						pinned_cell_indices_ = cell_indices_around;
+					}
+					else
+					{
+						viewer_cell_ = view_cell_at_position;
 					}
 				}
 			}
@@ -378,20 +421,41 @@ set_viewer_position(const scm::math::vec3d& position)
 	}
 }
 
-void pvs_database::
-load_visibility_data_async(uint64_t cell_index)
+std::set<size_t> pvs_database::
+request_cells_around(const view_cell* cell, const scm::math::vec3d& motion_direction)
 {
-  const view_cell* cell = visibility_grid_->get_cell_at_index(cell_index);
-  //
-  if (cell != viewer_cell_) {
-    return;
-  }
-  
-  //std::cout << "loading cell " << cell_index << std::endl;
-  
 	scm::math::vec3d center = cell->get_position_center();
 
-	std::set<size_t> cell_indices_to_load;
+	// Cells ordered by the priority they are loaded with: the entered cell, the cells ahead of the viewer and the remaining neighbours.
+	std::vector<size_t> cell_indices_to_load;
+	std::set<size_t> cell_indices_around;
+
+	auto add_cell_at_position = [&](const scm::math::vec3d& position)
+	{
+		size_t local_cell_index = 0;
+		const view_cell* local_view_cell_at_position = visibility_grid_->get_cell_at_position(position, &local_cell_index);
+
+		if(local_view_cell_at_position != nullptr && cell_indices_around.insert(local_cell_index).second)
+		{
+			cell_indices_to_load.push_back(local_cell_index);
+		}
+	};
+
+	add_cell_at_position(center);
+
+	// Scale the motion so a single step reaches the next cell along its major axis.
+	double cells_per_motion = std::max(std::abs(motion_direction.x) / smallest_cell_size_.x,
+									std::max(std::abs(motion_direction.y) / smallest_cell_size_.y, std::abs(motion_direction.z) / smallest_cell_size_.z));
+
+	if(cells_per_motion > 0.0)
+	{
+		scm::math::vec3d motion_step = motion_direction / cells_per_motion;
+
+		for(size_t step = 1; step <= num_prefetched_cells_along_motion_; ++step)
+		{
+			add_cell_at_position(center + motion_step * double(step));
+		}
+	}
 
 	for(double z = -1.0; z < 1.5; z += 1.0)
 	{
@@ -399,50 +463,138 @@ load_visibility_data_async(uint64_t cell_index)
 		{
 			for(double x = -1.0; x < 1.5; x += 1.0)
 			{
-				size_t local_cell_index = 0;
-				scm::math::vec3d direction = smallest_cell_size_ * scm::math::vec3d(x, y, z);
-				const view_cell* local_view_cell_at_position = visibility_grid_->get_cell_at_position(center + direction, &local_cell_index);
+				add_cell_at_position(center + smallest_cell_size_ * scm::math::vec3d(x, y, z));
+			}
+		}
+	}
 
-				if(local_view_cell_at_position != nullptr)
-				{
-					cell_indices_to_load.insert(local_cell_index);
-				}
+	std::vector<size_t> cell_indices_not_loaded;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		pinned_cell_indices_.insert(cell_indices_around.begin(), cell_indices_around.end());
+
+		if(loaded_cell_iterators_.find(cell_indices_to_load.front()) != loaded_cell_iterators_.end())
+		{
+			++num_cell_hits_;
+		}
+		else
+		{
+			++num_cell_misses_;
+		}
+
+		for(size_t local_cell_index : cell_indices_to_load)
+		{
+			if(loaded_cell_iterators_.find(local_cell_index) != loaded_cell_iterators_.end())
+			{
+				touch_cell(local_cell_index);
+			}
+			else
+			{
+				cell_indices_not_loaded.push_back(local_cell_index);
 			}
 		}
 	}
-  
-  std::lock_guard<std::mutex> lock(mutex_);
 
-	// Load required visibility data which is not yet loaded.
-	for (std::set<size_t>::iterator iter = cell_indices_to_load.begin(); iter != cell_indices_to_load.end(); ++iter)
+	std::lock_guard<std::mutex> lock(loading_mutex_);
+
+	// Requests which were not picked up yet belong to the previous neighbourhood.
+	for(uint64_t queued_cell_index : loading_queue_)
+	{
+		loading_cell_indices_.erase(queued_cell_index);
+	}
+
+	loading_queue_.clear();
+
+	size_t num_requests = 0;
+
+	for(size_t local_cell_index : cell_indices_not_loaded)
 	{
-		if(previously_loaded_cell_indices_.find(*iter) == previously_loaded_cell_indices_.end())
+		if(loading_cell_indices_.insert(local_cell_index).second)
 		{
-			visibility_grid_->load_cell_visibility_from_file(pvs_file_path_, *iter);
+			loading_queue_.push_back(local_cell_index);
+			++num_requests;
 		}
 	}
 
-	// Release visibility data not within current neighbourhood.
-	for (std::set<size_t>::iterator iter = previously_loaded_cell_indices_.begin(); iter != previously_loaded_cell_indices_.end(); ++iter)
+	if(num_requests > 0)
+	{
+		semaphore_.signal(num_requests);
+	}
+
+	return cell_indices_around;
+}
+
+void pvs_database::
+load_visibility_data_async(uint64_t cell_index)
+{
 	{
-		if(cell_indices_to_load.find(*iter) == cell_indices_to_load.end())
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if(visibility_grid_ == nullptr || loaded_cell_iterators_.find(cell_index) != loaded_cell_iterators_.end())
 		{
-			visibility_grid_->clear_cell_visibility(*iter);
+			return;
 		}
 	}
 
-	previously_loaded_cell_indices_ = std::set<size_t>(cell_indices_to_load);
+	// The grid guards its own file access, so the database stays available while the cell is read.
+	if(!visibility_grid_->load_cell_visibility_from_file(pvs_file_path_, cell_index))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	loaded_cells_.push_front(cell_index);
+	loaded_cell_iterators_[cell_index] = loaded_cells_.begin();
+
+	evict_cells();
+}
+
+void pvs_database::
+touch_cell(const size_t& cell_index)
+{
+	// Expects the mutex to be locked.
+	loaded_cells_.splice(loaded_cells_.begin(), loaded_cells_, loaded_cell_iterators_[cell_index]);
+}
+
+void pvs_database::
+evict_cells()
+{
+	// Expects the mutex to be locked.
+	std::list<size_t>::iterator iter = loaded_cells_.end();
+
+	while(loaded_cells_.size() * cell_visibility_bytes_ > memory_budget_ && iter != loaded_cells_.begin())
+	{
+		--iter;
+
+		if(pinned_cell_indices_.find(*iter) != pinned_cell_indices_.end())
+		{
+			continue;
+		}
+
+		visibility_grid_->clear_cell_visibility(*iter);
+		loaded_cell_iterators_.erase(*iter);
+		iter = loaded_cells_.erase(iter);
+	}
 }
 
 bool pvs_database::
 get_viewer_visibility(const model_t& model_id, const node_t node_id) const
 {
-	if(!activated_ || viewer_cell_ == nullptr || !viewer_cell_->contains_visibility_data())
+	if(!activated_ || viewer_cell_ == nullptr)
+	{
+		return true;
+	}
+	else if(!viewer_cell_->contains_visibility_data())
 	{
+		num_visibility_misses_.fetch_add(1, std::memory_order_relaxed);
 		return true;
 	}
 	else
 	{
+		num_visibility_hits_.fetch_add(1, std::memory_order_relaxed);
 		return viewer_cell_->get_visibility(model_id, node_id);
 	}
 }
@@ -482,6 +634,70 @@ clear_visibility_grid()
 
 	delete visibility_grid_;
 	visibility_grid_ = nullptr;
+
+	pinned_cell_indices_.clear();
+	loaded_cells_.clear();
+	loaded_cell_iterators_.clear();
+}
+
+void pvs_database::
+set_memory_budget(const size_t& budget_in_bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	memory_budget_ = budget_in_bytes;
+
+	if(visibility_grid_ != nullptr)
+	{
+		evict_cells();
+	}
+}
+
+size_t pvs_database::
+get_memory_budget() const
+{
+	return memory_budget_;
+}
+
+size_t pvs_database::
+get_memory_usage() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return loaded_cells_.size() * cell_visibility_bytes_;
+}
+
+uint64_t pvs_database::
+get_num_visibility_hits() const
+{
+	return num_visibility_hits_.load(std::memory_order_relaxed);
+}
+
+uint64_t pvs_database::
+get_num_visibility_misses() const
+{
+	return num_visibility_misses_.load(std::memory_order_relaxed);
+}
+
+uint64_t pvs_database::
+get_num_cell_hits() const
+{
+	return num_cell_hits_.load();
+}
+
+uint64_t pvs_database::
+get_num_cell_misses() const
+{
+	return num_cell_misses_.load();
+}
+
+void pvs_database::
+reset_statistics()
+{
+	num_visibility_hits_ = 0;
+	num_visibility_misses_ = 0;
+	num_cell_hits_ = 0;
+	num_cell_misses_ = 0;
 }
 
 }
@@ -0,0 +1,367 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include "lamure/pvs/roaring_bitmap.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+namespace lamure
+{
+namespace pvs
+{
+
+namespace
+{
+	const size_t chunk_bits = 16;
+	const size_t chunk_size = size_t(1) << chunk_bits;
+
+	// A bitmap container covers a whole chunk. Arrays are only used while they are smaller.
+	const size_t bitmap_words = chunk_size / 16;
+}
+
+roaring_bitmap::
+roaring_bitmap()
+{
+}
+
+roaring_bitmap::
+roaring_bitmap(const boost::dynamic_bitset<>& bitset)
+{
+	size_t num_chunks = (bitset.size() + chunk_size - 1) / chunk_size;
+	size_t position = bitset.find_first();
+
+	std::vector<uint16_t> values;
+	values.reserve(chunk_size);
+
+	for(size_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index)
+	{
+		size_t chunk_begin = chunk_index * chunk_size;
+		size_t chunk_end = chunk_begin + chunk_size;
+		size_t num_runs = 0;
+
+		values.clear();
+
+		while(position != boost::dynamic_bitset<>::npos && position < chunk_end)
+		{
+			uint16_t low = (uint16_t)(position - chunk_begin);
+
+			if(values.empty() || (size_t)values.back() + 1 != low)
+			{
+				++num_runs;
+			}
+
+			values.push_back(low);
+			position = bitset.find_next(position);
+		}
+
+		container current_container;
+		current_container.offset = (uint32_t)data_.size();
+
+		if(values.empty())
+		{
+			current_container.type = CONTAINER_EMPTY;
+		}
+		else if(2 * num_runs < std::min(values.size(), bitmap_words))
+		{
+			// Runs are stored as first id and number of following ids.
+			current_container.type = CONTAINER_RUN;
+
+			for(size_t value_index = 0; value_index < values.size(); ++value_index)
+			{
+				if(value_index == 0 || values[value_index - 1] + 1 != values[value_index])
+				{
+					data_.push_back(values[value_index]);
+					data_.push_back(0);
+				}
+				else
+				{
+					++data_.back();
+				}
+			}
+		}
+		else if(values.size() <= bitmap_words)
+		{
+			current_container.type = CONTAINER_ARRAY;
+			data_.insert(data_.end(), values.begin(), values.end());
+		}
+		else
+		{
+			current_container.type = CONTAINER_BITMAP;
+			data_.resize(data_.size() + bitmap_words, 0);
+
+			uint16_t* words = &data_[current_container.offset];
+
+			for(uint16_t value : values)
+			{
+				words[value >> 4] |= (uint16_t)(1 << (value & 15));
+			}
+		}
+
+		current_container.size = (uint32_t)(data_.size() - current_container.offset);
+		containers_.push_back(current_container);
+	}
+
+	// Trailing chunks without visible nodes are answered by the range check.
+	while(!containers_.empty() && containers_.back().type == CONTAINER_EMPTY)
+	{
+		containers_.pop_back();
+	}
+
+	containers_.shrink_to_fit();
+	data_.shrink_to_fit();
+}
+
+roaring_bitmap::
+~roaring_bitmap()
+{
+}
+
+bool roaring_bitmap::
+contains(const node_t& node_id) const
+{
+	size_t chunk_index = node_id >> chunk_bits;
+
+	if(chunk_index >= containers_.size())
+	{
+		return false;
+	}
+
+	const container& current_container = containers_[chunk_index];
+	const uint16_t* words = data_.data() + current_container.offset;
+	uint16_t low = (uint16_t)(node_id & (chunk_size - 1));
+
+	switch(current_container.type)
+	{
+		case CONTAINER_ARRAY:
+			return std::binary_search(words, words + current_container.size, low);
+
+		case CONTAINER_BITMAP:
+			return ((words[low >> 4] >> (low & 15)) & 1) == 1;
+
+		case CONTAINER_RUN:
+		{
+			// Find the last run starting at or before the id.
+			size_t first = 0;
+			size_t count = current_container.size / 2;
+
+			while(count > 0)
+			{
+				size_t step = count / 2;
+
+				if(words[2 * (first + step)] <= low)
+				{
+					first += step + 1;
+					count -= step + 1;
+				}
+				else
+				{
+					count = step;
+				}
+			}
+
+			if(first == 0)
+			{
+				return false;
+			}
+
+			const uint16_t* run = words + 2 * (first - 1);
+			return (size_t)(low - run[0]) <= run[1];
+		}
+
+		default:
+			return false;
+	}
+}
+
+bool roaring_bitmap::
+empty() const
+{
+	return containers_.empty();
+}
+
+size_t roaring_bitmap::
+get_cardinality() const
+{
+	size_t cardinality = 0;
+
+	for(const container& current_container : containers_)
+	{
+		const uint16_t* words = data_.data() + current_container.offset;
+
+		switch(current_container.type)
+		{
+			case CONTAINER_ARRAY:
+				cardinality += current_container.size;
+				break;
+
+			case CONTAINER_BITMAP:
+				for(size_t word_index = 0; word_index < current_container.size; ++word_index)
+				{
+					cardinality += std::bitset<16>(words[word_index]).count();
+				}
+				break;
+
+			case CONTAINER_RUN:
+				for(size_t run_index = 0; run_index < current_container.size; run_index += 2)
+				{
+					cardinality += (size_t)words[run_index + 1] + 1;
+				}
+				break;
+		}
+	}
+
+	return cardinality;
+}
+
+std::vector<node_t> roaring_bitmap::
+get_indices() const
+{
+	std::vector<node_t> indices;
+
+	for(size_t chunk_index = 0; chunk_index < containers_.size(); ++chunk_index)
+	{
+		const container& current_container = containers_[chunk_index];
+		const uint16_t* words = data_.data() + current_container.offset;
+		node_t chunk_begin = (node_t)(chunk_index << chunk_bits);
+
+		switch(current_container.type)
+		{
+			case CONTAINER_ARRAY:
+				for(size_t value_index = 0; value_index < current_container.size; ++value_index)
+				{
+					indices.push_back(chunk_begin + words[value_index]);
+				}
+				break;
+
+			case CONTAINER_BITMAP:
+				for(size_t word_index = 0; word_index < current_container.size; ++word_index)
+				{
+					for(size_t bit_index = 0; bit_index < 16; ++bit_index)
+					{
+						if((words[word_index] >> bit_index) & 1)
+						{
+							indices.push_back(chunk_begin + (node_t)(word_index * 16 + bit_index));
+						}
+					}
+				}
+				break;
+
+			case CONTAINER_RUN:
+				for(size_t run_index = 0; run_index < current_container.size; run_index += 2)
+				{
+					for(size_t value = words[run_index]; value <= (size_t)words[run_index] + words[run_index + 1]; ++value)
+					{
+						indices.push_back(chunk_begin + (node_t)value);
+					}
+				}
+				break;
+		}
+	}
+
+	return indices;
+}
+
+boost::dynamic_bitset<> roaring_bitmap::
+get_bitset(const size_t& num_bits) const
+{
+	boost::dynamic_bitset<> bitset(num_bits);
+	std::vector<node_t> indices = get_indices();
+
+	for(node_t index : indices)
+	{
+		if(index < num_bits)
+		{
+			bitset[index] = true;
+		}
+	}
+
+	return bitset;
+}
+
+size_t roaring_bitmap::
+get_byte_size() const
+{
+	return sizeof(roaring_bitmap) + containers_.size() * sizeof(container) + data_.size() * sizeof(uint16_t);
+}
+
+void roaring_bitmap::
+serialize(std::string& output) const
+{
+	// Number of containers, followed by type and size of each container and the concatenated container data.
+	uint32_t num_containers = (uint32_t)containers_.size();
+	output.append(reinterpret_cast<const char*>(&num_containers), sizeof(num_containers));
+
+	for(const container& current_container : containers_)
+	{
+		output.append(reinterpret_cast<const char*>(&current_container.type), sizeof(current_container.type));
+		output.append(reinterpret_cast<const char*>(&current_container.size), sizeof(current_container.size));
+	}
+
+	output.append(reinterpret_cast<const char*>(data_.data()), data_.size() * sizeof(uint16_t));
+}
+
+size_t roaring_bitmap::
+deserialize(const char* data, const size_t& data_size)
+{
+	containers_.clear();
+	data_.clear();
+
+	uint32_t num_containers = 0;
+
+	if(data_size < sizeof(num_containers))
+	{
+		return 0;
+	}
+
+	std::memcpy(&num_containers, data, sizeof(num_containers));
+	size_t position = sizeof(num_containers);
+
+	if((data_size - position) / (2 * sizeof(uint32_t)) < num_containers)
+	{
+		return 0;
+	}
+
+	containers_.resize(num_containers);
+	size_t num_words = 0;
+
+	for(container& current_container : containers_)
+	{
+		std::memcpy(&current_container.type, data + position, sizeof(current_container.type));
+		std::memcpy(&current_container.size, data + position + sizeof(uint32_t), sizeof(current_container.size));
+		position += 2 * sizeof(uint32_t);
+
+		bool valid = (current_container.type == CONTAINER_EMPTY && current_container.size == 0) ||
+					(current_container.type == CONTAINER_ARRAY && current_container.size > 0 && current_container.size <= bitmap_words) ||
+					(current_container.type == CONTAINER_BITMAP && current_container.size == bitmap_words) ||
+					(current_container.type == CONTAINER_RUN && current_container.size > 0 && current_container.size <= chunk_size && current_container.size % 2 == 0);
+
+		if(!valid)
+		{
+			containers_.clear();
+			return 0;
+		}
+
+		current_container.offset = (uint32_t)num_words;
+		num_words += current_container.size;
+	}
+
+	if((data_size - position) / sizeof(uint16_t) < num_words)
+	{
+		containers_.clear();
+		return 0;
+	}
+
+	data_.resize(num_words);
+	std::memcpy(data_.data(), data + position, num_words * sizeof(uint16_t));
+
+	return position + num_words * sizeof(uint16_t);
+}
+
+}
+}
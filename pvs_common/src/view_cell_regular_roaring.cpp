@@ -0,0 +1,171 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include "lamure/pvs/view_cell_regular_roaring.h"
+
+#include <utility>
+
+namespace lamure
+{
+namespace pvs
+{
+
+view_cell_regular_roaring::
+view_cell_regular_roaring() : view_cell_regular_roaring(1.0, scm::math::vec3d(0.0, 0.0, 0.0))
+{
+}
+
+view_cell_regular_roaring::
+view_cell_regular_roaring(const double& cell_size, const scm::math::vec3d& position_center) : view_cell_regular(cell_size, position_center)
+{
+}
+
+view_cell_regular_roaring::
+~view_cell_regular_roaring()
+{
+}
+
+std::string view_cell_regular_roaring::
+get_cell_type() const
+{
+	return get_cell_identifier();
+}
+
+std::string view_cell_regular_roaring::
+get_cell_identifier()
+{
+	return "view_cell_regular_roaring";
+}
+
+void view_cell_regular_roaring::
+set_visibility(const model_t& object_id, const node_t& node_id, const bool& visible)
+{
+	decompress();
+	view_cell_regular::set_visibility(object_id, node_id, visible);
+}
+
+bool view_cell_regular_roaring::
+get_visibility(const model_t& object_id, const node_t& node_id) const
+{
+	if(compressed_visibility_.size() == 0)
+	{
+		return view_cell_regular::get_visibility(object_id, node_id);
+	}
+
+	if(compressed_visibility_.size() <= object_id)
+	{
+		return false;
+	}
+
+	return compressed_visibility_[object_id].contains(node_id);
+}
+
+bool view_cell_regular_roaring::
+contains_visibility_data() const
+{
+	return compressed_visibility_.size() > 0 || view_cell_regular::contains_visibility_data();
+}
+
+std::map<model_t, std::vector<node_t>> view_cell_regular_roaring::
+get_visible_indices() const
+{
+	if(compressed_visibility_.size() == 0)
+	{
+		return view_cell_regular::get_visible_indices();
+	}
+
+	std::map<model_t, std::vector<node_t>> indices;
+
+	for(model_t model_index = 0; model_index < compressed_visibility_.size(); ++model_index)
+	{
+		if(!compressed_visibility_[model_index].empty())
+		{
+			indices[model_index] = compressed_visibility_[model_index].get_indices();
+		}
+	}
+
+	return indices;
+}
+
+void view_cell_regular_roaring::
+clear_visibility_data()
+{
+	compressed_visibility_.clear();
+	compressed_visibility_.shrink_to_fit();
+	view_cell_regular::clear_visibility_data();
+}
+
+boost::dynamic_bitset<> view_cell_regular_roaring::
+get_bitset(const model_t& object_id) const
+{
+	if(compressed_visibility_.size() == 0)
+	{
+		return view_cell_regular::get_bitset(object_id);
+	}
+
+	if(compressed_visibility_.size() <= object_id)
+	{
+		return boost::dynamic_bitset<>();
+	}
+
+	return compressed_visibility_[object_id].get_bitset(ids_[object_id]);
+}
+
+void view_cell_regular_roaring::
+set_bitset(const model_t& object_id, const boost::dynamic_bitset<>& bitset)
+{
+	decompress();
+	view_cell_regular::set_bitset(object_id, bitset);
+}
+
+void view_cell_regular_roaring::
+set_compressed_visibility(std::vector<roaring_bitmap> compressed_visibility, const std::vector<node_t>& ids)
+{
+	view_cell_regular::clear_visibility_data();
+
+	compressed_visibility_ = std::move(compressed_visibility);
+	ids_ = ids;
+}
+
+const std::vector<roaring_bitmap>& view_cell_regular_roaring::
+get_compressed_visibility() const
+{
+	return compressed_visibility_;
+}
+
+size_t view_cell_regular_roaring::
+get_compressed_byte_size() const
+{
+	size_t byte_size = 0;
+
+	for(const roaring_bitmap& bitmap : compressed_visibility_)
+	{
+		byte_size += bitmap.get_byte_size();
+	}
+
+	return byte_size;
+}
+
+void view_cell_regular_roaring::
+decompress()
+{
+	if(compressed_visibility_.size() == 0)
+	{
+		return;
+	}
+
+	std::vector<roaring_bitmap> compressed_visibility;
+	compressed_visibility.swap(compressed_visibility_);
+
+	for(model_t model_index = 0; model_index < compressed_visibility.size(); ++model_index)
+	{
+		view_cell_regular::set_bitset(model_index, compressed_visibility[model_index].get_bitset(ids_[model_index]));
+	}
+}
+
+}
+}
@@ -21,6 +21,8 @@ class PVS_PREPROCESSING_DLL grid_optimizer_irregular
 public:
 	// Equality threshold is the allowed difference in percent used to consider two cells as equal.
 	// E.g. a value of 0.9 means the cells must contain 90% equal elements to be considered equal.
+	// Equality is measured as shared visible nodes by nodes visible in either cell (Jaccard similarity).
+	// Only cells with similar MinHash signatures are compared, so the optimization scales to large grids.
 	void optimize_grid(grid* input_grid, const float& equality_threshold);
 };
 
@@ -0,0 +1,84 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef LAMURE_PVS_VISIBILITY_TEST_CPU_RASTERIZER_H
+#define LAMURE_PVS_VISIBILITY_TEST_CPU_RASTERIZER_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <lamure/pvs/pvs_preprocessing.h>
+#include "lamure/pvs/visibility_test.h"
+#include "lamure/pvs/grid.h"
+
+#include <lamure/types.h>
+#include <scm/core/math.h>
+
+namespace lamure
+{
+namespace pvs
+{
+
+// Headless visibility test which needs neither OpenGL nor a window.
+// Bounding boxes of the LOD-nodes are rasterized into a software ID buffer, using the same pixel encoding as the GPU renderer,
+// so the ID histogram is evaluated the same way. Nodes are refined until their projected size falls below a pixel limit.
+// View cells are rendered independently, so they are distributed across all available cores.
+class PVS_PREPROCESSING_DLL visibility_test_cpu_rasterizer : public visibility_test
+{
+public:
+	visibility_test_cpu_rasterizer();
+	virtual ~visibility_test_cpu_rasterizer();
+
+	virtual int initialize(int& argc, char** argv);
+	virtual void test_visibility(grid* visibility_grid);
+	virtual void shutdown();
+
+	virtual bounding_box get_scene_bounds() const;
+
+private:
+	// Node selected for rasterization in the current view cell.
+	struct rasterized_node
+	{
+		model_t model_id;
+		node_t node_id;
+	};
+
+	// Per-thread buffers of a single cube map face.
+	struct face_buffer
+	{
+		std::vector<unsigned int> ids;
+		std::vector<float> inverse_depths;
+	};
+
+	void select_nodes(const scm::math::vec3d& eye, const bounding_box& cell_bounds, std::vector<rasterized_node>& rasterized_nodes, std::vector<rasterized_node>& nodes_inside_cell) const;
+	void rasterize_face(const scm::math::vec3d& eye, const unsigned short& direction, const double& near_plane, const std::vector<rasterized_node>& rasterized_nodes, face_buffer& buffer) const;
+	void rasterize_triangle(const scm::math::vec3d& v0, const scm::math::vec3d& v1, const scm::math::vec3d& v2, const unsigned int& id, face_buffer& buffer) const;
+
+	void propagate_visibility(const model_t& model_id, const node_t& node_id, std::vector<bool>& visible_nodes) const;
+
+	int resolution_x_;
+	int resolution_y_;
+	float max_node_pixels_;
+	float visibility_threshold_;
+
+	std::vector<std::string> model_filenames_;
+	std::vector<scm::math::mat4d> model_transformations_;
+	std::vector<scm::math::mat4d> normal_transformations_;
+	std::set<model_t> invisible_set_;
+
+	// World space bounds of all nodes, indexed by model and node ID.
+	std::vector<std::vector<bounding_box>> node_bounds_;
+
+	bounding_box scene_bounds_;
+	bool initialized_;
+};
+
+}
+}
+
+#endif
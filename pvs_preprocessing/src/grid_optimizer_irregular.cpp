@@ -1,13 +1,26 @@
 // Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
 // This Software is distributed under the Modified BSD License, see license.txt.
 //
-// Virtual Reality and Visualization Research Group 
+// Virtual Reality and Visualization Research Group
 // Faculty of Media, Bauhaus-Universitaet Weimar
 // http://www.uni-weimar.de/medien/vr
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
-#include <queue>
+#include <limits>
+#include <tuple>
 #include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #include "lamure/pvs/grid_optimizer_irregular.h"
 #include "lamure/pvs/grid_irregular.h"
@@ -17,75 +30,341 @@ namespace lamure
 namespace pvs
 {
 
+namespace
+{
+	// Number of MinHash values per cell. They are split into bands for the locality sensitive hashing.
+	const size_t num_min_hashes = 128;
+
+	// Cells sharing a band in larger buckets are only paired with their neighbours in the bucket.
+	// Otherwise many identical cells (e.g. empty cells outside of the scene) would produce a quadratic amount of candidates.
+	const size_t max_bucket_size = 64;
+
+	uint64_t mix_hash(uint64_t value)
+	{
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		value ^= value >> 31;
+		return value;
+	}
+
+	unsigned int count_trailing_zeros(const uint64_t& word)
+	{
+#ifdef _MSC_VER
+		unsigned long bit_index = 0;
+		_BitScanForward64(&bit_index, word);
+		return (unsigned int)bit_index;
+#else
+		return (unsigned int)__builtin_ctzll(word);
+#endif
+	}
+
+	uint64_t count_bits(uint64_t word)
+	{
+		word = word - ((word >> 1) & 0x5555555555555555ull);
+		word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+		word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return (word * 0x0101010101010101ull) >> 56;
+	}
+
+#if defined(__SSE2__) || defined(_M_X64)
+	// Per byte bit count, summed into the two 64 bit lanes.
+	__m128i count_bits(__m128i words)
+	{
+		const __m128i mask_one = _mm_set1_epi8(0x55);
+		const __m128i mask_two = _mm_set1_epi8(0x33);
+		const __m128i mask_four = _mm_set1_epi8(0x0F);
+
+		words = _mm_sub_epi8(words, _mm_and_si128(_mm_srli_epi64(words, 1), mask_one));
+		words = _mm_add_epi8(_mm_and_si128(words, mask_two), _mm_and_si128(_mm_srli_epi64(words, 2), mask_two));
+		words = _mm_and_si128(_mm_add_epi8(words, _mm_srli_epi64(words, 4)), mask_four);
+
+		return _mm_sad_epu8(words, _mm_setzero_si128());
+	}
+#endif
+
+	// Jaccard similarity (size of intersection by size of union) of two visibility rows.
+	// Two empty rows are considered equal.
+	float compute_similarity(const uint64_t* words_one, const uint64_t* words_two, const size_t& num_words)
+	{
+		uint64_t num_common = 0;
+		uint64_t num_combined = 0;
+		size_t word_index = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+		__m128i common_sum = _mm_setzero_si128();
+		__m128i combined_sum = _mm_setzero_si128();
+
+		for(; word_index + 2 <= num_words; word_index += 2)
+		{
+			__m128i one = _mm_loadu_si128((const __m128i*)(words_one + word_index));
+			__m128i two = _mm_loadu_si128((const __m128i*)(words_two + word_index));
+
+			common_sum = _mm_add_epi64(common_sum, count_bits(_mm_and_si128(one, two)));
+			combined_sum = _mm_add_epi64(combined_sum, count_bits(_mm_or_si128(one, two)));
+		}
+
+		uint64_t lanes[2];
+		_mm_storeu_si128((__m128i*)lanes, common_sum);
+		num_common = lanes[0] + lanes[1];
+		_mm_storeu_si128((__m128i*)lanes, combined_sum);
+		num_combined = lanes[0] + lanes[1];
+#endif
+
+		for(; word_index < num_words; ++word_index)
+		{
+			num_common += count_bits(words_one[word_index] & words_two[word_index]);
+			num_combined += count_bits(words_one[word_index] | words_two[word_index]);
+		}
+
+		if(num_combined == 0)
+		{
+			return 1.0f;
+		}
+
+		return (float)num_common / (float)num_combined;
+	}
+
+	size_t find_cluster(std::vector<size_t>& clusters, size_t cell_index)
+	{
+		while(clusters[cell_index] != cell_index)
+		{
+			clusters[cell_index] = clusters[clusters[cell_index]];
+			cell_index = clusters[cell_index];
+		}
+
+		return cell_index;
+	}
+}
+
 void grid_optimizer_irregular::
 optimize_grid(grid* input_grid, const float& equality_threshold)
 {
 	grid_irregular* irr_grid = (grid_irregular*)input_grid;
 
-	for(long current_cell_index = 0; current_cell_index < irr_grid->get_cell_count(); ++current_cell_index)
+	long num_cells = (long)irr_grid->get_cell_count();
+
+	// Each cell is identified by one of its original cells, since cell indices change whenever cells are joined.
+	std::vector<size_t> original_indices(num_cells, irr_grid->get_original_cell_count());
+
+	for(size_t original_index = 0; original_index < irr_grid->get_original_cell_count(); ++original_index)
 	{
-		bool is_original_cell = irr_grid->is_cell_at_index_original(current_cell_index);
-		const view_cell* current_cell = irr_grid->get_cell_at_index(current_cell_index);
+		size_t cell_index = irr_grid->get_cell_index_of_original_cell(original_index);
+
+		if(original_indices[cell_index] == irr_grid->get_original_cell_count())
+		{
+			original_indices[cell_index] = original_index;
+		}
+	}
 
-		std::priority_queue<std::pair<float, size_t>, std::vector<std::pair<float, size_t>>, std::greater<std::pair<float, size_t>>> merge_options;
+	// Copy visibility of all cells into word aligned rows, so comparisons run without allocations.
+	std::vector<size_t> model_word_offsets(irr_grid->get_num_models() + 1, 0);
 
-		for(long compare_cell_index = 0; compare_cell_index < irr_grid->get_cell_count(); ++compare_cell_index)
+	for(model_t model_index = 0; model_index < irr_grid->get_num_models(); ++model_index)
+	{
+		model_word_offsets[model_index + 1] = model_word_offsets[model_index] + (irr_grid->get_num_nodes(model_index) + 63) / 64;
+	}
+
+	size_t num_words = model_word_offsets.back();
+	std::vector<uint64_t> visibility_words(num_cells * num_words, 0);
+	std::vector<uint64_t> min_hashes(num_cells * num_min_hashes);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(long cell_index = 0; cell_index < num_cells; ++cell_index)
+	{
+		const view_cell_regular* current_cell = (const view_cell_regular*)irr_grid->get_cell_at_index(cell_index);
+		uint64_t* row = &visibility_words[cell_index * num_words];
+
+		for(model_t model_index = 0; model_index < irr_grid->get_num_models(); ++model_index)
 		{
-			if(compare_cell_index == current_cell_index)
+			boost::dynamic_bitset<> bitset = current_cell->get_bitset(model_index);
+			uint64_t* model_row = row + model_word_offsets[model_index];
+
+			for(size_t node_index = bitset.find_first(); node_index != boost::dynamic_bitset<>::npos && node_index < irr_grid->get_num_nodes(model_index); node_index = bitset.find_next(node_index))
 			{
-				continue;
+				model_row[node_index / 64] |= uint64_t(1) << (node_index % 64);
 			}
+		}
 
-			const view_cell* compare_cell = irr_grid->get_cell_at_index(compare_cell_index);
-
-			// Check equality.
-			size_t equality_counter = 0;
-			size_t total_nodes = 0;
+		// One permutation MinHash: every visible node is hashed once and kept as minimum of the bin it falls into.
+		uint64_t* signature = &min_hashes[cell_index * num_min_hashes];
+		std::fill(signature, signature + num_min_hashes, std::numeric_limits<uint64_t>::max());
 
-			view_cell_regular* current_view_cell_regular = (view_cell_regular*)current_cell;
-			view_cell_regular* compare_view_cell_regular = (view_cell_regular*)compare_cell;
+		for(size_t word_index = 0; word_index < num_words; ++word_index)
+		{
+			uint64_t word = row[word_index];
 
-			for(model_t model_index = 0; model_index < irr_grid->get_num_models(); ++model_index)
+			while(word != 0)
 			{
-				boost::dynamic_bitset<> bitset_one = boost::dynamic_bitset<>(current_view_cell_regular->get_bitset(model_index));
-				bitset_one.resize(input_grid->get_num_nodes(model_index));
-				boost::dynamic_bitset<> bitset_two = boost::dynamic_bitset<>(compare_view_cell_regular->get_bitset(model_index));
-				bitset_two.resize(input_grid->get_num_nodes(model_index));
+				uint64_t hash = mix_hash(word_index * 64 + count_trailing_zeros(word));
+				uint64_t& bin = signature[hash % num_min_hashes];
+				bin = std::min(bin, hash / num_min_hashes);
 
-				boost::dynamic_bitset<> common_bits = bitset_one & bitset_two;
+				word &= word - 1;
+			}
+		}
+
+		// Fill empty bins from the next filled one, so sparse cells still produce comparable signatures.
+		for(size_t bin_index = 0; bin_index < num_min_hashes; ++bin_index)
+		{
+			for(size_t distance = 1; signature[bin_index] == std::numeric_limits<uint64_t>::max() && distance < num_min_hashes; ++distance)
+			{
+				uint64_t neighbour_bin = signature[(bin_index + distance) % num_min_hashes];
 
-				equality_counter += common_bits.count();
-				total_nodes += common_bits.size();
+				if(neighbour_bin != std::numeric_limits<uint64_t>::max())
+				{
+					signature[bin_index] = mix_hash(neighbour_bin + distance);
+				}
 			}
+		}
+	}
+
+	// Choose the rows per band so that pairs somewhat below the threshold still become candidates.
+	size_t rows_per_band = 1;
+
+	for(size_t rows = 2; rows <= num_min_hashes; rows *= 2)
+	{
+		double num_bands = (double)(num_min_hashes / rows);
+
+		if(std::pow(1.0 / num_bands, 1.0 / (double)rows) > 0.85 * equality_threshold)
+		{
+			break;
+		}
 
-			float equality = (float)equality_counter / (float)total_nodes;
-			float error = 1.0f - equality;
+		rows_per_band = rows;
+	}
+
+	long num_bands = (long)(num_min_hashes / rows_per_band);
+	std::vector<std::vector<std::pair<size_t, size_t>>> band_candidates(num_bands);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(long band_index = 0; band_index < num_bands; ++band_index)
+	{
+		std::vector<std::pair<uint64_t, size_t>> bucket_keys(num_cells);
 
-			// This test will already cancel some unecessary tests, yet a further threshold test will be done within join_cells.
-			if(equality >= equality_threshold)
+		for(long cell_index = 0; cell_index < num_cells; ++cell_index)
+		{
+			const uint64_t* band = &min_hashes[cell_index * num_min_hashes + band_index * rows_per_band];
+			uint64_t key = band_index;
+
+			for(size_t row_index = 0; row_index < rows_per_band; ++row_index)
 			{
-				merge_options.push(std::pair<float, size_t>(error, compare_cell_index));
+				key = mix_hash(key ^ band[row_index]);
 			}
+
+			bucket_keys[cell_index] = std::make_pair(key, (size_t)cell_index);
 		}
 
-		// Merge view cells.
-		while(merge_options.size() > 0)
+		std::sort(bucket_keys.begin(), bucket_keys.end());
+
+		for(size_t bucket_begin = 0; bucket_begin < bucket_keys.size();)
 		{
-			if(irr_grid->join_cells(current_cell_index, merge_options.top().second, merge_options.top().first, equality_threshold) && is_original_cell)
+			size_t bucket_end = bucket_begin + 1;
+
+			while(bucket_end < bucket_keys.size() && bucket_keys[bucket_end].first == bucket_keys[bucket_begin].first)
+			{
+				++bucket_end;
+			}
+
+			for(size_t first = bucket_begin; first < bucket_end; ++first)
 			{
-				--current_cell_index;
-				break;
+				size_t last = (bucket_end - bucket_begin) <= max_bucket_size ? bucket_end : std::min(first + 2, bucket_end);
+
+				for(size_t second = first + 1; second < last; ++second)
+				{
+					band_candidates[band_index].push_back(std::make_pair(bucket_keys[first].second, bucket_keys[second].second));
+				}
 			}
 
-			merge_options.pop();
+			bucket_begin = bucket_end;
+		}
+	}
+
+	std::vector<std::pair<size_t, size_t>> candidates;
+
+	for(long band_index = 0; band_index < num_bands; ++band_index)
+	{
+		candidates.insert(candidates.end(), band_candidates[band_index].begin(), band_candidates[band_index].end());
+		std::vector<std::pair<size_t, size_t>>().swap(band_candidates[band_index]);
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	// Evaluate the exact similarity of all candidates.
+	std::vector<float> similarities(candidates.size());
+
+	#pragma omp parallel for schedule(dynamic, 256)
+	for(long candidate_index = 0; candidate_index < (long)candidates.size(); ++candidate_index)
+	{
+		similarities[candidate_index] = compute_similarity(&visibility_words[candidates[candidate_index].first * num_words],
+														&visibility_words[candidates[candidate_index].second * num_words], num_words);
+	}
+
+	std::vector<std::tuple<float, size_t, size_t>> merge_options;
+
+	for(size_t candidate_index = 0; candidate_index < candidates.size(); ++candidate_index)
+	{
+		// This test will already cancel some unecessary tests, yet a further threshold test will be done within join_cells.
+		if(similarities[candidate_index] >= equality_threshold)
+		{
+			merge_options.push_back(std::make_tuple(1.0f - similarities[candidate_index], candidates[candidate_index].first, candidates[candidate_index].second));
 		}
+	}
+
+	std::sort(merge_options.begin(), merge_options.end());
+
+	// Merge view cells, most similar pairs first. Rows of merged cells are combined, so later pairs are compared against the joined visibility.
+	std::vector<size_t> clusters(num_cells);
 
-		double current_percentage_done = ((double)current_cell_index / (double)irr_grid->get_cell_count()) * 100.0;
-		std::cout << "\rgrid optimization in progress [" << current_percentage_done << "]       " << std::flush;
+	for(long cell_index = 0; cell_index < num_cells; ++cell_index)
+	{
+		clusters[cell_index] = cell_index;
+	}
+
+	for(size_t option_index = 0; option_index < merge_options.size(); ++option_index)
+	{
+		size_t cluster_one = find_cluster(clusters, std::get<1>(merge_options[option_index]));
+		size_t cluster_two = find_cluster(clusters, std::get<2>(merge_options[option_index]));
+
+		if(cluster_one == cluster_two)
+		{
+			continue;
+		}
+
+		uint64_t* row_one = &visibility_words[cluster_one * num_words];
+		uint64_t* row_two = &visibility_words[cluster_two * num_words];
+
+		float error = std::get<0>(merge_options[option_index]);
+
+		if(cluster_one != std::get<1>(merge_options[option_index]) || cluster_two != std::get<2>(merge_options[option_index]))
+		{
+			error = 1.0f - compute_similarity(row_one, row_two, num_words);
+		}
+
+		size_t cell_index_one = irr_grid->get_cell_index_of_original_cell(original_indices[cluster_one]);
+		size_t cell_index_two = irr_grid->get_cell_index_of_original_cell(original_indices[cluster_two]);
+
+		if(irr_grid->join_cells(cell_index_one, cell_index_two, error, equality_threshold))
+		{
+			clusters[cluster_two] = cluster_one;
+
+			for(size_t word_index = 0; word_index < num_words; ++word_index)
+			{
+				row_one[word_index] |= row_two[word_index];
+			}
+		}
+
+		if(option_index % 64 == 0)
+		{
+			double current_percentage_done = ((double)option_index / (double)merge_options.size()) * 100.0;
+			std::cout << "\rgrid optimization in progress [" << current_percentage_done << "]       " << std::flush;
+		}
 	}
 
 	std::cout << "\rgrid optimization in progress [100]       " << std::endl;
 }
 
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,602 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include "lamure/pvs/visibility_test_cpu_rasterizer.h"
+#include "lamure/pvs/utils.h"
+#include "lamure/pvs/pvs_database.h"
+#include "lamure/pvs/id_histogram.h"
+
+#include "lamure/ren/model_database.h"
+#include "lamure/ren/controller.h"
+#include "lamure/ren/bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+namespace lamure
+{
+namespace pvs
+{
+
+namespace
+{
+	// Corner indices of the six faces of a box, corner bits are x (1), y (2) and z (4).
+	const unsigned int box_faces[6][4] =
+	{
+		{0, 2, 6, 4}, {1, 3, 7, 5},
+		{0, 1, 5, 4}, {2, 3, 7, 6},
+		{0, 1, 3, 2}, {4, 5, 7, 6}
+	};
+
+	// Outward normals of the faces above in model space.
+	const double box_face_normals[6][3] =
+	{
+		{-1.0, 0.0, 0.0}, {1.0, 0.0, 0.0},
+		{0.0, -1.0, 0.0}, {0.0, 1.0, 0.0},
+		{0.0, 0.0, -1.0}, {0.0, 0.0, 1.0}
+	};
+
+	// Same view directions as the OpenGL histogram renderer.
+	void get_face_basis(const unsigned short& direction, scm::math::vec3d& look_dir, scm::math::vec3d& up_dir)
+	{
+		switch(direction)
+		{
+			case 0: look_dir = scm::math::vec3d(1.0, 0.0, 0.0); up_dir = scm::math::vec3d(0.0, 1.0, 0.0); break;
+			case 1: look_dir = scm::math::vec3d(-1.0, 0.0, 0.0); up_dir = scm::math::vec3d(0.0, 1.0, 0.0); break;
+			case 2: look_dir = scm::math::vec3d(0.0, 1.0, 0.0); up_dir = scm::math::vec3d(0.0, 0.0, 1.0); break;
+			case 3: look_dir = scm::math::vec3d(0.0, -1.0, 0.0); up_dir = scm::math::vec3d(0.0, 0.0, 1.0); break;
+			case 4: look_dir = scm::math::vec3d(0.0, 0.0, 1.0); up_dir = scm::math::vec3d(0.0, 1.0, 0.0); break;
+			default: look_dir = scm::math::vec3d(0.0, 0.0, -1.0); up_dir = scm::math::vec3d(0.0, 1.0, 0.0); break;
+		}
+	}
+}
+
+visibility_test_cpu_rasterizer::
+visibility_test_cpu_rasterizer()
+{
+	resolution_x_ = 512;
+	resolution_y_ = 512;
+	max_node_pixels_ = 8.0f;
+	visibility_threshold_ = 0.0001f;
+	initialized_ = false;
+}
+
+visibility_test_cpu_rasterizer::
+~visibility_test_cpu_rasterizer()
+{
+	shutdown();
+}
+
+int visibility_test_cpu_rasterizer::
+initialize(int& argc, char** argv)
+{
+	namespace po = boost::program_options;
+	namespace fs = boost::filesystem;
+
+	const std::string exec_name = (argc > 0) ? fs::basename(argv[0]) : "";
+
+	std::string resource_file_path = "";
+
+	// These value are read, but not used. Yet ignoring them in the terminal parameters would lead to misinterpretation.
+	std::string pvs_output_file_path = "";
+	std::string visibility_test_type = "";
+	std::string grid_type = "";
+	unsigned int grid_size = 1;
+	unsigned int num_steps = 11;
+	double oversize_factor = 1.5;
+	float optimization_threshold = 1.0f;
+
+	po::options_description desc("Usage: " + exec_name + " [OPTION]... INPUT\n\n"
+								"Allowed Options");
+	desc.add_options()
+		("help", "print help message")
+		("width,w", po::value<int>(&resolution_x_)->default_value(512), "specify width of the rasterized images (default=512)")
+		("height,h", po::value<int>(&resolution_y_)->default_value(512), "specify height of the rasterized images (default=512)")
+		("resource-file,f", po::value<std::string>(&resource_file_path), "specify resource input-file")
+		("nodepixels", po::value<float>(&max_node_pixels_)->default_value(8.0f), "specify the projected size in pixels below which LOD-nodes are no longer refined (default=8)")
+	// The following parameters are used by the main app only, yet must be identified nonetheless since otherwise they are dealt with as file paths.
+		("pvs-file,p", po::value<std::string>(&pvs_output_file_path), "specify output file of calculated pvs data")
+		("vistest", po::value<std::string>(&visibility_test_type)->default_value("cpu"), "specify type of visibility test to be used.")
+		("gridtype", po::value<std::string>(&grid_type)->default_value("octree"), "specify type of grid to store visibility data")
+		("gridsize", po::value<unsigned int>(&grid_size)->default_value(1), "specify size/depth of the grid used for the visibility test (depends on chosen grid type)")
+		("oversize", po::value<double>(&oversize_factor)->default_value(1.5), "factor the grid bounds will be scaled by, default is 1.5 (grid bounds will exceed scene bounds by factor of 1.5)")
+		("optithresh", po::value<float>(&optimization_threshold)->default_value(1.0f), "specify the threshold at which common data are converged. Default is 1.0, which means data must be 100 percent equal.")
+		("numsteps,n", po::value<unsigned int>(&num_steps)->default_value(11), "specify the number of intervals the occlusion values will be split into (visibility analysis only)");
+		;
+
+	po::variables_map vm;
+
+	try
+	{
+		auto parsed_options = po::command_line_parser(argc, argv).options(desc).allow_unregistered().run();
+		po::store(parsed_options, vm);
+		po::notify(vm);
+
+		if(vm.count("help") || resource_file_path == "")
+		{
+			std::cout << desc;
+			return 0;
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "Warning: No input file specified. \n" << desc;
+		return 0;
+	}
+
+	resolution_x_ = std::max(resolution_x_, 1);
+	resolution_y_ = std::max(resolution_y_, 1);
+	max_node_pixels_ = std::max(max_node_pixels_, 1.0f);
+
+	std::pair< std::vector<std::string>, std::vector<scm::math::mat4f> > model_attributes;
+	std::set<lamure::model_t> visible_set;
+	model_attributes = read_model_string(resource_file_path, &visible_set, &invisible_set_);
+
+	model_filenames_ = model_attributes.first;
+
+	// Only the bounding hierarchies are required, so no rendering context is created.
+	lamure::ren::model_database* database = lamure::ren::model_database::get_instance();
+
+	for(model_t model_index = 0; model_index < model_filenames_.size(); ++model_index)
+	{
+		database->add_model(model_filenames_[model_index], std::to_string(model_index));
+	}
+
+	initialized_ = true;
+
+	model_transformations_.resize(database->num_models());
+	normal_transformations_.resize(database->num_models());
+	node_bounds_.resize(database->num_models());
+
+	for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
+	{
+		const lamure::ren::bvh* bvh = database->get_model(model_id)->get_bvh();
+
+		model_transformations_[model_id] = scm::math::mat4d(model_attributes.second[model_id]) * scm::math::make_translation(scm::math::vec3d(bvh->get_translation()));
+		normal_transformations_[model_id] = scm::math::transpose(scm::math::inverse(model_transformations_[model_id]));
+
+		// Transform node boxes to world space once, so the per-cell traversal works on axis aligned bounds.
+		const std::vector<scm::gl::boxf>& boxes = bvh->get_bounding_boxes();
+		node_bounds_[model_id].resize(boxes.size());
+
+		for(node_t node_id = 0; node_id < boxes.size(); ++node_id)
+		{
+			bounding_box world_bounds;
+
+			for(unsigned int corner_index = 0; corner_index < 8; ++corner_index)
+			{
+				scm::math::vec3d corner(corner_index & 1 ? boxes[node_id].max_vertex().x : boxes[node_id].min_vertex().x,
+										corner_index & 2 ? boxes[node_id].max_vertex().y : boxes[node_id].min_vertex().y,
+										corner_index & 4 ? boxes[node_id].max_vertex().z : boxes[node_id].min_vertex().z);
+				vec3r world_corner(model_transformations_[model_id] * corner);
+
+				if(corner_index == 0)
+				{
+					world_bounds = bounding_box(world_corner, world_corner);
+				}
+				else
+				{
+					world_bounds.expand(world_corner);
+				}
+			}
+
+			node_bounds_[model_id][node_id] = world_bounds;
+		}
+
+		// Calculate bounding box of whole scene.
+		if(model_id == 0)
+		{
+			scene_bounds_ = node_bounds_[model_id][0];
+		}
+		else
+		{
+			scene_bounds_.expand(node_bounds_[model_id][0]);
+		}
+	}
+
+	return 0;
+}
+
+void visibility_test_cpu_rasterizer::
+test_visibility(grid* visibility_grid)
+{
+	lamure::ren::model_database* database = lamure::ren::model_database::get_instance();
+
+	size_t num_cells = visibility_grid->get_cell_count();
+	size_t num_pixels = (size_t)resolution_x_ * (size_t)resolution_y_;
+	float steps_finished = 0.0f;
+
+	// Hardcoded heresy. This grid type applies visibility propagation at runtime.
+	bool propagate_visibility_in_lod = visibility_grid->get_grid_type() != "octree_hierarchical_v3";
+
+	#pragma omp parallel
+	{
+		// Buffers are reused for all cells processed by a thread.
+		face_buffer buffer;
+		buffer.ids.resize(num_pixels);
+		buffer.inverse_depths.resize(num_pixels);
+
+		std::vector<rasterized_node> rasterized_nodes;
+		std::vector<rasterized_node> nodes_inside_cell;
+		std::vector<std::vector<bool>> visible_nodes(database->num_models());
+
+		#pragma omp for schedule(dynamic)
+		for(size_t cell_index = 0; cell_index < num_cells; ++cell_index)
+		{
+			const view_cell* current_cell = visibility_grid->get_cell_at_index(cell_index);
+			scm::math::vec3d eye = current_cell->get_position_center();
+			scm::math::vec3d cell_size = current_cell->get_size();
+			bounding_box cell_bounds(vec3r(eye - cell_size * 0.5), vec3r(eye + cell_size * 0.5));
+
+			for(model_t model_id = 0; model_id < visible_nodes.size(); ++model_id)
+			{
+				visible_nodes[model_id].assign(node_bounds_[model_id].size(), false);
+			}
+
+			select_nodes(eye, cell_bounds, rasterized_nodes, nodes_inside_cell);
+
+			// Nodes intersecting the cell are visible from some position within it.
+			for(const rasterized_node& node : nodes_inside_cell)
+			{
+				visible_nodes[node.model_id][node.node_id] = true;
+			}
+
+			for(unsigned short direction = 0; direction < 6; ++direction)
+			{
+				// Near plane touches the cell bounds, just like in the OpenGL renderer.
+				double near_plane = cell_size[direction / 2] * 0.5;
+				rasterize_face(eye, direction, near_plane, rasterized_nodes, buffer);
+
+				id_histogram hist;
+				hist.create(buffer.ids.data(), num_pixels);
+				std::map<model_t, std::vector<node_t>> visible_ids = hist.get_visible_nodes(num_pixels, visibility_threshold_);
+
+				for(std::map<model_t, std::vector<node_t>>::const_iterator iter = visible_ids.begin(); iter != visible_ids.end(); ++iter)
+				{
+					for(node_t node_id : iter->second)
+					{
+						visible_nodes[iter->first][node_id] = true;
+					}
+				}
+			}
+
+			for(model_t model_id = 0; model_id < visible_nodes.size(); ++model_id)
+			{
+				if(propagate_visibility_in_lod)
+				{
+					// Since only a single LOD-level was rendered in the visibility test, advance visibility to parents and children.
+					for(node_t node_id = 0; node_id < visible_nodes[model_id].size(); ++node_id)
+					{
+						if(visible_nodes[model_id][node_id])
+						{
+							propagate_visibility(model_id, node_id, visible_nodes[model_id]);
+						}
+					}
+				}
+
+				for(node_t node_id = 0; node_id < visible_nodes[model_id].size(); ++node_id)
+				{
+					if(visible_nodes[model_id][node_id])
+					{
+						visibility_grid->set_cell_visibility(cell_index, model_id, node_id, true);
+					}
+				}
+			}
+
+			#pragma omp critical
+			{
+				// Calculate current rendering state so user gets visual feedback on the preprocessing progress.
+				steps_finished++;
+				float current_percentage_done = (steps_finished / (float)num_cells) * 100.0f;
+				std::cout << "\rrendering in progress [" << current_percentage_done << "]       " << std::flush;
+			}
+		}
+	}
+
+	std::cout << std::endl;
+}
+
+void visibility_test_cpu_rasterizer::
+shutdown()
+{
+	if(initialized_)
+	{
+		delete lamure::pvs::pvs_database::get_instance();
+
+		delete lamure::ren::controller::get_instance();
+		delete lamure::ren::model_database::get_instance();
+
+		initialized_ = false;
+	}
+}
+
+bounding_box visibility_test_cpu_rasterizer::
+get_scene_bounds() const
+{
+	return scene_bounds_;
+}
+
+void visibility_test_cpu_rasterizer::
+select_nodes(const scm::math::vec3d& eye, const bounding_box& cell_bounds, std::vector<rasterized_node>& rasterized_nodes, std::vector<rasterized_node>& nodes_inside_cell) const
+{
+	lamure::ren::model_database* database = lamure::ren::model_database::get_instance();
+
+	rasterized_nodes.clear();
+	nodes_inside_cell.clear();
+
+	// Pixels covered by one world unit at distance one with an opening angle of 90 degrees.
+	double pixels_per_unit = 0.5 * (double)std::max(resolution_x_, resolution_y_);
+	std::vector<node_t> node_stack;
+
+	for(model_t model_id = 0; model_id < node_bounds_.size(); ++model_id)
+	{
+		if(invisible_set_.find(model_id) != invisible_set_.end() || node_bounds_[model_id].empty())
+		{
+			continue;
+		}
+
+		const lamure::ren::bvh* bvh = database->get_model(model_id)->get_bvh();
+		node_t num_nodes = node_bounds_[model_id].size();
+
+		node_stack.clear();
+		node_stack.push_back(0);
+
+		while(!node_stack.empty())
+		{
+			node_t node_id = node_stack.back();
+			node_stack.pop_back();
+
+			const bounding_box& bounds = node_bounds_[model_id][node_id];
+			node_t first_child_id = bvh->get_child_id(node_id, 0);
+			bool has_children = first_child_id < num_nodes;
+
+			// Refine nodes like the cut update does, yet based on the projected size of their bounds instead of the surfels.
+			scm::math::vec3d closest_point(std::max(bounds.min().x, std::min(eye.x, bounds.max().x)),
+											std::max(bounds.min().y, std::min(eye.y, bounds.max().y)),
+											std::max(bounds.min().z, std::min(eye.z, bounds.max().z)));
+			double distance = scm::math::length(closest_point - eye);
+			double projected_size = (scm::math::length(bounds.get_dimensions()) / std::max(distance, 1e-6)) * pixels_per_unit;
+
+			if(has_children && projected_size > max_node_pixels_)
+			{
+				for(uint32_t child_index = 0; child_index < bvh->get_fan_factor(); ++child_index)
+				{
+					node_t child_id = bvh->get_child_id(node_id, child_index);
+
+					if(child_id < num_nodes)
+					{
+						node_stack.push_back(child_id);
+					}
+				}
+			}
+			else
+			{
+				rasterized_node node;
+				node.model_id = model_id;
+				node.node_id = node_id;
+
+				// Nodes around the viewer would occlude everything else, so they are not used as occluders.
+				if(cell_bounds.intersects(bounds))
+				{
+					nodes_inside_cell.push_back(node);
+				}
+				else
+				{
+					rasterized_nodes.push_back(node);
+				}
+			}
+		}
+	}
+}
+
+void visibility_test_cpu_rasterizer::
+rasterize_face(const scm::math::vec3d& eye, const unsigned short& direction, const double& near_plane, const std::vector<rasterized_node>& rasterized_nodes, face_buffer& buffer) const
+{
+	lamure::ren::model_database* database = lamure::ren::model_database::get_instance();
+
+	std::fill(buffer.ids.begin(), buffer.ids.end(), 0);
+	std::fill(buffer.inverse_depths.begin(), buffer.inverse_depths.end(), 0.0f);
+
+	scm::math::vec3d look_dir;
+	scm::math::vec3d up_dir;
+	get_face_basis(direction, look_dir, up_dir);
+	scm::math::vec3d right_dir = scm::math::cross(look_dir, up_dir);
+
+	scm::math::vec3d corners[8];
+	scm::math::vec3d clipped[8];
+
+	for(const rasterized_node& node : rasterized_nodes)
+	{
+		const bounding_box& bounds = node_bounds_[node.model_id][node.node_id];
+
+		// Cull against the frustum of the face using the world space bounds. Frustum planes are at 45 degrees.
+		bool outside = false;
+		scm::math::vec3d plane_normals[5] = {look_dir, look_dir + right_dir, look_dir - right_dir, look_dir + up_dir, look_dir - up_dir};
+		double plane_offsets[5] = {near_plane, 0.0, 0.0, 0.0, 0.0};
+
+		for(unsigned int plane_index = 0; plane_index < 5 && !outside; ++plane_index)
+		{
+			const scm::math::vec3d& normal = plane_normals[plane_index];
+			scm::math::vec3d positive_vertex(normal.x >= 0.0 ? bounds.max().x : bounds.min().x,
+												normal.y >= 0.0 ? bounds.max().y : bounds.min().y,
+												normal.z >= 0.0 ? bounds.max().z : bounds.min().z);
+
+			outside = scm::math::dot(positive_vertex - eye, normal) < plane_offsets[plane_index];
+		}
+
+		if(outside)
+		{
+			continue;
+		}
+
+		// Transform the corners of the node box into the view space of the face (x right, y up, z depth).
+		const scm::gl::boxf& box = database->get_model(node.model_id)->get_bvh()->get_bounding_boxes()[node.node_id];
+		const scm::math::mat4d& transformation = model_transformations_[node.model_id];
+
+		for(unsigned int corner_index = 0; corner_index < 8; ++corner_index)
+		{
+			scm::math::vec3d corner(corner_index & 1 ? box.max_vertex().x : box.min_vertex().x,
+									corner_index & 2 ? box.max_vertex().y : box.min_vertex().y,
+									corner_index & 4 ? box.max_vertex().z : box.min_vertex().z);
+			scm::math::vec3d relative = scm::math::vec3d(transformation * corner) - eye;
+
+			corners[corner_index] = scm::math::vec3d(scm::math::dot(relative, right_dir), scm::math::dot(relative, up_dir), scm::math::dot(relative, look_dir));
+		}
+
+		// ID encoding matches the OpenGL renderer: inverted model ID in the upper 8 bits, node ID in the lower 24 bits.
+		unsigned int id = ((255u - (unsigned int)node.model_id) << 24) | ((unsigned int)node.node_id & 0xFFFFFF);
+
+		for(unsigned int face_index = 0; face_index < 6; ++face_index)
+		{
+			const unsigned int* face = box_faces[face_index];
+			const double* face_normal = box_face_normals[face_index];
+
+			// Normals are transformed instead of derived from the corners, since boxes of planar nodes may be flat.
+			scm::math::vec3d normal(normal_transformations_[node.model_id] * scm::math::vec4d(face_normal[0], face_normal[1], face_normal[2], 0.0));
+			scm::math::vec3d view_normal(scm::math::dot(normal, right_dir), scm::math::dot(normal, up_dir), scm::math::dot(normal, look_dir));
+
+			// Only faces facing the viewer can be visible, the viewer is in the origin of the view space.
+			if(scm::math::dot(view_normal, corners[face[0]]) >= 0.0)
+			{
+				continue;
+			}
+
+			// Clip the face against the near plane.
+			unsigned int num_clipped = 0;
+
+			for(unsigned int vertex_index = 0; vertex_index < 4; ++vertex_index)
+			{
+				const scm::math::vec3d& current = corners[face[vertex_index]];
+				const scm::math::vec3d& next = corners[face[(vertex_index + 1) % 4]];
+				bool current_inside = current.z >= near_plane;
+				bool next_inside = next.z >= near_plane;
+
+				if(current_inside)
+				{
+					clipped[num_clipped++] = current;
+				}
+
+				if(current_inside != next_inside)
+				{
+					double t = (near_plane - current.z) / (next.z - current.z);
+					clipped[num_clipped++] = current + (next - current) * t;
+				}
+			}
+
+			for(unsigned int vertex_index = 2; vertex_index < num_clipped; ++vertex_index)
+			{
+				rasterize_triangle(clipped[0], clipped[vertex_index - 1], clipped[vertex_index], id, buffer);
+			}
+		}
+	}
+}
+
+void visibility_test_cpu_rasterizer::
+rasterize_triangle(const scm::math::vec3d& v0, const scm::math::vec3d& v1, const scm::math::vec3d& v2, const unsigned int& id, face_buffer& buffer) const
+{
+	// Project to pixel coordinates. Opening angle is 90 degrees in both directions.
+	double half_width = 0.5 * (double)resolution_x_;
+	double half_height = 0.5 * (double)resolution_y_;
+
+	double x0 = (v0.x / v0.z + 1.0) * half_width, y0 = (v0.y / v0.z + 1.0) * half_height;
+	double x1 = (v1.x / v1.z + 1.0) * half_width, y1 = (v1.y / v1.z + 1.0) * half_height;
+	double x2 = (v2.x / v2.z + 1.0) * half_width, y2 = (v2.y / v2.z + 1.0) * half_height;
+
+	double area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+
+	if(std::abs(area) < 1e-12)
+	{
+		return;
+	}
+
+	int min_x = std::max(0, (int)std::floor(std::min(x0, std::min(x1, x2))));
+	int max_x = std::min(resolution_x_ - 1, (int)std::ceil(std::max(x0, std::max(x1, x2))));
+	int min_y = std::max(0, (int)std::floor(std::min(y0, std::min(y1, y2))));
+	int max_y = std::min(resolution_y_ - 1, (int)std::ceil(std::max(y0, std::max(y1, y2))));
+
+	if(min_x > max_x || min_y > max_y)
+	{
+		return;
+	}
+
+	// Inverse depth is linear in screen space.
+	double inverse_area = 1.0 / area;
+	double z0 = 1.0 / v0.z, z1 = 1.0 / v1.z, z2 = 1.0 / v2.z;
+
+	for(int y = min_y; y <= max_y; ++y)
+	{
+		double sample_y = (double)y + 0.5;
+		unsigned int* ids = buffer.ids.data() + (size_t)y * resolution_x_;
+		float* inverse_depths = buffer.inverse_depths.data() + (size_t)y * resolution_x_;
+
+		for(int x = min_x; x <= max_x; ++x)
+		{
+			double sample_x = (double)x + 0.5;
+
+			// Barycentric coordinates by edge functions, all share the sign of the area for samples inside.
+			double w0 = ((x2 - x1) * (sample_y - y1) - (y2 - y1) * (sample_x - x1)) * inverse_area;
+			double w1 = ((x0 - x2) * (sample_y - y2) - (y0 - y2) * (sample_x - x2)) * inverse_area;
+			double w2 = 1.0 - w0 - w1;
+
+			if(w0 < 0.0 || w1 < 0.0 || w2 < 0.0)
+			{
+				continue;
+			}
+
+			float inverse_depth = (float)(w0 * z0 + w1 * z1 + w2 * z2);
+
+			if(inverse_depth > inverse_depths[x])
+			{
+				inverse_depths[x] = inverse_depth;
+				ids[x] = id;
+			}
+		}
+	}
+}
+
+void visibility_test_cpu_rasterizer::
+propagate_visibility(const model_t& model_id, const node_t& node_id, std::vector<bool>& visible_nodes) const
+{
+	const lamure::ren::bvh* bvh = lamure::ren::model_database::get_instance()->get_model(model_id)->get_bvh();
+
+	// Set parents of a visible node visible, too. Stop at the first parent which is already visible.
+	node_t parent_id = bvh->get_parent_id(node_id);
+
+	while(parent_id != lamure::invalid_node_t && parent_id < visible_nodes.size() && !visible_nodes[parent_id])
+	{
+		visible_nodes[parent_id] = true;
+		parent_id = bvh->get_parent_id(parent_id);
+	}
+
+	// Set children of a visible node visible, too.
+	std::vector<node_t> node_stack(1, node_id);
+
+	while(!node_stack.empty())
+	{
+		node_t current_id = node_stack.back();
+		node_stack.pop_back();
+
+		for(uint32_t child_index = 0; child_index < bvh->get_fan_factor(); ++child_index)
+		{
+			node_t child_id = bvh->get_child_id(current_id, child_index);
+
+			if(child_id < visible_nodes.size() && !visible_nodes[child_id])
+			{
+				visible_nodes[child_id] = true;
+				node_stack.push_back(child_id);
+			}
+		}
+	}
+}
+
+}
+}
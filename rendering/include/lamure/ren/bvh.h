@@ -35,6 +35,11 @@ public:
        TRIMESH = 1,      // uncompressed tri mesh 
        POINTCLOUD_QZ = 2 // point cloud with quantized attributes
     };
+    //layout of the nodes in the lod file
+    enum node_compression {
+       UNCOMPRESSED = 0, // fixed size nodes
+       DEFLATE = 1       // deflated nodes, followed by a table of node offsets
+    };
     enum node_visibility {
        NODE_VISIBLE = 0,
        NODE_INVISIBLE = 1
@@ -65,6 +70,7 @@ public:
     const float         get_max_surfel_radius_deviation(const node_t node_id) const;
     const node_visibility get_visibility(const node_t node_id) const;
     const primitive_type get_primitive() const { return primitive_; }
+    const node_compression get_node_compression() const { return node_compression_; }
     
     void                set_num_nodes(const uint32_t num_nodes) { num_nodes_ = num_nodes; }
     void                set_fan_factor(const uint32_t fan_factor) { fan_factor_ = fan_factor; }
@@ -78,6 +84,7 @@ public:
     void                set_max_surfel_radius_deviation(const node_t node_id, const float max_radius_deviation);
     void                set_visibility(const node_t node_id, const node_visibility visibility);
     void                set_primitive(const primitive_type primitive) { primitive_ = primitive; };
+    void                set_node_compression(const node_compression compression) { node_compression_ = compression; };
 
     void                write_bvh_file(const std::string& filename);
 
@@ -105,6 +112,7 @@ private:
     vec3f               translation_;
    
     primitive_type      primitive_;
+    node_compression    node_compression_;
 
 };
 
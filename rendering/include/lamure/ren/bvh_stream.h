@@ -69,6 +69,10 @@ protected:
         BVH_TRIMESH = 1,
         BHV_POINTCLOUD_QZ = 2
     };
+    enum bvh_node_compression {
+        BVH_UNCOMPRESSED = 0,
+        BVH_DEFLATE = 1
+    };
     enum bvh_node_visibility {
         BVH_NODE_VISIBLE = 0,
         BVH_NODE_INVISIBLE = 1
@@ -232,7 +236,7 @@ protected:
         uint32_t max_surfels_per_node_;
         uint32_t serialized_surfel_size_;
         uint32_t primitive_;
-        uint32_t reserved_0_;
+        uint32_t compression_;
 
         bvh_tree_state state_;
         uint32_t reserved_1_;
@@ -268,7 +272,7 @@ protected:
             file.write((char*)&max_surfels_per_node_, 4);
             file.write((char*)&serialized_surfel_size_, 4);
             file.write((char*)&primitive_, 4);
-            file.write((char*)&reserved_0_, 4);
+            file.write((char*)&compression_, 4);
             file.write((char*)&state_, 4);
             file.write((char*)&reserved_1_, 4);
             file.write((char*)&reserved_2_, 8);
@@ -289,7 +293,7 @@ protected:
             file.read((char*)&max_surfels_per_node_, 4);
             file.read((char*)&serialized_surfel_size_, 4);
             file.read((char*)&primitive_, 4);
-            file.read((char*)&reserved_0_, 4);
+            file.read((char*)&compression_, 4);
             file.read((char*)&state_, 4);
             file.read((char*)&reserved_1_, 4);
             file.read((char*)&reserved_2_, 8);
@@ -45,10 +45,15 @@ public:
     void                lock();
     void                unlock();
 
-    void                aquire_node(const context_t context_id, const view_t view_id, const model_t model_id, const node_t node_id);
-    void                release_node(const context_t context_id, const view_t view_id, const model_t model_id, const node_t node_id);
+    //return true if a free slot was used up or given back
+    const bool          aquire_node(const context_t context_id, const view_t view_id, const model_t model_id, const node_t node_id);
+    const bool          release_node(const context_t context_id, const view_t view_id, const model_t model_id, const node_t node_id);
     const bool          release_node_invalidate(const context_t context_id, const view_t view_id, const model_t model_id, const node_t node_id);
 
+    //projected error hint for the eviction policy
+    const bool          uses_node_errors() const;
+    void                update_node_error(const model_t model_id, const node_t node_id, const float error);
+
 protected:
                         cache(const slot_t num_slots);
 
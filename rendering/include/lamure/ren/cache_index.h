@@ -12,13 +12,15 @@
 #include <lamure/utils.h>
 #include <lamure/ren/config.h>
 #include <lamure/ren/platform.h>
+#include <lamure/ren/cache_policy.h>
+#include <lamure/ren/flat_key_map.h>
 
 #include <vector>
-#include <set>
-#include <map>
-#include <unordered_map>
+#include <memory>
 #include <mutex>
 #include <iostream>
+#include <fstream>
+#include <string>
 
 
 namespace lamure {
@@ -27,7 +29,8 @@ namespace ren {
 class RENDERING_DLL cache_index
 {
 public:
-                        cache_index(const model_t num_models, const slot_t num_slots);
+                        cache_index(const model_t num_models, const slot_t num_slots,
+                                    const cache_policy::policy_type policy_type = cache_policy::policy_type::LRU);
     virtual             ~cache_index();
 
     const slot_t        num_slots() const { return num_slots_; };
@@ -41,12 +44,23 @@ public:
     const bool          is_node_indexed(const model_t model_id, const node_t node_id);
     const bool          is_node_aquired(const model_t model_id, const node_t node_id);
 
-    void                aquire_slot(const view_t view_id, const model_t model_id, const node_t node_id);
-    void                release_slot(const view_t view_id, const model_t model_id, const node_t node_id);
+    //return true if the slot was taken from or returned to the free slots
+    const bool          aquire_slot(const view_t view_id, const model_t model_id, const node_t node_id);
+    const bool          release_slot(const view_t view_id, const model_t model_id, const node_t node_id);
     const bool          release_slot_invalidate(const view_t view_id, const model_t model_id, const node_t node_id);
 
+    //projected error of a resident node, only kept if the policy uses it
+    const bool          uses_node_errors() const { return policy_->uses_node_errors() || trace_enabled_; };
+    void                update_node_error(const model_t model_id, const node_t node_id, const float error);
+
+    //log aquire, release and error updates for cache_trace_simulator
+    void                start_trace(const std::string& filename);
+
 private:
 
+    //views are tracked as bits, at most 64 distinct (context, view) pairs
+    const uint64_t      view_bit(const view_t view_id);
+
     model_t             num_models_;
     slot_t              num_slots_;
     slot_t              num_free_slots_;
@@ -54,33 +68,29 @@ private:
 
     struct cache_index_node
     {
-        cache_index_node(
-            const model_t model_id,
-            const node_t node_id,
-            const slot_t prev,
-            const slot_t next)
-            : model_id_(model_id),
-            node_id_(node_id),
-            prev_(prev),
-            next_(next) {};
-
         cache_index_node()
             : model_id_(invalid_model_t),
             node_id_(invalid_node_t),
-            prev_(invalid_slot_t),
-            next_(invalid_slot_t) {};
+            evictable_(true),
+            views_(0) {};
 
         model_t         model_id_;
         node_t          node_id_;
-        slot_t          prev_;
-        slot_t          next_;
-        std::set<view_t> views_;
+        //slot is known to the policy and may be reserved
+        bool            evictable_;
+        uint64_t        views_;
     };
 
     std::mutex          mutex_;
 
     std::vector<cache_index_node> slots_;
-    std::vector<std::map<node_t, slot_t>> maps_;
+    flat_key_map<slot_t> map_;
+    std::vector<view_t> view_ids_;
+
+    std::unique_ptr<cache_policy> policy_;
+
+    bool                trace_enabled_;
+    std::ofstream       trace_;
 };
 
 
@@ -0,0 +1,96 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef REN_CACHE_POLICY_H_
+#define REN_CACHE_POLICY_H_
+
+#include <lamure/types.h>
+#include <lamure/ren/platform.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lamure {
+namespace ren {
+
+/**
+* Eviction policy of a cache_index.
+*
+* The policy orders the slots that may be handed out by reserve_slot:
+* empty slots and slots whose node is not aquired by any view. Reserved
+* and aquired slots are not tracked until they are given back.
+* All calls are serialized by the owning cache_index.
+*/
+class RENDERING_DLL cache_policy
+{
+public:
+    enum policy_type
+    {
+        LRU = 0,
+        TWO_QUEUE = 1,
+        ARC = 2,
+        ERROR_WEIGHTED = 3
+    };
+
+    static cache_policy* create(const policy_type type, const slot_t num_slots);
+    static const std::string type_name(const policy_type type);
+
+                        cache_policy(const cache_policy&) = delete;
+                        cache_policy& operator=(const cache_policy&) = delete;
+    virtual             ~cache_policy() {};
+
+    //slot is empty, it is handed out before any resident node is evicted
+    virtual void        insert_free(const slot_t slot_id);
+    //slot was reserved and now holds the node with the given key
+    virtual void        insert(const slot_t slot_id, const uint64_t key) = 0;
+    //slot was aquired and is no longer evictable
+    virtual void        remove(const slot_t slot_id) = 0;
+    //slot was released by the last view that aquired it
+    virtual void        release(const slot_t slot_id) = 0;
+    //choose the next slot to reserve and stop tracking it
+    virtual const slot_t victim() = 0;
+
+    virtual const bool  uses_node_errors() const { return false; };
+    virtual void        update_node_error(const slot_t slot_id, const float error) {};
+
+protected:
+                        cache_policy(const slot_t num_slots, const uint32_t num_lists);
+
+    //list 0 holds the empty slots
+    static const uint32_t free_list_ = 0;
+    static const uint32_t no_list_ = 0xFFFFFFFF;
+
+    void                push_back(const uint32_t list, const slot_t slot_id);
+    void                push_front(const uint32_t list, const slot_t slot_id);
+    void                erase(const slot_t slot_id);
+    const slot_t        front(const uint32_t list) const { return next_[num_slots_ + list]; };
+    const slot_t        next(const slot_t slot_id) const { return next_[slot_id]; };
+    const bool          is_end(const uint32_t list, const slot_t slot_id) const { return slot_id == num_slots_ + list; };
+    const bool          empty(const uint32_t list) const { return sizes_[list] == 0; };
+    const slot_t        size(const uint32_t list) const { return sizes_[list]; };
+    const uint32_t      list_of(const slot_t slot_id) const { return lists_[slot_id]; };
+
+    const slot_t        pop_front(const uint32_t list);
+
+    slot_t              num_slots_;
+    std::vector<uint64_t> keys_;
+
+private:
+    //intrusive doubly linked lists over the slots,
+    //entries past num_slots_ are the sentinels of the lists
+    std::vector<slot_t> prev_;
+    std::vector<slot_t> next_;
+    std::vector<uint32_t> lists_;
+    std::vector<slot_t> sizes_;
+};
+
+
+} } // namespace lamure
+
+
+#endif // REN_CACHE_POLICY_H_
@@ -8,13 +8,13 @@
 #ifndef REN_CACHE_QUEUE_H_
 #define REN_CACHE_QUEUE_H_
 
+#include <atomic>
+#include <memory>
 #include <mutex>
-#include <queue>
-#include <unordered_map>
-#include <unordered_set>
-#include <deque>
+#include <vector>
 
 #include <lamure/ren/platform.h>
+#include <lamure/mpsc_queue.h>
 #include <lamure/utils.h>
 
 namespace lamure {
@@ -77,34 +77,75 @@ public:
     };
 
                         cache_queue();
+                        cache_queue(const cache_queue&) = delete;
+                        cache_queue& operator=(const cache_queue&) = delete;
     virtual             ~cache_queue();
 
+    // lock-free, may be called from any thread
     bool                push_job(const job& job);
+    void                update_job(const model_t model_id, const node_t node_id, int32_t priority);
+    const query_result  is_node_indexed(const model_t model_id, const node_t node_id);
+    const size_t        num_jobs();
+
+    // consumers, serialized among each other
     const job           top_job();
+    const size_t        top_jobs(std::vector<job>& jobs, const size_t max_jobs);
     void                pop_job(const job& job);
-    void                update_job(const model_t model_id, const node_t node_id, int32_t priority);
     const abort_result  abort_job(const job& job);
 
-    const size_t        num_jobs();
-    void                initialize(const update_mode mode, const model_t num_models);
-    const query_result  is_node_indexed(const model_t model_id, const node_t node_id);
+    void                initialize(const update_mode mode, const std::vector<node_t>& num_nodes_per_model);
 
 private:
-    void                swap(const size_t slot_id_0, const size_t slot_id_1);
-    void                shuffle_up(const size_t slot_id);
-    void                shuffle_down(const size_t slot_id);
+    enum node_state : uint8_t
+    {
+        STATE_NOT_INDEXED,
+        STATE_WAITING,
+        STATE_LOADING
+    };
+
+    enum message_type : uint8_t
+    {
+        MESSAGE_PUSH,
+        MESSAGE_UPDATE,
+        MESSAGE_ABORT
+    };
+
+    struct message
+    {
+        message_type    type_;
+        job             job_;
+    };
+
+    static const uint32_t invalid_position = 0xFFFFFFFF;
+    static const size_t heap_arity = 4;
+
+    void                submit(const message& msg);
+    void                drain();
+    void                apply(const message& msg);
+
+    void                take_top(std::vector<job>& jobs);
+    void                remove_at(const uint32_t pos);
+    void                place(const uint32_t pos, const job& job);
+    void                sift_up(uint32_t pos);
+    void                sift_down(uint32_t pos);
 
-    size_t              num_slots_;
     model_t             num_models_;
-    std::mutex          mutex_;
     update_mode         mode_;
     bool                initialized_;
 
-    std::vector<job>    slots_;
+    // requests from producers, applied to the heap by the consumer
+    // holding owner_mutex_
+    mpsc_queue<message> messages_;
+    std::mutex          owner_mutex_;
+
+    // indexed 4-ary max-heap over the waiting jobs
+    std::vector<job>    heap_;
+
+    // flat per-model arrays indexed by node id
+    std::vector<std::unique_ptr<std::atomic<uint8_t>[]>> states_;
+    std::vector<std::vector<uint32_t>> positions_;
 
-    //mapping (model, node) to slot
-    std::vector<std::unordered_map<node_t, slot_t>> requested_set_;
-    std::vector<std::unordered_set<node_t>> pending_set_;
+    std::atomic<size_t> num_waiting_;
 };
 
 
@@ -66,6 +66,19 @@ namespace ren {
 #define LAMURE_CUT_UPDATE_PREFETCH_FACTOR 5.f
 #define LAMURE_CUT_UPDATE_PREFETCH_BUDGET 1024
 
+//predictive prefetching, enabled by policy::set_predictive_prefetching
+//number of camera samples the motion is extrapolated from
+#define LAMURE_CUT_UPDATE_PREDICTION_HISTORY 8
+//a camera at rest is sampled at this interval only
+#define LAMURE_CUT_UPDATE_PREDICTION_REST_INTERVAL_MS 100.0
+//how far ahead and at how many points in between the view is predicted
+#define LAMURE_CUT_UPDATE_PREDICTION_LOOKAHEAD_MS 500.0
+#define LAMURE_CUT_UPDATE_PREDICTION_STEPS 2
+//max. number of nodes requested per cut update
+#define LAMURE_CUT_UPDATE_PREDICTION_BUDGET 256
+//prefetched nodes not used by a split within this time count as expired
+#define LAMURE_CUT_UPDATE_PREDICTION_EXPIRY_MS 5000.0
+
 #define LAMURE_MIN_UPLOAD_BUDGET 16
 #define LAMURE_MIN_VIDEO_MEMORY_BUDGET 128
 #define LAMURE_MIN_MAIN_MEMORY_BUDGET 512
@@ -84,6 +97,12 @@ namespace ren {
 //#define LAMURE_CUT_UPDATE_ENABLE_CACHE_MAINTENANCE
 #define LAMURE_CUT_UPDATE_CACHE_MAINTENANCE_COUNTER 500
 
+//slot eviction of ooc_cache and gpu_cache
+#define LAMURE_CUT_UPDATE_CACHE_EVICTION_POLICY cache_policy::policy_type::LRU
+//#define LAMURE_CUT_UPDATE_CACHE_EVICTION_POLICY cache_policy::policy_type::TWO_QUEUE
+//#define LAMURE_CUT_UPDATE_CACHE_EVICTION_POLICY cache_policy::policy_type::ARC
+//#define LAMURE_CUT_UPDATE_CACHE_EVICTION_POLICY cache_policy::policy_type::ERROR_WEIGHTED
+
 //------------------------------
 //for ooc_pool:
 //------------------------------
@@ -91,6 +110,9 @@ namespace ren {
 #define LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE cache_queue::update_mode::UPDATE_ALWAYS
 //#define LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE cache_queue::update_mode::UPDATE_INCREMENT_ONLY
 
+//number of reads in flight when the asynchronous io backend is selected
+#define LAMURE_CUT_UPDATE_ASYNC_IO_QUEUE_DEPTH 128
+
 //------------------------------
 //for bvh_stream: 
 //------------------------------
@@ -100,6 +122,11 @@ namespace ren {
 //------------------------------
 #define LAMURE_WYSIWYG_SPLAT_SCALE 1.3f
 
+//rays traced together by the ray_picker
+#define LAMURE_PICKING_PACKET_SIZE 8
+//worker threads of the ray_picker, 0 uses one per hardware thread
+#define LAMURE_PICKING_NUM_THREADS 0
+
 #ifdef LAMURE_CUT_UPDATE_ENABLE_CUT_UPDATE_EXPERIMENTAL_MODE
 #undef LAMURE_CUT_UPDATE_ENABLE_SPLIT_AGAIN_MODE
 #endif
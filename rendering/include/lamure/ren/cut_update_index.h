@@ -12,15 +12,11 @@
 #include <lamure/utils.h>
 #include <lamure/ren/config.h>
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
-#include <queue>
 #include <set>
-#include <map>
 #include <mutex>
+#include <memory>
 #include <assert.h>
 #include <algorithm>
-#include <stack>
 
 #include <lamure/ren/model_database.h>
 
@@ -99,8 +95,17 @@ public:
     void                pop_front_action(const queue_t queue);
     void                Popback_action(const queue_t queue);
 
-    const std::set<node_t>& get_current_cut(const view_t view_id, const model_t model_id);
-    const std::set<node_t>& get_previous_cut(const view_t view_id, const model_t model_id);
+    //the queues are partitioned per model, actions of different models
+    //can be processed concurrently through these
+    const size_t        num_actions(const queue_t queue, const model_t model_id);
+    const action        front_action(const queue_t queue, const model_t model_id);
+    const action        back_action(const queue_t queue, const model_t model_id);
+    void                pop_front_action(const queue_t queue, const model_t model_id);
+    void                Popback_action(const queue_t queue, const model_t model_id);
+
+    //cuts are returned as node ids in ascending order
+    const std::vector<node_t>& get_current_cut(const view_t view_id, const model_t model_id);
+    const std::vector<node_t>& get_previous_cut(const view_t view_id, const model_t model_id);
     void                swap_cuts();
     void                reset_cut(const view_t view_id, const model_t model_id);
 
@@ -124,13 +129,69 @@ private:
         INVALID_FRONT = 2
     };
 
+    //node ids of one cut plus a membership bitset over all nodes of the model,
+    //the node list is sorted lazily when the cut is requested
+    struct cut_set
+    {
+        void            insert(const node_t node_id, const node_t num_nodes);
+        void            erase(const node_t node_id);
+        void            clear();
+        const std::vector<node_t>& sorted();
+
+        std::vector<node_t>   nodes_;
+        std::vector<uint64_t> bits_;
+        //node -> index in nodes_, only valid while the node's bit is set
+        std::vector<uint32_t> positions_;
+        bool            sorted_ = true;
+    };
+
+    //actions live in a per-model pool and never move, the heaps only hold
+    //(error, record) pairs and every record knows its heap position.
+    //all records of a (model, node) are chained in an intrusive list
+    struct record
+    {
+        action          action_;
+        uint32_t        heap_pos_;
+        uint32_t        prev_;
+        uint32_t        next_;
+    };
+
+    struct heap_entry
+    {
+        float           error_;
+        uint32_t        record_id_;
+    };
+
+    //action queues, records and node lists of one model
+    struct model_actions
+    {
+        std::mutex            mutex_;
+        std::vector<heap_entry> heaps_[queue_t::NUM_QUEUES];
+        std::vector<record>   records_;
+        std::vector<uint32_t> free_records_;
+        //node -> first record of that node in any queue
+        std::vector<uint32_t> node_records_;
+    };
+
+    static const uint32_t invalid_record = 0xFFFFFFFF;
+
     void                add_action(const action& action, bool sort);
+    void                resize_tables();
+
+    cut_set&            current_cut(const view_t view_id, const model_t model_id);
+    cut_set&            previous_cut(const view_t view_id, const model_t model_id);
+
+    model_t             find_front_model(const queue_t queue);
+    model_t             find_back_model(const queue_t queue);
+
+    uint32_t            allocate_record(model_actions& actions, const action& action);
+    void                release_record(model_actions& actions, const uint32_t record_id);
+    void                remove_from_heap(model_actions& actions, const queue_t queue, const size_t heap_pos);
 
-    void                swap(const queue_t queue, const size_t slot_id_0, const size_t slot_id_1);
-    void                shuffle_up(const queue_t queue, const size_t slot_id);
-    void                shuffle_down(const queue_t queue, const size_t slot_id);
+    void                place(model_actions& actions, const queue_t queue, const size_t heap_pos, const heap_entry& entry);
+    void                shuffle_up(model_actions& actions, const queue_t queue, size_t heap_pos);
+    void                shuffle_down(model_actions& actions, const queue_t queue, size_t heap_pos);
 
-    size_t              num_slots_[queue_t::NUM_QUEUES];
     view_t              num_views_;
     model_t             num_models_;
     std::mutex          mutex_;
@@ -139,16 +200,14 @@ private:
     std::vector<node_t> num_nodes_table_;
     std::set<view_t> view_ids_;
 
-    std::vector<action> slots_[queue_t::NUM_QUEUES];
-    std::stack<action> initial_queue_;
+    std::vector<action> initial_queue_;
 
-    //mapping [queue] (model, node) to slot
-    std::vector<std::map<node_t, std::set<slot_t>>> slot_maps_[queue_t::NUM_QUEUES];
+    //[model], the cuts of a model are guarded by its mutex as well
+    std::vector<std::unique_ptr<model_actions>> models_;
 
     cut_front            current_cut_front_;
-    //[user][model][node]
-    std::map<view_t, std::vector<std::set<node_t>>> front_a_cuts_;
-    std::map<view_t, std::vector<std::set<node_t>>> front_b_cuts_;
+    //[front][view][model]
+    std::vector<std::vector<cut_set>> cuts_[2];
 
 };
 
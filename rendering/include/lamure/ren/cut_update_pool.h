@@ -13,6 +13,11 @@
 #include <lamure/semaphore.h>
 
 #include <lamure/utils.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <lamure/ren/cut_database.h>
@@ -44,19 +49,56 @@ class cut_update_pool
     // void                    dispatch_cut_update(char* current_gpu_storage_A, char* current_gpu_storage_B);
     const bool is_running();
 
+    // wall clock time spent in the phases of the last finished cut update,
+    // summed over all updates of that frame in repeat mode
+    struct latency
+    {
+        double analysis_ms_ = 0.0;
+        double update_ms_ = 0.0;
+        double total_ms_ = 0.0;
+        uint32_t num_updates_ = 0;
+    };
+
+    const latency last_latency();
+
+    // nodes requested ahead of the camera by the predictive prefetching
+    // and what became of them, counted since the pool was created.
+    // hits / prefetched is the accuracy of the prediction,
+    // hits / (hits + demand loads) the share of splits it served
+    struct prefetch_statistics
+    {
+        size_t num_prefetched_ = 0;
+        size_t num_prefetch_hits_ = 0;
+        size_t num_prefetch_expired_ = 0;
+        size_t num_demand_loads_ = 0;
+    };
+
+    const prefetch_statistics prefetch_stats();
+
   protected:
+    // slots a model may consume during the update phase without
+    // consulting the shared pools
+    struct slot_budget
+    {
+        int64_t gpu_slots_;
+        int64_t ooc_slots_;
+        int64_t transfer_slots_;
+    };
+
     void initialize(bool provenance = false);
     const bool prepare();
 
     void split_node(const cut_update_index::action &item);
     void collapse_node(const cut_update_index::action &item);
+    const bool aquire_children(const cut_update_index::action &item, const std::vector<node_t> &child_ids);
     void cut_update_split_again(const cut_update_index::action &split_action);
 
-    const bool is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::set<node_t> &cut);
+    const bool is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::vector<node_t> &cut);
     const bool is_node_in_frustum(const view_t view_id, const model_t model_id, const node_t node_id, const scm::gl::frustum &frustum);
     const bool is_no_node_in_frustum(const view_t view_id, const model_t model_id, const std::vector<node_t> &node_ids, const scm::gl::frustum &frustum);
 
     const float calculate_node_error(const view_t view_id, const model_t model_id, const node_t node_id);
+    const float calculate_node_error(const view_t view_id, const model_t model_id, const node_t node_id, const scm::math::mat4f &view_matrix);
 
     /*virtual*/ void run();
     void shutdown();
@@ -64,14 +106,31 @@ class cut_update_pool
     void cut_master();
     void cut_analysis(view_t view_id, model_t model_id);
     void cut_update();
+    void cut_update_worker();
+    void cut_update_model(const model_t model_id);
+    void distribute_budgets();
+    const bool draw_budget(slot_budget &budget, const int64_t num_gpu_slots, const int64_t num_ooc_slots);
     void compile_transfer_list();
     void compile_render_list();
 #ifdef LAMURE_CUT_UPDATE_ENABLE_PREFETCHING
     void prefetch_routine();
 #endif
+    void record_camera_history();
+    const bool predict_view_matrix(const view_t view_id, const double lookahead_ms, scm::math::mat4f &predicted_view_matrix);
+    void predictive_prefetch_routine();
+    void count_prefetch_hits(const model_t model_id, const std::vector<node_t> &node_ids);
+    void count_demand_load();
 
   private:
     bool is_shutdown();
+    const bool take_model(const uint32_t worker_id, model_t &model_id);
+
+    // models still to be updated by a worker, stolen from the back by the others
+    struct update_worker
+    {
+        std::mutex mutex_;
+        std::deque<model_t> model_ids_;
+    };
 
     Data_Provenance _data_provenance;
     context_t context_id_;
@@ -87,6 +146,16 @@ class cut_update_pool
 
     cut_update_queue job_queue_;
 
+    std::vector<std::unique_ptr<update_worker>> update_workers_;
+    std::atomic<uint32_t> next_update_worker_;
+
+    std::vector<slot_budget> model_budgets_;
+    std::atomic<int64_t> shared_gpu_slots_;
+    std::atomic<int64_t> shared_ooc_slots_;
+    std::atomic<int64_t> shared_transfer_slots_;
+
+    latency last_latency_;
+
     gpu_cache *gpu_cache_;
     cut_update_index *index_;
 
@@ -120,9 +189,24 @@ class cut_update_pool
 #endif
 
 #ifdef LAMURE_CUT_UPDATE_ENABLE_PREFETCHING
+    std::mutex prefetch_mutex_;
     std::vector<cut_update_index::action> pending_prefetch_set_;
 #endif
 
+    struct camera_sample
+    {
+        std::chrono::steady_clock::time_point time_;
+        scm::math::mat4f view_matrix_;
+    };
+
+    bool predictive_prefetching_;
+    std::map<view_t, std::deque<camera_sample>> camera_history_;
+
+    // prefetched nodes not yet used by a split, keyed by model and node
+    std::mutex prediction_mutex_;
+    std::unordered_map<uint64_t, std::chrono::steady_clock::time_point> predicted_nodes_;
+    prefetch_statistics prefetch_statistics_;
+
 #ifdef LAMURE_CUT_UPDATE_ENABLE_REPEAT_MODE
     boost::timer::cpu_timer master_timer_;
 
@@ -0,0 +1,124 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef REN_FLAT_KEY_MAP_H_
+#define REN_FLAT_KEY_MAP_H_
+
+#include <lamure/types.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace lamure {
+namespace ren {
+
+/**
+* Open addressing hash map from packed (model, node) keys to values.
+* The number of entries is bounded by the caller, so the table is
+* allocated once and never rehashed. Collisions are resolved by linear
+* probing, erase shifts the following entries back instead of leaving
+* tombstones.
+*/
+template <typename value_t>
+class flat_key_map
+{
+public:
+    explicit            flat_key_map(const size_t max_entries)
+                        : num_entries_(0), mask_(0), shift_(64) {
+                            size_t capacity = 16;
+                            while (capacity < 2 * max_entries) {
+                                capacity <<= 1;
+                            }
+                            mask_ = capacity - 1;
+                            while ((size_t(1) << (64 - shift_)) < capacity) {
+                                --shift_;
+                            }
+                            keys_.resize(capacity, empty_key());
+                            values_.resize(capacity);
+                        };
+
+    static const uint64_t make_key(const model_t model_id, const node_t node_id) {
+                            return (uint64_t(model_id) << 32) | uint64_t(node_id);
+                        };
+
+    const size_t        size() const { return num_entries_; };
+
+    const bool          find(const uint64_t key, value_t& value) const {
+                            for (size_t i = bucket(key); keys_[i] != empty_key(); i = (i + 1) & mask_) {
+                                if (keys_[i] == key) {
+                                    value = values_[i];
+                                    return true;
+                                }
+                            }
+                            return false;
+                        };
+
+    const bool          contains(const uint64_t key) const {
+                            value_t value;
+                            return find(key, value);
+                        };
+
+    void                insert(const uint64_t key, const value_t& value) {
+                            size_t i = bucket(key);
+                            for (; keys_[i] != empty_key(); i = (i + 1) & mask_) {
+                                if (keys_[i] == key) {
+                                    values_[i] = value;
+                                    return;
+                                }
+                            }
+                            keys_[i] = key;
+                            values_[i] = value;
+                            ++num_entries_;
+                        };
+
+    const bool          erase(const uint64_t key) {
+                            size_t i = bucket(key);
+                            for (; keys_[i] != key; i = (i + 1) & mask_) {
+                                if (keys_[i] == empty_key()) {
+                                    return false;
+                                }
+                            }
+
+                            //move back entries that were displaced past the hole
+                            size_t j = i;
+                            while (true) {
+                                j = (j + 1) & mask_;
+                                if (keys_[j] == empty_key()) {
+                                    break;
+                                }
+                                const size_t home = bucket(keys_[j]);
+                                const bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                                if (!stays) {
+                                    keys_[i] = keys_[j];
+                                    values_[i] = values_[j];
+                                    i = j;
+                                }
+                            }
+
+                            keys_[i] = empty_key();
+                            --num_entries_;
+                            return true;
+                        };
+
+private:
+    //invalid model and invalid node, never inserted
+    static const uint64_t empty_key() { return ~uint64_t(0); };
+
+    const size_t        bucket(const uint64_t key) const {
+                            return size_t((key * 0x9E3779B97F4A7C15ull) >> shift_) & mask_;
+                        };
+
+    std::vector<uint64_t> keys_;
+    std::vector<value_t> values_;
+    size_t              num_entries_;
+    size_t              mask_;
+    uint32_t            shift_;
+};
+
+} } // namespace lamure
+
+#endif // REN_FLAT_KEY_MAP_H_
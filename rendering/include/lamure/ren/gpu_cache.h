@@ -10,6 +10,7 @@
 
 #include <lamure/types.h>
 #include <unordered_set>
+#include <atomic>
 #include <lamure/utils.h>
 #include <lamure/ren/cache.h>
 
@@ -34,11 +35,13 @@ public:
     const bool          register_node(const model_t model_id, const node_t node_id);
 
     void                reset_transfer_list();
-    void                remove_from_transfer_list(const model_t model_id, const node_t node_id);
+    //return true if the node was pending for transfer
+    const bool          remove_from_transfer_list(const model_t model_id, const node_t node_id);
 
 private:
     /* data */
-    node_t              transfer_budget_;
+    //decremented by concurrent cut update workers
+    std::atomic<node_t> transfer_budget_;
     node_t              transfer_slots_written_;
     std::vector<std::unordered_set<node_t>> transfer_list_;
 
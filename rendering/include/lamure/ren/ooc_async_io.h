@@ -0,0 +1,117 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef REN_OOC_ASYNC_IO_H_
+#define REN_OOC_ASYNC_IO_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <lamure/ren/platform.h>
+#include <lamure/ren/ooc_file.h>
+#include <lamure/types.h>
+
+struct iovec;
+
+namespace lamure {
+namespace ren
+{
+
+/**
+* Batched asynchronous reads for the out-of-core cache.
+* Reads are queued with submit(), handed over to the kernel in one go
+* with flush() and retired with reap(). On Linux, io_uring is used if
+* the kernel supports it; otherwise a pool of threads performs
+* positional reads.
+*/
+class RENDERING_DLL ooc_async_io
+{
+public:
+                        ooc_async_io(const uint32_t queue_depth, const uint32_t num_fallback_threads);
+                        ooc_async_io(const ooc_async_io&) = delete;
+                        ooc_async_io& operator=(const ooc_async_io&) = delete;
+    virtual             ~ooc_async_io();
+
+    const bool          is_kernel_backed() const { return ring_fd_ >= 0; };
+    const uint32_t      queue_depth() const { return queue_depth_; };
+    const uint32_t      num_free() const { return (uint32_t)free_requests_.size(); };
+    const uint32_t      num_in_flight() const { return queue_depth_ - num_free(); };
+
+    // queues a read, returns false if the queue depth is exhausted
+    bool                submit(const ooc_file& file,
+                               char* const data,
+                               const size_t start_in_file,
+                               const size_t length_in_bytes,
+                               const uint64_t tag);
+
+    // hands all queued reads over to the backend
+    void                flush();
+
+    // collects the tags of completed reads, blocks until at least
+    // min_completions reads are done
+    void                reap(std::vector<uint64_t>& tags, const uint32_t min_completions);
+
+private:
+    struct request
+    {
+        const ooc_file* file_;
+        char*           data_;
+        size_t          offset_;
+        size_t          length_;
+        size_t          done_;
+        uint64_t        tag_;
+    };
+
+    bool                setup_ring();
+    void                release_ring();
+    bool                push_sqe(const uint32_t request_id);
+    void                enter(const uint32_t min_completions);
+    void                reap_ring(std::vector<uint64_t>& tags);
+
+    void                run_fallback();
+
+    uint32_t            queue_depth_;
+
+    std::vector<request> requests_;
+    std::vector<uint32_t> free_requests_;
+    std::vector<uint32_t> queued_requests_;
+    uint32_t            num_unsubmitted_;
+
+    // io_uring state
+    int                 ring_fd_;
+    void*               sq_ring_;
+    void*               cq_ring_;
+    void*               sqes_;
+    size_t              sq_ring_size_;
+    size_t              cq_ring_size_;
+    size_t              sqes_size_;
+    uint32_t*           sq_head_;
+    uint32_t*           sq_tail_;
+    uint32_t*           sq_mask_;
+    uint32_t*           sq_array_;
+    uint32_t*           cq_head_;
+    uint32_t*           cq_tail_;
+    uint32_t*           cq_mask_;
+    void*               cqes_;
+    ::iovec*            iovecs_;
+
+    // thread fallback state
+    std::vector<std::thread> threads_;
+    std::mutex          mutex_;
+    std::condition_variable submitted_signal_;
+    std::condition_variable completed_signal_;
+    std::deque<uint32_t> submitted_;
+    std::vector<uint32_t> completed_;
+    bool                shutdown_;
+};
+
+} } // namespace lamure
+
+#endif // REN_OOC_ASYNC_IO_H_
@@ -36,7 +36,10 @@ class RENDERING_DLL ooc_cache : public cache
     static ooc_cache *get_instance(Data_Provenance const &data_provenance);
     static ooc_cache *get_instance();
 
-    void register_node(const model_t model_id, const node_t node_id, const int32_t priority);
+    // returns true if a free slot was reserved to load the node into,
+    // a node that is already waiting for a loader keeps its priority
+    // unless update_priority is set
+    const bool register_node(const model_t model_id, const node_t node_id, const int32_t priority, const bool update_priority = true);
     char *node_data(const model_t model_id, const node_t node_id);
     char *node_data_provenance(const model_t model_id, const node_t node_id);
 
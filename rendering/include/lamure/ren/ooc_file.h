@@ -0,0 +1,69 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef REN_OOC_FILE_H_
+#define REN_OOC_FILE_H_
+
+#include <string>
+#include <cstdio>
+
+#include <lamure/ren/platform.h>
+#include <lamure/utils.h>
+#include <lamure/ren/config.h>
+
+namespace lamure {
+namespace ren
+{
+
+/**
+* Read-only file handle for the out-of-core loader threads.
+* The file stays open for the lifetime of the handle and is read with
+* positional reads, so no seek state is shared between reads.
+* Optionally, the whole file is memory-mapped instead.
+*/
+class RENDERING_DLL ooc_file
+{
+public:
+                        ooc_file();
+                        ooc_file(const ooc_file&) = delete;
+                        ooc_file& operator=(const ooc_file&) = delete;
+    virtual             ~ooc_file();
+
+    void                open(const std::string& file_name,
+                             const bool memory_mapped = false);
+    void                close();
+    const bool          is_file_open() const { return is_file_open_; };
+    const bool          is_memory_mapped() const { return mapped_data_ != nullptr; };
+    const std::string&  file_name() const { return file_name_; };
+    const size_t        size() const { return size_; };
+#ifdef WIN32
+    void*               native_handle() const { return handle_; };
+#else
+    const int           native_handle() const { return handle_; };
+#endif
+
+    void                read(char* const data,
+                             const size_t start_in_file,
+                             const size_t length_in_bytes) const;
+
+private:
+#ifdef WIN32
+    void*               handle_;
+    void*               mapping_;
+#else
+    int                 handle_;
+#endif
+    char*               mapped_data_;
+    size_t              size_;
+
+    std::string         file_name_;
+    bool                is_file_open_;
+};
+
+} } // namespace lamure
+
+#endif // REN_OOC_FILE_H_
@@ -14,7 +14,9 @@
 #include <lamure/ren/config.h>
 #include <lamure/ren/lod_stream.h>
 #include <lamure/ren/model_database.h>
-#include <lamure/ren/provenance_stream.h>
+#include <lamure/ren/ooc_async_io.h>
+#include <lamure/ren/ooc_file.h>
+#include <lamure/ren/policy.h>
 #include <lamure/types.h>
 #include <lamure/utils.h>
 #include <map>
@@ -60,9 +62,14 @@ class ooc_pool
 
   protected:
     void run();
+    void run_async();
     bool is_shutdown();
 
   private:
+    void start_threads();
+    void get_file_names(std::vector<std::string> &lod_file_names, std::vector<std::string> &provenance_file_names);
+    void load_node_offsets();
+
     bool locked_;
     semaphore semaphore_;
     size_t size_of_slot_;
@@ -81,6 +88,9 @@ class ooc_pool
     cache_queue priority_queue_;
 
     Data_Provenance _data_provenance;
+
+    // offsets of the deflated nodes per model, empty for uncompressed models
+    std::vector<std::vector<uint64_t>> node_offsets_;
 };
 }
 } // namespace lamure
@@ -15,6 +15,9 @@
 #include <lamure/types.h>
 #include <lamure/memory.h>
 #include <lamure/config.h>
+#include <lamure/ren/cache_policy.h>
+
+#include <string>
 
 namespace lamure {
 namespace ren {
@@ -33,12 +36,28 @@ public:
     void                set_render_budget_in_mb(const size_t render_budget) { render_budget_in_mb_ = render_budget; };
     void                set_out_of_core_budget_in_mb(const size_t out_of_core_budget) { out_of_core_budget_in_mb_ = out_of_core_budget; };
     void                set_size_of_provenance(const size_t size_of_provenance) { size_of_provenance_ = size_of_provenance; };
+    void                set_num_loading_threads(const uint32_t num_loading_threads) { num_loading_threads_ = num_loading_threads; };
+    void                set_out_of_core_memory_mapped(const bool memory_mapped) { out_of_core_memory_mapped_ = memory_mapped; };
+    void                set_out_of_core_async_io(const bool async_io) { out_of_core_async_io_ = async_io; };
+    void                set_out_of_core_io_queue_depth(const uint32_t queue_depth) { out_of_core_io_queue_depth_ = queue_depth; };
+    void                set_measure_cut_update_latency(const bool measure_latency) { measure_cut_update_latency_ = measure_latency; };
+    void                set_cache_eviction_policy(const cache_policy::policy_type eviction_policy) { cache_eviction_policy_ = eviction_policy; };
+    void                set_cache_trace_file(const std::string& trace_file) { cache_trace_file_ = trace_file; };
+    void                set_predictive_prefetching(const bool predictive_prefetching) { predictive_prefetching_ = predictive_prefetching; };
 
     const bool          reset_system() const { return reset_system_; };
     const size_t        max_upload_budget_in_mb() const { return max_upload_budget_in_mb_; };
     const size_t        render_budget_in_mb() const { return render_budget_in_mb_; };
     const size_t        out_of_core_budget_in_mb() const { return out_of_core_budget_in_mb_; };
     const size_t        size_of_provenance() const { return size_of_provenance_; };
+    const uint32_t      num_loading_threads() const { return num_loading_threads_; };
+    const bool          out_of_core_memory_mapped() const { return out_of_core_memory_mapped_; };
+    const bool          out_of_core_async_io() const { return out_of_core_async_io_; };
+    const uint32_t      out_of_core_io_queue_depth() const { return out_of_core_io_queue_depth_; };
+    const bool          measure_cut_update_latency() const { return measure_cut_update_latency_; };
+    const cache_policy::policy_type cache_eviction_policy() const { return cache_eviction_policy_; };
+    const std::string&  cache_trace_file() const { return cache_trace_file_; };
+    const bool          predictive_prefetching() const { return predictive_prefetching_; };
 
     const int32_t       window_width() const { return window_width_; };
     const int32_t       window_height() const { return window_height_; };
@@ -64,6 +83,18 @@ private:
 
     size_t              size_of_provenance_;
 
+    uint32_t            num_loading_threads_;
+    bool                out_of_core_memory_mapped_;
+    bool                out_of_core_async_io_;
+    uint32_t            out_of_core_io_queue_depth_;
+
+    bool                measure_cut_update_latency_;
+
+    cache_policy::policy_type cache_eviction_policy_;
+    std::string         cache_trace_file_;
+
+    bool                predictive_prefetching_;
+
     int32_t             window_width_;
     int32_t             window_height_;
 
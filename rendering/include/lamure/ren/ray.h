@@ -131,6 +131,8 @@ class ray_queue
 
     void push_job(const ray_job &job);
     const ray_job pop_job();
+    // takes all queued jobs at once, shuts the queue down like pop_job
+    void pop_all_jobs(std::vector<ray_job> &jobs);
 
     void wait();
     void relaunch();
@@ -0,0 +1,107 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef REN_RAY_PICKER_H_
+#define REN_RAY_PICKER_H_
+
+#include <lamure/ren/config.h>
+#include <lamure/ren/platform.h>
+#include <lamure/ren/ray.h>
+#include <lamure/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lamure
+{
+namespace ren
+{
+/**
+ * Splat-based picking of many rays at once.
+ *
+ * Rays are traced in packets of LAMURE_PICKING_PACKET_SIZE through the
+ * resident nodes of a model. A packet is culled against each bounding box
+ * in one go, and the surfels of a node are tested against the rays of the
+ * packet in batches of the same width, stored as structure of arrays.
+ * Packets are distributed over worker threads that persist between calls.
+ *
+ * Every ray receives the intersection ray::intersect_model would
+ * report for it (without wysiwyg, unless requested).
+ */
+class RENDERING_DLL ray_picker
+{
+  public:
+    ray_picker(const ray_picker &) = delete;
+    ray_picker &operator=(const ray_picker &) = delete;
+    virtual ~ray_picker();
+
+    static ray_picker *get_instance();
+
+    const uint32_t num_threads() const { return threads_.size() + 1; }
+
+    // all models with their current transforms, rays without hit keep an
+    // error of std::numeric_limits<float>::max(). returns the number of hits
+    const size_t intersect(const std::vector<ray> &rays, const float aabb_scale, const unsigned int max_depth, const unsigned int surfel_skip, const bool is_wysiwyg,
+                           std::vector<ray::intersection> &intersections);
+
+    const size_t intersect_model(const model_t model_id, const scm::math::mat4f &model_transform, const std::vector<ray> &rays, const float aabb_scale, const unsigned int max_depth,
+                                 const unsigned int surfel_skip, const bool is_wysiwyg, std::vector<ray::intersection> &intersections);
+
+    // takes all jobs from the queue, the intersections are indexed by job id
+    const size_t intersect(ray_queue &queue, const float aabb_scale, const unsigned int max_depth, const unsigned int surfel_skip, const bool is_wysiwyg,
+                           std::vector<ray::intersection> &intersections);
+
+  protected:
+    explicit ray_picker(const uint32_t num_threads);
+
+    static bool is_instanced_;
+    static ray_picker *single_;
+
+  private:
+    struct picked_model
+    {
+        model_t model_id_;
+        scm::math::mat4f transform_;
+    };
+
+    const size_t run(const std::vector<ray> &rays, const std::vector<picked_model> &models, const unsigned int max_depth, const unsigned int surfel_skip, const bool is_wysiwyg,
+                     std::vector<ray::intersection> &intersections);
+
+    void worker();
+    void trace_packets();
+    void trace_packet(const size_t first_ray, const uint32_t num_rays, const picked_model &model);
+
+    static std::mutex mutex_;
+
+    // one batch at a time
+    std::mutex batch_mutex_;
+
+    std::mutex worker_mutex_;
+    std::condition_variable batch_available_;
+    std::condition_variable batch_done_;
+    std::vector<std::thread> threads_;
+    uint64_t batch_generation_;
+    uint32_t num_busy_workers_;
+    bool shutdown_;
+
+    // current batch
+    std::atomic<size_t> next_packet_;
+    size_t num_packets_;
+    const std::vector<ray> *rays_;
+    const std::vector<picked_model> *models_;
+    std::vector<ray::intersection> *intersections_;
+    unsigned int max_depth_;
+    unsigned int surfel_skip_;
+    bool is_wysiwyg_;
+};
+}
+} // namespace lamure
+
+#endif // REN_RAY_PICKER_H_
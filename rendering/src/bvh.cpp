@@ -32,7 +32,8 @@ bvh()
   size_of_primitive_(0),
   filename_(""),
   translation_(scm::math::vec3f(0.f)),
-  primitive_(primitive_type::POINTCLOUD) {
+  primitive_(primitive_type::POINTCLOUD),
+  node_compression_(node_compression::UNCOMPRESSED) {
 
 
 } 
@@ -45,7 +46,9 @@ bvh(const std::string& filename)
   primitives_per_node_(0),
   size_of_primitive_(0),
   filename_(""),
-  translation_(scm::math::vec3f(0.f)) {
+  translation_(scm::math::vec3f(0.f)),
+  primitive_(primitive_type::POINTCLOUD),
+  node_compression_(node_compression::UNCOMPRESSED) {
 
     std::string extension = filename.substr(filename.find_last_of(".") + 1);
 
@@ -20,7 +20,7 @@ cache(const slot_t num_slots)
     model_database* database = model_database::get_instance();
 
     slot_size_ = database->get_slot_size();
-    index_ = new cache_index(database->num_models(), num_slots_);
+    index_ = new cache_index(database->num_models(), num_slots_, policy::get_instance()->cache_eviction_policy());
 }
 
 cache::
@@ -46,21 +46,20 @@ slot_id(const model_t model_id, const node_t node_id) {
     return index_->get_slot(model_id, node_id);
 }
 
-void cache::
+const bool cache::
 aquire_node(const context_t context_id, const view_t view_id, const model_t model_id, const node_t node_id) {
-    if (index_->is_node_indexed(model_id, node_id)) {
-        uint32_t hash_id = ((((uint32_t)context_id) & 0xFFFF) << 16) | (((uint32_t)view_id) & 0xFFFF);
-        index_->aquire_slot(hash_id, model_id, node_id);
-    }
+    uint32_t hash_id = ((((uint32_t)context_id) & 0xFFFF) << 16) | (((uint32_t)view_id) & 0xFFFF);
+    return index_->aquire_slot(hash_id, model_id, node_id);
 }
 
-void cache::
+const bool cache::
 release_node(const context_t context_id, const view_t view_id, const model_t model_id, const node_t node_id) {
     if (index_->is_node_indexed(model_id, node_id)) {
         uint32_t hash_id = ((((uint32_t)context_id) & 0xFFFF) << 16) | (((uint32_t)view_id) & 0xFFFF);
-        index_->release_slot(hash_id, model_id, node_id);
+        return index_->release_slot(hash_id, model_id, node_id);
     }
 
+    return false;
 }
 
 const bool cache::
@@ -73,6 +72,16 @@ release_node_invalidate(const context_t context_id, const view_t view_id, const
     return false;
 }
 
+const bool cache::
+uses_node_errors() const {
+    return index_->uses_node_errors();
+}
+
+void cache::
+update_node_error(const model_t model_id, const node_t node_id, const float error) {
+    index_->update_node_error(model_id, node_id, error);
+}
+
 void cache::
 lock() {
     mutex_.lock();
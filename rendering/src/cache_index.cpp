@@ -7,6 +7,9 @@
 
 #include <lamure/ren/cache_index.h>
 
+#include <cassert>
+#include <stdexcept>
+
 
 namespace lamure
 {
@@ -15,21 +18,16 @@ namespace ren
 {
 
 cache_index::
-cache_index(const model_t num_models, const slot_t num_slots)
-    : num_models_(num_models), num_slots_(num_slots), num_free_slots_(num_slots) {
+cache_index(const model_t num_models, const slot_t num_slots, const cache_policy::policy_type policy_type)
+    : num_models_(num_models), num_slots_(num_slots), num_free_slots_(num_slots),
+      slots_(num_slots), map_(num_slots), trace_enabled_(false) {
     assert(num_slots > 0);
 
-    try {
-      for (slot_t i = 0; i < num_slots_ + 2; ++i) {
-        slots_.push_back(cache_index_node(invalid_model_t, invalid_node_t, i - 1, i + 1));
-      }
-
-      slots_[0].prev_ = invalid_slot_t;
-      slots_[num_slots_ + 1].next_ = invalid_slot_t;
+    policy_.reset(cache_policy::create(policy_type, num_slots_));
 
-      maps_.resize(num_models_);
-    }
-    catch (...) {
+    //insert in reverse, the free slots are handed out in ascending order
+    for (slot_t i = num_slots_; i > 0; --i) {
+        policy_->insert_free(i-1);
     }
 }
 
@@ -38,6 +36,22 @@ cache_index::
 
 }
 
+const uint64_t cache_index::
+view_bit(const view_t view_id) {
+    for (size_t i = 0; i < view_ids_.size(); ++i) {
+        if (view_ids_[i] == view_id) {
+            return uint64_t(1) << i;
+        }
+    }
+
+    if (view_ids_.size() >= 64) {
+        throw std::runtime_error("lamure: cache_index::view_bit: more than 64 views aquire slots");
+    }
+
+    view_ids_.push_back(view_id);
+    return uint64_t(1) << (view_ids_.size()-1);
+}
+
 const slot_t cache_index::
 num_free_slots() {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -48,31 +62,22 @@ const slot_t cache_index::
 reserve_slot() {
     std::lock_guard<std::mutex> lock(mutex_);
 
+    //we shouldn't reserve something if the cache is full
     assert(num_free_slots_ > 0);
 
-    slot_t slot_id = slots_[0].next_;
-
-    //we shouldn't reserve something if the cache is full
-    assert(slot_id != invalid_slot_t);
-    assert(slot_id < num_slots_+1);
+    slot_t slot_id = policy_->victim();
+    assert(slot_id < num_slots_);
 
     cache_index_node& node = slots_[slot_id];
 
-    //assert slot was in linked list
-    assert(node.prev_ != invalid_slot_t);
-    assert(node.next_ != invalid_slot_t);
-
-    //remove node from linked list
-    slots_[node.prev_].next_ = node.next_;
-    slots_[node.next_].prev_ = node.prev_;
+    //assert slot was evictable
+    assert(node.evictable_);
+    assert(node.views_ == 0);
 
-    node.prev_ = invalid_slot_t;
-    node.next_ = invalid_slot_t;
-
-    assert(node.views_.empty());
+    node.evictable_ = false;
 
     if (node.node_id_ != invalid_node_t) {
-        maps_[node.model_id_].erase(node.node_id_);
+        map_.erase(flat_key_map<slot_t>::make_key(node.model_id_, node.node_id_));
     }
 
     node.node_id_ = invalid_node_t;
@@ -82,34 +87,30 @@ reserve_slot() {
         --num_free_slots_;
     }
 
-    return slot_id-1;
+    return slot_id;
 }
 
 void cache_index::
 apply_slot(const slot_t slot_id, const model_t model_id, const node_t node_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    cache_index_node& node = slots_[slot_id+1];
+    cache_index_node& node = slots_[slot_id];
+    const uint64_t key = flat_key_map<slot_t>::make_key(model_id, node_id);
 
     //these raise when slot was not reserved
-    assert(node.prev_ == invalid_slot_t);
-    assert(node.next_ == invalid_slot_t);
+    assert(!node.evictable_);
     assert(node.node_id_ == invalid_node_t);
     assert(node.model_id_ == invalid_model_t);
-    assert(node.views_.empty());
-    assert(maps_[model_id].find(node_id) == maps_[model_id].end());
+    assert(node.views_ == 0);
+    assert(model_id < num_models_);
+    assert(!map_.contains(key));
 
     node.node_id_ = node_id;
     node.model_id_ = model_id;
+    node.evictable_ = true;
 
-    //insert node at tail
-    node.prev_ = slots_[num_slots_+1].prev_;
-    node.next_ = num_slots_+1;
-
-    slots_[slots_[num_slots_+1].prev_].next_ = slot_id+1;
-    slots_[num_slots_+1].prev_ = slot_id+1;
-
-    maps_[model_id][node_id] = slot_id+1;
+    map_.insert(key, slot_id);
+    policy_->insert(slot_id, key);
 
     if (num_free_slots_ < num_slots_) {
         ++num_free_slots_;
@@ -121,35 +122,30 @@ void cache_index::
 unreserve_slot(const slot_t slot_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    cache_index_node& node = slots_[slot_id+1];
+    cache_index_node& node = slots_[slot_id];
 
-    //assert slot was reserved and is not in linked list
-    assert(node.prev_ == invalid_slot_t);
-    assert(node.next_ == invalid_slot_t);
+    //assert slot was reserved
+    assert(!node.evictable_);
 
     //assert slot was not aquired by any views
-    assert(node.views_.empty());
-
-    //insert to head
-    node.prev_ = 0;
-    node.next_ = slots_[0].next_;
-
-    slots_[slots_[0].next_].prev_ = slot_id+1;
-    slots_[0].next_ = slot_id+1;
+    assert(node.views_ == 0);
 
     //section below is not really necessary,
     //but let's keep it for sanity
     {
         if (node.node_id_ != invalid_node_t) {
-            maps_[node.model_id_].erase(node.node_id_);
+            map_.erase(flat_key_map<slot_t>::make_key(node.model_id_, node.node_id_));
         }
 
         node.node_id_ = invalid_node_t;
         node.model_id_ = invalid_model_t;
 
-        node.views_.clear();
+        node.views_ = 0;
     }
 
+    node.evictable_ = true;
+    policy_->insert_free(slot_id);
+
     if (num_free_slots_ < num_slots_) {
         ++num_free_slots_;
     }
@@ -159,160 +155,156 @@ const slot_t cache_index::
 get_slot(const model_t model_id, const node_t node_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
+    slot_t slot_id = invalid_slot_t;
+    const bool found = map_.find(flat_key_map<slot_t>::make_key(model_id, node_id), slot_id);
 
     //this raises when slot was not applied
-    assert(it != maps_[model_id].end());
+    assert(found);
+    (void)found;
 
-    //assert that this slot was actually aquired
-    slot_t slot_id = it->second;
-    
     //this raises if attempting to access a slot that was not aquired
     //and, thus, is in danger of being overriden very soon
-    assert(!slots_[slot_id].views_.empty());
-
-    //assert slot was removed from linked list
-    assert(slots_[slot_id].prev_ == invalid_slot_t);
-    assert(slots_[slot_id].next_ == invalid_slot_t);
-
-    assert(slot_id != invalid_slot_t);
+    assert(slots_[slot_id].views_ != 0);
+    assert(!slots_[slot_id].evictable_);
 
-    return slot_id-1;
+    return slot_id;
 }
 
 const bool cache_index::
 is_node_indexed(const model_t model_id, const node_t node_id) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return maps_[model_id].find(node_id) != maps_[model_id].end();
+    return map_.contains(flat_key_map<slot_t>::make_key(model_id, node_id));
 }
 
 const bool cache_index::
 is_node_aquired(const model_t model_id, const node_t node_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
-    if (it == maps_[model_id].end()) {
+    slot_t slot_id;
+    if (!map_.find(flat_key_map<slot_t>::make_key(model_id, node_id), slot_id)) {
       return false;
     }
 
-    slot_t slot_id = it->second;
-    cache_index_node& node = slots_[slot_id];
-
-    return !node.views_.empty();
+    return slots_[slot_id].views_ != 0;
 }
 
-void cache_index::
+const bool cache_index::
 aquire_slot(const view_t view_id, const model_t model_id, const node_t node_id) {
 
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
-
-    //this raises when node was not applied
-    assert(it != maps_[model_id].end());
+    if (trace_enabled_) {
+        trace_ << "a " << view_id << " " << model_id << " " << node_id << "\n";
+    }
 
-    slot_t slot_id = it->second;
-    cache_index_node& node = slots_[slot_id];
+    slot_t slot_id;
 
-    if (node.views_.find(view_id) == node.views_.end()) {
-        node.views_.insert(view_id);
+    //the node may have been evicted since it was found resident
+    if (!map_.find(flat_key_map<slot_t>::make_key(model_id, node_id), slot_id)) {
+        return false;
+    }
 
-        //if slot was not removed from linked list
-        if (node.prev_ != invalid_slot_t || node.next_ != invalid_slot_t) {
-            assert(node.prev_ != invalid_slot_t);
-            assert(node.next_ != invalid_slot_t);
+    cache_index_node& node = slots_[slot_id];
+    const uint64_t bit = view_bit(view_id);
 
-            //remove node from linked list
-            slots_[node.prev_].next_ = node.next_;
-            slots_[node.next_].prev_ = node.prev_;
+    if ((node.views_ & bit) == 0) {
+        node.views_ |= bit;
 
-            node.prev_ = invalid_slot_t;
-            node.next_ = invalid_slot_t;
+        //if slot was not removed from the policy
+        if (node.evictable_) {
+            node.evictable_ = false;
+            policy_->remove(slot_id);
 
             if (num_free_slots_ > 0) {
                 --num_free_slots_;
             }
 
+            return true;
         }
     }
 
-
+    return false;
 }
 
-void cache_index::
+const bool cache_index::
 release_slot(const view_t view_id, const model_t model_id, const node_t node_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
+    if (trace_enabled_) {
+        trace_ << "r " << view_id << " " << model_id << " " << node_id << "\n";
+    }
 
-    //this raises when node was not  applied
-    assert(it != maps_[model_id].end());
+    slot_t slot_id;
 
-    slot_t slot_id = it->second;
-    cache_index_node& node = slots_[slot_id];
+    //the node may have been evicted since it was found resident
+    if (!map_.find(flat_key_map<slot_t>::make_key(model_id, node_id), slot_id)) {
+        return false;
+    }
 
-    if (node.views_.find(view_id) != node.views_.end()) {
-        node.views_.erase(view_id);
+    cache_index_node& node = slots_[slot_id];
+    const uint64_t bit = view_bit(view_id);
 
-        if (node.views_.empty()) {
-            //if slot was removed from linked list
-            if (node.prev_ == invalid_slot_t && node.next_ == invalid_slot_t) {
-                //insert node at tail
-                node.prev_ = slots_[num_slots_+1].prev_;
-                node.next_ = num_slots_+1;
+    if ((node.views_ & bit) != 0) {
+        node.views_ &= ~bit;
 
-                slots_[slots_[num_slots_+1].prev_].next_ = slot_id;
-                slots_[num_slots_+1].prev_ = slot_id;
+        if (node.views_ == 0) {
+            //if slot was removed from the policy
+            if (!node.evictable_) {
+                node.evictable_ = true;
+                policy_->release(slot_id);
 
                 if (num_free_slots_ < num_slots_) {
                     ++num_free_slots_;
                 }
+
+                return true;
             }
         }
 
     }
 
+    return false;
 }
 
 const bool cache_index::
 release_slot_invalidate(const view_t view_id, const model_t model_id, const node_t node_id) {
     //purpose: unregister view from node,
     //if no views remain, invalidate node (remove from index)
-    //and insert slot to head
+    //and hand the slot out before any other
     //return true if and only if the slot was invalidated
     //during current function call
 
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
+    if (trace_enabled_) {
+        trace_ << "i " << view_id << " " << model_id << " " << node_id << "\n";
+    }
 
-    //this raises when node was not  applied
-    assert(it != maps_[model_id].end());
+    slot_t slot_id;
 
-    slot_t slot_id = it->second;
-    cache_index_node& node = slots_[slot_id];
+    //the node may have been evicted since it was found resident
+    if (!map_.find(flat_key_map<slot_t>::make_key(model_id, node_id), slot_id)) {
+        return false;
+    }
 
-    if (node.views_.find(view_id) != node.views_.end()) {
-        node.views_.erase(view_id);
+    cache_index_node& node = slots_[slot_id];
+    const uint64_t bit = view_bit(view_id);
 
-        if (node.views_.empty()) {
-            //if slot was removed from linked list
-            if (node.prev_ == invalid_slot_t && node.next_ == invalid_slot_t) {
-                //insert to head
-                node.prev_ = 0;
-                node.next_ = slots_[0].next_;
+    if ((node.views_ & bit) != 0) {
+        node.views_ &= ~bit;
 
-                slots_[slots_[0].next_].prev_ = slot_id;
-                slots_[0].next_ = slot_id;
+        if (node.views_ == 0) {
+            //if slot was removed from the policy
+            if (!node.evictable_) {
+                node.evictable_ = true;
+                policy_->insert_free(slot_id);
 
                 if (num_free_slots_ < num_slots_) {
                     ++num_free_slots_;
                 }
 
                 //invalidate slot
-                if (node.node_id_ != invalid_node_t) {
-                    maps_[node.model_id_].erase(node.node_id_);
-                }
+                map_.erase(flat_key_map<slot_t>::make_key(node.model_id_, node.node_id_));
 
                 node.node_id_ = invalid_node_t;
                 node.model_id_ = invalid_model_t;
@@ -329,6 +321,33 @@ release_slot_invalidate(const view_t view_id, const model_t model_id, const node
     return false;
 }
 
+void cache_index::
+update_node_error(const model_t model_id, const node_t node_id, const float error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (trace_enabled_) {
+        trace_ << "e " << model_id << " " << node_id << " " << error << "\n";
+    }
+
+    slot_t slot_id;
+    if (map_.find(flat_key_map<slot_t>::make_key(model_id, node_id), slot_id)) {
+        policy_->update_node_error(slot_id, error);
+    }
+}
+
+void cache_index::
+start_trace(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    trace_.open(filename, std::ios::out | std::ios::trunc);
+    if (!trace_.is_open()) {
+        throw std::runtime_error("lamure: cache_index::start_trace: unable to open " + filename);
+    }
+
+    trace_ << "# lamure cache trace, slots " << num_slots_ << "\n";
+    trace_enabled_ = true;
+}
+
 
 } // namespace ren
 
@@ -0,0 +1,528 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/ren/cache_policy.h>
+#include <lamure/ren/flat_key_map.h>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+
+
+namespace lamure
+{
+
+namespace ren
+{
+
+namespace
+{
+
+//keys of recently evicted nodes, the oldest key is dropped when full
+class ghost_list
+{
+public:
+    explicit ghost_list(const slot_t capacity)
+        : capacity_(std::max(capacity, slot_t(1))), sequence_(0), entries_(capacity_ + 1) {}
+
+    const slot_t size() const { return entries_.size(); }
+
+    const bool erase(const uint64_t key) {
+        //the queue entry becomes stale and is skipped when it is dropped
+        return entries_.erase(key);
+    }
+
+    void insert(const uint64_t key) {
+        entries_.insert(key, sequence_);
+        order_.push_back(std::make_pair(key, sequence_));
+        ++sequence_;
+
+        while (entries_.size() > capacity_) {
+            pop_oldest();
+        }
+
+        if (order_.size() > 4 * capacity_) {
+            compact();
+        }
+    }
+
+private:
+    void pop_oldest() {
+        while (!order_.empty()) {
+            const std::pair<uint64_t, uint64_t> entry = order_.front();
+            order_.pop_front();
+
+            uint64_t sequence;
+            if (entries_.find(entry.first, sequence) && sequence == entry.second) {
+                entries_.erase(entry.first);
+                return;
+            }
+        }
+    }
+
+    void compact() {
+        std::deque<std::pair<uint64_t, uint64_t>> order;
+        for (const auto& entry : order_) {
+            uint64_t sequence;
+            if (entries_.find(entry.first, sequence) && sequence == entry.second) {
+                order.push_back(entry);
+            }
+        }
+        order_.swap(order);
+    }
+
+    slot_t capacity_;
+    uint64_t sequence_;
+    flat_key_map<uint64_t> entries_;
+    std::deque<std::pair<uint64_t, uint64_t>> order_;
+};
+
+
+//least recently released node is evicted first
+class lru_cache_policy : public cache_policy
+{
+public:
+    explicit lru_cache_policy(const slot_t num_slots)
+        : cache_policy(num_slots, 2) {}
+
+    void insert(const slot_t slot_id, const uint64_t key) override {
+        keys_[slot_id] = key;
+        push_back(lru_list_, slot_id);
+    }
+
+    void remove(const slot_t slot_id) override {
+        erase(slot_id);
+    }
+
+    void release(const slot_t slot_id) override {
+        push_back(lru_list_, slot_id);
+    }
+
+    const slot_t victim() override {
+        return pop_front(empty(free_list_) ? lru_list_ : free_list_);
+    }
+
+private:
+    static const uint32_t lru_list_ = 1;
+};
+
+
+//2Q: nodes enter a1in and are promoted to am when they are aquired
+//again or reloaded shortly after eviction. nodes that were only needed
+//once, e.g. while the camera passes by, are evicted from a1in before
+//the frequently used nodes in am are touched
+class two_queue_cache_policy : public cache_policy
+{
+public:
+    explicit two_queue_cache_policy(const slot_t num_slots)
+        : cache_policy(num_slots, 3),
+          classes_(num_slots, free_list_),
+          uses_(num_slots, 0),
+          num_a1in_(0),
+          max_a1in_(std::max(num_slots / 4, slot_t(1))),
+          a1out_(std::max(num_slots / 2, slot_t(1))) {}
+
+    void insert_free(const slot_t slot_id) override {
+        if (classes_[slot_id] == a1in_list_) {
+            --num_a1in_;
+        }
+        classes_[slot_id] = free_list_;
+        cache_policy::insert_free(slot_id);
+    }
+
+    void insert(const slot_t slot_id, const uint64_t key) override {
+        keys_[slot_id] = key;
+        uses_[slot_id] = 0;
+
+        if (a1out_.erase(key)) {
+            classes_[slot_id] = am_list_;
+        }
+        else {
+            classes_[slot_id] = a1in_list_;
+            ++num_a1in_;
+        }
+
+        push_back(classes_[slot_id], slot_id);
+    }
+
+    void remove(const slot_t slot_id) override {
+        erase(slot_id);
+
+        if (++uses_[slot_id] > 1 && classes_[slot_id] == a1in_list_) {
+            classes_[slot_id] = am_list_;
+            --num_a1in_;
+        }
+    }
+
+    void release(const slot_t slot_id) override {
+        push_back(classes_[slot_id], slot_id);
+    }
+
+    const slot_t victim() override {
+        if (!empty(free_list_)) {
+            return pop_front(free_list_);
+        }
+
+        slot_t slot_id;
+        if ((num_a1in_ > max_a1in_ && !empty(a1in_list_)) || empty(am_list_)) {
+            slot_id = pop_front(a1in_list_);
+            a1out_.insert(keys_[slot_id]);
+            --num_a1in_;
+        }
+        else {
+            slot_id = pop_front(am_list_);
+        }
+
+        classes_[slot_id] = free_list_;
+        return slot_id;
+    }
+
+private:
+    static const uint32_t a1in_list_ = 1;
+    static const uint32_t am_list_ = 2;
+
+    std::vector<uint32_t> classes_;
+    std::vector<uint32_t> uses_;
+
+    //resident nodes in a1in, including aquired ones
+    slot_t num_a1in_;
+    slot_t max_a1in_;
+
+    ghost_list a1out_;
+};
+
+
+//ARC: like 2Q, but the share of t1 (seen once) and t2 (seen repeatedly)
+//adapts to the hits in the ghost lists b1 and b2
+class arc_cache_policy : public cache_policy
+{
+public:
+    explicit arc_cache_policy(const slot_t num_slots)
+        : cache_policy(num_slots, 3),
+          classes_(num_slots, free_list_),
+          uses_(num_slots, 0),
+          num_t1_(0),
+          target_t1_(0.0),
+          b1_(num_slots),
+          b2_(num_slots) {}
+
+    void insert_free(const slot_t slot_id) override {
+        if (classes_[slot_id] == t1_list_) {
+            --num_t1_;
+        }
+        classes_[slot_id] = free_list_;
+        cache_policy::insert_free(slot_id);
+    }
+
+    void insert(const slot_t slot_id, const uint64_t key) override {
+        keys_[slot_id] = key;
+        uses_[slot_id] = 0;
+
+        const double size_b1 = double(b1_.size());
+        const double size_b2 = double(b2_.size());
+
+        if (b1_.erase(key)) {
+            target_t1_ = std::min(double(num_slots_), target_t1_ + std::max(size_b2 / size_b1, 1.0));
+            classes_[slot_id] = t2_list_;
+        }
+        else if (b2_.erase(key)) {
+            target_t1_ = std::max(0.0, target_t1_ - std::max(size_b1 / size_b2, 1.0));
+            classes_[slot_id] = t2_list_;
+        }
+        else {
+            classes_[slot_id] = t1_list_;
+            ++num_t1_;
+        }
+
+        push_back(classes_[slot_id], slot_id);
+    }
+
+    void remove(const slot_t slot_id) override {
+        erase(slot_id);
+
+        if (++uses_[slot_id] > 1 && classes_[slot_id] == t1_list_) {
+            classes_[slot_id] = t2_list_;
+            --num_t1_;
+        }
+    }
+
+    void release(const slot_t slot_id) override {
+        push_back(classes_[slot_id], slot_id);
+    }
+
+    const slot_t victim() override {
+        if (!empty(free_list_)) {
+            return pop_front(free_list_);
+        }
+
+        slot_t slot_id;
+        if ((double(num_t1_) > target_t1_ && !empty(t1_list_)) || empty(t2_list_)) {
+            slot_id = pop_front(t1_list_);
+            b1_.insert(keys_[slot_id]);
+            --num_t1_;
+        }
+        else {
+            slot_id = pop_front(t2_list_);
+            b2_.insert(keys_[slot_id]);
+        }
+
+        classes_[slot_id] = free_list_;
+        return slot_id;
+    }
+
+private:
+    static const uint32_t t1_list_ = 1;
+    static const uint32_t t2_list_ = 2;
+
+    std::vector<uint32_t> classes_;
+    std::vector<uint32_t> uses_;
+
+    //resident nodes in t1, including aquired ones
+    slot_t num_t1_;
+    double target_t1_;
+
+    ghost_list b1_;
+    ghost_list b2_;
+};
+
+
+//greedy dual: a released node is valued at its projected error on top of
+//the value of the last evicted node. nodes that are small on screen go
+//first, nodes that stay unused fall behind as the value rises over time.
+//the error is the last value reported by the cut update, nodes that were
+//never rated count as zero
+class error_weighted_cache_policy : public cache_policy
+{
+public:
+    explicit error_weighted_cache_policy(const slot_t num_slots)
+        : cache_policy(num_slots, 1),
+          errors_(num_slots, 0.f),
+          priorities_(num_slots, 0.0),
+          heap_positions_(num_slots, invalid_slot_t),
+          inflation_(0.0) {
+        heap_.reserve(num_slots);
+    }
+
+    const bool uses_node_errors() const override { return true; }
+
+    void update_node_error(const slot_t slot_id, const float error) override {
+        errors_[slot_id] = error;
+
+        if (heap_positions_[slot_id] != invalid_slot_t) {
+            priorities_[slot_id] = inflation_ + error;
+            sift_up(heap_positions_[slot_id]);
+            sift_down(heap_positions_[slot_id]);
+        }
+    }
+
+    void insert_free(const slot_t slot_id) override {
+        heap_erase(slot_id);
+        cache_policy::insert_free(slot_id);
+    }
+
+    void insert(const slot_t slot_id, const uint64_t key) override {
+        keys_[slot_id] = key;
+        errors_[slot_id] = 0.f;
+        heap_push(slot_id);
+    }
+
+    void remove(const slot_t slot_id) override {
+        heap_erase(slot_id);
+    }
+
+    void release(const slot_t slot_id) override {
+        heap_push(slot_id);
+    }
+
+    const slot_t victim() override {
+        if (!empty(free_list_)) {
+            return pop_front(free_list_);
+        }
+
+        assert(!heap_.empty());
+        const slot_t slot_id = heap_.front();
+        inflation_ = priorities_[slot_id];
+        heap_erase(slot_id);
+        return slot_id;
+    }
+
+private:
+    void heap_push(const slot_t slot_id) {
+        priorities_[slot_id] = inflation_ + errors_[slot_id];
+        heap_positions_[slot_id] = heap_.size();
+        heap_.push_back(slot_id);
+        sift_up(heap_.size() - 1);
+    }
+
+    void heap_erase(const slot_t slot_id) {
+        const slot_t position = heap_positions_[slot_id];
+        if (position == invalid_slot_t) {
+            return;
+        }
+
+        heap_positions_[slot_id] = invalid_slot_t;
+        const slot_t last_id = heap_.back();
+        heap_.pop_back();
+
+        if (last_id != slot_id) {
+            heap_[position] = last_id;
+            heap_positions_[last_id] = position;
+            sift_up(position);
+            sift_down(heap_positions_[last_id]);
+        }
+    }
+
+    void sift_up(slot_t position) {
+        while (position > 0) {
+            const slot_t parent = (position - 1) / 2;
+            if (priorities_[heap_[parent]] <= priorities_[heap_[position]]) {
+                break;
+            }
+            swap_entries(parent, position);
+            position = parent;
+        }
+    }
+
+    void sift_down(slot_t position) {
+        while (true) {
+            slot_t smallest = position;
+            const slot_t left = 2 * position + 1;
+            const slot_t right = left + 1;
+            if (left < heap_.size() && priorities_[heap_[left]] < priorities_[heap_[smallest]]) {
+                smallest = left;
+            }
+            if (right < heap_.size() && priorities_[heap_[right]] < priorities_[heap_[smallest]]) {
+                smallest = right;
+            }
+            if (smallest == position) {
+                break;
+            }
+            swap_entries(smallest, position);
+            position = smallest;
+        }
+    }
+
+    void swap_entries(const slot_t a, const slot_t b) {
+        std::swap(heap_[a], heap_[b]);
+        heap_positions_[heap_[a]] = a;
+        heap_positions_[heap_[b]] = b;
+    }
+
+    std::vector<float> errors_;
+    std::vector<double> priorities_;
+
+    //min heap of the evictable resident slots
+    std::vector<slot_t> heap_;
+    std::vector<slot_t> heap_positions_;
+    double inflation_;
+};
+
+} // namespace
+
+const uint32_t cache_policy::free_list_;
+const uint32_t cache_policy::no_list_;
+
+cache_policy* cache_policy::
+create(const policy_type type, const slot_t num_slots) {
+    switch (type) {
+        case LRU: return new lru_cache_policy(num_slots);
+        case TWO_QUEUE: return new two_queue_cache_policy(num_slots);
+        case ARC: return new arc_cache_policy(num_slots);
+        case ERROR_WEIGHTED: return new error_weighted_cache_policy(num_slots);
+    }
+
+    throw std::runtime_error("lamure: cache_policy::create: unknown policy type");
+}
+
+const std::string cache_policy::
+type_name(const policy_type type) {
+    switch (type) {
+        case LRU: return "lru";
+        case TWO_QUEUE: return "2q";
+        case ARC: return "arc";
+        case ERROR_WEIGHTED: return "error_weighted";
+    }
+
+    return "unknown";
+}
+
+cache_policy::
+cache_policy(const slot_t num_slots, const uint32_t num_lists)
+    : num_slots_(num_slots),
+      keys_(num_slots, 0),
+      prev_(num_slots + num_lists),
+      next_(num_slots + num_lists),
+      lists_(num_slots, no_list_),
+      sizes_(num_lists, 0) {
+    for (uint32_t list = 0; list < num_lists; ++list) {
+        prev_[num_slots_ + list] = num_slots_ + list;
+        next_[num_slots_ + list] = num_slots_ + list;
+    }
+}
+
+void cache_policy::
+insert_free(const slot_t slot_id) {
+    erase(slot_id);
+    push_front(free_list_, slot_id);
+}
+
+void cache_policy::
+push_back(const uint32_t list, const slot_t slot_id) {
+    assert(lists_[slot_id] == no_list_);
+
+    const slot_t sentinel = num_slots_ + list;
+    prev_[slot_id] = prev_[sentinel];
+    next_[slot_id] = sentinel;
+    next_[prev_[sentinel]] = slot_id;
+    prev_[sentinel] = slot_id;
+
+    lists_[slot_id] = list;
+    ++sizes_[list];
+}
+
+void cache_policy::
+push_front(const uint32_t list, const slot_t slot_id) {
+    assert(lists_[slot_id] == no_list_);
+
+    const slot_t sentinel = num_slots_ + list;
+    prev_[slot_id] = sentinel;
+    next_[slot_id] = next_[sentinel];
+    prev_[next_[sentinel]] = slot_id;
+    next_[sentinel] = slot_id;
+
+    lists_[slot_id] = list;
+    ++sizes_[list];
+}
+
+void cache_policy::
+erase(const slot_t slot_id) {
+    if (lists_[slot_id] == no_list_) {
+        return;
+    }
+
+    next_[prev_[slot_id]] = next_[slot_id];
+    prev_[next_[slot_id]] = prev_[slot_id];
+
+    --sizes_[lists_[slot_id]];
+    lists_[slot_id] = no_list_;
+}
+
+const slot_t cache_policy::
+pop_front(const uint32_t list) {
+    assert(!empty(list));
+
+    const slot_t slot_id = front(list);
+    erase(slot_id);
+    return slot_id;
+}
+
+
+} // namespace ren
+
+} // namespace lamure
@@ -13,12 +13,16 @@ namespace lamure
 namespace ren
 {
 
+// number of requests that can be in flight between producers and the heap
+static const size_t LAMURE_CACHE_QUEUE_MESSAGE_CAPACITY = 1 << 16;
+
 cache_queue::
 cache_queue()
-: num_slots_(0),
-  num_models_(0),
+: num_models_(0),
   mode_(update_mode::UPDATE_NEVER),
-  initialized_(false) {
+  initialized_(false),
+  messages_(LAMURE_CACHE_QUEUE_MESSAGE_CAPACITY),
+  num_waiting_(0) {
 
 }
 
@@ -29,45 +33,44 @@ cache_queue::
 
 const size_t cache_queue::
 num_jobs() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return num_slots_;
+    return num_waiting_.load();
 }
 
 const cache_queue::query_result cache_queue::
 is_node_indexed(const model_t model_id, const node_t node_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(initialized_);
     assert(model_id < num_models_);
-
-    query_result result = query_result::NOT_INDEXED;
-
-    if (requested_set_[model_id].find(node_id) != requested_set_[model_id].end()) {
-        result = query_result::INDEXED_AS_LOADING;
-
-        if (mode_ != update_mode::UPDATE_NEVER) {
-            if (pending_set_[model_id].find(node_id) == pending_set_[model_id].end()) {
-                result = query_result::INDEXED_AS_WAITING;
-            }
-        }
+    assert(node_id < positions_[model_id].size());
+
+    switch (states_[model_id][node_id].load(std::memory_order_acquire)) {
+        case STATE_WAITING:
+            return mode_ == update_mode::UPDATE_NEVER ? query_result::INDEXED_AS_LOADING : query_result::INDEXED_AS_WAITING;
+        case STATE_LOADING:
+            return query_result::INDEXED_AS_LOADING;
+        default:
+            return query_result::NOT_INDEXED;
     }
-
-    return result;
 }
 
 void cache_queue::
-initialize(const update_mode mode, const model_t num_models) {
-    std::lock_guard<std::mutex> lock(mutex_);
+initialize(const update_mode mode, const std::vector<node_t>& num_nodes_per_model) {
+    std::lock_guard<std::mutex> lock(owner_mutex_);
 
     assert(!initialized_);
 
     mode_ = mode;
-    num_models_ = num_models;
+    num_models_ = (model_t)num_nodes_per_model.size();
 
-    requested_set_.resize(num_models_);
+    states_.resize(num_models_);
+    positions_.resize(num_models_);
 
-    if (mode_ != update_mode::UPDATE_NEVER) {
-        pending_set_.resize(num_models_);
+    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+        const node_t num_nodes = num_nodes_per_model[model_id];
+        states_[model_id].reset(new std::atomic<uint8_t>[num_nodes]);
+        for (node_t node_id = 0; node_id < num_nodes; ++node_id) {
+            states_[model_id][node_id].store(STATE_NOT_INDEXED, std::memory_order_relaxed);
+        }
+        positions_[model_id].assign(num_nodes, invalid_position);
     }
 
     initialized_ = true;
@@ -75,65 +78,56 @@ initialize(const update_mode mode, const model_t num_models) {
 
 bool cache_queue::
 push_job(const job& job) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(initialized_);
     assert(job.model_id_ < num_models_);
 
-    if (requested_set_[job.model_id_].find(job.node_id_) == requested_set_[job.model_id_].end()) {
-        slots_.push_back(job);
-        requested_set_[job.model_id_][job.node_id_] = num_slots_;
-
-        ++num_slots_;
-
-        shuffle_up(num_slots_-1);
-
-        return true;
+    uint8_t expected = STATE_NOT_INDEXED;
+    if (!states_[job.model_id_][job.node_id_].compare_exchange_strong(expected, STATE_WAITING)) {
+        return false;
     }
 
-    return false;
+    ++num_waiting_;
+
+    message msg;
+    msg.type_ = MESSAGE_PUSH;
+    msg.job_ = job;
+    submit(msg);
 
+    return true;
 }
 
 const cache_queue::job cache_queue::
 top_job() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(owner_mutex_);
 
-    job job;
+    drain();
 
-    if (num_slots_ > 0) {
-        job = slots_.front();
+    std::vector<job> jobs;
+    take_top(jobs);
 
-        if (mode_ != update_mode::UPDATE_NEVER) {
-            pending_set_[job.model_id_].insert(job.node_id_);
-        }
+    return jobs.empty() ? job() : jobs.front();
+}
 
-        swap(0, num_slots_-1);
-        slots_.pop_back();
+const size_t cache_queue::
+top_jobs(std::vector<job>& jobs, const size_t max_jobs) {
+    std::lock_guard<std::mutex> lock(owner_mutex_);
 
-        --num_slots_;
+    drain();
 
-        shuffle_down(0);
+    const size_t num_before = jobs.size();
+    while (jobs.size() - num_before < max_jobs && !heap_.empty()) {
+        take_top(jobs);
     }
 
-    return job;
+    return jobs.size() - num_before;
 }
 
 void cache_queue::
 pop_job(const job& job) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(job.model_id_ < num_models_);
+    assert(states_[job.model_id_][job.node_id_].load() == STATE_LOADING);
 
-    requested_set_[job.model_id_].erase(job.node_id_);
-
-    if (mode_ != update_mode::UPDATE_NEVER) {
-        assert(pending_set_[job.model_id_].find(job.node_id_) != pending_set_[job.model_id_].end());
-
-        if (pending_set_[job.model_id_].find(job.node_id_) != pending_set_[job.model_id_].end()) {
-            pending_set_[job.model_id_].erase(job.node_id_);
-        }
-    }
+    states_[job.model_id_][job.node_id_].store(STATE_NOT_INDEXED, std::memory_order_release);
 }
 
 void cache_queue::
@@ -142,123 +136,191 @@ update_job(const model_t model_id, const node_t node_id, int32_t priority) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(model_id < num_models_);
 
-    if (pending_set_[model_id].find(node_id) != pending_set_[model_id].end()) {
+    if (states_[model_id][node_id].load(std::memory_order_acquire) != STATE_WAITING) {
         return;
     }
 
-    const auto it = requested_set_[model_id].find(node_id);
+    message msg;
+    msg.type_ = MESSAGE_UPDATE;
+    msg.job_.model_id_ = model_id;
+    msg.job_.node_id_ = node_id;
+    msg.job_.priority_ = priority;
+    submit(msg);
+}
 
-    //assert(it != requested_set_[model_id].end());
+const cache_queue::abort_result cache_queue::
+abort_job(const job& job) {
+    if (mode_ == update_mode::UPDATE_NEVER) {
+        return abort_result::ABORT_FAILED;
+    }
 
-    if (it == requested_set_[model_id].end()) {
-        return;
+    uint8_t expected = STATE_WAITING;
+    if (!states_[job.model_id_][job.node_id_].compare_exchange_strong(expected, STATE_NOT_INDEXED)) {
+        return abort_result::ABORT_FAILED;
     }
 
-    size_t slot_id = it->second;
+    --num_waiting_;
 
-    if (priority < slots_[slot_id].priority_) {
-        if (mode_ == update_mode::UPDATE_ALWAYS || mode_ == update_mode::UPDATE_DECREMENT_ONLY) {
-            slots_[slot_id].priority_ = priority;
-            shuffle_down(slot_id);
-        }
-    }
-    else if (priority > slots_[slot_id].priority_) {
-        if (mode_ == update_mode::UPDATE_ALWAYS || mode_ == update_mode::UPDATE_INCREMENT_ONLY) {
-            slots_[slot_id].priority_ = priority;
-            shuffle_up(slot_id);
-        }
-    }
+    message msg;
+    msg.type_ = MESSAGE_ABORT;
+    msg.job_ = job;
+    submit(msg);
 
+    return abort_result::ABORT_SUCCESS;
 }
 
-const cache_queue::abort_result cache_queue::
-abort_job(const job& job) {
-    abort_result result = abort_result::ABORT_FAILED;
-
-    if (mode_ != update_mode::UPDATE_NEVER) {
-        std::lock_guard<std::mutex> lock(mutex_);
+void cache_queue::
+submit(const message& msg) {
+    while (!messages_.try_push(msg)) {
+        // the ring is full, make room by applying the pending requests
+        std::lock_guard<std::mutex> lock(owner_mutex_);
+        drain();
+    }
+}
 
-        const auto it = requested_set_[job.model_id_].find(job.node_id_);
+void cache_queue::
+drain() {
+    message msg;
+    while (messages_.try_pop(msg)) {
+        apply(msg);
+    }
+}
 
-        if (it != requested_set_[job.model_id_].end()) {
-            if (pending_set_[job.model_id_].find(job.node_id_) == pending_set_[job.model_id_].end()) {
-                size_t slot_id = it->second;
+void cache_queue::
+apply(const message& msg) {
+    const job& job = msg.job_;
+    const uint32_t pos = positions_[job.model_id_][job.node_id_];
+
+    switch (msg.type_) {
+        case MESSAGE_PUSH:
+            if (pos == invalid_position) {
+                heap_.push_back(job);
+                place((uint32_t)heap_.size()-1, job);
+                sift_up((uint32_t)heap_.size()-1);
+            }
+            else {
+                // aborted and pushed again before the abort was applied
+                place(pos, job);
+                sift_up(pos);
+                sift_down(positions_[job.model_id_][job.node_id_]);
+            }
+            break;
 
-                swap(slot_id, num_slots_-1);
-                slots_.pop_back();
-                --num_slots_;
-                shuffle_down(slot_id);
-                requested_set_[job.model_id_].erase(job.node_id_);
+        case MESSAGE_UPDATE:
+            if (pos == invalid_position) {
+                break;
+            }
+            if (job.priority_ < heap_[pos].priority_) {
+                if (mode_ == update_mode::UPDATE_ALWAYS || mode_ == update_mode::UPDATE_DECREMENT_ONLY) {
+                    heap_[pos].priority_ = job.priority_;
+                    sift_down(pos);
+                }
+            }
+            else if (job.priority_ > heap_[pos].priority_) {
+                if (mode_ == update_mode::UPDATE_ALWAYS || mode_ == update_mode::UPDATE_INCREMENT_ONLY) {
+                    heap_[pos].priority_ = job.priority_;
+                    sift_up(pos);
+                }
+            }
+            break;
 
-                result = abort_result::ABORT_SUCCESS;
+        case MESSAGE_ABORT:
+            // keep the entry if the node has been requested again meanwhile
+            if (pos != invalid_position && states_[job.model_id_][job.node_id_].load() != STATE_WAITING) {
+                remove_at(pos);
             }
-        }
+            break;
     }
-
-    return result;
 }
 
 void cache_queue::
-swap(const size_t slot_id_0, const size_t slot_id_1) {
-    job& job0 = slots_[slot_id_0];
-    job& job1 = slots_[slot_id_1];
-
-    requested_set_[job0.model_id_][job0.node_id_] = slot_id_1;
-    requested_set_[job1.model_id_][job1.node_id_] = slot_id_0;
-    std::swap(slots_[slot_id_0], slots_[slot_id_1]);
+take_top(std::vector<job>& jobs) {
+    while (!heap_.empty()) {
+        const job top = heap_.front();
+        remove_at(0);
+
+        // fails if the job has been aborted but the abort is not applied yet
+        uint8_t expected = STATE_WAITING;
+        if (states_[top.model_id_][top.node_id_].compare_exchange_strong(expected, STATE_LOADING)) {
+            --num_waiting_;
+            jobs.push_back(top);
+            return;
+        }
+    }
 }
 
 void cache_queue::
-shuffle_up(const size_t slot_id) {
-    if (slot_id == 0) {
-        return;
-    }
+remove_at(const uint32_t pos) {
+    const job& removed = heap_[pos];
+    positions_[removed.model_id_][removed.node_id_] = invalid_position;
 
-    size_t parent_slot_id = (size_t)std::floor((slot_id-1)/2);
+    const job last = heap_.back();
+    heap_.pop_back();
 
-    if (slots_[slot_id].priority_ < slots_[parent_slot_id].priority_) {
-        return;
+    if (pos < heap_.size()) {
+        place(pos, last);
+        if (pos > 0 && heap_[(pos-1)/heap_arity].priority_ < last.priority_) {
+            sift_up(pos);
+        }
+        else {
+            sift_down(pos);
+        }
     }
+}
 
-    swap(slot_id, parent_slot_id);
-
-    shuffle_up(parent_slot_id);
+void cache_queue::
+place(const uint32_t pos, const job& job) {
+    heap_[pos] = job;
+    positions_[job.model_id_][job.node_id_] = pos;
 }
 
 void cache_queue::
-shuffle_down(const size_t slot_id) {
-    size_t left_child_id = slot_id*2 + 1;
-    size_t right_child_id = slot_id*2 + 2;
+sift_up(uint32_t pos) {
+    const job moving = heap_[pos];
 
-    size_t replace_id = slot_id;
+    while (pos > 0) {
+        const uint32_t parent = (pos-1)/heap_arity;
+        if (moving.priority_ <= heap_[parent].priority_) {
+            break;
+        }
+        place(pos, heap_[parent]);
+        pos = parent;
+    }
 
-    if (right_child_id < num_slots_) {
-        bool left_greater = slots_[right_child_id].priority_ < slots_[left_child_id].priority_;
+    place(pos, moving);
+}
 
-        if (left_greater && slots_[slot_id].priority_ < slots_[left_child_id].priority_) {
-            replace_id = left_child_id;
+void cache_queue::
+sift_down(uint32_t pos) {
+    const job moving = heap_[pos];
+    const uint32_t num_entries = (uint32_t)heap_.size();
+
+    while (true) {
+        const uint32_t first_child = pos*heap_arity + 1;
+        if (first_child >= num_entries) {
+            break;
         }
-        else if (!left_greater && slots_[slot_id].priority_ < slots_[right_child_id].priority_) {
-            replace_id = right_child_id;
+
+        uint32_t best_child = first_child;
+        const uint32_t last_child = std::min(first_child + (uint32_t)heap_arity, num_entries);
+        for (uint32_t child = first_child + 1; child < last_child; ++child) {
+            if (heap_[child].priority_ > heap_[best_child].priority_) {
+                best_child = child;
+            }
         }
-    }
-    else if (left_child_id < num_slots_) {
-        if (slots_[slot_id].priority_ < slots_[left_child_id].priority_) {
-            replace_id = left_child_id;
+
+        if (heap_[best_child].priority_ <= moving.priority_) {
+            break;
         }
+        place(pos, heap_[best_child]);
+        pos = best_child;
     }
 
-    if (replace_id != slot_id) {
-        swap(slot_id, replace_id);
-        shuffle_down(replace_id);
-    }
+    place(pos, moving);
 }
 
 } // namespace ren
 
 } // namespace lamure
-
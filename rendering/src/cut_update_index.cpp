@@ -14,6 +14,8 @@ namespace ren
 {
 
 
+const uint32_t cut_update_index::invalid_record;
+
 cut_update_index::
 cut_update_index()
 : num_views_(0),
@@ -24,21 +26,13 @@ cut_update_index()
 
     num_models_ = database->num_models();
 
-    for (int32_t queue_id = 0; queue_id < queue_t::NUM_QUEUES; ++queue_id) {
-        num_slots_[queue_id] = 0;
-        slot_maps_[queue_id].resize(num_models_);
-    }
-
-    for (const auto& view_id : view_ids_) {
-        front_a_cuts_[view_id].resize(num_models_);
-        front_b_cuts_[view_id].resize(num_models_);
-    }
-
     for (model_t model_id = 0; model_id < num_models_; ++model_id) {
         fan_factor_table_.push_back(database->get_model(model_id)->get_bvh()->get_fan_factor());
         num_nodes_table_.push_back(database->get_model(model_id)->get_bvh()->get_num_nodes());
     }
 
+    resize_tables();
+
 }
 
 cut_update_index::
@@ -46,6 +40,24 @@ cut_update_index::
 
 }
 
+void cut_update_index::
+resize_tables() {
+    initial_queue_.clear();
+
+    models_.clear();
+    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+        models_.emplace_back(new model_actions());
+        models_.back()->node_records_.resize(num_nodes_table_[model_id], uint32_t(invalid_record));
+    }
+
+    for (uint32_t front = 0; front < 2; ++front) {
+        for (auto& view_cuts : cuts_[front]) {
+            view_cuts.clear();
+            view_cuts.resize(num_models_);
+        }
+    }
+}
+
 void cut_update_index::
 update_policy(const view_t num_views) {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -58,6 +70,12 @@ update_policy(const view_t num_views) {
         for (view_t view_id = 0; view_id < num_views; ++view_id) {
             view_ids_.insert(view_id);
         }
+
+        for (uint32_t front = 0; front < 2; ++front) {
+            if (cuts_[front].size() < num_views_) {
+                cuts_[front].resize(num_views_, std::vector<cut_set>(num_models_));
+            }
+        }
     }
 
     model_database* database = model_database::get_instance();
@@ -65,19 +83,6 @@ update_policy(const view_t num_views) {
     if (database->num_models() != num_models_) {
         num_models_ = database->num_models();
 
-        for (int32_t queue_id = 0; queue_id < queue_t::NUM_QUEUES; ++queue_id) {
-            num_slots_[queue_id] = 0;
-            slot_maps_[queue_id].clear();
-            slot_maps_[queue_id].resize(num_models_);
-        }
-
-        for (const auto& view_id : view_ids_) {
-            front_a_cuts_[view_id].clear();
-            front_a_cuts_[view_id].resize(num_models_);
-            front_b_cuts_[view_id].clear();
-            front_b_cuts_[view_id].resize(num_models_);
-        }
-
         fan_factor_table_.clear();
         num_nodes_table_.clear();
 
@@ -86,14 +91,8 @@ update_policy(const view_t num_views) {
             num_nodes_table_.push_back(database->get_model(model_id)->get_bvh()->get_num_nodes());
         }
 
+        resize_tables();
     }
-    else if (num_views_ > prev_num_views) {
-        for (const auto& view_id : view_ids_) {
-            front_a_cuts_[view_id].resize(num_models_);
-            front_b_cuts_[view_id].resize(num_models_);
-        }
-    }
-
 
 }
 
@@ -113,57 +112,99 @@ fan_factor(const model_t model_id) const {
 
 const size_t cut_update_index::
 num_actions(const queue_t queue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(queue < queue_t::NUM_QUEUES);
 
-    return num_slots_[queue];
-}
+    size_t num_actions = 0;
 
-const std::set<node_t>& cut_update_index::
-get_current_cut(const view_t view_id, const model_t model_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& actions : models_) {
+        std::lock_guard<std::mutex> lock(actions->mutex_);
+        num_actions += actions->heaps_[queue].size();
+    }
 
-    assert(view_ids_.find(view_id) != view_ids_.end());
+    return num_actions;
+}
+
+const size_t cut_update_index::
+num_actions(const queue_t queue, const model_t model_id) {
+    assert(queue < queue_t::NUM_QUEUES);
     assert(model_id < num_models_);
 
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            return front_a_cuts_[view_id][model_id];
-            break;
+    model_actions& actions = *models_[model_id];
+    std::lock_guard<std::mutex> lock(actions.mutex_);
 
-        case cut_front::FRONT_B:
-            return front_b_cuts_[view_id][model_id];
-            break;
+    return actions.heaps_[queue].size();
+}
 
-        default: break;
+model_t cut_update_index::
+find_front_model(const queue_t queue) {
+    model_t front_model_id = invalid_model_t;
+    float front_error = 0.f;
 
+    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+        model_actions& actions = *models_[model_id];
+        std::lock_guard<std::mutex> lock(actions.mutex_);
+
+        if (!actions.heaps_[queue].empty()) {
+            float error = actions.heaps_[queue].front().error_;
+            if (front_model_id == invalid_model_t || front_error < error) {
+                front_model_id = model_id;
+                front_error = error;
+            }
+        }
     }
 
-    return front_a_cuts_[view_id][model_id];
+    return front_model_id;
 }
 
-const std::set<node_t>& cut_update_index::
-get_previous_cut(const view_t view_id, const model_t model_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+model_t cut_update_index::
+find_back_model(const queue_t queue) {
+    model_t back_model_id = invalid_model_t;
+    float back_error = 0.f;
+
+    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+        model_actions& actions = *models_[model_id];
+        std::lock_guard<std::mutex> lock(actions.mutex_);
+
+        if (!actions.heaps_[queue].empty()) {
+            float error = actions.heaps_[queue].back().error_;
+            if (back_model_id == invalid_model_t || error < back_error) {
+                back_model_id = model_id;
+                back_error = error;
+            }
+        }
+    }
+
+    return back_model_id;
+}
 
+cut_update_index::cut_set& cut_update_index::
+current_cut(const view_t view_id, const model_t model_id) {
     assert(view_ids_.find(view_id) != view_ids_.end());
     assert(model_id < num_models_);
 
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            return front_b_cuts_[view_id][model_id];
-            break;
+    return cuts_[current_cut_front_][view_id][model_id];
+}
 
-        case cut_front::FRONT_B:
-            return front_a_cuts_[view_id][model_id];
-            break;
+cut_update_index::cut_set& cut_update_index::
+previous_cut(const view_t view_id, const model_t model_id) {
+    assert(view_ids_.find(view_id) != view_ids_.end());
+    assert(model_id < num_models_);
 
-        default: break;
+    return cuts_[current_cut_front_ == cut_front::FRONT_A ? cut_front::FRONT_B : cut_front::FRONT_A][view_id][model_id];
+}
 
-    }
+const std::vector<node_t>& cut_update_index::
+get_current_cut(const view_t view_id, const model_t model_id) {
+    std::lock_guard<std::mutex> lock(models_[model_id]->mutex_);
+
+    return current_cut(view_id, model_id).sorted();
+}
+
+const std::vector<node_t>& cut_update_index::
+get_previous_cut(const view_t view_id, const model_t model_id) {
+    std::lock_guard<std::mutex> lock(models_[model_id]->mutex_);
 
-    return front_b_cuts_[view_id][model_id];
+    return previous_cut(view_id, model_id).sorted();
 }
 
 void cut_update_index::
@@ -181,30 +222,13 @@ swap_cuts() {
 
 void cut_update_index::
 reset_cut(const view_t view_id, const model_t model_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    assert(view_ids_.find(view_id) != view_ids_.end());
-    assert(model_id < num_models_);
-
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            front_a_cuts_[view_id][model_id].clear();
-            break;
-
-        case cut_front::FRONT_B:
-            front_b_cuts_[view_id][model_id].clear();
-            break;
-
-        default: break;
-
-    }
+    std::lock_guard<std::mutex> lock(models_[model_id]->mutex_);
 
+    current_cut(view_id, model_id).clear();
 }
 
 void cut_update_index::
 push_action(const action& action, bool sort) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(action.model_id_ < num_models_);
     assert(action.node_id_ < num_nodes_table_[action.model_id_]);
     assert(action.queue_ < queue_t::NUM_QUEUES);
@@ -214,178 +238,143 @@ push_action(const action& action, bool sort) {
 
 const cut_update_index::action cut_update_index::
 front_action(const queue_t queue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(queue < queue_t::NUM_QUEUES);
 
-    action action;
+    model_t model_id = find_front_model(queue);
 
-    if (num_slots_[queue] > 0) {
-        action = slots_[queue].front();
+    if (model_id == invalid_model_t) {
+        return action();
     }
 
-    return action;
+    return front_action(queue, model_id);
 }
 
 const cut_update_index::action cut_update_index::
 back_action(const queue_t queue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(queue < queue_t::NUM_QUEUES);
 
-    action action;
+    model_t model_id = find_back_model(queue);
 
-    if (num_slots_[queue] > 0) {
-        action = slots_[queue].back();
+    if (model_id == invalid_model_t) {
+        return action();
     }
 
-    return action;
+    return back_action(queue, model_id);
 }
 
 void cut_update_index::
 pop_front_action(const queue_t queue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(queue < queue_t::NUM_QUEUES);
-    assert(!slots_[queue].empty());
 
-    action action = slots_[queue].front();
-    assert(action.queue_ == queue);
-
-    swap(queue, 0, num_slots_[queue]-1);
-
-
-    assert(slot_maps_[queue][action.model_id_][action.node_id_].find(num_slots_[queue]-1) != slot_maps_[queue][action.model_id_][action.node_id_].end());
-
-    slots_[queue].pop_back();
-    slot_maps_[queue][action.model_id_][action.node_id_].erase(num_slots_[queue]-1);
-
-    --num_slots_[queue];
-
-    shuffle_down(queue, 0);
-
-    if (slot_maps_[queue][action.model_id_][action.node_id_].empty()) {
-        slot_maps_[queue][action.model_id_].erase(action.node_id_);
-    }
+    model_t model_id = find_front_model(queue);
+    assert(model_id != invalid_model_t);
 
+    pop_front_action(queue, model_id);
 }
 
 void cut_update_index::
 Popback_action(const queue_t queue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(queue < queue_t::NUM_QUEUES);
-    assert(!slots_[queue].empty());
 
-    action action = slots_[queue].back();
-    assert(action.queue_ == queue);
+    model_t model_id = find_back_model(queue);
+    assert(model_id != invalid_model_t);
 
-    assert(slot_maps_[queue][action.model_id_][action.node_id_].find(num_slots_[queue]-1) != slot_maps_[queue][action.model_id_][action.node_id_].end());
+    Popback_action(queue, model_id);
+}
 
+const cut_update_index::action cut_update_index::
+front_action(const queue_t queue, const model_t model_id) {
+    assert(queue < queue_t::NUM_QUEUES);
+    assert(model_id < num_models_);
 
-    slots_[queue].pop_back();
-    slot_maps_[queue][action.model_id_][action.node_id_].erase(num_slots_[queue]-1);
+    model_actions& actions = *models_[model_id];
+    std::lock_guard<std::mutex> lock(actions.mutex_);
 
-    --num_slots_[queue];
+    action action;
 
-    if (slot_maps_[queue][action.model_id_][action.node_id_].empty()) {
-        slot_maps_[queue][action.model_id_].erase(action.node_id_);
+    if (!actions.heaps_[queue].empty()) {
+        action = actions.records_[actions.heaps_[queue].front().record_id_].action_;
     }
 
+    return action;
 }
 
-void cut_update_index::
-approve_action(const action& action) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    assert(action.model_id_ < num_models_);
-    assert(action.node_id_ < num_nodes_table_[action.model_id_]);
-    assert(action.queue_ < queue_t::NUM_QUEUES);
+const cut_update_index::action cut_update_index::
+back_action(const queue_t queue, const model_t model_id) {
+    assert(queue < queue_t::NUM_QUEUES);
+    assert(model_id < num_models_);
 
-    //approve action, this adds the action to all cuts of all the users in question.
-    switch (action.queue_) {
-        case queue_t::KEEP:
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
+    model_actions& actions = *models_[model_id];
+    std::lock_guard<std::mutex> lock(actions.mutex_);
 
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
+    action action;
 
-                default: break;
+    if (!actions.heaps_[queue].empty()) {
+        action = actions.records_[actions.heaps_[queue].back().record_id_].action_;
+    }
 
-            }
-            break;
+    return action;
+}
 
-        case queue_t::MUST_SPLIT:
-            {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
+void cut_update_index::
+pop_front_action(const queue_t queue, const model_t model_id) {
+    assert(queue < queue_t::NUM_QUEUES);
+    assert(model_id < num_models_);
 
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
+    model_actions& actions = *models_[model_id];
+    std::lock_guard<std::mutex> lock(actions.mutex_);
 
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
+    assert(!actions.heaps_[queue].empty());
 
-                    default: break;
+    uint32_t record_id = actions.heaps_[queue].front().record_id_;
+    assert(actions.records_[record_id].action_.queue_ == queue);
 
-                }
+    remove_from_heap(actions, queue, 0);
+    release_record(actions, record_id);
+}
 
-            }
-            break;
+void cut_update_index::
+Popback_action(const queue_t queue, const model_t model_id) {
+    assert(queue < queue_t::NUM_QUEUES);
+    assert(model_id < num_models_);
 
-        case queue_t::MUST_COLLAPSE:
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
+    model_actions& actions = *models_[model_id];
+    std::lock_guard<std::mutex> lock(actions.mutex_);
 
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
+    assert(!actions.heaps_[queue].empty());
 
-                default: break;
+    uint32_t record_id = actions.heaps_[queue].back().record_id_;
+    assert(actions.records_[record_id].action_.queue_ == queue);
 
-            }
-            break;
+    remove_from_heap(actions, queue, actions.heaps_[queue].size()-1);
+    release_record(actions, record_id);
+}
 
-        case queue_t::COLLAPSE_ON_NEED:
-            //if a collapse-on-need-action is approved, we collapse the node
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
+void cut_update_index::
+approve_action(const action& action) {
+    assert(action.model_id_ < num_models_);
+    assert(action.node_id_ < num_nodes_table_[action.model_id_]);
+    assert(action.queue_ < queue_t::NUM_QUEUES);
 
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
+    std::lock_guard<std::mutex> lock(models_[action.model_id_]->mutex_);
 
-                default: break;
+    cut_set& cut = current_cut(action.view_id_, action.model_id_);
+    const node_t num_nodes = num_nodes_table_[action.model_id_];
 
+    //approve action, this adds the action to all cuts of all the users in question.
+    switch (action.queue_) {
+        case queue_t::MUST_SPLIT:
+            for (node_t i = 0; i < (node_t)fan_factor_table_[action.model_id_]; ++i) {
+                cut.insert(get_child_id(action.model_id_, action.node_id_, i), num_nodes);
             }
             break;
 
-
+        //if a collapse action is approved, we collapse the node
+        case queue_t::KEEP:
+        case queue_t::MUST_COLLAPSE:
+        case queue_t::COLLAPSE_ON_NEED:
         case queue_t::MAYBE_COLLAPSE:
-            //if a maybe-collapse-action is approved, we collapse the node
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                default: break;
-
-            }
+            cut.insert(action.node_id_, num_nodes);
             break;
 
         default: break;
@@ -395,12 +384,15 @@ approve_action(const action& action) {
 
 void cut_update_index::
 reject_action(const action& action) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     assert(action.model_id_ < num_models_);
     assert(action.node_id_ < num_nodes_table_[action.model_id_]);
     assert(action.queue_ < queue_t::NUM_QUEUES);
 
+    std::lock_guard<std::mutex> lock(models_[action.model_id_]->mutex_);
+
+    cut_set& cut = current_cut(action.view_id_, action.model_id_);
+    const node_t num_nodes = num_nodes_table_[action.model_id_];
+
     //raise replacement action
     switch (action.queue_) {
         case queue_t::KEEP:
@@ -408,75 +400,14 @@ reject_action(const action& action) {
             break;
 
         case queue_t::MUST_SPLIT:
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                default: break;
-
-            }
-            break;
-
-        case queue_t::MUST_COLLAPSE: {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
-
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    default: break;
-
-                }
-            }
-            break;
-
-        case queue_t::COLLAPSE_ON_NEED: {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
-
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    default: break;
-
-                }
-            }
+            cut.insert(action.node_id_, num_nodes);
             break;
 
+        case queue_t::MUST_COLLAPSE:
+        case queue_t::COLLAPSE_ON_NEED:
         case queue_t::MAYBE_COLLAPSE:
-            {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
-
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    default: break;
-
-                }
+            for (node_t i = 0; i < (node_t)fan_factor_table_[action.model_id_]; ++i) {
+                cut.insert(get_child_id(action.model_id_, action.node_id_, i), num_nodes);
             }
             break;
 
@@ -492,16 +423,19 @@ add_action(const action& action, bool sort) {
     assert(action.queue_ < queue_t::NUM_QUEUES);
 
     if (sort) {
-        slots_[action.queue_].push_back(action);
-        ++num_slots_[action.queue_];
+        model_actions& actions = *models_[action.model_id_];
+        std::lock_guard<std::mutex> lock(actions.mutex_);
 
-        slot_maps_[action.queue_][action.model_id_][action.node_id_].insert(num_slots_[action.queue_]-1);
+        uint32_t record_id = allocate_record(actions, action);
 
-        shuffle_up(action.queue_, num_slots_[action.queue_]-1);
+        actions.heaps_[action.queue_].push_back(heap_entry{action.error_, record_id});
+        actions.records_[record_id].heap_pos_ = actions.heaps_[action.queue_].size()-1;
 
+        shuffle_up(actions, action.queue_, actions.heaps_[action.queue_].size()-1);
     }
     else {
-        initial_queue_.push(action);
+        std::lock_guard<std::mutex> lock(mutex_);
+        initial_queue_.push_back(action);
     }
 
 }
@@ -512,177 +446,272 @@ cancel_action(const view_t view_id, const model_t model_id, const node_t node_id
     assert(node_id < num_nodes_table_[model_id]);
     assert(view_ids_.find(view_id) != view_ids_.end());
 
+    model_actions& actions = *models_[model_id];
+    std::lock_guard<std::mutex> lock(actions.mutex_);
+
     //firstly, cancel actions that already happened (remove nodes from cuts)
+    current_cut(view_id, model_id).erase(node_id);
 
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            if (front_a_cuts_[view_id][model_id].find(node_id) != front_a_cuts_[view_id][model_id].end()) {
-                front_a_cuts_[view_id][model_id].erase(node_id);
-            }
-            break;
+    //secondly, cancel all pending actions of this view (remove actions from queues)
+    uint32_t record_id = actions.node_records_[node_id];
 
-        case cut_front::FRONT_B:
-            if (front_b_cuts_[view_id][model_id].find(node_id) != front_b_cuts_[view_id][model_id].end()) {
-                front_b_cuts_[view_id][model_id].erase(node_id);
-            }
-            break;
+    while (record_id != invalid_record) {
+        uint32_t next_id = actions.records_[record_id].next_;
 
-        default: break;
+        const action& current_item = actions.records_[record_id].action_;
+        assert(current_item.model_id_ == model_id);
+        assert(current_item.node_id_ == node_id);
 
+        if (current_item.view_id_ == view_id) {
+            remove_from_heap(actions, current_item.queue_, actions.records_[record_id].heap_pos_);
+            release_record(actions, record_id);
+        }
+
+        record_id = next_id;
     }
 
-    //secondly, cancel all pending actions (remove actions from queues)
+}
 
-    for (uint32_t queue = 0; queue < queue_t::NUM_QUEUES; ++queue) {
-        const auto slot_it = slot_maps_[queue][model_id].find(node_id);
+void cut_update_index::
+sort() {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-        if (slot_it == slot_maps_[queue][model_id].end()) {
-            continue;
+    std::vector<size_t> num_sorted(num_models_ * queue_t::NUM_QUEUES);
+    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+        for (uint32_t queue = 0; queue < queue_t::NUM_QUEUES; ++queue) {
+            num_sorted[model_id * queue_t::NUM_QUEUES + queue] = models_[model_id]->heaps_[queue].size();
         }
+    }
 
-        assert(slot_it != slot_maps_[queue][model_id].end());
+    for (const auto& action : initial_queue_) {
+        model_actions& actions = *models_[action.model_id_];
 
-        std::set<slot_t> slot_ids = slot_it->second; //copy
+        uint32_t record_id = allocate_record(actions, action);
 
-        std::set<slot_t>::iterator it = std::prev(slot_ids.end());
+        actions.heaps_[action.queue_].push_back(heap_entry{action.error_, record_id});
+        actions.records_[record_id].heap_pos_ = actions.heaps_[action.queue_].size()-1;
+    }
 
-        while (true) {
-            std::set<slot_t>::iterator current_it = it--;
+    initial_queue_.clear();
 
-            slot_t slot_id = *(current_it);
+    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+        model_actions& actions = *models_[model_id];
 
-            if (slots_[queue][slot_id].view_id_ == view_id) {
+        for (uint32_t queue = 0; queue < queue_t::NUM_QUEUES; ++queue) {
+            size_t num_entries = actions.heaps_[queue].size();
+            size_t num_sorted_entries = num_sorted[model_id * queue_t::NUM_QUEUES + queue];
 
-                action current_item = slots_[queue][slot_id];
-                action last_item = slots_[queue][num_slots_[queue]-1];
+            if (num_sorted_entries == 0) {
+                //build the heap bottom-up in linear time
+                for (size_t heap_pos = num_entries/2; heap_pos-- > 0; ) {
+                    shuffle_down(actions, (queue_t)queue, heap_pos);
+                }
+            }
+            else {
+                for (size_t heap_pos = num_sorted_entries; heap_pos < num_entries; ++heap_pos) {
+                    shuffle_up(actions, (queue_t)queue, heap_pos);
+                }
+            }
+        }
+    }
 
-                assert(slot_maps_[queue][current_item.model_id_][current_item.node_id_].find(slot_id) != slot_maps_[queue][current_item.model_id_][current_item.node_id_].end());
-                assert(slot_maps_[queue][last_item.model_id_][last_item.node_id_].find(num_slots_[queue]-1) != slot_maps_[queue][last_item.model_id_][last_item.node_id_].end());
+}
 
-                assert(current_item.queue_ == queue);
-                assert(current_item.model_id_ == model_id);
-                assert(current_item.node_id_ == node_id);
-                assert(last_item.queue_ == queue);
+uint32_t cut_update_index::
+allocate_record(model_actions& actions, const action& action) {
+    uint32_t record_id;
 
-                slot_maps_[queue][current_item.model_id_][current_item.node_id_].erase(slot_id);
-                slot_maps_[queue][last_item.model_id_][last_item.node_id_].erase(num_slots_[queue]-1);
+    if (!actions.free_records_.empty()) {
+        record_id = actions.free_records_.back();
+        actions.free_records_.pop_back();
+    }
+    else {
+        record_id = actions.records_.size();
+        actions.records_.push_back(record());
+    }
 
-                slot_maps_[queue][current_item.model_id_][current_item.node_id_].insert(num_slots_[queue]-1);
-                slot_maps_[queue][last_item.model_id_][last_item.node_id_].insert(slot_id);
+    uint32_t& head = actions.node_records_[action.node_id_];
 
-                std::swap(slots_[queue][slot_id], slots_[queue][num_slots_[queue]-1]);
+    record& rec = actions.records_[record_id];
+    rec.action_ = action;
+    rec.heap_pos_ = 0;
+    rec.prev_ = invalid_record;
+    rec.next_ = head;
 
-                slot_maps_[queue][current_item.model_id_][current_item.node_id_].erase(num_slots_[queue]-1);
+    if (head != invalid_record) {
+        actions.records_[head].prev_ = record_id;
+    }
+    head = record_id;
 
-                slots_[queue].pop_back();
+    return record_id;
+}
 
-                --num_slots_[queue];
+void cut_update_index::
+release_record(model_actions& actions, const uint32_t record_id) {
+    record& rec = actions.records_[record_id];
 
-                shuffle_down((queue_t)queue, slot_id);
+    if (rec.prev_ != invalid_record) {
+        actions.records_[rec.prev_].next_ = rec.next_;
+    }
+    else {
+        actions.node_records_[rec.action_.node_id_] = rec.next_;
+    }
 
-            }
+    if (rec.next_ != invalid_record) {
+        actions.records_[rec.next_].prev_ = rec.prev_;
+    }
 
-            if (current_it == slot_ids.begin()) {
-                break;
-            }
-        }
+    actions.free_records_.push_back(record_id);
+}
 
-        if (slot_maps_[queue][model_id][node_id].empty()) {
-            slot_maps_[queue][model_id].erase(node_id);
-        }
+void cut_update_index::
+remove_from_heap(model_actions& actions, const queue_t queue, const size_t heap_pos) {
+    std::vector<heap_entry>& heap = actions.heaps_[queue];
+
+    assert(heap_pos < heap.size());
+
+    heap_entry last = heap.back();
+    heap.pop_back();
+
+    if (heap_pos < heap.size()) {
+        place(actions, queue, heap_pos, last);
+        shuffle_down(actions, queue, heap_pos);
+        shuffle_up(actions, queue, actions.records_[last.record_id_].heap_pos_);
     }
+}
 
+void cut_update_index::
+place(model_actions& actions, const queue_t queue, const size_t heap_pos, const heap_entry& entry) {
+    actions.heaps_[queue][heap_pos] = entry;
+    actions.records_[entry.record_id_].heap_pos_ = heap_pos;
 }
 
 void cut_update_index::
-sort() {
-    while(!initial_queue_.empty()) {
-        action action = initial_queue_.top();
-        initial_queue_.pop();
+shuffle_up(model_actions& actions, const queue_t queue, size_t heap_pos) {
+    std::vector<heap_entry>& heap = actions.heaps_[queue];
 
-        slots_[action.queue_].push_back(action);
-        ++num_slots_[action.queue_];
+    heap_entry entry = heap[heap_pos];
 
-        slot_maps_[action.queue_][action.model_id_][action.node_id_].insert(num_slots_[action.queue_]-1);
+    while (heap_pos > 0) {
+        size_t parent_pos = (heap_pos-1)/2;
 
-        shuffle_up(action.queue_, num_slots_[action.queue_]-1);
+        if (entry.error_ < heap[parent_pos].error_) {
+            break;
+        }
 
+        place(actions, queue, heap_pos, heap[parent_pos]);
+        heap_pos = parent_pos;
     }
 
+    place(actions, queue, heap_pos, entry);
 }
 
 void cut_update_index::
-swap(const queue_t queue, const size_t slot_id_0, const size_t slot_id_1) {
-    if (slot_id_0 == slot_id_1) {
-        return;
-    }
+shuffle_down(model_actions& actions, const queue_t queue, size_t heap_pos) {
+    std::vector<heap_entry>& heap = actions.heaps_[queue];
+    const size_t num_entries = heap.size();
 
-    action& item0 = slots_[queue][slot_id_0];
-    action& item1 = slots_[queue][slot_id_1];
+    heap_entry entry = heap[heap_pos];
 
+    while (true) {
+        size_t child_pos = heap_pos*2 + 1;
 
-    assert(slot_maps_[queue][item0.model_id_][item0.node_id_].find(slot_id_0) != slot_maps_[queue][item0.model_id_][item0.node_id_].end());
-    assert(slot_maps_[queue][item1.model_id_][item1.node_id_].find(slot_id_1) != slot_maps_[queue][item1.model_id_][item1.node_id_].end());
+        if (child_pos >= num_entries) {
+            break;
+        }
 
+        if (child_pos+1 < num_entries && heap[child_pos].error_ < heap[child_pos+1].error_) {
+            ++child_pos;
+        }
 
-    slot_maps_[queue][item0.model_id_][item0.node_id_].erase(slot_id_0);
-    slot_maps_[queue][item1.model_id_][item1.node_id_].erase(slot_id_1);
+        if (!(entry.error_ < heap[child_pos].error_)) {
+            break;
+        }
 
-    slot_maps_[queue][item0.model_id_][item0.node_id_].insert(slot_id_1);
-    slot_maps_[queue][item1.model_id_][item1.node_id_].insert(slot_id_0);
+        place(actions, queue, heap_pos, heap[child_pos]);
+        heap_pos = child_pos;
+    }
 
-    std::swap(slots_[queue][slot_id_0], slots_[queue][slot_id_1]);
+    place(actions, queue, heap_pos, entry);
 }
 
-void cut_update_index::
-shuffle_up(const queue_t queue, const size_t slot_id) {
-    if (slot_id == 0) {
+void cut_update_index::cut_set::
+insert(const node_t node_id, const node_t num_nodes) {
+    if (node_id == invalid_node_t) {
         return;
     }
 
-    size_t parent_slot_id = (size_t)std::floor((slot_id-1)/2);
+    assert(node_id < num_nodes);
+
+    if (bits_.empty()) {
+        bits_.resize((num_nodes + 63) / 64, 0);
+        positions_.resize(num_nodes);
+    }
+
+    uint64_t& word = bits_[node_id >> 6];
+    const uint64_t mask = uint64_t(1) << (node_id & 63);
 
-    if (slots_[queue][slot_id].error_ < slots_[queue][parent_slot_id].error_) {
+    if (word & mask) {
         return;
     }
 
-    swap(queue, slot_id, parent_slot_id);
+    word |= mask;
 
-    shuffle_up(queue, parent_slot_id);
+    if (!nodes_.empty() && node_id < nodes_.back()) {
+        sorted_ = false;
+    }
+    positions_[node_id] = nodes_.size();
+    nodes_.push_back(node_id);
 }
 
-void cut_update_index::
-shuffle_down(const queue_t queue, const size_t slot_id) {
-    size_t left_child_id = slot_id*2 + 1;
-    size_t right_child_id = slot_id*2 + 2;
+void cut_update_index::cut_set::
+erase(const node_t node_id) {
+    if (bits_.empty() || node_id == invalid_node_t) {
+        return;
+    }
 
-    size_t replace_id = slot_id;
+    uint64_t& word = bits_[node_id >> 6];
+    const uint64_t mask = uint64_t(1) << (node_id & 63);
 
-    if (slot_id == num_slots_[queue]-1) {
+    if (!(word & mask)) {
         return;
     }
 
-    if (right_child_id < num_slots_[queue]) {
-        bool left_greater = slots_[queue][right_child_id].error_ < slots_[queue][left_child_id].error_;
+    word &= ~mask;
 
-        if (left_greater && slots_[queue][slot_id].error_ < slots_[queue][left_child_id].error_) {
-            replace_id = left_child_id;
-        }
-        else if (!left_greater && slots_[queue][slot_id].error_ < slots_[queue][right_child_id].error_) {
-            replace_id = right_child_id;
-        }
+    //swap the last node into the gap, the list is sorted again on request
+    const uint32_t pos = positions_[node_id];
+    const node_t last_id = nodes_.back();
+    if (last_id != node_id) {
+        nodes_[pos] = last_id;
+        positions_[last_id] = pos;
+        sorted_ = false;
+    }
+    nodes_.pop_back();
+}
 
+void cut_update_index::cut_set::
+clear() {
+    //only touch the words that hold a node of the cut
+    for (const auto node_id : nodes_) {
+        bits_[node_id >> 6] = 0;
     }
-    else if (left_child_id < num_slots_[queue]) {
-        if (slots_[queue][slot_id].error_ < slots_[queue][left_child_id].error_) {
-            replace_id = left_child_id;
+
+    nodes_.clear();
+    sorted_ = true;
+}
+
+const std::vector<node_t>& cut_update_index::cut_set::
+sorted() {
+    if (!sorted_) {
+        std::sort(nodes_.begin(), nodes_.end());
+        for (uint32_t pos = 0; pos < nodes_.size(); ++pos) {
+            positions_[nodes_[pos]] = pos;
         }
+        sorted_ = true;
     }
 
-    if (replace_id != slot_id) {
-        swap(queue, slot_id, replace_id);
-        shuffle_down(queue, replace_id);
-    }
+    return nodes_;
 }
 
 const node_t cut_update_index::
@@ -8,7 +8,12 @@
 #include <lamure/ren/cut_update_pool.h>
 #include <lamure/pvs/pvs_database.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <numeric>
+#include <queue>
 
 namespace lamure
 {
@@ -82,6 +87,8 @@ void cut_update_pool::initialize(bool provenance)
     index_->update_policy(0);
     gpu_cache_ = new gpu_cache(render_budget_in_nodes_);
 
+    predictive_prefetching_ = policy->predictive_prefetching();
+
     if (provenance) {
       ooc_cache *ooc_cache = ooc_cache::get_instance(_data_provenance);
     }
@@ -92,7 +99,15 @@ void cut_update_pool::initialize(bool provenance)
     semaphore_.set_max_signal_count(1);
     semaphore_.set_min_signal_count(1);
 
-    
+    for(uint32_t i = 0; i < num_threads_; ++i)
+    {
+        update_workers_.emplace_back(new update_worker());
+    }
+    next_update_worker_ = 0;
+
+    shared_gpu_slots_ = 0;
+    shared_ooc_slots_ = 0;
+    shared_transfer_slots_ = 0;
 
 #ifdef LAMURE_ENABLE_INFO
     std::cout << "lamure: num models: " << index_->num_models() << std::endl;
@@ -135,6 +150,18 @@ const bool cut_update_pool::is_running()
     return master_dispatched_;
 }
 
+const cut_update_pool::latency cut_update_pool::last_latency()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_latency_;
+}
+
+const cut_update_pool::prefetch_statistics cut_update_pool::prefetch_stats()
+{
+    std::lock_guard<std::mutex> lock(prediction_mutex_);
+    return prefetch_statistics_;
+}
+
 void cut_update_pool::dispatch_cut_update(char *current_gpu_storage_A, char *current_gpu_storage_B, char *current_gpu_storage_A_provenance, char *current_gpu_storage_B_provenance)
 {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -191,7 +218,8 @@ void cut_update_pool::run()
                 break;
 
             case cut_update_queue::task_t::CUT_UPDATE_TASK:
-                cut_update();
+                cut_update_worker();
+                master_semaphore_.signal(1);
                 break;
 
             default:
@@ -207,6 +235,11 @@ const bool cut_update_pool::prepare()
 
     cut_database->receive_cameras(context_id_, user_cameras_);
     cut_database->receive_height_divided_by_top_minus_bottoms(context_id_, height_divided_by_top_minus_bottoms_);
+
+    if(predictive_prefetching_)
+    {
+        record_camera_history();
+    }
     cut_database->receive_transforms(context_id_, model_transforms_);
     cut_database->receive_thresholds(context_id_, model_thresholds_);
 
@@ -313,6 +346,11 @@ const bool cut_update_pool::prepare()
 
 void cut_update_pool::cut_master()
 {
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point master_start = clock::now();
+
+    latency frame_latency;
+
     if(!prepare())
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -367,6 +405,8 @@ void cut_update_pool::cut_master()
 
 #endif
 
+        const clock::time_point analysis_start = clock::now();
+
         // swap cut index
         index_->swap_cuts();
 
@@ -404,24 +444,16 @@ void cut_update_pool::cut_master()
 
         index_->sort();
 
-        // re-configure semaphores
-        master_semaphore_.lock();
-        master_semaphore_.set_max_signal_count(1);
-        master_semaphore_.set_min_signal_count(1);
-        master_semaphore_.unlock();
-
-        semaphore_.lock();
-        semaphore_.set_max_signal_count(1);
-        semaphore_.set_min_signal_count(1);
-        semaphore_.unlock();
+        const clock::time_point update_start = clock::now();
 
-        job_queue_.push_job(cut_update_queue::job(cut_update_queue::task_t::CUT_UPDATE_TASK, 0, 0));
-        semaphore_.signal(1);
-
-        master_semaphore_.wait();
+        cut_update();
         if(is_shutdown())
             return;
 
+        frame_latency.analysis_ms_ += std::chrono::duration<double, std::milli>(update_start - analysis_start).count();
+        frame_latency.update_ms_ += std::chrono::duration<double, std::milli>(clock::now() - update_start).count();
+        ++frame_latency.num_updates_;
+
 #ifdef LAMURE_CUT_UPDATE_ENABLE_REPEAT_MODE
     }
 #endif
@@ -452,8 +484,17 @@ void cut_update_pool::cut_master()
 
         cuts->unlock_record(context_id_);
 
+        frame_latency.total_ms_ = std::chrono::duration<double, std::milli>(clock::now() - master_start).count();
+
+        if(policy::get_instance()->measure_cut_update_latency())
+        {
+            std::cout << "lamure: cut update (context " << context_id_ << ") analysis: " << frame_latency.analysis_ms_ << " ms, update: " << frame_latency.update_ms_
+                      << " ms, total: " << frame_latency.total_ms_ << " ms (" << frame_latency.num_updates_ << " updates)" << std::endl;
+        }
+
         {
             std::lock_guard<std::mutex> lock(mutex_);
+            last_latency_ = frame_latency;
             master_dispatched_ = false;
         }
     }
@@ -464,6 +505,7 @@ void cut_update_pool::
 cut_analysis(view_t view_id, model_t model_id) {
 
     lamure::pvs::pvs_database* pvs = lamure::pvs::pvs_database::get_instance();
+    ooc_cache* ooc_cache = ooc_cache::get_instance(_data_provenance);
 
     assert(view_id != invalid_view_t);
     assert(model_id != invalid_model_t);
@@ -486,7 +528,7 @@ cut_analysis(view_t view_id, model_t model_id) {
     }
 
     // perform cut analysis
-    std::set<node_t> old_cut = index_->get_previous_cut(view_id, model_id);
+    std::vector<node_t> old_cut = index_->get_previous_cut(view_id, model_id);
 
     index_->reset_cut(view_id, model_id);
 
@@ -501,7 +543,7 @@ cut_analysis(view_t view_id, model_t model_id) {
     float max_error_threshold = model_thresholds_[model_id] + 0.1f;
 
     // cut analysis
-    std::set<node_t>::iterator cut_it;
+    std::vector<node_t>::const_iterator cut_it;
     for(cut_it = old_cut.begin(); cut_it != old_cut.end(); ++cut_it)
     {
         node_t node_id = *cut_it;
@@ -544,6 +586,16 @@ cut_analysis(view_t view_id, model_t model_id) {
             float node_error = calculate_node_error(view_id, model_id, node_id);
             bool node_in_frustum = is_node_in_frustum(view_id, model_id, node_id, frustum);
 
+            //hint for error weighted eviction of the node once it leaves the cut
+            if (ooc_cache->uses_node_errors())
+            {
+                ooc_cache->update_node_error(model_id, node_id, node_error);
+            }
+            if (gpu_cache_->uses_node_errors())
+            {
+                gpu_cache_->update_node_error(model_id, node_id, node_error);
+            }
+
             if (node_in_frustum && node_error > max_error_threshold && pvs->get_viewer_visibility(model_id, node_id))
             {
                 //only split if the predicted error of children does not require collapsing
@@ -755,33 +807,251 @@ void cut_update_pool::cut_update()
     ooc_cache->refresh();
     gpu_cache_->lock();
 
-    bool check_residency = true;
+    distribute_budgets();
+
+    // the models are resolved independently, the master acts as one of the workers
+    const uint32_t num_helpers = std::max(1u, std::min((uint32_t)index_->num_models(), num_threads_)) - 1;
+    next_update_worker_ = 0;
+
+    if(num_helpers > 0)
+    {
+        // re-configure semaphores
+        master_semaphore_.lock();
+        master_semaphore_.set_max_signal_count(num_helpers);
+        master_semaphore_.set_min_signal_count(num_helpers);
+        master_semaphore_.unlock();
+
+        semaphore_.lock();
+        semaphore_.set_max_signal_count(num_helpers);
+        semaphore_.set_min_signal_count(1);
+        semaphore_.unlock();
 
-    bool all_children_in_ooc_cache = true;
-    bool all_children_in_gpu_cache = true;
+        for(uint32_t i = 0; i < num_helpers; ++i)
+        {
+            job_queue_.push_job(cut_update_queue::job(cut_update_queue::task_t::CUT_UPDATE_TASK, invalid_view_t, invalid_model_t));
+        }
+
+        semaphore_.signal(num_helpers);
+    }
+
+    cut_update_worker();
+
+    if(num_helpers > 0)
+    {
+        master_semaphore_.wait();
+        if(is_shutdown())
+        {
+            gpu_cache_->unlock();
+            ooc_cache->unlock();
+            return;
+        }
+    }
+
+#ifdef LAMURE_CUT_UPDATE_ENABLE_PREFETCHING
+    prefetch_routine();
+#endif
+    if(predictive_prefetching_)
+    {
+        predictive_prefetch_routine();
+    }
+    gpu_cache_->unlock();
+    ooc_cache->unlock();
+
+    assert(index_->num_actions(cut_update_index::queue_t::KEEP) == 0);
+    assert(index_->num_actions(cut_update_index::queue_t::MUST_SPLIT) == 0);
+    assert(index_->num_actions(cut_update_index::queue_t::MUST_COLLAPSE) == 0);
+    assert(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED) == 0);
+    assert(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE) == 0);
+
+    compile_render_list();
+    compile_transfer_list();
+}
+
+void cut_update_pool::distribute_budgets()
+{
+    ooc_cache *ooc_cache = ooc_cache::get_instance(_data_provenance);
+
+    const model_t num_models = index_->num_models();
+
+    int64_t gpu_slots = gpu_cache_->num_free_slots();
+    int64_t ooc_slots = ooc_cache->num_free_slots();
+    int64_t transfer_slots = gpu_cache_->transfer_budget();
+
+    // every model is granted a share proportional to the slots its splits ask for,
+    // whatever is not granted remains in the shared pools
+    std::vector<int64_t> demands(num_models, 0);
+    int64_t total_demand = 0;
+
+    for(model_t model_id = 0; model_id < num_models; ++model_id)
+    {
+        demands[model_id] = (int64_t)index_->num_actions(cut_update_index::queue_t::MUST_SPLIT, model_id) * index_->fan_factor(model_id);
+        total_demand += demands[model_id];
+    }
+
+    model_budgets_.assign(num_models, slot_budget{0, 0, 0});
+
+    if(total_demand > 0)
+    {
+        for(model_t model_id = 0; model_id < num_models; ++model_id)
+        {
+            slot_budget &budget = model_budgets_[model_id];
+            budget.gpu_slots_ = std::min(demands[model_id], gpu_slots * demands[model_id] / total_demand);
+            budget.ooc_slots_ = std::min(demands[model_id], ooc_slots * demands[model_id] / total_demand);
+            budget.transfer_slots_ = std::min(demands[model_id], transfer_slots * demands[model_id] / total_demand);
+        }
+
+        for(const auto &budget : model_budgets_)
+        {
+            gpu_slots -= budget.gpu_slots_;
+            ooc_slots -= budget.ooc_slots_;
+            transfer_slots -= budget.transfer_slots_;
+        }
+    }
+
+    shared_gpu_slots_ = gpu_slots;
+    shared_ooc_slots_ = ooc_slots;
+    shared_transfer_slots_ = transfer_slots;
+
+    // deal the models round robin to the workers, most expensive first
+    std::vector<size_t> weights(num_models, 0);
+    for(model_t model_id = 0; model_id < num_models; ++model_id)
+    {
+        for(uint32_t queue_id = 0; queue_id < cut_update_index::queue_t::NUM_QUEUES; ++queue_id)
+        {
+            weights[model_id] += index_->num_actions((cut_update_index::queue_t)queue_id, model_id);
+        }
+    }
+
+    std::vector<model_t> model_ids(num_models);
+    std::iota(model_ids.begin(), model_ids.end(), 0);
+    std::stable_sort(model_ids.begin(), model_ids.end(), [&](const model_t l, const model_t r) { return weights[l] > weights[r]; });
+
+    const uint32_t num_workers = std::max(1u, std::min((uint32_t)num_models, num_threads_));
+
+    for(auto &worker : update_workers_)
+    {
+        worker->model_ids_.clear();
+    }
+
+    for(model_t i = 0; i < num_models; ++i)
+    {
+        update_workers_[i % num_workers]->model_ids_.push_back(model_ids[i]);
+    }
+}
+
+static const bool draw_slots(int64_t &local_slots, std::atomic<int64_t> &shared_slots, const int64_t num_slots)
+{
+    if(local_slots >= num_slots)
+    {
+        local_slots -= num_slots;
+        return true;
+    }
+
+    const int64_t missing_slots = num_slots - local_slots;
+    int64_t available_slots = shared_slots.load();
+
+    while(available_slots >= missing_slots)
+    {
+        if(shared_slots.compare_exchange_weak(available_slots, available_slots - missing_slots))
+        {
+            local_slots = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const bool cut_update_pool::draw_budget(slot_budget &budget, const int64_t num_gpu_slots, const int64_t num_ooc_slots)
+{
+    if(!draw_slots(budget.gpu_slots_, shared_gpu_slots_, num_gpu_slots))
+    {
+        return false;
+    }
+
+    if(!draw_slots(budget.ooc_slots_, shared_ooc_slots_, num_ooc_slots))
+    {
+        budget.gpu_slots_ += num_gpu_slots;
+        return false;
+    }
+
+    return true;
+}
+
+const bool cut_update_pool::take_model(const uint32_t worker_id, model_t &model_id)
+{
+    const uint32_t num_workers = update_workers_.size();
+
+    {
+        update_worker &worker = *update_workers_[worker_id % num_workers];
+        std::lock_guard<std::mutex> lock(worker.mutex_);
+
+        if(!worker.model_ids_.empty())
+        {
+            model_id = worker.model_ids_.front();
+            worker.model_ids_.pop_front();
+            return true;
+        }
+    }
+
+    for(uint32_t i = 1; i < num_workers; ++i)
+    {
+        update_worker &victim = *update_workers_[(worker_id + i) % num_workers];
+        std::lock_guard<std::mutex> lock(victim.mutex_);
+
+        if(!victim.model_ids_.empty())
+        {
+            model_id = victim.model_ids_.back();
+            victim.model_ids_.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void cut_update_pool::cut_update_worker()
+{
+    const uint32_t worker_id = next_update_worker_.fetch_add(1);
+
+    model_t model_id = invalid_model_t;
+    while(take_model(worker_id, model_id))
+    {
+        cut_update_model(model_id);
+    }
+}
+
+void cut_update_pool::cut_update_model(const model_t model_id)
+{
+    ooc_cache *ooc_cache = ooc_cache::get_instance(_data_provenance);
+    slot_budget &budget = model_budgets_[model_id];
+
+    const int64_t fan_factor = index_->fan_factor(model_id);
+
+    bool check_residency = true;
 
     // cut update
-    while(index_->num_actions(cut_update_index::queue_t::MUST_SPLIT) > 0)
+    while(index_->num_actions(cut_update_index::queue_t::MUST_SPLIT, model_id) > 0)
     {
-        cut_update_index::action must_split_action = index_->front_action(cut_update_index::queue_t::MUST_SPLIT);
-        size_t fan_factor = index_->fan_factor(must_split_action.model_id_);
+        cut_update_index::action must_split_action = index_->front_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
 
-#if 1
+        bool all_children_in_ooc_cache = true;
+        bool all_children_in_gpu_cache = true;
 
         if(check_residency)
         {
             std::vector<node_t> child_ids;
-            index_->get_all_children(must_split_action.model_id_, must_split_action.node_id_, child_ids);
+            index_->get_all_children(model_id, must_split_action.node_id_, child_ids);
 
             for(const auto &child_id : child_ids)
             {
-                if(!ooc_cache->is_node_resident(must_split_action.model_id_, child_id))
+                if(!ooc_cache->is_node_resident(model_id, child_id))
                 {
                     all_children_in_ooc_cache = false;
                     if(!all_children_in_gpu_cache)
                         break;
                 }
-                if(!gpu_cache_->is_node_resident(must_split_action.model_id_, child_id))
+                if(!gpu_cache_->is_node_resident(model_id, child_id))
                 {
                     all_children_in_gpu_cache = false;
                     if(!all_children_in_ooc_cache)
@@ -789,65 +1059,79 @@ void cut_update_pool::cut_update()
                 }
             }
 
-            if(all_children_in_ooc_cache && all_children_in_gpu_cache)
+            if(all_children_in_ooc_cache && all_children_in_gpu_cache && draw_budget(budget, fan_factor, fan_factor))
             {
-                index_->pop_front_action(cut_update_index::queue_t::MUST_SPLIT);
+                index_->pop_front_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
 
-                for(const auto &child_id : child_ids)
+                // children may have been evicted by another model in the meantime
+                if(aquire_children(must_split_action, child_ids))
                 {
-                    gpu_cache_->aquire_node(context_id_, must_split_action.view_id_, must_split_action.model_id_, child_id);
-                    ooc_cache->aquire_node(context_id_, must_split_action.view_id_, must_split_action.model_id_, child_id);
-                }
-
 #ifdef LAMURE_CUT_UPDATE_ENABLE_SPLIT_AGAIN_MODE
-                cut_update_split_again(must_split_action);
+                    cut_update_split_again(must_split_action);
 #else
-                index_->approve_action(must_split_action);
+                    index_->approve_action(must_split_action);
 #endif
+                }
+                else
+                {
+                    index_->reject_action(must_split_action);
+                }
                 continue;
             }
         }
 
-#endif
         check_residency = false;
 
-        bool all_children_fit_in_ooc_cache = ooc_cache->num_free_slots() >= fan_factor;
-        bool all_children_fit_in_gpu_cache = gpu_cache_->num_free_slots() >= fan_factor;
+        std::vector<node_t> child_ids;
+        index_->get_all_children(model_id, must_split_action.node_id_, child_ids);
+
+        int64_t num_children_to_load = 0;
+        for(const auto &child_id : child_ids)
+        {
+            if(!ooc_cache->is_node_resident(model_id, child_id))
+            {
+                ++num_children_to_load;
+            }
+        }
 
-        if((all_children_fit_in_ooc_cache && all_children_fit_in_gpu_cache) || (all_children_in_ooc_cache && all_children_fit_in_gpu_cache))
+        if(draw_budget(budget, fan_factor, num_children_to_load))
         {
-            cut_update_index::action msa = index_->front_action(cut_update_index::queue_t::MUST_SPLIT);
-            index_->pop_front_action(cut_update_index::queue_t::MUST_SPLIT);
+            cut_update_index::action msa = index_->front_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
+            index_->pop_front_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
+
+            // split_node draws the ooc slots per child, they are guaranteed to be
+            // found in the model budget now
+            budget.ooc_slots_ += num_children_to_load;
 
             split_node(msa);
             check_residency = true;
             continue;
         }
 
-        if(index_->num_actions(cut_update_index::queue_t::MUST_COLLAPSE) > 0)
+        if(index_->num_actions(cut_update_index::queue_t::MUST_COLLAPSE, model_id) > 0)
         {
-            cut_update_index::action collapse_action = index_->front_action(cut_update_index::queue_t::MUST_COLLAPSE);
-            index_->pop_front_action(cut_update_index::queue_t::MUST_COLLAPSE);
+            cut_update_index::action collapse_action = index_->front_action(cut_update_index::queue_t::MUST_COLLAPSE, model_id);
+            index_->pop_front_action(cut_update_index::queue_t::MUST_COLLAPSE, model_id);
 
             collapse_node(collapse_action);
             continue;
         }
 
-        if(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED) > 0)
+        if(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED, model_id) > 0)
         {
-            cut_update_index::action collapse_on_need_action = index_->front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED);
-            index_->pop_front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED);
+            cut_update_index::action collapse_on_need_action = index_->front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED, model_id);
+            index_->pop_front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED, model_id);
 
             collapse_node(collapse_on_need_action);
             continue;
         }
 
-        if(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE) > 0)
+        if(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE, model_id) > 0)
         {
-            if(must_split_action.error_ > index_->back_action(cut_update_index::queue_t::MAYBE_COLLAPSE).error_)
+            if(must_split_action.error_ > index_->back_action(cut_update_index::queue_t::MAYBE_COLLAPSE, model_id).error_)
             {
-                cut_update_index::action collapse_action = index_->back_action(cut_update_index::queue_t::MAYBE_COLLAPSE);
-                index_->Popback_action(cut_update_index::queue_t::MAYBE_COLLAPSE);
+                cut_update_index::action collapse_action = index_->back_action(cut_update_index::queue_t::MAYBE_COLLAPSE, model_id);
+                index_->Popback_action(cut_update_index::queue_t::MAYBE_COLLAPSE, model_id);
 
                 collapse_node(collapse_action);
                 continue;
@@ -855,21 +1139,21 @@ void cut_update_pool::cut_update()
         }
 
 #ifdef LAMURE_CUT_UPDATE_ENABLE_CUT_UPDATE_EXPERIMENTAL_MODE
-        if(index_->num_actions(cut_update_index::queue_t::KEEP) > 0)
+        if(index_->num_actions(cut_update_index::queue_t::KEEP, model_id) > 0)
         {
-            cut_update_index::action keep_action = index_->back_action(cut_update_index::queue_t::KEEP);
-            index_->Popback_action(cut_update_index::queue_t::KEEP);
+            cut_update_index::action keep_action = index_->back_action(cut_update_index::queue_t::KEEP, model_id);
+            index_->Popback_action(cut_update_index::queue_t::KEEP, model_id);
 
             if(must_split_action.error_ > keep_action.error_)
             {
-                node_t keep_action_parent_id = index_->get_parent_id(keep_action.model_id_, keep_action.node_id_);
+                node_t keep_action_parent_id = index_->get_parent_id(model_id, keep_action.node_id_);
 
                 if(keep_action.node_id_ > 0 && keep_action_parent_id > 0)
                 {
                     std::vector<node_t> siblings;
-                    index_->get_all_siblings(keep_action.model_id_, keep_action.node_id_, siblings);
+                    index_->get_all_siblings(model_id, keep_action.node_id_, siblings);
 
-                    if(is_all_nodes_in_cut(keep_action.model_id_, siblings, index_->get_previous_cut(keep_action.view_id_, keep_action.model_id_)))
+                    if(is_all_nodes_in_cut(model_id, siblings, index_->get_previous_cut(keep_action.view_id_, model_id)))
                     {
                         bool singularity = false;
 
@@ -885,7 +1169,7 @@ void cut_update_pool::cut_update()
                             }
 
                             std::vector<node_t> sibling_children;
-                            index_->get_all_children(keep_action.model_id_, sibling_id, sibling_children);
+                            index_->get_all_children(model_id, sibling_id, sibling_children);
 
                             for(const auto &sibling_child_id : sibling_children)
                             {
@@ -899,44 +1183,52 @@ void cut_update_pool::cut_update()
 
                         if(!singularity)
                         {
+                            std::vector<node_t> released_ids;
+
                             for(const auto &sibling_id : siblings)
                             {
                                 if(sibling_id != invalid_node_t)
                                 {
-                                    // cancel all possible actions on sibling_id
-                                    index_->cancel_action(keep_action.view_id_, keep_action.model_id_, sibling_id);
-
-                                    if(gpu_cache_->release_node_invalidate(context_id_, keep_action.view_id_, keep_action.model_id_, sibling_id))
-                                    {
-                                        gpu_cache_->remove_from_transfer_list(keep_action.model_id_, sibling_id);
-                                    }
-
-                                    ooc_cache->release_node(context_id_, keep_action.view_id_, keep_action.model_id_, sibling_id);
+                                    released_ids.push_back(sibling_id);
 
                                     // cancel a possible split action that already happened
                                     std::vector<node_t> sibling_children;
-                                    index_->get_all_children(keep_action.model_id_, sibling_id, sibling_children);
+                                    index_->get_all_children(model_id, sibling_id, sibling_children);
                                     for(const auto &sibling_child_id : sibling_children)
                                     {
                                         if(sibling_child_id != invalid_node_t)
                                         {
-                                            index_->cancel_action(keep_action.view_id_, keep_action.model_id_, sibling_child_id);
+                                            released_ids.push_back(sibling_child_id);
+                                        }
+                                    }
+                                }
+                            }
 
-                                            if(gpu_cache_->release_node_invalidate(context_id_, keep_action.view_id_, keep_action.model_id_, sibling_child_id))
-                                            {
-                                                gpu_cache_->remove_from_transfer_list(keep_action.model_id_, sibling_child_id);
-                                            }
+                            for(const auto &released_id : released_ids)
+                            {
+                                // cancel all possible actions on released_id
+                                index_->cancel_action(keep_action.view_id_, model_id, released_id);
 
-                                            ooc_cache->release_node(context_id_, keep_action.view_id_, keep_action.model_id_, sibling_child_id);
-                                        }
+                                if(gpu_cache_->release_node_invalidate(context_id_, keep_action.view_id_, model_id, released_id))
+                                {
+                                    ++budget.gpu_slots_;
+
+                                    if(gpu_cache_->remove_from_transfer_list(model_id, released_id))
+                                    {
+                                        ++budget.transfer_slots_;
                                     }
                                 }
+
+                                if(ooc_cache->release_node(context_id_, keep_action.view_id_, model_id, released_id))
+                                {
+                                    ++budget.ooc_slots_;
+                                }
                             }
 
-                            assert(gpu_cache_->is_node_resident(keep_action.model_id_, keep_action_parent_id));
-                            assert(ooc_cache->is_node_resident(keep_action.model_id_, keep_action_parent_id));
+                            assert(gpu_cache_->is_node_resident(model_id, keep_action_parent_id));
+                            assert(ooc_cache->is_node_resident(model_id, keep_action_parent_id));
 
-                            index_->approve_action(cut_update_index::action(cut_update_index::queue_t::KEEP, keep_action.view_id_, keep_action.model_id_, keep_action_parent_id, keep_action.error_));
+                            index_->approve_action(cut_update_index::action(cut_update_index::queue_t::KEEP, keep_action.view_id_, model_id, keep_action_parent_id, keep_action.error_));
 
                             continue;
                         }
@@ -948,34 +1240,31 @@ void cut_update_pool::cut_update()
             index_->approve_action(keep_action);
         }
 
-        if(index_->num_actions(cut_update_index::queue_t::MUST_SPLIT) > 1)
+        if(index_->num_actions(cut_update_index::queue_t::MUST_SPLIT, model_id) > 1)
         { //> 1, prevent request from canceling itself
-            cut_update_index::action split_action = index_->back_action(cut_update_index::queue_t::MUST_SPLIT);
-            index_->Popback_action(cut_update_index::queue_t::MUST_SPLIT);
+            cut_update_index::action split_action = index_->back_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
+            index_->Popback_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
 
             if(must_split_action.error_ > split_action.error_)
             {
-                node_t split_action_parent_id = index_->get_parent_id(split_action.model_id_, split_action.node_id_);
+                node_t split_action_parent_id = index_->get_parent_id(model_id, split_action.node_id_);
 
                 if(split_action.node_id_ > 0 && split_action_parent_id > 0)
                 {
-                    // only if siblings are also in cut -- why does it make sense to check this here?
-                    // because we check it above in the keep-action branch anyway
-                    // and there is really no reason to cancel this action if we cannot use it
-                    // to cut down memory usage in the end.
+                    // only if siblings are also in cut, there is no reason to cancel
+                    // this action if we cannot use it to cut down memory usage in the end
                     std::vector<node_t> siblings;
-                    index_->get_all_siblings(split_action.model_id_, split_action.node_id_, siblings);
+                    index_->get_all_siblings(model_id, split_action.node_id_, siblings);
 
-                    if(is_all_nodes_in_cut(split_action.model_id_, siblings, index_->get_previous_cut(split_action.view_id_, split_action.model_id_)))
+                    if(is_all_nodes_in_cut(model_id, siblings, index_->get_previous_cut(split_action.view_id_, model_id)))
                     {
                         bool singularity = split_action.node_id_ == must_split_action.node_id_;
 
                         std::vector<node_t> split_children;
-                        index_->get_all_children(split_action.model_id_, split_action.node_id_, split_children);
+                        index_->get_all_children(model_id, split_action.node_id_, split_children);
 
-                        // check if children of split_action are equal to the must_split_node (parent of must_split)
-                        // this is important, since it would not free any memory anyways to cancel a split_action that is above
-                        // the must_split action in the hierarchy
+                        // cancelling a split_action that is above the must_split action
+                        // in the hierarchy would not free any memory
                         for(const auto &split_child_id : split_children)
                         {
                             if(split_child_id == must_split_action.node_id_)
@@ -987,14 +1276,12 @@ void cut_update_pool::cut_update()
 
                         if(!singularity)
                         {
-                            assert(gpu_cache_->is_node_resident(split_action.model_id_, split_action.node_id_));
-                            assert(ooc_cache->is_node_resident(split_action.model_id_, split_action.node_id_));
-
-                            scm::math::mat4f model_matrix = model_transforms_[split_action.model_id_];
+                            assert(gpu_cache_->is_node_resident(model_id, split_action.node_id_));
+                            assert(ooc_cache->is_node_resident(model_id, split_action.node_id_));
 
-                            float replacement_node_error = calculate_node_error(split_action.view_id_, split_action.model_id_, split_action.node_id_);
-                            index_->push_action(
-                                cut_update_index::action(cut_update_index::queue_t::KEEP, split_action.view_id_, split_action.model_id_, split_action.node_id_, replacement_node_error * 2.75f), true);
+                            float replacement_node_error = calculate_node_error(split_action.view_id_, model_id, split_action.node_id_);
+                            index_->push_action(cut_update_index::action(cut_update_index::queue_t::KEEP, split_action.view_id_, model_id, split_action.node_id_, replacement_node_error * 2.75f),
+                                                true);
 
                             continue;
                         }
@@ -1009,60 +1296,49 @@ void cut_update_pool::cut_update()
 #endif
 
         // no success, reject must split action
-        cut_update_index::action msa = index_->front_action(cut_update_index::queue_t::MUST_SPLIT);
-        index_->pop_front_action(cut_update_index::queue_t::MUST_SPLIT);
+        cut_update_index::action msa = index_->front_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
+        index_->pop_front_action(cut_update_index::queue_t::MUST_SPLIT, model_id);
         index_->reject_action(msa);
         check_residency = true;
     }
 
     // approve all remaining must-collapse-actions
-    while(index_->num_actions(cut_update_index::queue_t::MUST_COLLAPSE) > 0)
+    while(index_->num_actions(cut_update_index::queue_t::MUST_COLLAPSE, model_id) > 0)
     {
-        cut_update_index::action collapse_action = index_->front_action(cut_update_index::queue_t::MUST_COLLAPSE);
-        index_->pop_front_action(cut_update_index::queue_t::MUST_COLLAPSE);
+        cut_update_index::action collapse_action = index_->front_action(cut_update_index::queue_t::MUST_COLLAPSE, model_id);
+        index_->pop_front_action(cut_update_index::queue_t::MUST_COLLAPSE, model_id);
         collapse_node(collapse_action);
     }
 
-#ifdef LAMURE_CUT_UPDATE_ENABLE_PREFETCHING
-    prefetch_routine();
-#endif
-    gpu_cache_->unlock();
-    ooc_cache->unlock();
+    // hand the unused budget back to the other models
+    shared_gpu_slots_ += budget.gpu_slots_;
+    shared_ooc_slots_ += budget.ooc_slots_;
+    shared_transfer_slots_ += budget.transfer_slots_;
+    budget = slot_budget{0, 0, 0};
 
     // reject remaining collapse-on-need-actions
-    while(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED) > 0)
+    while(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED, model_id) > 0)
     {
-        cut_update_index::action collapse_on_need_action = index_->front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED);
-        index_->pop_front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED);
+        cut_update_index::action collapse_on_need_action = index_->front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED, model_id);
+        index_->pop_front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED, model_id);
         index_->reject_action(collapse_on_need_action);
     }
 
     // reject remaining maybe-collapse-actions
-    while(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE) > 0)
+    while(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE, model_id) > 0)
     {
-        cut_update_index::action maybe_collapse_action = index_->front_action(cut_update_index::queue_t::MAYBE_COLLAPSE);
-        index_->pop_front_action(cut_update_index::queue_t::MAYBE_COLLAPSE);
+        cut_update_index::action maybe_collapse_action = index_->front_action(cut_update_index::queue_t::MAYBE_COLLAPSE, model_id);
+        index_->pop_front_action(cut_update_index::queue_t::MAYBE_COLLAPSE, model_id);
         index_->reject_action(maybe_collapse_action);
     }
 
     // approve all keep-actions
-    while(index_->num_actions(cut_update_index::queue_t::KEEP) > 0)
+    while(index_->num_actions(cut_update_index::queue_t::KEEP, model_id) > 0)
     {
-        cut_update_index::action keep_action = index_->front_action(cut_update_index::queue_t::KEEP);
-        index_->pop_front_action(cut_update_index::queue_t::KEEP);
+        cut_update_index::action keep_action = index_->front_action(cut_update_index::queue_t::KEEP, model_id);
+        index_->pop_front_action(cut_update_index::queue_t::KEEP, model_id);
         index_->approve_action(keep_action);
     }
-
-    assert(index_->num_actions(cut_update_index::queue_t::KEEP) == 0);
-    assert(index_->num_actions(cut_update_index::queue_t::MUST_SPLIT) == 0);
-    assert(index_->num_actions(cut_update_index::queue_t::MUST_COLLAPSE) == 0);
-    assert(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED) == 0);
-    assert(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE) == 0);
-
-    compile_render_list();
-    compile_transfer_list();
-
-    master_semaphore_.signal(1);
 }
 
 void cut_update_pool::compile_render_list()
@@ -1079,7 +1355,7 @@ void cut_update_pool::compile_render_list()
         {
             std::vector<cut::node_slot_aggregate> model_render_lists;
 
-            const std::set<node_t> &current_cut = index_->get_current_cut(view_id, model_id);
+            const std::vector<node_t> &current_cut = index_->get_current_cut(view_id, model_id);
 
             for(const auto &node_id : current_cut)
             {
@@ -1109,7 +1385,7 @@ void cut_update_pool::prefetch_routine()
             continue;
         }
 
-        float max_error_threshold = model_thresholds_[model_id] + 0.1f;
+        float max_error_threshold = model_thresholds_[action.model_id_] + 0.1f;
 
         if(action.error_ > max_error_threshold * LAMURE_CUT_UPDATE_PREFETCH_FACTOR)
         {
@@ -1180,6 +1456,216 @@ void cut_update_pool::prefetch_routine()
 }
 #endif
 
+void cut_update_pool::record_camera_history()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    for(const auto &camera_it : user_cameras_)
+    {
+        std::deque<camera_sample> &history = camera_history_[camera_it.first];
+        const scm::math::mat4f view_matrix = camera_it.second.get_view_matrix();
+
+        if(!history.empty())
+        {
+            // repeated updates within a frame see the same camera and must not
+            // flatten the motion, a camera at rest is sampled at a low rate
+            const bool moved = 0 != std::memcmp(view_matrix.data_array, history.back().view_matrix_.data_array, sizeof(view_matrix.data_array));
+            const double elapsed_ms = std::chrono::duration<double, std::milli>(now - history.back().time_).count();
+            if(!moved && elapsed_ms < LAMURE_CUT_UPDATE_PREDICTION_REST_INTERVAL_MS)
+            {
+                continue;
+            }
+        }
+
+        history.push_back(camera_sample{now, view_matrix});
+        while(history.size() > LAMURE_CUT_UPDATE_PREDICTION_HISTORY)
+        {
+            history.pop_front();
+        }
+    }
+}
+
+const bool cut_update_pool::predict_view_matrix(const view_t view_id, const double lookahead_ms, scm::math::mat4f &predicted_view_matrix)
+{
+    const auto history_it = camera_history_.find(view_id);
+    if(history_it == camera_history_.end() || history_it->second.size() < 2)
+    {
+        return false;
+    }
+
+    const std::deque<camera_sample> &history = history_it->second;
+    const double span_ms = std::chrono::duration<double, std::milli>(history.back().time_ - history.front().time_).count();
+    if(span_ms <= 0.0)
+    {
+        return false;
+    }
+
+    // extrapolate position and orientation of the camera with the mean
+    // velocity over the recorded samples
+    const float t = float(lookahead_ms / span_ms);
+
+    const scm::math::mat4f first_camera = scm::math::inverse(history.front().view_matrix_);
+    const scm::math::mat4f last_camera = scm::math::inverse(history.back().view_matrix_);
+
+    const scm::math::vec3f first_position(first_camera[12], first_camera[13], first_camera[14]);
+    const scm::math::vec3f last_position(last_camera[12], last_camera[13], last_camera[14]);
+    const scm::math::vec3f predicted_position = last_position + (last_position - first_position) * t;
+
+    const scm::math::quatf first_rotation = scm::math::quatf::from_matrix(first_camera);
+    const scm::math::quatf last_rotation = scm::math::quatf::from_matrix(last_camera);
+    scm::math::quatf rotation = scm::math::normalize(last_rotation * scm::math::conjugate(first_rotation));
+
+    // take the short way around
+    if(rotation.w < 0.f)
+    {
+        rotation = scm::math::quatf(-rotation.w, -rotation.i, -rotation.j, -rotation.k);
+    }
+
+    scm::math::quatf predicted_rotation = last_rotation;
+    if(rotation.w < 0.999999f)
+    {
+        float angle = 0.f;
+        scm::math::vec3f axis(1.f, 0.f, 0.f);
+        rotation.retrieve_axis_angle(angle, axis);
+        predicted_rotation = scm::math::normalize(scm::math::quatf::from_axis(angle * t, axis) * last_rotation);
+    }
+
+    scm::math::mat4f predicted_camera = predicted_rotation.to_matrix();
+    predicted_camera[12] = predicted_position.x;
+    predicted_camera[13] = predicted_position.y;
+    predicted_camera[14] = predicted_position.z;
+
+    predicted_view_matrix = scm::math::inverse(predicted_camera);
+    return true;
+}
+
+void cut_update_pool::predictive_prefetch_routine()
+{
+    ooc_cache *ooc_cache = ooc_cache::get_instance(_data_provenance);
+    model_database *database = model_database::get_instance();
+    const auto now = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(prediction_mutex_);
+        for(auto it = predicted_nodes_.begin(); it != predicted_nodes_.end();)
+        {
+            if(std::chrono::duration<double, std::milli>(now - it->second).count() > LAMURE_CUT_UPDATE_PREDICTION_EXPIRY_MS)
+            {
+                ++prefetch_statistics_.num_prefetch_expired_;
+                it = predicted_nodes_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    uint32_t num_prefetched = 0;
+
+    // walk the cut of the predicted views downwards from the resident nodes
+    // and request the children of nodes that would be split, nearer
+    // predictions at higher priorities. all prefetches rank below the
+    // requests of the cut update, which are queued at their error
+    for(uint32_t step = 1; step <= LAMURE_CUT_UPDATE_PREDICTION_STEPS; ++step)
+    {
+        const double lookahead_ms = LAMURE_CUT_UPDATE_PREDICTION_LOOKAHEAD_MS * step / LAMURE_CUT_UPDATE_PREDICTION_STEPS;
+        const int32_t priority = -(int32_t)step;
+
+        for(const auto &camera_it : user_cameras_)
+        {
+            const view_t view_id = camera_it.first;
+
+            scm::math::mat4f predicted_view_matrix;
+            if(!predict_view_matrix(view_id, lookahead_ms, predicted_view_matrix))
+            {
+                continue;
+            }
+
+            for(model_t model_id = 0; model_id < index_->num_models(); ++model_id)
+            {
+                const auto bvh = database->get_model(model_id)->get_bvh();
+                const scm::gl::frustum frustum(camera_it.second.get_projection_matrix() * predicted_view_matrix * model_transforms_[model_id]);
+                const float max_error_threshold = model_thresholds_[model_id] + 0.1f;
+
+                std::queue<node_t> node_ids;
+                node_ids.push(0);
+
+                while(!node_ids.empty())
+                {
+                    // keep room for the loads the next cut updates ask for
+                    if(num_prefetched >= LAMURE_CUT_UPDATE_PREDICTION_BUDGET || ooc_cache->num_free_slots() <= ooc_cache->num_slots() / 4)
+                    {
+                        return;
+                    }
+
+                    const node_t node_id = node_ids.front();
+                    node_ids.pop();
+
+                    if(!ooc_cache->is_node_resident(model_id, node_id) || !is_node_in_frustum(view_id, model_id, node_id, frustum))
+                    {
+                        continue;
+                    }
+
+                    // see split_node
+                    if(bvh->get_depth_of_node(node_id) >= bvh->get_depth() - 1)
+                    {
+                        continue;
+                    }
+
+                    if(calculate_node_error(view_id, model_id, node_id, predicted_view_matrix) <= max_error_threshold)
+                    {
+                        continue;
+                    }
+
+                    std::vector<node_t> child_ids;
+                    index_->get_all_children(model_id, node_id, child_ids);
+
+                    for(const auto &child_id : child_ids)
+                    {
+                        if(child_id == invalid_node_t)
+                        {
+                            continue;
+                        }
+
+                        if(ooc_cache->is_node_resident(model_id, child_id))
+                        {
+                            node_ids.push(child_id);
+                        }
+                        else if(ooc_cache->register_node(model_id, child_id, priority, false))
+                        {
+                            ++num_prefetched;
+
+                            std::lock_guard<std::mutex> lock(prediction_mutex_);
+                            predicted_nodes_[(uint64_t(model_id) << 32) | uint64_t(child_id)] = now;
+                            ++prefetch_statistics_.num_prefetched_;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void cut_update_pool::count_prefetch_hits(const model_t model_id, const std::vector<node_t> &node_ids)
+{
+    std::lock_guard<std::mutex> lock(prediction_mutex_);
+
+    for(const auto &node_id : node_ids)
+    {
+        if(predicted_nodes_.erase((uint64_t(model_id) << 32) | uint64_t(node_id)) > 0)
+        {
+            ++prefetch_statistics_.num_prefetch_hits_;
+        }
+    }
+}
+
+void cut_update_pool::count_demand_load()
+{
+    std::lock_guard<std::mutex> lock(prediction_mutex_);
+    ++prefetch_statistics_.num_demand_loads_;
+}
+
 void cut_update_pool::compile_transfer_list()
 {
     model_database *database = model_database::get_instance();
@@ -1217,12 +1703,82 @@ void cut_update_pool::compile_transfer_list()
     gpu_cache_->set_transfer_slots_written(slot_count);
 }
 
+const bool cut_update_pool::aquire_children(const cut_update_index::action &action, const std::vector<node_t> &child_ids)
+{
+    // expects one gpu and one ooc slot per child to be drawn from the model budget,
+    // slots that are not used up are given back
+    ooc_cache *ooc_cache = ooc_cache::get_instance(_data_provenance);
+    slot_budget &budget = model_budgets_[action.model_id_];
+
+    int64_t num_gpu_slots_used = 0;
+    int64_t num_ooc_slots_used = 0;
+    bool all_children_aquired = true;
+
+    for(const auto &child_id : child_ids)
+    {
+        if(gpu_cache_->aquire_node(context_id_, action.view_id_, action.model_id_, child_id))
+        {
+            ++num_gpu_slots_used;
+        }
+        else if(!gpu_cache_->is_node_resident(action.model_id_, child_id))
+        {
+            all_children_aquired = false;
+        }
+
+        if(ooc_cache->aquire_node(context_id_, action.view_id_, action.model_id_, child_id))
+        {
+            ++num_ooc_slots_used;
+        }
+        else if(!ooc_cache->is_node_resident(action.model_id_, child_id))
+        {
+            all_children_aquired = false;
+        }
+    }
+
+    if(!all_children_aquired)
+    {
+        // a child was evicted before it could be aquired, undo the others
+        for(const auto &child_id : child_ids)
+        {
+            if(gpu_cache_->release_node_invalidate(context_id_, action.view_id_, action.model_id_, child_id))
+            {
+                --num_gpu_slots_used;
+            }
+
+            if(gpu_cache_->remove_from_transfer_list(action.model_id_, child_id))
+            {
+                ++budget.transfer_slots_;
+            }
+
+            if(ooc_cache->release_node(context_id_, action.view_id_, action.model_id_, child_id))
+            {
+                --num_ooc_slots_used;
+            }
+        }
+    }
+
+    budget.gpu_slots_ += (int64_t)child_ids.size() - num_gpu_slots_used;
+    budget.ooc_slots_ += (int64_t)child_ids.size() - num_ooc_slots_used;
+
+    if(all_children_aquired && predictive_prefetching_)
+    {
+        count_prefetch_hits(action.model_id_, child_ids);
+    }
+
+    return all_children_aquired;
+}
+
 void cut_update_pool::split_node(const cut_update_index::action &action)
 {
+    // expects fan_factor gpu slots to be drawn from the model budget
+    slot_budget &budget = model_budgets_[action.model_id_];
+    const int64_t fan_factor = index_->fan_factor(action.model_id_);
+
     // hack: split until depth-1
     const auto bvh = model_database::get_instance()->get_model(action.model_id_)->get_bvh();
     if(bvh->get_depth_of_node(action.node_id_) >= bvh->get_depth() - 1)
     {
+        budget.gpu_slots_ += fan_factor;
         index_->reject_action(action);
         return;
     }
@@ -1233,31 +1789,32 @@ void cut_update_pool::split_node(const cut_update_index::action &action)
     // return if children are invalid node ids
     if(child_ids[0] == invalid_node_t || action.node_id_ == invalid_node_t)
     {
+        budget.gpu_slots_ += fan_factor;
         index_->reject_action(action);
         return;
     }
 
-    size_t fan_factor = index_->fan_factor(action.model_id_);
-
     assert(child_ids[0] < index_->num_nodes(action.model_id_));
 
     bool all_children_available = true;
 
     ooc_cache *ooc_cache = ooc_cache::get_instance(_data_provenance);
-    bool all_children_fit_in_ooc_cache = ooc_cache->num_free_slots() >= fan_factor;
-    bool all_children_fit_in_gpu_cache = gpu_cache_->transfer_budget() >= fan_factor && gpu_cache_->num_free_slots() >= fan_factor;
 
     // try to obtain children
     for(const auto &child_id : child_ids)
     {
         if(!ooc_cache->is_node_resident(action.model_id_, child_id))
         {
-            if(all_children_fit_in_ooc_cache)
+            // load child from harddisk
+            if(draw_slots(budget.ooc_slots_, shared_ooc_slots_, 1))
             {
-                // load child from harddisk
-                if(ooc_cache->num_free_slots() > 0)
+                if(!ooc_cache->register_node(action.model_id_, child_id, (int32_t)action.error_))
                 {
-                    ooc_cache->register_node(action.model_id_, child_id, (int32_t)action.error_);
+                    ++budget.ooc_slots_;
+                }
+                else if(predictive_prefetching_)
+                {
+                    count_demand_load();
                 }
             }
             all_children_available = false;
@@ -1266,6 +1823,9 @@ void cut_update_pool::split_node(const cut_update_index::action &action)
 
     if(all_children_available)
     {
+        const bool all_children_fit_in_gpu_cache = draw_slots(budget.transfer_slots_, shared_transfer_slots_, fan_factor);
+        int64_t num_transfer_slots_used = 0;
+
         for(const auto &child_id : child_ids)
         {
             if(!gpu_cache_->is_node_resident(action.model_id_, child_id))
@@ -1273,18 +1833,13 @@ void cut_update_pool::split_node(const cut_update_index::action &action)
                 if(all_children_fit_in_gpu_cache)
                 {
                     // transfer child to gpu
-                    if(gpu_cache_->transfer_budget() > 0 && gpu_cache_->num_free_slots() > 0)
+                    if(gpu_cache_->register_node(action.model_id_, child_id))
                     {
-                        if(gpu_cache_->register_node(action.model_id_, child_id))
-                        {
+                        ++num_transfer_slots_used;
 #ifdef LAMURE_CUT_UPDATE_ENABLE_PREFETCHING
-                            pending_prefetch_set_.push_back(action);
+                        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+                        pending_prefetch_set_.push_back(action);
 #endif
-                        }
-                    }
-                    else
-                    {
-                        all_children_available = false;
                     }
                 }
                 else
@@ -1293,26 +1848,32 @@ void cut_update_pool::split_node(const cut_update_index::action &action)
                 }
             }
         }
-    }
 
-    if(all_children_available)
-    {
-        for(const auto &child_id : child_ids)
+        if(all_children_fit_in_gpu_cache)
         {
-            gpu_cache_->aquire_node(context_id_, action.view_id_, action.model_id_, child_id);
-            ooc_cache->aquire_node(context_id_, action.view_id_, action.model_id_, child_id);
+            budget.transfer_slots_ += fan_factor - num_transfer_slots_used;
         }
+    }
 
+    // the children have to be aquired in the ooc cache as well
+    if(all_children_available && draw_slots(budget.ooc_slots_, shared_ooc_slots_, fan_factor))
+    {
+        if(aquire_children(action, child_ids))
+        {
 #ifdef LAMURE_CUT_UPDATE_ENABLE_SPLIT_AGAIN_MODE
-        cut_update_split_again(action);
+            cut_update_split_again(action);
 #else
-        index_->approve_action(action);
+            index_->approve_action(action);
 #endif
+            return;
+        }
     }
     else
     {
-        index_->reject_action(action);
+        budget.gpu_slots_ += fan_factor;
     }
+
+    index_->reject_action(action);
 }
 
 void cut_update_pool::collapse_node(const cut_update_index::action &action)
@@ -1328,17 +1889,26 @@ void cut_update_pool::collapse_node(const cut_update_index::action &action)
     index_->get_all_children(action.model_id_, action.node_id_, child_ids);
 
     ooc_cache *ooc_cache = ooc_cache::get_instance(_data_provenance);
+    slot_budget &budget = model_budgets_[action.model_id_];
 
+    // the released slots can be used by further splits of the same model
     for(const auto &child_id : child_ids)
     {
-        gpu_cache_->release_node(context_id_, action.view_id_, action.model_id_, child_id);
-        ooc_cache->release_node(context_id_, action.view_id_, action.model_id_, child_id);
+        if(gpu_cache_->release_node(context_id_, action.view_id_, action.model_id_, child_id))
+        {
+            ++budget.gpu_slots_;
+        }
+
+        if(ooc_cache->release_node(context_id_, action.view_id_, action.model_id_, child_id))
+        {
+            ++budget.ooc_slots_;
+        }
     }
 
     index_->approve_action(action);
 }
 
-const bool cut_update_pool::is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::set<node_t> &cut)
+const bool cut_update_pool::is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::vector<node_t> &cut)
 {
     for(node_t i = 0; i < node_ids.size(); ++i)
     {
@@ -1350,7 +1920,7 @@ const bool cut_update_pool::is_all_nodes_in_cut(const model_t model_id, const st
         if(node_id == invalid_node_t)
             return false;
 
-        if(cut.find(node_id) == cut.end())
+        if(!std::binary_search(cut.begin(), cut.end(), node_id))
             return false;
     }
 
@@ -1382,12 +1952,16 @@ const bool cut_update_pool::is_no_node_in_frustum(const view_t view_id, const mo
 }
 
 const float cut_update_pool::calculate_node_error(const view_t view_id, const model_t model_id, const node_t node_id)
+{
+    return calculate_node_error(view_id, model_id, node_id, user_cameras_[view_id].get_view_matrix());
+}
+
+const float cut_update_pool::calculate_node_error(const view_t view_id, const model_t model_id, const node_t node_id, const scm::math::mat4f &view_matrix)
 {
     model_database *database = model_database::get_instance();
     auto bvh = database->get_model(model_id)->get_bvh();
 
     const scm::math::mat4f &model_matrix = model_transforms_[model_id];
-    const scm::math::mat4f &view_matrix = user_cameras_[view_id].get_view_matrix();
 
     float radius_scaling = scm::math::length(model_matrix * scm::math::vec4f(1.0f, 0.f, 0.f, 0.f));
     float representative_radius = bvh->get_avg_primitive_extent(node_id) * radius_scaling;
@@ -37,8 +37,8 @@ register_node(const model_t model_id, const node_t node_id) {
         return false;
     }
 
-    if (transfer_budget_ > 0) {
-        --transfer_budget_;
+    node_t transfer_budget = transfer_budget_.load();
+    while (transfer_budget > 0 && !transfer_budget_.compare_exchange_weak(transfer_budget, transfer_budget - 1)) {
     }
 
     node_t least_recently_used_slot = index_->reserve_slot();
@@ -51,12 +51,15 @@ register_node(const model_t model_id, const node_t node_id) {
 }
 
 
-void gpu_cache::
+const bool gpu_cache::
 remove_from_transfer_list(const model_t model_id, const node_t node_id) {
     if (transfer_list_[model_id].find(node_id) != transfer_list_[model_id].end()) {
         transfer_list_[model_id].erase(node_id);
         ++transfer_budget_;
+        return true;
     }
+
+    return false;
 }
 
 
@@ -0,0 +1,402 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LAMURE_OOC_ENABLE_IO_URING
+#endif
+#endif
+
+#ifdef LAMURE_OOC_ENABLE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <lamure/ren/ooc_async_io.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace lamure
+{
+namespace ren
+{
+ooc_async_io::ooc_async_io(const uint32_t queue_depth, const uint32_t num_fallback_threads)
+    : queue_depth_(queue_depth), num_unsubmitted_(0), ring_fd_(-1), sq_ring_(nullptr), cq_ring_(nullptr), sqes_(nullptr), sq_ring_size_(0), cq_ring_size_(0), sqes_size_(0),
+      sq_head_(nullptr), sq_tail_(nullptr), sq_mask_(nullptr), sq_array_(nullptr), cq_head_(nullptr), cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr), iovecs_(nullptr),
+      shutdown_(false)
+{
+    assert(queue_depth_ > 0);
+
+    requests_.resize(queue_depth_);
+    free_requests_.reserve(queue_depth_);
+    for(uint32_t i = queue_depth_; i-- > 0;)
+    {
+        free_requests_.push_back(i);
+    }
+
+    if(!setup_ring())
+    {
+        const uint32_t num_threads = std::max(num_fallback_threads, 1u);
+#ifdef LAMURE_ENABLE_INFO
+        std::cout << "lamure: ooc async io falls back to " << num_threads << " reader threads" << std::endl;
+#endif
+        for(uint32_t i = 0; i < num_threads; ++i)
+        {
+            threads_.push_back(std::thread(&ooc_async_io::run_fallback, this));
+        }
+    }
+}
+
+ooc_async_io::~ooc_async_io()
+{
+    // slot memory is owned by the caller, finish all outstanding reads first
+    std::vector<uint64_t> tags;
+    flush();
+    while(num_in_flight() > 0)
+    {
+        reap(tags, 1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    submitted_signal_.notify_all();
+    for(auto &thread : threads_)
+    {
+        thread.join();
+    }
+    threads_.clear();
+
+    release_ring();
+}
+
+bool ooc_async_io::submit(const ooc_file &file, char *const data, const size_t start_in_file, const size_t length_in_bytes, const uint64_t tag)
+{
+    assert(file.is_file_open());
+    assert(length_in_bytes > 0);
+
+    if(free_requests_.empty())
+    {
+        return false;
+    }
+
+    uint32_t request_id = free_requests_.back();
+    free_requests_.pop_back();
+
+    request &req = requests_[request_id];
+    req.file_ = &file;
+    req.data_ = data;
+    req.offset_ = start_in_file;
+    req.length_ = length_in_bytes;
+    req.done_ = 0;
+    req.tag_ = tag;
+
+    queued_requests_.push_back(request_id);
+    return true;
+}
+
+void ooc_async_io::flush()
+{
+    if(queued_requests_.empty())
+    {
+        return;
+    }
+
+    if(is_kernel_backed())
+    {
+        for(const auto request_id : queued_requests_)
+        {
+            push_sqe(request_id);
+        }
+        enter(0);
+    }
+    else
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            submitted_.insert(submitted_.end(), queued_requests_.begin(), queued_requests_.end());
+        }
+        submitted_signal_.notify_all();
+    }
+
+    queued_requests_.clear();
+}
+
+void ooc_async_io::reap(std::vector<uint64_t> &tags, const uint32_t min_completions)
+{
+    assert(min_completions <= num_in_flight());
+
+    if(is_kernel_backed())
+    {
+        size_t num_completed = tags.size();
+        reap_ring(tags);
+        while(tags.size() - num_completed < min_completions)
+        {
+            enter(1);
+            reap_ring(tags);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    completed_signal_.wait(lock, [&] { return completed_.size() >= min_completions; });
+    for(const auto request_id : completed_)
+    {
+        tags.push_back(requests_[request_id].tag_);
+        free_requests_.push_back(request_id);
+    }
+    completed_.clear();
+}
+
+void ooc_async_io::run_fallback()
+{
+    while(true)
+    {
+        uint32_t request_id;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            submitted_signal_.wait(lock, [&] { return shutdown_ || !submitted_.empty(); });
+            if(submitted_.empty())
+            {
+                return;
+            }
+            request_id = submitted_.front();
+            submitted_.pop_front();
+        }
+
+        request &req = requests_[request_id];
+        req.file_->read(req.data_, req.offset_, req.length_);
+        req.done_ = req.length_;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completed_.push_back(request_id);
+        }
+        completed_signal_.notify_one();
+    }
+}
+
+#ifdef LAMURE_OOC_ENABLE_IO_URING
+
+bool ooc_async_io::setup_ring()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, queue_depth_, &params);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(single_mmap)
+    {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(sq_ring_ == MAP_FAILED)
+    {
+        sq_ring_ = nullptr;
+        close(fd);
+        return false;
+    }
+
+    if(single_mmap)
+    {
+        cq_ring_ = sq_ring_;
+    }
+    else
+    {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if(cq_ring_ == MAP_FAILED)
+        {
+            cq_ring_ = nullptr;
+            munmap(sq_ring_, sq_ring_size_);
+            sq_ring_ = nullptr;
+            close(fd);
+            return false;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(sqes_ == MAP_FAILED)
+    {
+        sqes_ = nullptr;
+        ring_fd_ = fd;
+        release_ring();
+        return false;
+    }
+
+    char *sq = (char *)sq_ring_;
+    char *cq = (char *)cq_ring_;
+    sq_head_ = (uint32_t *)(sq + params.sq_off.head);
+    sq_tail_ = (uint32_t *)(sq + params.sq_off.tail);
+    sq_mask_ = (uint32_t *)(sq + params.sq_off.ring_mask);
+    sq_array_ = (uint32_t *)(sq + params.sq_off.array);
+    cq_head_ = (uint32_t *)(cq + params.cq_off.head);
+    cq_tail_ = (uint32_t *)(cq + params.cq_off.tail);
+    cq_mask_ = (uint32_t *)(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+
+    iovecs_ = new iovec[queue_depth_];
+    ring_fd_ = fd;
+
+#ifdef LAMURE_ENABLE_INFO
+    std::cout << "lamure: ooc async io uses io_uring (queue depth " << queue_depth_ << ")" << std::endl;
+#endif
+    return true;
+}
+
+void ooc_async_io::release_ring()
+{
+    if(sqes_ != nullptr)
+    {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if(cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+    {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if(sq_ring_ != nullptr)
+    {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if(ring_fd_ >= 0)
+    {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    if(iovecs_ != nullptr)
+    {
+        delete[] iovecs_;
+        iovecs_ = nullptr;
+    }
+}
+
+bool ooc_async_io::push_sqe(const uint32_t request_id)
+{
+    request &req = requests_[request_id];
+
+    // the ring has as many entries as there are requests, it never overflows
+    const uint32_t tail = *sq_tail_;
+    const uint32_t index = tail & *sq_mask_;
+
+    iovec &iov = iovecs_[request_id];
+    iov.iov_base = req.data_ + req.done_;
+    iov.iov_len = req.length_ - req.done_;
+
+    io_uring_sqe *sqe = (io_uring_sqe *)sqes_ + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = req.file_->native_handle();
+    sqe->off = req.offset_ + req.done_;
+    sqe->addr = (uint64_t)(uintptr_t)&iov;
+    sqe->len = 1;
+    sqe->user_data = request_id;
+
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++num_unsubmitted_;
+    return true;
+}
+
+void ooc_async_io::enter(const uint32_t min_completions)
+{
+    uint32_t flags = min_completions > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while(true)
+    {
+        int result = (int)syscall(__NR_io_uring_enter, ring_fd_, num_unsubmitted_, min_completions, flags, nullptr, 0);
+        if(result < 0)
+        {
+            if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+            {
+                continue;
+            }
+            throw std::runtime_error(std::string("lamure: ooc_async_io::io_uring_enter failed: ") + strerror(errno));
+        }
+        num_unsubmitted_ -= std::min((uint32_t)result, num_unsubmitted_);
+        if(num_unsubmitted_ == 0)
+        {
+            break;
+        }
+    }
+}
+
+void ooc_async_io::reap_ring(std::vector<uint64_t> &tags)
+{
+    uint32_t head = *cq_head_;
+    const uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    bool resubmit = false;
+
+    while(head != tail)
+    {
+        const io_uring_cqe &cqe = ((io_uring_cqe *)cqes_)[head & *cq_mask_];
+        const uint32_t request_id = (uint32_t)cqe.user_data;
+        request &req = requests_[request_id];
+        ++head;
+
+        if(cqe.res == -EINTR || cqe.res == -EAGAIN)
+        {
+            push_sqe(request_id);
+            resubmit = true;
+            continue;
+        }
+        if(cqe.res <= 0)
+        {
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            throw std::runtime_error("lamure: ooc_async_io::Unable to read file: " + req.file_->file_name());
+        }
+
+        req.done_ += (size_t)cqe.res;
+        if(req.done_ < req.length_)
+        {
+            // short read, request the remainder
+            push_sqe(request_id);
+            resubmit = true;
+            continue;
+        }
+
+        tags.push_back(req.tag_);
+        free_requests_.push_back(request_id);
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+    if(resubmit)
+    {
+        enter(0);
+    }
+}
+
+#else
+
+bool ooc_async_io::setup_ring() { return false; }
+void ooc_async_io::release_ring() {}
+bool ooc_async_io::push_sqe(const uint32_t) { return false; }
+void ooc_async_io::enter(const uint32_t) {}
+void ooc_async_io::reap_ring(std::vector<uint64_t> &) {}
+
+#endif
+
+}
+} // namespace lamure
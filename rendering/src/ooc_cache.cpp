@@ -28,7 +28,12 @@ ooc_cache::ooc_cache(const slot_t num_slots, Data_Provenance const &data_provena
 
     cache_data_ = new char[num_slots * database->get_slot_size()];
     cache_data_provenance_ = new char[num_slots * slot_size_provenance];
-    pool_ = new ooc_pool(LAMURE_CUT_UPDATE_NUM_LOADING_THREADS, database->get_slot_size(), slot_size_provenance, data_provenance);
+    pool_ = new ooc_pool(policy::get_instance()->num_loading_threads(), database->get_slot_size(), slot_size_provenance, data_provenance);
+
+    if(!policy::get_instance()->cache_trace_file().empty())
+    {
+        index_->start_trace(policy::get_instance()->cache_trace_file());
+    }
 
 #ifdef LAMURE_ENABLE_INFO
     std::cout << "lamure: ooc-cache init (WITH PROVENANCE)" << std::endl;
@@ -40,7 +45,12 @@ ooc_cache::ooc_cache(const slot_t num_slots) : cache(num_slots), maintenance_cou
     model_database *database = model_database::get_instance();
 
     cache_data_ = new char[num_slots * database->get_slot_size()];
-    pool_ = new ooc_pool(LAMURE_CUT_UPDATE_NUM_LOADING_THREADS, database->get_slot_size());
+    pool_ = new ooc_pool(policy::get_instance()->num_loading_threads(), database->get_slot_size());
+
+    if(!policy::get_instance()->cache_trace_file().empty())
+    {
+        index_->start_trace(policy::get_instance()->cache_trace_file());
+    }
 
 #ifdef LAMURE_ENABLE_INFO
     std::cout << "lamure: ooc-cache init (WITHOUT PROVENANCE)" << std::endl;
@@ -206,11 +216,11 @@ ooc_cache *ooc_cache::get_instance()
     }
 }
 
-void ooc_cache::register_node(const model_t model_id, const node_t node_id, const int32_t priority)
+const bool ooc_cache::register_node(const model_t model_id, const node_t node_id, const int32_t priority, const bool update_priority)
 {
     if(is_node_resident(model_id, node_id))
     {
-        return;
+        return false;
     }
 
     cache_queue::query_result query_result = pool_->acknowledge_query(model_id, node_id);
@@ -227,12 +237,16 @@ void ooc_cache::register_node(const model_t model_id, const node_t node_id, cons
         if(!pool_->acknowledge_request(job))
         {
             index_->unreserve_slot(slot_id);
+            return false;
         }
-        break;
+        return true;
     }
 
     case cache_queue::query_result::INDEXED_AS_WAITING:
-        pool_->acknowledge_update(model_id, node_id, priority);
+        if(update_priority)
+        {
+            pool_->acknowledge_update(model_id, node_id, priority);
+        }
         break;
 
     case cache_queue::query_result::INDEXED_AS_LOADING:
@@ -243,6 +257,8 @@ void ooc_cache::register_node(const model_t model_id, const node_t node_id, cons
     default:
         break;
     }
+
+    return false;
 }
 
 char *ooc_cache::node_data(const model_t model_id, const node_t node_id) { return cache_data_ + index_->get_slot(model_id, node_id) * slot_size(); }
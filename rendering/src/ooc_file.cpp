@@ -0,0 +1,185 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifdef WIN32
+#undef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <lamure/ren/ooc_file.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace lamure
+{
+namespace ren
+{
+ooc_file::ooc_file()
+#ifdef WIN32
+    : handle_(INVALID_HANDLE_VALUE), mapping_(nullptr),
+#else
+    : handle_(-1),
+#endif
+      mapped_data_(nullptr), size_(0), is_file_open_(false)
+{
+}
+
+ooc_file::~ooc_file()
+{
+    try
+    {
+        close();
+    }
+    catch(...)
+    {
+    }
+}
+
+void ooc_file::open(const std::string &file_name, const bool memory_mapped)
+{
+    close();
+    file_name_ = file_name;
+
+#ifdef WIN32
+    handle_ = CreateFileA(file_name_.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if(handle_ == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("lamure: ooc_file::Unable to open file: " + file_name_);
+    }
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(handle_, &file_size);
+    size_ = (size_t)file_size.QuadPart;
+
+    if(memory_mapped && size_ > 0)
+    {
+        mapping_ = CreateFileMappingA(handle_, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping_ != nullptr)
+        {
+            mapped_data_ = (char *)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        }
+        if(mapped_data_ == nullptr)
+        {
+            throw std::runtime_error("lamure: ooc_file::Unable to map file: " + file_name_);
+        }
+    }
+#else
+    handle_ = ::open(file_name_.c_str(), O_RDONLY);
+    if(handle_ < 0)
+    {
+        throw std::runtime_error("lamure: ooc_file::Unable to open file: " + file_name_ + " (" + strerror(errno) + ")");
+    }
+
+    struct stat file_stat;
+    fstat(handle_, &file_stat);
+    size_ = (size_t)file_stat.st_size;
+
+    if(memory_mapped && size_ > 0)
+    {
+        void *mapped = mmap(nullptr, size_, PROT_READ, MAP_SHARED, handle_, 0);
+        if(mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("lamure: ooc_file::Unable to map file: " + file_name_ + " (" + strerror(errno) + ")");
+        }
+        madvise(mapped, size_, MADV_RANDOM);
+        mapped_data_ = (char *)mapped;
+    }
+    else
+    {
+        posix_fadvise(handle_, 0, 0, POSIX_FADV_RANDOM);
+    }
+#endif
+
+    is_file_open_ = true;
+}
+
+void ooc_file::close()
+{
+    if(!is_file_open_)
+    {
+        return;
+    }
+
+#ifdef WIN32
+    if(mapped_data_ != nullptr)
+    {
+        UnmapViewOfFile(mapped_data_);
+    }
+    if(mapping_ != nullptr)
+    {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    CloseHandle(handle_);
+    handle_ = INVALID_HANDLE_VALUE;
+#else
+    if(mapped_data_ != nullptr)
+    {
+        munmap(mapped_data_, size_);
+    }
+    ::close(handle_);
+    handle_ = -1;
+#endif
+
+    mapped_data_ = nullptr;
+    size_ = 0;
+    file_name_ = "";
+    is_file_open_ = false;
+}
+
+void ooc_file::read(char *const data, const size_t offset_in_bytes, const size_t length_in_bytes) const
+{
+    assert(length_in_bytes > 0);
+    assert(is_file_open_);
+    assert(data != nullptr);
+
+    if(mapped_data_ != nullptr)
+    {
+        assert(offset_in_bytes + length_in_bytes <= size_);
+        memcpy(data, mapped_data_ + offset_in_bytes, length_in_bytes);
+        return;
+    }
+
+    size_t bytes_read = 0;
+    while(bytes_read < length_in_bytes)
+    {
+#ifdef WIN32
+        const size_t offset = offset_in_bytes + bytes_read;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD chunk = 0;
+        DWORD to_read = (DWORD)std::min<size_t>(length_in_bytes - bytes_read, 0x40000000);
+        if(!ReadFile(handle_, data + bytes_read, to_read, &chunk, &overlapped) || chunk == 0)
+        {
+            throw std::runtime_error("lamure: ooc_file::Unable to read file: " + file_name_);
+        }
+#else
+        ssize_t chunk = pread(handle_, data + bytes_read, length_in_bytes - bytes_read, offset_in_bytes + bytes_read);
+        if(chunk < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(chunk <= 0)
+        {
+            throw std::runtime_error("lamure: ooc_file::Unable to read file: " + file_name_);
+        }
+#endif
+        bytes_read += (size_t)chunk;
+    }
+}
+}
+} // namespace lamure
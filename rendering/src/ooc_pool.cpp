@@ -7,6 +7,8 @@
 
 #include <lamure/ren/ooc_pool.h>
 
+#include <zlib.h>
+
 namespace lamure
 {
 namespace ren
@@ -21,12 +23,15 @@ ooc_pool::ooc_pool(const uint32_t num_threads, const size_t size_of_slot_in_byte
 
     model_database *database = model_database::get_instance();
 
-    priority_queue_.initialize(LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE, database->num_models());
-
-    for(uint32_t i = 0; i < num_threads_; ++i)
+    std::vector<node_t> num_nodes_per_model;
+    for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
     {
-        threads_.push_back(std::thread(&ooc_pool::run, this));
+        num_nodes_per_model.push_back(database->get_model(model_id)->get_bvh()->get_num_nodes());
     }
+    priority_queue_.initialize(LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE, num_nodes_per_model);
+
+    load_node_offsets();
+    start_threads();
 }
 
 ooc_pool::ooc_pool(const uint32_t num_threads, const size_t size_of_slot_in_bytes, const size_t size_of_slot_provenance, Data_Provenance const &data_provenance)
@@ -40,12 +45,15 @@ ooc_pool::ooc_pool(const uint32_t num_threads, const size_t size_of_slot_in_byte
     semaphore_.set_min_signal_count(1);
     semaphore_.set_max_signal_count(std::numeric_limits<size_t>::max());
 
-    priority_queue_.initialize(LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE, database->num_models());
-
-    for(uint32_t i = 0; i < num_threads_; ++i)
+    std::vector<node_t> num_nodes_per_model;
+    for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
     {
-        threads_.push_back(std::thread(&ooc_pool::run, this));
+        num_nodes_per_model.push_back(database->get_model(model_id)->get_bvh()->get_num_nodes());
     }
+    priority_queue_.initialize(LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE, num_nodes_per_model);
+
+    load_node_offsets();
+    start_threads();
 }
 
 ooc_pool::~ooc_pool()
@@ -67,6 +75,29 @@ ooc_pool::~ooc_pool()
     threads_.clear();
 }
 
+void ooc_pool::start_threads()
+{
+    // deflated nodes are inflated by the loader threads themselves
+    bool has_compressed_models = false;
+    for(const auto &offsets : node_offsets_)
+    {
+        has_compressed_models |= !offsets.empty();
+    }
+
+    if(policy::get_instance()->out_of_core_async_io() && !has_compressed_models)
+    {
+        // a single thread drives the asynchronous reads
+        threads_.push_back(std::thread(&ooc_pool::run_async, this));
+    }
+    else
+    {
+        for(uint32_t i = 0; i < num_threads_; ++i)
+        {
+            threads_.push_back(std::thread(&ooc_pool::run, this));
+        }
+    }
+}
+
 bool ooc_pool::is_shutdown()
 {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -97,14 +128,11 @@ void ooc_pool::end_measure()
     std::cout << "megabytes loaded: " << bytes_loaded_ / 1024 / 1024 << std::endl;
 }
 
-void ooc_pool::run()
+void ooc_pool::get_file_names(std::vector<std::string> &lod_file_names, std::vector<std::string> &provenance_file_names)
 {
     model_database *database = model_database::get_instance();
     model_t num_models = database->num_models();
 
-    std::vector<std::string> lod_files;
-    std::vector<std::string> provenance_files;
-
     for (model_t model_id = 0; model_id < num_models; ++model_id) {
         
         std::string bvh_filename = database->get_model(model_id)->get_bvh()->get_filename();        
@@ -115,20 +143,72 @@ void ooc_pool::run()
         std::string provenance_file_name = bvh_filename.substr(0, bvh_filename.size() - 3) + "prov";
 
 
-        lod_files.push_back(lod_file_name);
+        lod_file_names.push_back(lod_file_name);
 
         if(_data_provenance.get_size_in_bytes() > 0)
         {
-            provenance_files.push_back(provenance_file_name);
+            provenance_file_names.push_back(provenance_file_name);
         }
     }
+}
+
+void ooc_pool::load_node_offsets()
+{
+    model_database *database = model_database::get_instance();
+
+    std::vector<std::string> lod_file_names;
+    std::vector<std::string> provenance_file_names;
+    get_file_names(lod_file_names, provenance_file_names);
+
+    node_offsets_.resize(database->num_models());
 
-    char *local_cache = new char[size_of_slot_];
-    
-    char *local_cache_provenance = nullptr;
-    if(_data_provenance.get_size_in_bytes() > 0) {
-      local_cache_provenance = new char[size_of_slot_provenance_];
+    for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
+    {
+        const bvh *model_bvh = database->get_model(model_id)->get_bvh();
+        if(model_bvh->get_node_compression() != bvh::node_compression::DEFLATE)
+        {
+            continue;
+        }
+
+        // the table of num_nodes + 1 offsets is followed by num_nodes
+        ooc_file lod;
+        lod.open(lod_file_names[model_id]);
+
+        uint64_t num_nodes = 0;
+        if(lod.size() >= sizeof(uint64_t))
+        {
+            lod.read((char *)&num_nodes, lod.size() - sizeof(uint64_t), sizeof(uint64_t));
+        }
+
+        const size_t table_size = (num_nodes + 1) * sizeof(uint64_t);
+        if(num_nodes != model_bvh->get_num_nodes() || lod.size() < table_size + sizeof(uint64_t))
+        {
+            throw std::runtime_error("lamure: ooc_pool::Invalid node offset table in: " + lod_file_names[model_id]);
+        }
+
+        std::vector<uint64_t> &offsets = node_offsets_[model_id];
+        offsets.resize(num_nodes + 1);
+        lod.read((char *)offsets.data(), lod.size() - sizeof(uint64_t) - table_size, table_size);
     }
+}
+
+void ooc_pool::run()
+{
+    model_database *database = model_database::get_instance();
+    model_t num_models = database->num_models();
+
+    const bool memory_mapped = policy::get_instance()->out_of_core_memory_mapped();
+    const bool has_provenance = _data_provenance.get_size_in_bytes() > 0;
+
+    std::vector<std::string> lod_file_names;
+    std::vector<std::string> provenance_file_names;
+    get_file_names(lod_file_names, provenance_file_names);
+
+    // file handles are opened on first access and kept open by this thread
+    std::vector<ooc_file> lod_files(num_models);
+    std::vector<ooc_file> provenance_files(has_provenance ? num_models : 0);
+
+    std::vector<char> compressed_node;
 
     while(true)
     {
@@ -142,51 +222,172 @@ void ooc_pool::run()
         if(job.node_id_ != invalid_node_t)
         {
             assert(job.slot_mem_ != nullptr);
-            //assert(job.slot_mem_provenance_ != nullptr);
 
+            // the slot is reserved for this job until the history is resolved,
+            // so the node can be read into it without holding the pool lock
             size_t stride_in_bytes = database->get_node_size(job.model_id_);
             size_t offset_in_bytes = job.node_id_ * stride_in_bytes;
 
-            lod_stream access;
-            access.open(lod_files[job.model_id_]);
-            access.read(local_cache, offset_in_bytes, stride_in_bytes);
-            access.close();
-
-            std::lock_guard<std::mutex> lock(mutex_);
-            bytes_loaded_ += stride_in_bytes;
+            ooc_file &lod = lod_files[job.model_id_];
+            if(!lod.is_file_open())
+            {
+                lod.open(lod_file_names[job.model_id_], memory_mapped);
+            }
 
-            memcpy(job.slot_mem_, local_cache, stride_in_bytes);
+            size_t bytes_read = stride_in_bytes;
+            const std::vector<uint64_t> &node_offsets = node_offsets_[job.model_id_];
+            if(node_offsets.empty())
+            {
+                lod.read(job.slot_mem_, offset_in_bytes, stride_in_bytes);
+            }
+            else
+            {
+                bytes_read = node_offsets[job.node_id_ + 1] - node_offsets[job.node_id_];
+                compressed_node.resize(bytes_read);
+                lod.read(compressed_node.data(), node_offsets[job.node_id_], bytes_read);
+
+                uLongf node_size = stride_in_bytes;
+                if(uncompress((Bytef *)job.slot_mem_, &node_size, (const Bytef *)compressed_node.data(), (uLong)bytes_read) != Z_OK || node_size != stride_in_bytes)
+                {
+                    throw std::runtime_error("lamure: ooc_pool::Unable to inflate node " + std::to_string(job.node_id_) + " of: " + lod_file_names[job.model_id_]);
+                }
+            }
 
-            history_.push_back(job);
+            size_t stride_in_bytes_provenance = 0;
+            if(has_provenance)
+            {
+                assert(job.slot_mem_provenance_ != nullptr);
 
-            if(_data_provenance.get_size_in_bytes() > 0) {
-                provenance_stream access_provenance;
-                access_provenance.open(provenance_files[job.model_id_]);
-                size_t stride_in_bytes_provenance = database->get_primitives_per_node(job.model_id_) * _data_provenance.get_size_in_bytes();
-                bytes_loaded_ += stride_in_bytes_provenance;
+                stride_in_bytes_provenance = database->get_primitives_per_node(job.model_id_) * _data_provenance.get_size_in_bytes();
                 size_t offset_in_bytes_provenance = job.node_id_ * stride_in_bytes_provenance;
-                access_provenance.read(local_cache_provenance, offset_in_bytes_provenance, stride_in_bytes_provenance);
-                access_provenance.close();
-                memcpy(job.slot_mem_provenance_, local_cache_provenance, stride_in_bytes_provenance);
+
+                ooc_file &provenance = provenance_files[job.model_id_];
+                if(!provenance.is_file_open())
+                {
+                    provenance.open(provenance_file_names[job.model_id_], memory_mapped);
+                }
+                provenance.read(job.slot_mem_provenance_, offset_in_bytes_provenance, stride_in_bytes_provenance);
             }
 
+            std::lock_guard<std::mutex> lock(mutex_);
+            bytes_loaded_ += bytes_read + stride_in_bytes_provenance;
+            history_.push_back(job);
         }
     }
+}
+
+void ooc_pool::run_async()
+{
+    model_database *database = model_database::get_instance();
+    model_t num_models = database->num_models();
+
+    const bool has_provenance = _data_provenance.get_size_in_bytes() > 0;
+    const uint32_t reads_per_job = has_provenance ? 2 : 1;
 
-    
-    lod_files.clear();
-    provenance_files.clear();
+    std::vector<std::string> lod_file_names;
+    std::vector<std::string> provenance_file_names;
+    get_file_names(lod_file_names, provenance_file_names);
 
+    std::vector<ooc_file> lod_files(num_models);
+    std::vector<ooc_file> provenance_files(has_provenance ? num_models : 0);
 
-    if(local_cache != nullptr)
+    ooc_async_io io(std::max(policy::get_instance()->out_of_core_io_queue_depth(), reads_per_job), num_threads_);
+
+    // jobs in flight, indexed by the tag of their reads
+    const uint32_t max_jobs_in_flight = io.queue_depth() / reads_per_job;
+    std::vector<cache_queue::job> jobs(max_jobs_in_flight);
+    std::vector<uint32_t> pending_reads(max_jobs_in_flight, 0);
+    std::vector<uint32_t> free_jobs;
+    for(uint32_t i = max_jobs_in_flight; i-- > 0;)
     {
-        delete[] local_cache;
-        local_cache = nullptr;
+        free_jobs.push_back(i);
     }
-    if(local_cache_provenance != nullptr)
+
+    std::vector<cache_queue::job> batch;
+    std::vector<uint64_t> completed;
+    std::vector<cache_queue::job> retired;
+
+    while(true)
     {
-        delete[] local_cache_provenance;
-        local_cache_provenance = nullptr;
+        if(free_jobs.size() == max_jobs_in_flight)
+        {
+            // nothing in flight, sleep until new requests arrive
+            semaphore_.wait();
+        }
+
+        if(is_shutdown())
+            break;
+
+        // drain the request queue in one batch
+        batch.clear();
+        priority_queue_.top_jobs(batch, free_jobs.size());
+
+        for(const auto &job : batch)
+        {
+            assert(job.slot_mem_ != nullptr);
+
+            uint32_t job_id = free_jobs.back();
+            free_jobs.pop_back();
+            jobs[job_id] = job;
+            pending_reads[job_id] = reads_per_job;
+
+            size_t stride_in_bytes = database->get_node_size(job.model_id_);
+            size_t offset_in_bytes = job.node_id_ * stride_in_bytes;
+
+            ooc_file &lod = lod_files[job.model_id_];
+            if(!lod.is_file_open())
+            {
+                lod.open(lod_file_names[job.model_id_]);
+            }
+            io.submit(lod, job.slot_mem_, offset_in_bytes, stride_in_bytes, job_id);
+
+            if(has_provenance)
+            {
+                assert(job.slot_mem_provenance_ != nullptr);
+
+                size_t stride_in_bytes_provenance = database->get_primitives_per_node(job.model_id_) * _data_provenance.get_size_in_bytes();
+                size_t offset_in_bytes_provenance = job.node_id_ * stride_in_bytes_provenance;
+
+                ooc_file &provenance = provenance_files[job.model_id_];
+                if(!provenance.is_file_open())
+                {
+                    provenance.open(provenance_file_names[job.model_id_]);
+                }
+                io.submit(provenance, job.slot_mem_provenance_, offset_in_bytes_provenance, stride_in_bytes_provenance, job_id);
+            }
+        }
+
+        io.flush();
+
+        // block for completions only if no new requests could be taken
+        completed.clear();
+        const bool must_wait = batch.empty() && io.num_in_flight() > 0;
+        io.reap(completed, must_wait ? 1 : 0);
+
+        retired.clear();
+        size_t bytes_loaded = 0;
+        for(const auto tag : completed)
+        {
+            uint32_t job_id = (uint32_t)tag;
+            if(--pending_reads[job_id] == 0)
+            {
+                const cache_queue::job &job = jobs[job_id];
+                bytes_loaded += database->get_node_size(job.model_id_);
+                if(has_provenance)
+                {
+                    bytes_loaded += database->get_primitives_per_node(job.model_id_) * _data_provenance.get_size_in_bytes();
+                }
+                retired.push_back(job);
+                free_jobs.push_back(job_id);
+            }
+        }
+
+        if(!retired.empty())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bytes_loaded_ += bytes_loaded;
+            history_.insert(history_.end(), retired.begin(), retired.end());
+        }
     }
 }
 
@@ -6,6 +6,7 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/ren/policy.h>
+#include <lamure/ren/config.h>
 
 #include <lamure/ren/controller.h>
 
@@ -26,6 +27,14 @@ policy()
   render_budget_in_mb_(LAMURE_DEFAULT_VIDEO_MEMORY_BUDGET),
   out_of_core_budget_in_mb_(LAMURE_DEFAULT_MAIN_MEMORY_BUDGET),
   size_of_provenance_(LAMURE_DEFAULT_SIZE_OF_PROVENANCE), 
+  num_loading_threads_(LAMURE_CUT_UPDATE_NUM_LOADING_THREADS),
+  out_of_core_memory_mapped_(false),
+  out_of_core_async_io_(false),
+  out_of_core_io_queue_depth_(LAMURE_CUT_UPDATE_ASYNC_IO_QUEUE_DEPTH),
+  measure_cut_update_latency_(false),
+  cache_eviction_policy_(LAMURE_CUT_UPDATE_CACHE_EVICTION_POLICY),
+  cache_trace_file_(""),
+  predictive_prefetching_(false),
     window_width_(1920), 
     window_height_(1080)
 {
@@ -6,6 +6,7 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/ren/ray.h>
+#include <lamure/ren/ray_picker.h>
 
 namespace lamure
 {
@@ -63,81 +64,14 @@ const bool ray::intersect(const float aabb_scale, scm::math::vec3f &ray_up_vecto
     }
 
     std::vector<ray::intersection> intersections;
-    std::vector<float> best_errors;
-    for(unsigned int i = 0; i < num_rays; ++i)
-    {
-        intersections.push_back(ray::intersection());
-        best_errors.push_back(std::numeric_limits<float>::max());
-    }
-
-    model_database *database = model_database::get_instance();
-    ooc_cache *ooc_cache = ooc_cache::get_instance();
-
-    ooc_cache->lock();
-    ooc_cache->refresh();
-
-    ray_queue job_queue;
-    for(unsigned int i = 0; i < num_rays; ++i)
-    {
-        job_queue.push_job(ray_queue::ray_job(i, rays[i]));
-    }
-
-    unsigned int num_threads = 16;
+    unsigned int num_rays_hit = (unsigned int)ray_picker::get_instance()->intersect(rays, aabb_scale, max_depth, surfel_skip, false, intersections);
 
-    std::vector<std::thread> threads;
-    for(unsigned int i = 0; i < num_threads; ++i)
-    {
-        threads.push_back(std::thread([&] {
-
-            while(true)
-            {
-                job_queue.wait();
-
-                if(job_queue.is_shutdown())
-                {
-                    break;
-                }
-
-                ray_queue::ray_job job = job_queue.pop_job();
-
-                if(job.id_ >= 0)
-                {
-                    ray &ray = rays[job.id_];
-                    ray::intersection temp;
-                    for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
-                    {
-                        const scm::math::mat4f &model_transform = database->get_model(model_id)->transform();
-                        if(ray.intersect_model_unsafe(model_id, model_transform, aabb_scale, max_depth, surfel_skip, false, temp))
-                        {
-                            if(temp.error_ < best_errors[job.id_])
-                            {
-                                best_errors[job.id_] = temp.error_;
-                                intersections[job.id_] = temp;
-                            }
-                        }
-                    }
-                }
-            }
-
-        }));
-    }
-
-    for(auto &thread : threads)
+    std::vector<float> best_errors;
+    for(const auto &ray_intersection : intersections)
     {
-        thread.join();
+        best_errors.push_back(ray_intersection.error_);
     }
 
-    unsigned int num_rays_hit = 0;
-    for(const auto &error : best_errors)
-    {
-        if(error < std::numeric_limits<float>::max())
-        {
-            ++num_rays_hit;
-        }
-    }
-
-    ooc_cache->unlock();
-
     if(num_rays_hit > num_rays / 4)
     {
         // fit the plane
@@ -842,5 +776,21 @@ const ray_queue::ray_job ray_queue::pop_job()
 
     return job;
 }
+
+void ray_queue::pop_all_jobs(std::vector<ray_queue::ray_job> &jobs)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    jobs.clear();
+    jobs.reserve(queue_.size());
+    while(!queue_.empty())
+    {
+        jobs.push_back(queue_.front());
+        queue_.pop();
+    }
+
+    is_shutdown_ = true;
+    semaphore_.shutdown();
+}
 }
 }
@@ -0,0 +1,603 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/ren/ray_picker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lamure
+{
+namespace ren
+{
+namespace
+{
+const uint32_t packet_size = LAMURE_PICKING_PACKET_SIZE;
+static_assert(packet_size > 0 && packet_size <= 32, "LAMURE_PICKING_PACKET_SIZE must be in [1, 32]");
+
+typedef uint32_t lane_mask;
+
+const float max_intersection_error = 6.f;
+
+// rays of a packet in object space of the current model (o_*) and in
+// world space (w_*), one entry per lane
+struct ray_packet
+{
+    alignas(32) float o_origin_[3][packet_size];
+    alignas(32) float o_direction_[3][packet_size];
+    alignas(32) float o_max_distance_[packet_size];
+    alignas(32) float object_to_world_scale_[packet_size];
+    alignas(32) float w_origin_[3][packet_size];
+    alignas(32) float w_direction_[3][packet_size];
+    alignas(32) float w_max_distance_[packet_size];
+};
+
+// up to packet_size surfels of a node, world positions precomputed
+struct surfel_batch
+{
+    alignas(32) float position_[3][packet_size];
+    alignas(32) float normal_[3][packet_size];
+    alignas(32) float size_[packet_size];
+    alignas(32) float w_position_[3][packet_size];
+    const dataset::serialized_surfel *surfels_[packet_size];
+};
+
+// same operations as ray::intersect_aabb for all lanes, returns the lanes that
+// hit the box and, if check_distance is set, do so within their max distance
+const lane_mask intersect_aabb(const ray_packet &packet, const scm::gl::boxf &bb, const lane_mask active, const bool check_distance)
+{
+    const scm::math::vec3f &min_vertex = bb.min_vertex();
+    const scm::math::vec3f &max_vertex = bb.max_vertex();
+
+    alignas(32) int hit[packet_size];
+
+#pragma omp simd
+    for(uint32_t l = 0; l < packet_size; ++l)
+    {
+        float tmin = -std::numeric_limits<float>::max();
+        float tmax = std::numeric_limits<float>::max();
+        for(uint32_t a = 0; a < 3; ++a)
+        {
+            const float t1 = (min_vertex[a] - packet.o_origin_[a][l]) / packet.o_direction_[a][l];
+            const float t2 = (max_vertex[a] - packet.o_origin_[a][l]) / packet.o_direction_[a][l];
+            const float tmin1 = std::min(t1, t2);
+            const float tmax1 = std::max(t1, t2);
+            tmin = a == 0 ? tmin1 : std::max(tmin, tmin1);
+            tmax = a == 0 ? tmax1 : std::min(tmax, tmax1);
+        }
+        hit[l] = (tmax >= 0.f && tmax >= tmin) && (!check_distance || tmin <= packet.o_max_distance_[l]);
+    }
+
+    lane_mask result = 0;
+    for(uint32_t l = 0; l < packet_size; ++l)
+    {
+        result |= lane_mask(hit[l] != 0) << l;
+    }
+    return result & active;
+}
+
+const uint32_t gather_surfels(const dataset::serialized_surfel *surfels, const uint32_t first, const uint32_t num_surfels, const uint32_t surfel_skip,
+                              const scm::math::mat4f &model_transform, surfel_batch &batch)
+{
+    uint32_t count = 0;
+    for(uint32_t k = first; k < num_surfels && count < packet_size; k += surfel_skip, ++count)
+    {
+        const dataset::serialized_surfel &surfel = surfels[k];
+        batch.surfels_[count] = &surfel;
+        batch.position_[0][count] = surfel.x;
+        batch.position_[1][count] = surfel.y;
+        batch.position_[2][count] = surfel.z;
+        batch.normal_[0][count] = surfel.nx;
+        batch.normal_[1][count] = surfel.ny;
+        batch.normal_[2][count] = surfel.nz;
+        batch.size_[count] = surfel.size;
+    }
+    for(uint32_t j = count; j < packet_size; ++j)
+    {
+        batch.surfels_[j] = nullptr;
+        batch.position_[0][j] = batch.position_[1][j] = batch.position_[2][j] = 0.f;
+        batch.normal_[0][j] = batch.normal_[1][j] = batch.normal_[2][j] = 0.f;
+        batch.size_[j] = 0.f;
+    }
+
+    // model_transform * vec3f, column major with w == 1
+    const float *m = model_transform.data_array;
+#pragma omp simd
+    for(uint32_t j = 0; j < packet_size; ++j)
+    {
+        for(uint32_t r = 0; r < 3; ++r)
+        {
+            float dp = 0.f;
+            dp += m[r] * batch.position_[0][j];
+            dp += m[r + 4] * batch.position_[1][j];
+            dp += m[r + 8] * batch.position_[2][j];
+            batch.w_position_[r][j] = dp + m[r + 12];
+        }
+    }
+
+    return count;
+}
+
+} // namespace
+
+bool ray_picker::is_instanced_ = false;
+ray_picker *ray_picker::single_ = nullptr;
+std::mutex ray_picker::mutex_;
+
+ray_picker::ray_picker(const uint32_t num_threads)
+    : batch_generation_(0), num_busy_workers_(0), shutdown_(false), next_packet_(0), num_packets_(0), rays_(nullptr), models_(nullptr), intersections_(nullptr), max_depth_(0),
+      surfel_skip_(1), is_wysiwyg_(false)
+{
+    // the calling thread traces packets as well
+    for(uint32_t i = 1; i < num_threads; ++i)
+    {
+        threads_.push_back(std::thread(&ray_picker::worker, this));
+    }
+}
+
+ray_picker::~ray_picker()
+{
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        shutdown_ = true;
+    }
+    batch_available_.notify_all();
+
+    for(auto &thread : threads_)
+    {
+        thread.join();
+    }
+    threads_.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_instanced_ = false;
+}
+
+ray_picker *ray_picker::get_instance()
+{
+    if(!is_instanced_)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(!is_instanced_)
+        {
+            uint32_t num_threads = LAMURE_PICKING_NUM_THREADS;
+            if(num_threads == 0)
+            {
+                num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+            }
+            single_ = new ray_picker(num_threads);
+            is_instanced_ = true;
+        }
+
+        return single_;
+    }
+    else
+    {
+        return single_;
+    }
+}
+
+const size_t ray_picker::intersect(const std::vector<ray> &rays, const float aabb_scale, const unsigned int max_depth, const unsigned int surfel_skip, const bool is_wysiwyg,
+                                   std::vector<ray::intersection> &intersections)
+{
+    model_database *database = model_database::get_instance();
+
+    std::vector<picked_model> models;
+    for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
+    {
+        models.push_back(picked_model{model_id, database->get_model(model_id)->transform()});
+    }
+
+    ooc_cache *ooc_cache = ooc_cache::get_instance();
+    ooc_cache->lock();
+    ooc_cache->refresh();
+
+    const size_t num_hits = run(rays, models, max_depth, surfel_skip, is_wysiwyg, intersections);
+
+    ooc_cache->unlock();
+
+    return num_hits;
+}
+
+const size_t ray_picker::intersect_model(const model_t model_id, const scm::math::mat4f &model_transform, const std::vector<ray> &rays, const float aabb_scale,
+                                         const unsigned int max_depth, const unsigned int surfel_skip, const bool is_wysiwyg, std::vector<ray::intersection> &intersections)
+{
+    std::vector<picked_model> models;
+    if(model_id < model_database::get_instance()->num_models())
+    {
+        models.push_back(picked_model{model_id, model_transform});
+    }
+
+    ooc_cache *ooc_cache = ooc_cache::get_instance();
+    ooc_cache->lock();
+    ooc_cache->refresh();
+
+    const size_t num_hits = run(rays, models, max_depth, surfel_skip, is_wysiwyg, intersections);
+
+    ooc_cache->unlock();
+
+    return num_hits;
+}
+
+const size_t ray_picker::intersect(ray_queue &queue, const float aabb_scale, const unsigned int max_depth, const unsigned int surfel_skip, const bool is_wysiwyg,
+                                   std::vector<ray::intersection> &intersections)
+{
+    std::vector<ray_queue::ray_job> jobs;
+    queue.pop_all_jobs(jobs);
+
+    std::vector<ray> rays;
+    int max_id = -1;
+    for(const auto &job : jobs)
+    {
+        if(job.id_ >= 0)
+        {
+            rays.push_back(job.ray_);
+            max_id = std::max(max_id, job.id_);
+        }
+    }
+
+    std::vector<ray::intersection> results;
+    const size_t num_hits = intersect(rays, aabb_scale, max_depth, surfel_skip, is_wysiwyg, results);
+
+    intersections.assign(size_t(max_id + 1), ray::intersection());
+    size_t i = 0;
+    for(const auto &job : jobs)
+    {
+        if(job.id_ >= 0)
+        {
+            intersections[job.id_] = results[i++];
+        }
+    }
+
+    return num_hits;
+}
+
+const size_t ray_picker::run(const std::vector<ray> &rays, const std::vector<picked_model> &models, const unsigned int max_depth, const unsigned int surfel_skip,
+                             const bool is_wysiwyg, std::vector<ray::intersection> &intersections)
+{
+    std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+
+    intersections.assign(rays.size(), ray::intersection());
+    if(rays.empty() || models.empty())
+    {
+        return 0;
+    }
+
+    rays_ = &rays;
+    models_ = &models;
+    intersections_ = &intersections;
+    max_depth_ = max_depth == 0 ? 255 : max_depth;
+    surfel_skip_ = surfel_skip == 0 ? 1 : surfel_skip;
+    is_wysiwyg_ = is_wysiwyg;
+    num_packets_ = (rays.size() + packet_size - 1) / packet_size;
+    next_packet_ = 0;
+
+    if(num_packets_ > 1 && !threads_.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex_);
+            ++batch_generation_;
+            num_busy_workers_ = threads_.size();
+        }
+        batch_available_.notify_all();
+
+        trace_packets();
+
+        std::unique_lock<std::mutex> lock(worker_mutex_);
+        batch_done_.wait(lock, [&] { return num_busy_workers_ == 0; });
+    }
+    else
+    {
+        trace_packets();
+    }
+
+    rays_ = nullptr;
+    models_ = nullptr;
+    intersections_ = nullptr;
+
+    size_t num_hits = 0;
+    for(const auto &intersection : intersections)
+    {
+        if(intersection.error_ < std::numeric_limits<float>::max())
+        {
+            ++num_hits;
+        }
+    }
+    return num_hits;
+}
+
+void ray_picker::worker()
+{
+    uint64_t generation = 0;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(worker_mutex_);
+            batch_available_.wait(lock, [&] { return shutdown_ || batch_generation_ != generation; });
+            if(shutdown_)
+            {
+                break;
+            }
+            generation = batch_generation_;
+        }
+
+        trace_packets();
+
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex_);
+            --num_busy_workers_;
+        }
+        batch_done_.notify_one();
+    }
+}
+
+void ray_picker::trace_packets()
+{
+    while(true)
+    {
+        const size_t packet = next_packet_.fetch_add(1);
+        if(packet >= num_packets_)
+        {
+            break;
+        }
+
+        const size_t first_ray = packet * packet_size;
+        const uint32_t num_rays = (uint32_t)std::min(rays_->size() - first_ray, size_t(packet_size));
+
+        // the intersections carry over, so each ray keeps its best hit over all models
+        for(const auto &model : *models_)
+        {
+            trace_packet(first_ray, num_rays, model);
+        }
+    }
+}
+
+// Packet version of ray::intersect_model_unsafe. Every lane visits the same
+// nodes and tests the same surfels as the single ray would, the packet just
+// shares the node fetches, the box tests and the loads of the surfels.
+void ray_picker::trace_packet(const size_t first_ray, const uint32_t num_rays, const picked_model &model)
+{
+    model_database *database = model_database::get_instance();
+    ooc_cache *ooc_cache = ooc_cache::get_instance();
+
+    const model_t model_id = model.model_id_;
+    const scm::math::mat4f &model_transform = model.transform_;
+
+    const bvh *tree = database->get_model(model_id)->get_bvh();
+    if(tree->get_primitive() != bvh::primitive_type::POINTCLOUD)
+    {
+        return;
+    }
+
+    // check if model has started loading
+    if(!ooc_cache->is_node_resident_and_aquired(model_id, 0))
+    {
+        return;
+    }
+
+    const unsigned int fan_factor = tree->get_fan_factor();
+    const node_t num_nodes = tree->get_num_nodes();
+    const uint32_t num_surfels_per_node = database->get_primitives_per_node();
+    const std::vector<scm::gl::boxf> &bounding_boxes = tree->get_bounding_boxes();
+
+    const scm::math::mat4f inverse_model_transform = scm::math::inverse(model_transform);
+    const scm::math::mat4f normal_transform = scm::math::transpose(inverse_model_transform);
+
+    ray_packet packet;
+    ray::intersection *intersections = intersections_->data() + first_ray;
+    alignas(32) float best_errors[packet_size];
+
+    for(uint32_t l = 0; l < packet_size; ++l)
+    {
+        // pad with copies of the first ray, padded lanes are never active
+        const ray &r = (*rays_)[first_ray + (l < num_rays ? l : 0)];
+
+        scm::math::vec3f object_ray_origin = inverse_model_transform * r.origin();
+        scm::math::vec3f object_ray_aux = inverse_model_transform * (r.origin() + r.direction() * r.max_distance());
+        scm::math::vec3f object_ray_direction = object_ray_aux - object_ray_origin;
+        float object_ray_max_distance = scm::math::length(object_ray_direction);
+        object_ray_direction = scm::math::normalize(object_ray_direction);
+
+        for(uint32_t a = 0; a < 3; ++a)
+        {
+            packet.o_origin_[a][l] = object_ray_origin[a];
+            packet.o_direction_[a][l] = object_ray_direction[a];
+            packet.w_origin_[a][l] = r.origin()[a];
+            packet.w_direction_[a][l] = r.direction()[a];
+        }
+        packet.o_max_distance_[l] = object_ray_max_distance;
+        packet.w_max_distance_[l] = r.max_distance();
+        packet.object_to_world_scale_[l] = r.max_distance() / object_ray_max_distance;
+
+        best_errors[l] = l < num_rays ? intersections[l].error_ : std::numeric_limits<float>::max();
+    }
+
+    const lane_mask all_lanes = num_rays >= 32 ? ~lane_mask(0) : (lane_mask(1) << num_rays) - 1;
+    lane_mask has_hit = 0;
+
+    surfel_batch batch;
+    alignas(32) float errors[packet_size];
+    alignas(32) float plane_distances[packet_size];
+    alignas(32) float intersection_distances[packet_size];
+    alignas(32) float positions[3][packet_size];
+
+    auto intersect_splats = [&](const node_t node_id, const lane_mask lanes) {
+        const dataset::serialized_surfel *surfels = (const dataset::serialized_surfel *)ooc_cache->node_data(model_id, node_id);
+
+        for(uint32_t first = 0; first < num_surfels_per_node; first += packet_size * surfel_skip_)
+        {
+            const uint32_t count = gather_surfels(surfels, first, num_surfels_per_node, surfel_skip_, model_transform, batch);
+            if(count == 0)
+            {
+                break;
+            }
+
+            for(uint32_t l = 0; l < packet_size; ++l)
+            {
+                if(!(lanes & (lane_mask(1) << l)))
+                {
+                    continue;
+                }
+
+                const float ox = packet.o_origin_[0][l], oy = packet.o_origin_[1][l], oz = packet.o_origin_[2][l];
+                const float dx = packet.o_direction_[0][l], dy = packet.o_direction_[1][l], dz = packet.o_direction_[2][l];
+                const float wox = packet.w_origin_[0][l], woy = packet.w_origin_[1][l], woz = packet.w_origin_[2][l];
+                const float wdx = packet.w_direction_[0][l], wdy = packet.w_direction_[1][l], wdz = packet.w_direction_[2][l];
+                const float w_max_distance = packet.w_max_distance_[l];
+                const float scale = packet.object_to_world_scale_[l];
+
+#pragma omp simd
+                for(uint32_t j = 0; j < packet_size; ++j)
+                {
+                    const float nx = batch.normal_[0][j], ny = batch.normal_[1][j], nz = batch.normal_[2][j];
+                    const float size = batch.size_[j];
+
+                    // plane intersection as in ray::intersect_surfel, the orientation
+                    // of the normal cancels out
+                    const float denom = nx * dx + ny * dy + nz * dz;
+                    const float numer = (batch.position_[0][j] - ox) * nx + (batch.position_[1][j] - oy) * ny + (batch.position_[2][j] - oz) * nz;
+                    const float ts = std::abs(denom) > std::numeric_limits<float>::min() ? numer / denom : -1.f;
+
+                    const float px = wox + wdx * ts * scale;
+                    const float py = woy + wdy * ts * scale;
+                    const float pz = woz + wdz * ts * scale;
+
+                    const float sx = batch.w_position_[0][j] - px, sy = batch.w_position_[1][j] - py, sz = batch.w_position_[2][j] - pz;
+                    const float plane_distance = std::sqrt(sx * sx + sy * sy + sz * sz);
+
+                    const float ex = batch.w_position_[0][j] - wox, ey = batch.w_position_[1][j] - woy, ez = batch.w_position_[2][j] - woz;
+                    const float origin_distance = std::sqrt(ex * ex + ey * ey + ez * ez);
+
+                    const float ix = px - wox, iy = py - woy, iz = pz - woz;
+                    const float intersection_distance = std::sqrt(ix * ix + iy * iy + iz * iz);
+
+                    bool valid = size > std::numeric_limits<float>::min() && ts > 0.f && origin_distance < w_max_distance;
+                    if(is_wysiwyg_)
+                    {
+                        valid = valid && !(plane_distance > scale * size * LAMURE_WYSIWYG_SPLAT_SCALE);
+                    }
+
+                    errors[j] = valid ? 0.01f * intersection_distance + plane_distance : std::numeric_limits<float>::infinity();
+                    plane_distances[j] = plane_distance;
+                    intersection_distances[j] = intersection_distance;
+                    positions[0][j] = px;
+                    positions[1][j] = py;
+                    positions[2][j] = pz;
+                }
+
+                // in order, so ties resolve to the first surfel like the single ray
+                uint32_t best = packet_size;
+                for(uint32_t j = 0; j < count; ++j)
+                {
+                    if(errors[j] < best_errors[l] && errors[j] < max_intersection_error)
+                    {
+                        best_errors[l] = errors[j];
+                        best = j;
+                    }
+                }
+
+                if(best < packet_size)
+                {
+                    ray::intersection &intersection = intersections[l];
+                    intersection.error_ = errors[best];
+                    intersection.error_raw_ = plane_distances[best];
+                    intersection.distance_ = intersection_distances[best];
+                    intersection.position_ = scm::math::vec3f(positions[0][best], positions[1][best], positions[2][best]);
+
+                    const dataset::serialized_surfel &surfel = *batch.surfels_[best];
+                    scm::math::vec3f plane_normal = normal_transform * scm::math::vec3f(surfel.nx, surfel.ny, surfel.nz);
+                    intersection.normal_ = scm::math::normalize(plane_normal);
+                    if(scm::math::dot(intersection.normal_, scm::math::vec3f(wdx, wdy, wdz)) > 0.f)
+                    {
+                        intersection.normal_ *= -1.f;
+                    }
+
+                    has_hit |= lane_mask(1) << l;
+                }
+            }
+        }
+    };
+
+    auto is_available = [&](const node_t node_id) { return node_id != invalid_node_t && node_id < num_nodes && ooc_cache->is_node_resident_and_aquired(model_id, node_id); };
+
+    // parent and the lanes that descend into it
+    std::vector<std::pair<node_t, lane_mask>> candidates;
+    candidates.push_back(std::make_pair(node_t(0), all_lanes));
+
+    while(!candidates.empty())
+    {
+        const node_t current_parent_id = candidates.back().first;
+        const lane_mask parent_lanes = candidates.back().second;
+        candidates.pop_back();
+
+        bool no_child_available = true;
+
+        for(node_t i = 0; i < (node_t)fan_factor; ++i)
+        {
+            const node_t node_id = tree->get_child_id(current_parent_id, i);
+            if(!is_available(node_id))
+            {
+                continue;
+            }
+
+            no_child_available = false;
+
+            const lane_mask node_lanes = intersect_aabb(packet, bounding_boxes[node_id], parent_lanes, true);
+            if(node_lanes == 0)
+            {
+                continue;
+            }
+
+            bool all_children_in_memory = true;
+            for(node_t k = 0; k < fan_factor; ++k)
+            {
+                if(!is_available(tree->get_child_id(node_id, k)))
+                {
+                    all_children_in_memory = false;
+                    break;
+                }
+            }
+
+            lane_mask splat_lanes = node_lanes;
+
+            if(all_children_in_memory)
+            {
+                lane_mask child_lanes = 0;
+                for(node_t k = 0; k < fan_factor && child_lanes != node_lanes; ++k)
+                {
+                    child_lanes |= intersect_aabb(packet, bounding_boxes[tree->get_child_id(node_id, k)], node_lanes & ~child_lanes, false);
+                }
+
+                if(child_lanes != 0 && tree->get_depth_of_node(node_id) + 1 < max_depth_)
+                {
+                    candidates.push_back(std::make_pair(node_id, child_lanes));
+                    splat_lanes &= ~child_lanes;
+                }
+            }
+
+            if(splat_lanes != 0 && tree->get_visibility(node_id) != bvh::node_visibility::NODE_INVISIBLE)
+            {
+                intersect_splats(node_id, splat_lanes);
+            }
+        }
+
+        // no node other than root in ram
+        if(no_child_available && current_parent_id == 0)
+        {
+            const lane_mask root_lanes = parent_lanes & ~has_hit;
+            if(root_lanes != 0)
+            {
+                intersect_splats(current_parent_id, root_lanes);
+            }
+        }
+    }
+}
+}
+} // namespace lamure
@@ -79,11 +79,15 @@ namespace vt{
         virtual void push(ooc::TileRequest *&content){
             auto entry = new TileRequestPriorityQueueEntry<priority_type>(content, *this);
 
-            std::lock_guard<std::mutex> lock(this->_lock);
+            {
+                std::lock_guard<std::mutex> lock(this->_lock);
 
-            this->_insertUnsafe(*entry);
-            this->_incrementSize(1);
+                this->_insertUnsafe(*entry);
+                this->_incrementSize(1);
+            }
 
+            // wake one of the workers blocked in pop
+            this->_newEntry.notify_one();
         }
 
         virtual bool pop(ooc::TileRequest *&content, const std::chrono::milliseconds maxTime){
@@ -58,6 +58,7 @@ class VIRTUAL_TEXTURING_DLL VTConfig
     uint32_t get_size_physical_update_throughput() const;
 
     uint32_t get_size_ram_cache() const;
+    uint16_t get_num_loading_threads() const;
 
     FORMAT_TEXTURE get_format_texture() const;
     bool is_verbose() const;
@@ -79,6 +80,7 @@ class VIRTUAL_TEXTURING_DLL VTConfig
     static constexpr const char *PHYSICAL_SIZE_MB = "PHYSICAL_SIZE_MB";
     static constexpr const char *PHYSICAL_UPDATE_THROUGHPUT_MB = "PHYSICAL_UPDATE_THROUGHPUT_MB";
     static constexpr const char *RAM_CACHE_SIZE_MB = "RAM_CACHE_SIZE_MB";
+    static constexpr const char *LOADING_THREADS = "LOADING_THREADS";
 
     static constexpr const char *TEXTURE_FORMAT = "TEXTURE_FORMAT";
     static constexpr const char *TEXTURE_FORMAT_RGBA8 = "RGBA8";
@@ -98,6 +100,7 @@ class VIRTUAL_TEXTURING_DLL VTConfig
     uint32_t _size_physical_texture;
     uint32_t _size_physical_update_throughput;
     uint32_t _size_ram_cache;
+    uint16_t _num_loading_threads;
 
     VTConfig::FORMAT_TEXTURE _format_texture;
     bool _verbose;
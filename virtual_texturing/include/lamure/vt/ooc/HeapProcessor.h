@@ -10,6 +10,7 @@
 
 
 #include <thread>
+#include <vector>
 #include <atomic>
 #include <condition_variable>
 #include <lamure/vt/ooc/TileCache.h>
@@ -25,7 +26,7 @@ namespace vt {
 
             std::atomic<bool> _running;
             std::atomic<size_t> _currentlyProcessing;
-            std::thread *_thread;
+            std::vector<std::thread> _threads;
 
             TileCache *_cache;
         public:
@@ -34,10 +35,12 @@ namespace vt {
 
             void request(TileRequest *request);
 
-            void start();
+            // starts threadCount workers that pop requests from the shared queue
+            void start(size_t threadCount = 1);
 
             void run();
 
+            // called by every worker thread
             virtual void beforeStart() = 0;
 
             virtual void process(TileRequest *req) = 0;
@@ -50,6 +53,8 @@ namespace vt {
 
             size_t pendingCount();
 
+            size_t threadCount();
+
             bool currentlyProcessing();
         };
     }
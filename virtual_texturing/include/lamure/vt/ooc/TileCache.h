@@ -8,13 +8,15 @@
 #ifndef VT_OOC_TILECACHE_H
 #define VT_OOC_TILECACHE_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
+#include <thread>
 #include <iostream>
 #include <lamure/vt/pre/AtlasFile.h>
-#include <queue>
-#include <map>
+#include <unordered_map>
+#include <vector>
 #include <condition_variable>
 
 namespace vt {
@@ -32,11 +34,13 @@ namespace vt {
             };
 
         protected:
-            STATE _state;
+            std::atomic<STATE> _state;
+            std::atomic<bool> _referenced;
+            // one bit per reading thread, guarded by the index shard of the slot's tile
+            uint64_t _readers;
             uint8_t *_buffer;
             size_t _size;
             size_t _id;
-            std::mutex _lock;
             //assoc_data_type _assocData;
 
             pre::AtlasFile *_resource;
@@ -51,6 +55,9 @@ namespace vt {
 
             bool hasState(STATE state);
 
+            // atomically moves the slot from expected to desired, fails if another thread changed it first
+            bool changeState(STATE expected, STATE desired);
+
             void setTileId(uint64_t tileId);
 
             uint64_t getTileId();
@@ -75,27 +82,88 @@ namespace vt {
 
             pre::AtlasFile *getResource();
 
+            // second chance bit of the clock eviction
+            void setReferenced();
+
+            bool clearReferenced();
+
+            void addReader(uint64_t readerBit);
+
+            // returns whether other readers still pin the slot
+            bool removeReader(uint64_t readerBit);
+
             void removeFromIDS();
         };
 
+        /*
+         * Fixed number of tile slots.
+         *
+         * Slots are found by (resource, tile id) through a hash index split
+         * into shards, each with its own lock. A slot is pinned while it is
+         * READING and while a loader is WRITING it. Every reading thread holds
+         * its own pin: reading a tile again from the same thread does not add
+         * another one, a single setSlotReady of that thread releases it. The
+         * slot stays READING until all threads released it. All state changes are
+         * compare-and-swap on the slot, so readers and writers never wait for
+         * each other. Loaders pick the next slot with a clock sweep: FREE slots
+         * are taken directly, OCCUPIED slots get a second chance if they were
+         * referenced since the hand last passed.
+         */
         class TileCache {
         protected:
             typedef TileCacheSlot slot_type;
+            typedef std::pair<pre::AtlasFile *, uint64_t> key_type;
+
+            struct KeyHash{
+                size_t operator()(const key_type &key) const {
+                    uint64_t h = (uint64_t)(uintptr_t)key.first * 0x9E3779B97F4A7C15ull;
+                    h ^= key.second + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+                    h ^= h >> 29;
+                    h *= 0xBF58476D1CE4E5B9ull;
+                    return (size_t)(h ^ (h >> 32));
+                }
+            };
+
+            static constexpr size_t SHARD_COUNT = 16;
+            static constexpr size_t CACHE_LINE_SIZE = 64;
+
+            // padded instead of over-aligned, plain new does not honour alignas beyond max_align_t
+            struct Shard{
+                std::mutex lock;
+                std::unordered_map<key_type, slot_type *, KeyHash> ids;
+                uint8_t padding[CACHE_LINE_SIZE];
+            };
 
             size_t _tileByteSize;
             size_t _slotCount;
             uint8_t *_buffer;
             slot_type *_slots;
-            std::mutex *_locks;
 
-            std::mutex _lruLock;
-            std::condition_variable _lruCondVar;
-            std::queue<TileCacheSlot*> _lru;
+            Shard _shards[SHARD_COUNT];
+
+            std::atomic<size_t> _clockHand;
+            uint8_t _clockHandPadding[CACHE_LINE_SIZE];
+
+            // writers that found no evictable slot wait until a slot is released
+            std::atomic<uint64_t> _released;
+            std::atomic<size_t> _waiting;
+            std::mutex _waitLock;
+            std::condition_variable _slotReleased;
+
+            std::atomic<uint64_t> _loaded;
 
-            std::mutex _idsLock;
-            std::map<std::pair<pre::AtlasFile *, uint64_t>, slot_type *> _ids;
+            // reading threads are numbered per cache, their pins are bits of the slots
+            static constexpr size_t MAX_READERS = 64;
 
-            uint64_t _loaded = 0;
+            uint64_t _instanceId;
+            std::mutex _readerLock;
+            std::vector<std::thread::id> _readerThreads;
+
+            uint64_t _readerBit();
+
+            Shard &_shard(const key_type &key);
+
+            slot_type *_sweep();
 
         public:
             uint64_t tiles_loaded();
@@ -110,6 +178,9 @@ namespace vt {
 
             void unregisterId(pre::AtlasFile *resource, uint64_t id);
 
+            // removes the index entry only if it still refers to the slot
+            void unregisterSlot(slot_type *slot);
+
             ~TileCache();
 
             void print();
@@ -43,7 +43,7 @@ namespace vt{
 
             ~TileProvider();
 
-            void start(size_t maxMemSize);
+            void start(size_t maxMemSize, size_t loaderThreads = 1);
 
             pre::AtlasFile *addResource(const char *fileName);
 
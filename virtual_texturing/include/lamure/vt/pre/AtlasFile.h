@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <fstream>
 #include <cstring>
+#include <mutex>
 #include <lamure/vt/pre/Bitmap.h>
 #include <lamure/vt/pre/QuadTree.h>
 #include <lamure/vt/pre/CielabIndex.h>
@@ -24,9 +25,12 @@ namespace vt{
         class VIRTUAL_TEXTURING_DLL AtlasFile
         {
         public:
+            // PACKED_DEFLATE is PACKED with every tile deflated on its own,
+            // tiles that do not shrink are stored as they are
             enum LAYOUT{
                 RAW = 1,
-                PACKED
+                PACKED,
+                PACKED_DEFLATE
             };
 
             static constexpr size_t HEADER_SIZE = 71;
@@ -35,6 +39,14 @@ namespace vt{
             const char *_fileName;
             std::ifstream _file;
 
+            // tiles are read with positional reads, so any number of loader
+            // threads can read from the same atlas concurrently
+#ifdef WIN32
+            std::mutex _tileReadLock;
+#else
+            int _tileFd;
+#endif
+
             uint64_t _imageWidth;
             uint64_t _imageHeight;
             uint64_t _tileWidth;
@@ -62,6 +74,7 @@ namespace vt{
             uint64_t _offsetIndexOffset;
             uint64_t _cielabIndexOffset;
             uint64_t _payloadOffset;
+            uint64_t _payloadSize;
 
             uint64_t _getLE(uint8_t *data);
             Bitmap::PIXEL_FORMAT _getPixelFormat(uint8_t *data);
@@ -69,6 +82,10 @@ namespace vt{
 
             uint64_t _getOffset(uint64_t id);
 
+            bool _readAt(uint64_t offset, uint8_t *out, size_t size);
+
+            bool _readDeflated(uint64_t offset, size_t size, uint8_t *out);
+
         public:
             AtlasFile(const char *fileName);
             ~AtlasFile();
@@ -91,6 +108,8 @@ namespace vt{
             uint64_t getPayloadOffset();
             Bitmap::PIXEL_FORMAT getPixelFormat();
             LAYOUT getFormat();
+            bool isCompressed();
+            uint64_t getPayloadSize();
 
             const char * getFileName();
 
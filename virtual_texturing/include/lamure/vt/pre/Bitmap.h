@@ -48,6 +48,14 @@ namespace vt{
             static void _deflatePixels(const uint8_t * const srcPx0, const uint8_t * const srcPx1, const uint8_t * const srcPx2, const uint8_t * const srcPx3, PIXEL_FORMAT srcFormat, uint8_t * const destPx, PIXEL_FORMAT destFormat);
             static void _inflatePixel(const uint8_t * const srcPx, PIXEL_FORMAT srcFormat, uint8_t * const destPx0, uint8_t * const destPx1, uint8_t * const destPx2, uint8_t * const destPx3, PIXEL_FORMAT destFormat);
 
+            // 2x2 box filter of two source rows into one row of destWidth pixels, source and destination share the format
+            template<PIXEL_FORMAT format>
+            static void _deflateRow(const uint8_t * const srcRow0, const uint8_t * const srcRow1, uint8_t * const destRow, size_t destWidth);
+
+            // writes every source pixel into a 2x2 block of two destination rows, source and destination share the format
+            template<PIXEL_FORMAT format>
+            static void _inflateRow(const uint8_t * const srcRow, uint8_t * const destRow0, uint8_t * const destRow1, size_t srcWidth);
+
         public:
             Bitmap(size_t width, size_t height, PIXEL_FORMAT pixelFormat, uint8_t *data = nullptr);
             ~Bitmap();
@@ -44,7 +44,7 @@ namespace vt {
         public:
             explicit Index<val_type>(size_t size){
                 _size = size;
-                _data = new val_type[size];
+                _data = new val_type[size]();
             }
 
             val_type getValue(uint64_t idx){
@@ -42,6 +42,23 @@ namespace vt{
         protected:
             static constexpr size_t _HEADER_SIZE = 71;
 
+            // nine tiles of the level below and the tile that is built from them
+            static constexpr size_t _DEFLATE_JOB_TILES = 10;
+
+            struct DeflateJob{
+                enum STATE{
+                    FREE = 1,
+                    LOADED,
+                    FILTERED
+                };
+
+                STATE state;
+                uint64_t relId;
+                uint64_t x;
+                uint64_t y;
+                uint8_t *buffer;
+            };
+
             std::string _srcFileName;
             Bitmap::PIXEL_FORMAT _srcPxFormat;
 
@@ -90,6 +107,9 @@ namespace vt{
             void _writeHeader();
             void _extract(size_t bufferTileWidth, size_t writeBufferTileSize);
             void _deflate(size_t tilesInWriteBuffer);
+            void _filterDeflateJob(DeflateJob &job);
+            void _compress(size_t maxMemory);
+            void _truncatePayload(uint64_t fileSize);
 
             void _putLE(uint64_t num, uint8_t *out);
             void _putPixelFormat(Bitmap::PIXEL_FORMAT pxFormat, uint8_t *out);
@@ -10,13 +10,14 @@
 namespace vt {
     namespace ooc {
         HeapProcessor::HeapProcessor() {
-            _thread = nullptr;
+            _running = false;
+            _currentlyProcessing = 0;
             _cache = nullptr;
         }
 
         HeapProcessor::~HeapProcessor(){
-            if(_thread != nullptr){
-                delete _thread;
+            if(!_threads.empty()){
+                stop();
             }
         }
 
@@ -24,8 +25,8 @@ namespace vt {
             _requests.push(request);
         }
 
-        void HeapProcessor::start(){
-            if(_thread != nullptr){
+        void HeapProcessor::start(size_t threadCount){
+            if(!_threads.empty()){
                 throw std::runtime_error("HeapProcessor is already started.");
             }
 
@@ -33,8 +34,15 @@ namespace vt {
                 throw std::runtime_error("Cache needs to be set.");
             }
 
+            if(threadCount == 0){
+                threadCount = 1;
+            }
+
             _running = true;
-            _thread = new std::thread(&HeapProcessor::run, this);
+
+            for(size_t i = 0; i < threadCount; ++i){
+                _threads.emplace_back(&HeapProcessor::run, this);
+            }
         }
 
         void HeapProcessor::run(){
@@ -47,9 +55,9 @@ namespace vt {
                     continue;
                 }
 
-                _currentlyProcessing.store(_currentlyProcessing.load() + 1);
+                ++_currentlyProcessing;
                 process(req);
-                _currentlyProcessing.store(_currentlyProcessing.load() - 1);
+                --_currentlyProcessing;
             }
 
             beforeStop();
@@ -61,13 +69,22 @@ namespace vt {
 
         void HeapProcessor::stop(){
             _running = false;
-            _thread->join();
+
+            for(auto &thread : _threads){
+                thread.join();
+            }
+
+            _threads.clear();
         }
 
         size_t HeapProcessor::pendingCount(){
             return _requests.getSize();
         }
 
+        size_t HeapProcessor::threadCount(){
+            return _threads.size();
+        }
+
         bool HeapProcessor::currentlyProcessing(){
             return _currentlyProcessing > 0;
         }
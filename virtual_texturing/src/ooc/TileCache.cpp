@@ -6,7 +6,9 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/vt/ooc/TileCache.h>
+#include <algorithm>
 #include <chrono>
+#include <stdexcept>
 
 namespace vt {
     namespace ooc {
@@ -14,10 +16,13 @@ namespace vt {
 
         TileCacheSlot::TileCacheSlot(){
             _state = STATE::FREE;
+            _referenced = false;
+            _readers = 0;
             _buffer = nullptr;
             _cache = nullptr;
             _size = 0;
             _tileId = 0;
+            _resource = nullptr;
         }
 
         TileCacheSlot::~TileCacheSlot(){
@@ -25,7 +30,11 @@ namespace vt {
         }
 
         bool TileCacheSlot::hasState(STATE state){
-            return _state == state;
+            return _state.load() == state;
+        }
+
+        bool TileCacheSlot::changeState(STATE expected, STATE desired){
+            return _state.compare_exchange_strong(expected, desired);
         }
 
         void TileCacheSlot::setTileId(uint64_t tileId){
@@ -41,7 +50,7 @@ namespace vt {
         }
 
         void TileCacheSlot::setState(STATE state){
-            _state = state;
+            _state.store(state);
         }
 
         void TileCacheSlot::setId(size_t id){
@@ -76,11 +85,29 @@ namespace vt {
             return _resource;
         }
 
-        void TileCacheSlot::removeFromIDS(){
-            std::lock_guard<std::mutex> lock(_lock);
+        void TileCacheSlot::setReferenced(){
+            if(!_referenced.load(std::memory_order_relaxed)){
+                _referenced.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        bool TileCacheSlot::clearReferenced(){
+            return _referenced.exchange(false, std::memory_order_relaxed);
+        }
+
+        void TileCacheSlot::addReader(uint64_t readerBit){
+            _readers |= readerBit;
+        }
+
+        bool TileCacheSlot::removeReader(uint64_t readerBit){
+            _readers &= ~readerBit;
 
+            return _readers != 0;
+        }
+
+        void TileCacheSlot::removeFromIDS(){
             if(_cache != nullptr){
-                _cache->unregisterId(_resource, _tileId);
+                _cache->unregisterSlot(this);
             }
         }
 
@@ -89,113 +116,202 @@ namespace vt {
             _slotCount = slotCount;
             _buffer = new uint8_t[tileByteSize * slotCount];
             _slots = new slot_type[slotCount];
-            _locks = new std::mutex[slotCount];
 
-            //_counter = 0;
+            _clockHand = 0;
+            _released = 0;
+            _waiting = 0;
+            _loaded = 0;
+
+            static std::atomic<uint64_t> instanceCount(0);
+            _instanceId = ++instanceCount;
 
             for(size_t i = 0; i < slotCount; ++i){
                 _slots[i].setId(i);
                 _slots[i].setBuffer(&_buffer[tileByteSize * i]);
                 _slots[i].setCache(this);
+            }
 
-                _lru.push(&_slots[i]);
+            for(auto &shard : _shards){
+                shard.ids.reserve(slotCount / SHARD_COUNT + 1);
             }
         }
 
+        TileCache::Shard &TileCache::_shard(const key_type &key){
+            return _shards[(KeyHash()(key) >> 7) % SHARD_COUNT];
+        }
+
+        uint64_t TileCache::_readerBit(){
+            // (cache instance, reader index) of the calling thread, instances are never reused
+            static thread_local std::pair<uint64_t, size_t> cached(0, 0);
+
+            if(cached.first == _instanceId){
+                return uint64_t(1) << cached.second;
+            }
+
+            std::lock_guard<std::mutex> lock(_readerLock);
+
+            auto iter = std::find(_readerThreads.begin(), _readerThreads.end(), std::this_thread::get_id());
+            size_t index = iter - _readerThreads.begin();
+
+            if(iter == _readerThreads.end()){
+                if(_readerThreads.size() == MAX_READERS){
+                    throw std::runtime_error("TileCache supports at most 64 reading threads.");
+                }
+
+                _readerThreads.push_back(std::this_thread::get_id());
+            }
+
+            cached = std::make_pair(_instanceId, index);
+
+            return uint64_t(1) << index;
+        }
+
         slot_type *TileCache::readSlotById(pre::AtlasFile *resource, uint64_t id){
-            std::lock_guard<std::mutex> lock(_idsLock);
+            auto readerBit = _readerBit();
+            auto key = std::make_pair(resource, id);
+            auto &shard = _shard(key);
+
+            std::lock_guard<std::mutex> lock(shard.lock);
 
-            auto iter = _ids.find(std::make_pair(resource, id));
+            auto iter = shard.ids.find(key);
 
-            if(iter == _ids.end()){
+            if(iter == shard.ids.end()){
                 return nullptr;
             }
 
             auto slot = iter->second;
 
-            slot->setState(slot_type::STATE::READING);
+            // the first reader pins the slot, a loader may have claimed it for
+            // eviction before removing it from the index
+            if(!slot->hasState(slot_type::STATE::READING) &&
+               !slot->changeState(slot_type::STATE::OCCUPIED, slot_type::STATE::READING)){
+                return nullptr;
+            }
+
+            slot->addReader(readerBit);
+            slot->setReferenced();
 
             return slot;
         }
 
-        slot_type *TileCache::writeSlot(std::chrono::milliseconds maxTime){
-            std::unique_lock<std::mutex> lock(_lruLock);
+        slot_type *TileCache::_sweep(){
+            // two rounds: the first one may only clear reference bits
+            for(size_t step = 0; step < 2 * _slotCount; ++step){
+                auto slot = &_slots[_clockHand.fetch_add(1, std::memory_order_relaxed) % _slotCount];
 
-            if(_lru.empty()){
-                auto destTime = std::chrono::system_clock::now() + maxTime;
+                if(slot->changeState(slot_type::STATE::FREE, slot_type::STATE::WRITING)){
+                    return slot;
+                }
 
-                if(!_lruCondVar.wait_until(lock, destTime, [this]{
-                    return !_lru.empty();
-                })){
-                    return nullptr;
+                if(!slot->hasState(slot_type::STATE::OCCUPIED)){
+                    continue;
                 }
-            }
 
-            TileCacheSlot *slot = nullptr;
+                if(slot->clearReferenced()){
+                    continue;
+                }
 
-            do{
-                slot = _lru.front();
-                _lru.pop();
+                if(slot->changeState(slot_type::STATE::OCCUPIED, slot_type::STATE::WRITING)){
+                    slot->removeFromIDS();
 
-                if(slot->hasState(TileCacheSlot::STATE::FREE) || slot->hasState(TileCacheSlot::STATE::OCCUPIED)){
-                    break;
+                    return slot;
                 }
-            }while(!_lru.empty());
+            }
 
-            lock.unlock();
+            return nullptr;
+        }
 
-            if(slot->hasState(TileCacheSlot::STATE::READING) || slot->hasState(TileCacheSlot::STATE::WRITING)) {
-                return nullptr;
-            }
+        slot_type *TileCache::writeSlot(std::chrono::milliseconds maxTime){
+            auto destTime = std::chrono::steady_clock::now() + maxTime;
 
-            if(!slot->hasState(TileCacheSlot::STATE::FREE)) {
-                slot->removeFromIDS();
-            }
+            while(true){
+                auto released = _released.load();
+                auto slot = _sweep();
 
-            slot->setState(slot_type::STATE::WRITING);
+                if(slot != nullptr){
+                    return slot;
+                }
 
-            return slot;
-        }
+                // every slot is pinned, wait until one is given back
+                std::unique_lock<std::mutex> lock(_waitLock);
+                ++_waiting;
 
-        uint64_t TileCache::tiles_loaded(){
-            auto loaded = _loaded;
+                bool wasReleased = _slotReleased.wait_until(lock, destTime, [this, released]{
+                    return _released.load() != released;
+                });
 
-            _loaded = 0;
+                --_waiting;
 
-            return loaded;
+                if(!wasReleased){
+                    return nullptr;
+                }
+            }
         }
 
-        void TileCache::setSlotReady(slot_type *slot){
-            std::unique_lock<std::mutex> lockSlot(_locks[slot->getId()]);
+        uint64_t TileCache::tiles_loaded(){
+            return _loaded.exchange(0);
+        }
 
+        void TileCache::setSlotReady(slot_type *slot){
             if(slot->hasState(slot_type::STATE::WRITING)){
-                std::lock_guard<std::mutex> lock(_idsLock);
-                _ids.insert(std::make_pair(std::make_pair(slot->getResource(), slot->getTileId()), slot));
+                auto key = std::make_pair(slot->getResource(), slot->getTileId());
+                auto &shard = _shard(key);
+
+                {
+                    std::lock_guard<std::mutex> lock(shard.lock);
+                    shard.ids[key] = slot;
+                }
+
                 ++_loaded;
-            }
 
-            slot->setState(slot_type::STATE::OCCUPIED);
+                slot->setReferenced();
+                slot->changeState(slot_type::STATE::WRITING, slot_type::STATE::OCCUPIED);
+            }else{
+                auto readerBit = _readerBit();
+                auto key = std::make_pair(slot->getResource(), slot->getTileId());
+                auto &shard = _shard(key);
 
-            lockSlot.unlock();
+                std::lock_guard<std::mutex> lock(shard.lock);
+
+                if(slot->removeReader(readerBit)){
+                    return;
+                }
+
+                slot->changeState(slot_type::STATE::READING, slot_type::STATE::OCCUPIED);
+            }
 
-            std::unique_lock<std::mutex> lock(_lruLock);
-            bool wasEmpty = _lru.empty();
-            _lru.push(slot);
-            lock.unlock();
+            ++_released;
 
-            if(wasEmpty){
-                _lruCondVar.notify_all();
+            if(_waiting.load() > 0){
+                std::lock_guard<std::mutex> lock(_waitLock);
+                _slotReleased.notify_all();
             }
         }
 
         void TileCache::unregisterId(pre::AtlasFile *resource, uint64_t id){
-            _ids.erase(std::make_pair(resource, id));
+            auto key = std::make_pair(resource, id);
+            auto &shard = _shard(key);
+
+            std::lock_guard<std::mutex> lock(shard.lock);
+            shard.ids.erase(key);
+        }
+
+        void TileCache::unregisterSlot(slot_type *slot){
+            auto key = std::make_pair(slot->getResource(), slot->getTileId());
+            auto &shard = _shard(key);
+
+            std::lock_guard<std::mutex> lock(shard.lock);
+
+            auto iter = shard.ids.find(key);
+
+            if(iter != shard.ids.end() && iter->second == slot){
+                shard.ids.erase(iter);
+            }
         }
 
         TileCache::~TileCache(){
             delete[] _buffer;
             delete[] _slots;
-            delete[] _locks;
         }
 
         void TileCache::print(){
@@ -215,11 +331,15 @@ namespace vt {
 
             std::cout << std::endl << "IDs:" << std::endl;
 
-            for(auto pair : _ids){
-                std::cout << "\t" << pair.first.first << " " << pair.first.second << " --> " << pair.second->getResource() << " " << pair.second->getTileId() << std::endl;
+            for(auto &shard : _shards){
+                std::lock_guard<std::mutex> lock(shard.lock);
+
+                for(auto pair : shard.ids){
+                    std::cout << "\t" << pair.first.first << " " << pair.first.second << " --> " << pair.second->getResource() << " " << pair.second->getTileId() << std::endl;
+                }
             }
 
             std::cout << std::endl;
         }
     }
-}
\ No newline at end of file
+}
@@ -21,8 +21,14 @@ namespace vt {
                 auto res = req->getResource();
                 auto slot = _cache->writeSlot(std::chrono::milliseconds(10));
 
-                if (slot == nullptr) {
-                    throw std::runtime_error("Cache seems to be full.");
+                // every slot is pinned by readers, wait for one to be given back
+                while (slot == nullptr) {
+                    if (!_running.load()) {
+                        req->erase();
+                        return;
+                    }
+
+                    slot = _cache->writeSlot(std::chrono::milliseconds(10));
                 }
 
                 res->getTile(req->getId(), slot->getBuffer());
@@ -15,6 +15,8 @@ namespace vt{
         }
 
         TileProvider::~TileProvider(){
+            _loader.stop();
+
             for(auto resource : _resources){
                 delete resource;
             }
@@ -22,7 +24,7 @@ namespace vt{
             delete _cache;
         }
 
-        void TileProvider::start(size_t maxMemSize){
+        void TileProvider::start(size_t maxMemSize, size_t loaderThreads){
             if(_tileByteSize == 0){
                 throw std::runtime_error("TileProvider tries to start loading Tiles of size 0.");
             }
@@ -35,7 +37,7 @@ namespace vt{
 
             _cache = new TileCache(_tileByteSize, slotCount);
             _loader.writeTo(_cache);
-            _loader.start();
+            _loader.start(loaderThreads);
         }
 
         pre::AtlasFile *TileProvider::addResource(const char *fileName){
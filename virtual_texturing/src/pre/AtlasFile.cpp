@@ -7,6 +7,14 @@
 
 #include <lamure/vt/pre/AtlasFile.h>
 #include <lamure/vt/pre/OffsetIndex.h>
+#include <vector>
+#include <zlib.h>
+
+#ifndef WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace vt{
     namespace pre {
@@ -42,6 +50,8 @@ namespace vt{
                     return LAYOUT::RAW;
                 case 2:
                     return LAYOUT::PACKED;
+                case 3:
+                    return LAYOUT::PACKED_DEFLATE;
                 default:
                     throw std::runtime_error("Trying to load unknown File Format.");
             }
@@ -100,6 +110,7 @@ namespace vt{
 
             _totalTileCount = 0;
             _filledTileCount = 0;
+            _payloadSize = 0;
 
             for(auto level = _treeDepth - 1; ; --level){
                 auto widthOfLevel = QuadTree::getWidthOfLevel(level);
@@ -130,15 +141,41 @@ namespace vt{
                 _file.seekg(_offsetIndexOffset);
                 _offsetIndex->readFromFile(_file);
 
+                _payloadSize = _filledTileCount * _tileByteSize;
+            }else if(_format == LAYOUT::PACKED_DEFLATE){
+                _offsetIndex = new OffsetIndex(_totalTileCount, _format);
+                _file.seekg(_offsetIndexOffset);
+                _offsetIndex->readFromFile(_file);
+
+                for(uint64_t id = 0; id < _totalTileCount; ++id){
+                    if(_offsetIndex->exists(id)){
+                        _payloadSize += _offsetIndex->getLength(id);
+                    }
+                }
+
+                if(fileLen != _payloadOffset + _payloadSize){
+                    throw std::runtime_error("Atlas-File does not have the expected Size.");
+                }
             }
 
             _cielabIndex = new CielabIndex(_totalTileCount);
             _file.seekg(_cielabIndexOffset);
             _cielabIndex->readFromFile(_file);
+
+#ifndef WIN32
+            _tileFd = open(fileName, O_RDONLY);
+
+            if(_tileFd < 0){
+                throw std::runtime_error("Could not open Atlas-File for reading Tiles.");
+            }
+#endif
         }
 
         AtlasFile::~AtlasFile(){
             _file.close();
+#ifndef WIN32
+            close(_tileFd);
+#endif
             delete _offsetIndex;
             delete _cielabIndex;
         }
@@ -195,6 +232,14 @@ namespace vt{
             return _format;
         }
 
+        bool AtlasFile::isCompressed(){
+            return _format == LAYOUT::PACKED_DEFLATE;
+        }
+
+        uint64_t AtlasFile::getPayloadSize(){
+            return _payloadSize;
+        }
+
         uint64_t AtlasFile::_getOffset(uint64_t id){
             if(id >= _totalTileCount){
                 return UINT64_MAX;
@@ -210,6 +255,16 @@ namespace vt{
         bool AtlasFile::getTile(uint64_t id, uint8_t *out){
             uint64_t offset = 0;
 
+            if(_format == LAYOUT::PACKED_DEFLATE){
+                if(!_offsetIndex->exists(id)){
+                    std::memset((char*)out, 0x00, _tileByteSize);
+
+                    return false;
+                }
+
+                return _readDeflated(_payloadOffset + _offsetIndex->getOffset(id), _offsetIndex->getLength(id), out);
+            }
+
             if(_format == LAYOUT::PACKED) {
                 if(_offsetIndex->exists(id)){
                     offset = _offsetIndex->getOffset(id);
@@ -226,8 +281,63 @@ namespace vt{
                 return false;
             }
 
-            _file.seekg(_payloadOffset + offset);
-            _file.read((char*)out, _tileByteSize);
+            return _readAt(_payloadOffset + offset, out, _tileByteSize);
+        }
+
+        bool AtlasFile::_readAt(uint64_t offset, uint8_t *out, size_t size){
+#ifdef WIN32
+            std::lock_guard<std::mutex> lock(_tileReadLock);
+
+            _file.clear();
+            _file.seekg(offset);
+            _file.read((char*)out, size);
+
+            return _file.gcount() == (std::streamsize)size;
+#else
+            size_t done = 0;
+
+            while(done < size){
+                auto count = pread(_tileFd, out + done, size - done, (off_t)(offset + done));
+
+                if(count < 0 && errno == EINTR){
+                    continue;
+                }
+
+                if(count <= 0){
+                    std::memset(out + done, 0x00, size - done);
+
+                    return false;
+                }
+
+                done += (size_t)count;
+            }
+
+            return true;
+#endif
+        }
+
+        bool AtlasFile::_readDeflated(uint64_t offset, size_t size, uint8_t *out){
+            if(size == _tileByteSize){
+                return _readAt(offset, out, size);
+            }
+
+            // one staging buffer per loader thread
+            thread_local std::vector<uint8_t> compressed;
+            compressed.resize(size);
+
+            if(!_readAt(offset, compressed.data(), size)){
+                std::memset((char*)out, 0x00, _tileByteSize);
+
+                return false;
+            }
+
+            uLongf outLen = (uLongf)_tileByteSize;
+
+            if(uncompress(out, &outLen, compressed.data(), (uLong)size) != Z_OK || outLen != _tileByteSize){
+                std::memset((char*)out, 0x00, _tileByteSize);
+
+                return false;
+            }
 
             return true;
         }
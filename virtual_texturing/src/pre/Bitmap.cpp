@@ -7,6 +7,11 @@
 
 #include <lamure/vt/pre/Bitmap.h>
 #include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 
 namespace vt {
@@ -471,6 +476,113 @@ namespace vt {
             return _byteSize;
         }
 
+        template<>
+        void Bitmap::_deflateRow<Bitmap::PIXEL_FORMAT::R8>(const uint8_t * const srcRow0, const uint8_t * const srcRow1, uint8_t * const destRow, size_t destWidth){
+            size_t x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i one = _mm_set1_epi16(1);
+
+            // 32 source pixels of each row to 16 destination pixels
+            for(; x + 16 <= destWidth; x += 16){
+                __m128i top0 = _mm_loadu_si128((const __m128i*)&srcRow0[x << 1]);
+                __m128i top1 = _mm_loadu_si128((const __m128i*)&srcRow0[(x << 1) + 16]);
+                __m128i bottom0 = _mm_loadu_si128((const __m128i*)&srcRow1[x << 1]);
+                __m128i bottom1 = _mm_loadu_si128((const __m128i*)&srcRow1[(x << 1) + 16]);
+
+                // vertical sums as 16 bit, neighbouring pairs summed to 32 bit
+                __m128i sum0 = _mm_madd_epi16(_mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero)), one);
+                __m128i sum1 = _mm_madd_epi16(_mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero)), one);
+                __m128i sum2 = _mm_madd_epi16(_mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero)), one);
+                __m128i sum3 = _mm_madd_epi16(_mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero)), one);
+
+                __m128i avg0 = _mm_packs_epi32(_mm_srli_epi32(sum0, 2), _mm_srli_epi32(sum1, 2));
+                __m128i avg1 = _mm_packs_epi32(_mm_srli_epi32(sum2, 2), _mm_srli_epi32(sum3, 2));
+
+                _mm_storeu_si128((__m128i*)&destRow[x], _mm_packus_epi16(avg0, avg1));
+            }
+#endif
+
+            for(; x < destWidth; ++x){
+                const uint8_t *top = &srcRow0[x << 1];
+                const uint8_t *bottom = &srcRow1[x << 1];
+
+                destRow[x] = (uint8_t)(((uint16_t)top[0] + top[1] + bottom[0] + bottom[1]) >> 2);
+            }
+        }
+
+        template<>
+        void Bitmap::_deflateRow<Bitmap::PIXEL_FORMAT::RGB8>(const uint8_t * const srcRow0, const uint8_t * const srcRow1, uint8_t * const destRow, size_t destWidth){
+            for(size_t x = 0; x < destWidth; ++x){
+                const uint8_t *top = &srcRow0[x * 6];
+                const uint8_t *bottom = &srcRow1[x * 6];
+                uint8_t *dest = &destRow[x * 3];
+
+                dest[0] = (uint8_t)(((uint16_t)top[0] + top[3] + bottom[0] + bottom[3]) >> 2);
+                dest[1] = (uint8_t)(((uint16_t)top[1] + top[4] + bottom[1] + bottom[4]) >> 2);
+                dest[2] = (uint8_t)(((uint16_t)top[2] + top[5] + bottom[2] + bottom[5]) >> 2);
+            }
+        }
+
+        template<>
+        void Bitmap::_deflateRow<Bitmap::PIXEL_FORMAT::RGBA8>(const uint8_t * const srcRow0, const uint8_t * const srcRow1, uint8_t * const destRow, size_t destWidth){
+            size_t x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+            const __m128i zero = _mm_setzero_si128();
+
+            // 8 source pixels of each row to 4 destination pixels
+            for(; x + 4 <= destWidth; x += 4){
+                __m128i top0 = _mm_loadu_si128((const __m128i*)&srcRow0[x << 3]);
+                __m128i top1 = _mm_loadu_si128((const __m128i*)&srcRow0[(x << 3) + 16]);
+                __m128i bottom0 = _mm_loadu_si128((const __m128i*)&srcRow1[x << 3]);
+                __m128i bottom1 = _mm_loadu_si128((const __m128i*)&srcRow1[(x << 3) + 16]);
+
+                // vertical sums of two pixels per register
+                __m128i sum01 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+                __m128i sum23 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+                __m128i sum45 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+                __m128i sum67 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+                // even pixels plus odd pixels
+                __m128i avg0 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum01, sum23), _mm_unpackhi_epi64(sum01, sum23)), 2);
+                __m128i avg1 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum45, sum67), _mm_unpackhi_epi64(sum45, sum67)), 2);
+
+                _mm_storeu_si128((__m128i*)&destRow[x << 2], _mm_packus_epi16(avg0, avg1));
+            }
+#endif
+
+            for(; x < destWidth; ++x){
+                const uint8_t *top = &srcRow0[x << 3];
+                const uint8_t *bottom = &srcRow1[x << 3];
+                uint8_t *dest = &destRow[x << 2];
+
+                dest[0] = (uint8_t)(((uint16_t)top[0] + top[4] + bottom[0] + bottom[4]) >> 2);
+                dest[1] = (uint8_t)(((uint16_t)top[1] + top[5] + bottom[1] + bottom[5]) >> 2);
+                dest[2] = (uint8_t)(((uint16_t)top[2] + top[6] + bottom[2] + bottom[6]) >> 2);
+                dest[3] = (uint8_t)(((uint16_t)top[3] + top[7] + bottom[3] + bottom[7]) >> 2);
+            }
+        }
+
+        template<Bitmap::PIXEL_FORMAT format>
+        void Bitmap::_inflateRow(const uint8_t * const srcRow, uint8_t * const destRow0, uint8_t * const destRow1, size_t srcWidth){
+            const size_t pxSize = (format == PIXEL_FORMAT::R8) ? 1 : ((format == PIXEL_FORMAT::RGB8) ? 3 : 4);
+
+            for(size_t x = 0; x < srcWidth; ++x){
+                const uint8_t *srcPx = &srcRow[x * pxSize];
+                uint8_t *dest0 = &destRow0[(x << 1) * pxSize];
+                uint8_t *dest1 = &destRow1[(x << 1) * pxSize];
+
+                for(size_t c = 0; c < pxSize; ++c){
+                    dest0[c] = srcPx[c];
+                    dest0[pxSize + c] = srcPx[c];
+                    dest1[c] = srcPx[c];
+                    dest1[pxSize + c] = srcPx[c];
+                }
+            }
+        }
+
         void Bitmap::copyRectFrom(const Bitmap &src, size_t srcX, size_t srcY, size_t destX, size_t destY, size_t cpyWidth, size_t cpyHeight){
 #ifdef BITMAP_ENABLE_SAFETY_CHECKS
             if((srcX + cpyWidth) > src._width || (srcY + cpyHeight) > src._height){
@@ -485,6 +597,14 @@ namespace vt {
             size_t srcPixelSize = pixelSize(src._format);
             size_t destPixelSize = pixelSize(_format);
 
+            if(src._format == _format){
+                for(size_t y = 0; y < cpyHeight; ++y) {
+                    std::memmove(&_data[((destY + y) * _width + destX) * destPixelSize], &src._data[((srcY + y) * src._width + srcX) * srcPixelSize], cpyWidth * destPixelSize);
+                }
+
+                return;
+            }
+
             for(size_t y = 0; y < cpyHeight; ++y) {
                 for (size_t x = 0; x < cpyWidth; ++x) {
                     _copyPixel(&src._data[((srcY + y) * src._width + srcX + x) * srcPixelSize], src._format, &_data[((destY + y) * _width + destX + x) * destPixelSize], _format);
@@ -506,6 +626,36 @@ namespace vt {
             size_t srcPixelSize = pixelSize(src._format);
             size_t destPixelSize = pixelSize(_format);
 
+            void (*deflateRow)(const uint8_t * const, const uint8_t * const, uint8_t * const, size_t) = nullptr;
+
+            if(src._format == _format && (cpyWidth & 1) == 0 && (cpyHeight & 1) == 0){
+                switch(_format){
+                    case PIXEL_FORMAT::R8:
+                        deflateRow = &_deflateRow<PIXEL_FORMAT::R8>;
+                        break;
+                    case PIXEL_FORMAT::RGB8:
+                        deflateRow = &_deflateRow<PIXEL_FORMAT::RGB8>;
+                        break;
+                    case PIXEL_FORMAT::RGBA8:
+                        deflateRow = &_deflateRow<PIXEL_FORMAT::RGBA8>;
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            if(deflateRow != nullptr){
+                for(size_t y = 0; y < cpyHeight; y += 2) {
+                    const uint8_t *srcRow0 = &src._data[((srcY + y) * src._width + srcX) * srcPixelSize];
+
+                    deflateRow(srcRow0, srcRow0 + src._width * srcPixelSize,
+                               &_data[((destY + (y >> 1)) * _width + destX) * destPixelSize],
+                               cpyWidth >> 1);
+                }
+
+                return;
+            }
+
             for(size_t y = 0; y < cpyHeight; y += 2) {
                 for (size_t x = 0; x < cpyWidth; x += 2) {
                     _deflatePixels(&src._data[((srcY + y) * src._width + srcX + x) * srcPixelSize], &src._data[((srcY + y) * src._width + srcX + x + 1) * srcPixelSize],
@@ -531,8 +681,38 @@ namespace vt {
             size_t srcPixelSize = pixelSize(src._format);
             size_t destPixelSize = pixelSize(_format);
 
-            for(size_t y = 0; y < cpyHeight; y += 2) {
-                for (size_t x = 0; x < cpyWidth; x += 2) {
+            void (*inflateRow)(const uint8_t * const, uint8_t * const, uint8_t * const, size_t) = nullptr;
+
+            if(src._format == _format){
+                switch(_format){
+                    case PIXEL_FORMAT::R8:
+                        inflateRow = &_inflateRow<PIXEL_FORMAT::R8>;
+                        break;
+                    case PIXEL_FORMAT::RGB8:
+                        inflateRow = &_inflateRow<PIXEL_FORMAT::RGB8>;
+                        break;
+                    case PIXEL_FORMAT::RGBA8:
+                        inflateRow = &_inflateRow<PIXEL_FORMAT::RGBA8>;
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            if(inflateRow != nullptr){
+                for(size_t y = 0; y < cpyHeight; ++y) {
+                    uint8_t *destRow0 = &_data[((destY + (y << 1)) * _width + destX) * destPixelSize];
+
+                    inflateRow(&src._data[((srcY + y) * src._width + srcX) * srcPixelSize],
+                               destRow0, destRow0 + _width * destPixelSize,
+                               cpyWidth);
+                }
+
+                return;
+            }
+
+            for(size_t y = 0; y < cpyHeight; ++y) {
+                for (size_t x = 0; x < cpyWidth; ++x) {
                     _inflatePixel(&src._data[((srcY + y) * src._width + srcX + x) * srcPixelSize], src._format,
                                   &_data[((destY + (y << 1)) * _width + destX + (x << 1)) * destPixelSize],
                                   &_data[((destY + (y << 1)) * _width + destX + (x << 1) + 1) * destPixelSize],
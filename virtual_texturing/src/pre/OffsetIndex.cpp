@@ -17,6 +17,7 @@ namespace vt {
                     idx = id;
                     break;
                 case AtlasFile::LAYOUT::PACKED:
+                case AtlasFile::LAYOUT::PACKED_DEFLATE:
                     idx = id + 1;
                     break;
                 default:
@@ -47,6 +48,7 @@ namespace vt {
                     nextIdx = idx + 1;
                     break;
                 case AtlasFile::LAYOUT::PACKED:
+                case AtlasFile::LAYOUT::PACKED_DEFLATE:
                     nextIdx = idx - 1;
                     break;
                 default:
@@ -68,6 +70,7 @@ namespace vt {
                     nextIdx = idx + 1;
                     break;
                 case AtlasFile::LAYOUT::PACKED:
+                case AtlasFile::LAYOUT::PACKED_DEFLATE:
                     nextIdx = idx - 1;
                     break;
                 default:
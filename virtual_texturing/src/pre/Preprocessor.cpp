@@ -6,6 +6,21 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/vt/pre/Preprocessor.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#ifdef WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace vt{
     namespace pre {
@@ -19,7 +34,115 @@ namespace vt{
             }
         }
 
+        void Preprocessor::_filterDeflateJob(DeflateJob &job) {
+            Bitmap bufferBitmap0(_tileWidth, _tileHeight, _destPxFormat, job.buffer);
+            Bitmap bufferBitmap1(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize]);
+            Bitmap bufferBitmap2(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 2]);
+            Bitmap bufferBitmap3(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 3]);
+            Bitmap bufferBitmap4(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 4]);
+            Bitmap bufferBitmap5(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 5]);
+            Bitmap bufferBitmap6(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 6]);
+            Bitmap bufferBitmap7(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 7]);
+            Bitmap bufferBitmap8(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 8]);
+            Bitmap writeBitmap(_tileWidth, _tileHeight, _destPxFormat, &job.buffer[_destTileByteSize * 9]);
+
+            size_t halfTileWidthInner = _innerTileWidth >> 1;
+            size_t halfTileHeightInner = _innerTileHeight >> 1;
+
+            uint64_t x = job.x;
+            uint64_t y = job.y;
+
+            std::memset((void *) &job.buffer[_destTileByteSize * 9], 0, _destTileByteSize);
+
+            writeBitmap.deflateRectFrom(bufferBitmap0,
+                                        _padding, _padding,
+                                        _padding + halfTileWidthInner, _padding + (_innerTileHeight >> 1),
+                                        _innerTileWidth, _innerTileHeight);
+
+            writeBitmap.deflateRectFrom(bufferBitmap1,
+                                        _padding, _padding,
+                                        _padding, _padding + halfTileHeightInner,
+                                        _innerTileWidth, _innerTileHeight);
+
+            writeBitmap.deflateRectFrom(bufferBitmap2,
+                                        _padding, _padding,
+                                        _padding + halfTileWidthInner, _padding,
+                                        _innerTileWidth, _innerTileHeight);
+
+            writeBitmap.deflateRectFrom(bufferBitmap3,
+                                        _padding, _padding,
+                                        _padding, _padding,
+                                        _innerTileWidth, _innerTileHeight);
+
+            if (x == 0) {
+                writeBitmap.smearHorizontal(_padding, _padding,
+                                            0, _padding,
+                                            _padding, _innerTileHeight);
+            } else {
+                // pad lower left side
+                writeBitmap.deflateRectFrom(bufferBitmap4,
+                                            _padding + _innerTileWidth - (_padding << 1), _padding,
+                                            0, _padding + halfTileHeightInner,
+                                            _padding << 1, _innerTileHeight);
+
+                // pad upper left side
+                writeBitmap.deflateRectFrom(bufferBitmap5,
+                                            _padding + _innerTileWidth - (_padding << 1), _padding,
+                                            0, _padding,
+                                            _padding << 1, _innerTileHeight);
+
+                if (y > 0) {
+                    // pad upper left corner
+                    writeBitmap.deflateRectFrom(bufferBitmap6,
+                                                _padding + _innerTileWidth - (_padding << 1),
+                                                _padding + _innerTileHeight - (_padding << 1),
+                                                0, 0,
+                                                _padding << 1, _padding << 1);
+                }
+            }
+
+            if (y == 0) {
+                // pad top side
+                writeBitmap.smearVertical(0, _padding,
+                                          0, 0,
+                                          _padding + _innerTileWidth, _padding);
+            } else {
+                // pad right top side
+                writeBitmap.deflateRectFrom(bufferBitmap7,
+                                            _padding, _padding + _innerTileHeight - (_padding << 1),
+                                            _padding + halfTileWidthInner, 0,
+                                            _innerTileWidth, _padding << 1);
+
+                // pad left top side
+                writeBitmap.deflateRectFrom(bufferBitmap8,
+                                            _padding, _padding + _innerTileHeight - (_padding << 1),
+                                            _padding, 0,
+                                            _innerTileWidth, _padding << 1);
+
+                if (x == 0) {
+                    // pad upper left corner
+                    writeBitmap.smearHorizontal(_padding, 0,
+                                                0, 0,
+                                                _padding, _padding);
+                }
+            }
+        }
+
         void Preprocessor::_deflate(size_t writeBufferSize) {
+            // tiles of a level are built in a pipeline: this thread loads the tiles of the level below,
+            // filter threads downsample them and this thread pads and writes the results in order
+            size_t filterThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+            size_t jobByteSize = _DEFLATE_JOB_TILES * _destTileByteSize;
+
+            // the job ring takes at most half of the memory budget, the rest is left for the write buffer
+            size_t jobCount = std::min(filterThreadCount * 4, (writeBufferSize >> 1) / jobByteSize);
+            jobCount = std::max(jobCount, (size_t) 1);
+            filterThreadCount = std::min(filterThreadCount, jobCount);
+
+            if (writeBufferSize >= ((jobCount * jobByteSize) << 1)) {
+                writeBufferSize -= jobCount * jobByteSize;
+            }
+
             size_t writeBufferTileSize = writeBufferSize / _destTileByteSize;
             writeBufferSize = writeBufferTileSize * _destTileByteSize;
 
@@ -46,22 +169,89 @@ namespace vt{
                 }
             }
 
-            size_t bufferSize = _destTileByteSize * 12;
-            auto buffer = new uint8_t[bufferSize];
+            auto jobBuffer = new uint8_t[jobCount * jobByteSize];
             auto writeBuffer = new uint8_t[writeBufferSize];
 
-            Bitmap bufferBitmap0(_tileWidth, _tileHeight, _destPxFormat, buffer);
-            Bitmap bufferBitmap1(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize]);
-            Bitmap bufferBitmap2(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 2]);
-            Bitmap bufferBitmap3(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 3]);
-            Bitmap bufferBitmap4(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 4]);
-            Bitmap bufferBitmap5(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 5]);
-            Bitmap bufferBitmap6(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 6]);
-            Bitmap bufferBitmap7(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 7]);
-            Bitmap bufferBitmap8(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 8]);
-            Bitmap bufferBitmap9(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 9]);
-            Bitmap bufferBitmap10(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 10]);
-            Bitmap writeBitmap(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 11]);
+            std::vector<DeflateJob> jobs(jobCount);
+
+            for (size_t i = 0; i < jobCount; ++i) {
+                jobs[i].state = DeflateJob::STATE::FREE;
+                jobs[i].buffer = &jobBuffer[i * jobByteSize];
+            }
+
+            // neighbours in the level that is written, they are done before the tile is padded
+            auto neighbourBuffer = new uint8_t[_destTileByteSize * 2];
+
+            Bitmap bufferBitmap9(_tileWidth, _tileHeight, _destPxFormat, neighbourBuffer);
+            Bitmap bufferBitmap10(_tileWidth, _tileHeight, _destPxFormat, &neighbourBuffer[_destTileByteSize]);
+
+            std::mutex jobLock;
+            std::condition_variable jobLoaded;
+            std::condition_variable jobFiltered;
+            uint64_t loadedJobs = 0;
+            uint64_t nextFilterJob = 0;
+            bool stopFilters = false;
+
+            std::vector<std::thread> filterThreads;
+
+            for (size_t i = 0; i < filterThreadCount; ++i) {
+                filterThreads.emplace_back([&]() {
+                    while (true) {
+                        DeflateJob *job = nullptr;
+
+                        {
+                            std::unique_lock<std::mutex> lock(jobLock);
+
+                            jobLoaded.wait(lock, [&]() {
+                                return stopFilters || nextFilterJob < loadedJobs;
+                            });
+
+                            if (nextFilterJob >= loadedJobs) {
+                                return;
+                            }
+
+                            job = &jobs[nextFilterJob % jobCount];
+                            ++nextFilterJob;
+                        }
+
+                        _filterDeflateJob(*job);
+
+                        {
+                            std::lock_guard<std::mutex> lock(jobLock);
+                            job->state = DeflateJob::STATE::FILTERED;
+                        }
+
+                        jobFiltered.notify_one();
+                    }
+                });
+            }
+
+            auto stopFilterThreads = [&]() {
+                {
+                    std::lock_guard<std::mutex> lock(jobLock);
+                    stopFilters = true;
+                }
+
+                jobLoaded.notify_all();
+
+                for (auto &thread : filterThreads) {
+                    if (thread.joinable()) {
+                        thread.join();
+                    }
+                }
+            };
+
+            // the filter threads are also stopped if loading or writing a tile throws
+            struct FilterThreadGuard {
+                std::function<void()> stop;
+
+                ~FilterThreadGuard() {
+                    stop();
+                }
+            } filterThreadGuard{stopFilterThreads};
+
+            uint64_t issuedJobs = 0;
+            uint64_t writtenJobs = 0;
 
             auto levelTileWidth = _imageTileWidth;
             auto levelTileHeight = _imageTileHeight;
@@ -98,6 +288,9 @@ namespace vt{
                     std::cout.flush();
 #endif
 
+                    // tiles of the level in the order they are written
+                    std::vector<uint64_t> levelJobs;
+
                     for (uint64_t relIterationId =
                             tilesInIterationLevel - 1; /* relIterationId > 0 */; --relIterationId) {
                         uint64_t x;
@@ -105,182 +298,140 @@ namespace vt{
 
                         QuadTree::getCoordinatesInLevel(relIterationId, iterationLevel, x, y);
 
-                        if (x >= iterationLevelTileWidth || y >= iterationLevelTileHeight) {
-                            continue;
+                        if (x < iterationLevelTileWidth && y < iterationLevelTileHeight) {
+                            levelJobs.push_back(relIterationId);
                         }
 
-                        uint64_t absIterationId = firstIdOfIterationLevel + relIterationId;
-                        size_t bufferOffset = 0;
-
-                        for (uint8_t relQuadId = 3;; --relQuadId) {
-                            uint64_t relId = (relIterationId << 2) + relQuadId;
-                            uint64_t absId = firstIdOfCurrentLevel + relId;
-
-                            uint64_t len = 0;
+                        if (relIterationId == 0) {
+                            break;
+                        }
+                    }
 
-                            uint64_t childX;
-                            uint64_t childY;
+                    uint64_t firstJobOfLevel = issuedJobs;
+                    uint64_t lastJobOfLevel = issuedJobs + levelJobs.size();
 
-                            QuadTree::getCoordinatesInLevel(relId, iterationLevel + 1, childX, childY);
+                    while (writtenJobs < lastJobOfLevel) {
+                        // keep the filter threads busy, the ring of jobs bounds what is in flight
+                        while (issuedJobs < lastJobOfLevel && (issuedJobs - writtenJobs) < jobCount) {
+                            auto &job = jobs[issuedJobs % jobCount];
+                            uint64_t relIterationId = levelJobs[issuedJobs - firstJobOfLevel];
+                            uint8_t *buffer = job.buffer;
+                            size_t bufferOffset = 0;
 
-                            if (childX < levelTileWidth && childY < levelTileHeight) {
-                                len = _getTileById(absId, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup,
-                                                   writeBufferTileSize, &buffer[bufferOffset]);
-                            }
+                            job.relId = relIterationId;
+                            QuadTree::getCoordinatesInLevel(relIterationId, iterationLevel, job.x, job.y);
 
-                            if (len == 0) {
-                                std::memset(&buffer[bufferOffset], 0, _destTileByteSize);
-                            }
+                            for (uint8_t relQuadId = 3;; --relQuadId) {
+                                uint64_t relId = (relIterationId << 2) + relQuadId;
+                                uint64_t absId = firstIdOfCurrentLevel + relId;
 
-                            if (relQuadId == 0) {
-                                break;
-                            }
+                                uint64_t len = 0;
 
-                            bufferOffset += _destTileByteSize;
-                        }
+                                uint64_t childX;
+                                uint64_t childY;
 
-                        uint64_t relId = relIterationId << 2;
+                                QuadTree::getCoordinatesInLevel(relId, iterationLevel + 1, childX, childY);
 
-                        uint64_t relId1 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::LEFT);
-                        uint64_t relId2 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::BOTTOM);
-                        uint64_t relId0 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::TOP);
+                                if (childX < levelTileWidth && childY < levelTileHeight) {
+                                    len = _getTileById(absId, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup,
+                                                       writeBufferTileSize, &buffer[bufferOffset]);
+                                }
 
-                        uint64_t len = 0;
+                                if (len == 0) {
+                                    std::memset(&buffer[bufferOffset], 0, _destTileByteSize);
+                                }
 
-                        bufferOffset += _destTileByteSize;
-                        if (relId1 != relId)
-                            len = _getTileById(firstIdOfCurrentLevel + relId2, writeBuffer, writeBufferFirstId,
-                                               writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                        if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                                if (relQuadId == 0) {
+                                    break;
+                                }
 
-                        bufferOffset += _destTileByteSize;
-                        if (relId1 != relId)
-                            len = _getTileById(firstIdOfCurrentLevel + relId1, writeBuffer, writeBufferFirstId,
-                                               writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                        if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                                bufferOffset += _destTileByteSize;
+                            }
 
-                        len = 0;
+                            uint64_t relId = relIterationId << 2;
 
-                        bufferOffset += _destTileByteSize;
-                        if (relId1 != relId && relId0 != relId1)
-                            len = _getTileById(firstIdOfCurrentLevel + relId0, writeBuffer, writeBufferFirstId,
-                                               writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                        if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                            uint64_t relId1 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::LEFT);
+                            uint64_t relId2 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::BOTTOM);
+                            uint64_t relId0 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::TOP);
 
-                        relId0 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::TOP);
-                        relId1 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::RIGHT);
+                            uint64_t len = 0;
 
-                        len = 0;
+                            bufferOffset += _destTileByteSize;
+                            if (relId1 != relId)
+                                len = _getTileById(firstIdOfCurrentLevel + relId2, writeBuffer, writeBufferFirstId,
+                                                   writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
+                            if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
 
-                        QuadTree::getCoordinatesInLevel(relId2, iterationLevel + 1, x, y);
+                            bufferOffset += _destTileByteSize;
+                            if (relId1 != relId)
+                                len = _getTileById(firstIdOfCurrentLevel + relId1, writeBuffer, writeBufferFirstId,
+                                                   writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
+                            if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
 
-                        bufferOffset += _destTileByteSize;
-                        if (relId0 != relId)
-                            len = _getTileById(firstIdOfCurrentLevel + relId1, writeBuffer, writeBufferFirstId,
-                                               writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                        if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                            len = 0;
 
-                        bufferOffset += _destTileByteSize;
-                        if (relId0 != relId)
-                            len = _getTileById(firstIdOfCurrentLevel + relId0, writeBuffer, writeBufferFirstId,
-                                               writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                        if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                            bufferOffset += _destTileByteSize;
+                            if (relId1 != relId && relId0 != relId1)
+                                len = _getTileById(firstIdOfCurrentLevel + relId0, writeBuffer, writeBufferFirstId,
+                                                   writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
+                            if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
 
-                        relId0 = relIterationId;
-                        relId1 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::RIGHT);
-                        relId2 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::BOTTOM);
+                            relId0 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::TOP);
+                            relId1 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::RIGHT);
 
-                        bufferOffset += _destTileByteSize;
-                        len = _getTileById(firstIdOfIterationLevel + relId2, writeBuffer, writeBufferFirstId,
-                                           writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                        if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                            len = 0;
 
-                        bufferOffset += _destTileByteSize;
-                        len = _getTileById(firstIdOfIterationLevel + relId1, writeBuffer, writeBufferFirstId,
-                                           writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                        if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                            bufferOffset += _destTileByteSize;
+                            if (relId0 != relId)
+                                len = _getTileById(firstIdOfCurrentLevel + relId1, writeBuffer, writeBufferFirstId,
+                                                   writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
+                            if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
 
-                        bufferOffset += _destTileByteSize;
+                            bufferOffset += _destTileByteSize;
+                            if (relId0 != relId)
+                                len = _getTileById(firstIdOfCurrentLevel + relId0, writeBuffer, writeBufferFirstId,
+                                                   writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
+                            if (len == 0) memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+
+                            {
+                                std::lock_guard<std::mutex> lock(jobLock);
+                                job.state = DeflateJob::STATE::LOADED;
+                                ++loadedJobs;
+                            }
 
-                        size_t halfTileWidthInner = _innerTileWidth >> 1;
-                        size_t halfTileHeightInner = _innerTileHeight >> 1;
+                            jobLoaded.notify_one();
+                            ++issuedJobs;
+                        }
 
-                        QuadTree::getCoordinatesInLevel(relIterationId, iterationLevel, x, y);
+                        auto &job = jobs[writtenJobs % jobCount];
 
-                        std::memset((void *) &buffer[bufferOffset], 0, _destTileByteSize);
+                        {
+                            std::unique_lock<std::mutex> lock(jobLock);
 
-                        writeBitmap.deflateRectFrom(bufferBitmap0,
-                                                    _padding, _padding,
-                                                    _padding + halfTileWidthInner, _padding + (_innerTileHeight >> 1),
-                                                    _innerTileWidth, _innerTileHeight);
+                            jobFiltered.wait(lock, [&]() {
+                                return job.state == DeflateJob::STATE::FILTERED;
+                            });
+                        }
 
-                        writeBitmap.deflateRectFrom(bufferBitmap1,
-                                                    _padding, _padding,
-                                                    _padding, _padding + halfTileHeightInner,
-                                                    _innerTileWidth, _innerTileHeight);
+                        uint64_t relIterationId = job.relId;
+                        uint64_t absIterationId = firstIdOfIterationLevel + relIterationId;
+                        uint64_t x = job.x;
+                        uint64_t y = job.y;
+                        uint8_t *tile = &job.buffer[_destTileByteSize * 9];
 
-                        writeBitmap.deflateRectFrom(bufferBitmap2,
-                                                    _padding, _padding,
-                                                    _padding + halfTileWidthInner, _padding,
-                                                    _innerTileWidth, _innerTileHeight);
+                        Bitmap writeBitmap(_tileWidth, _tileHeight, _destPxFormat, tile);
 
-                        writeBitmap.deflateRectFrom(bufferBitmap3,
-                                                    _padding, _padding,
-                                                    _padding, _padding,
-                                                    _innerTileWidth, _innerTileHeight);
+                        // right and bottom neighbour have higher ids, so they have been written already
+                        uint64_t relId1 = QuadTree::getNeighbour(relIterationId, QuadTree::NEIGHBOUR::RIGHT);
+                        uint64_t relId2 = QuadTree::getNeighbour(relIterationId, QuadTree::NEIGHBOUR::BOTTOM);
 
-                        if (x == 0) {
-                            writeBitmap.smearHorizontal(_padding, _padding,
-                                                        0, _padding,
-                                                        _padding, _innerTileHeight);
-                        } else {
-                            // pad lower left side
-                            writeBitmap.deflateRectFrom(bufferBitmap4,
-                                                        _padding + _innerTileWidth - (_padding << 1), _padding,
-                                                        0, _padding + halfTileHeightInner,
-                                                        _padding << 1, _innerTileHeight);
-
-                            // pad upper left side
-                            writeBitmap.deflateRectFrom(bufferBitmap5,
-                                                        _padding + _innerTileWidth - (_padding << 1), _padding,
-                                                        0, _padding,
-                                                        _padding << 1, _innerTileHeight);
-
-                            if (y > 0) {
-                                // pad upper left corner
-                                writeBitmap.deflateRectFrom(bufferBitmap6,
-                                                            _padding + _innerTileWidth - (_padding << 1),
-                                                            _padding + _innerTileHeight - (_padding << 1),
-                                                            0, 0,
-                                                            _padding << 1, _padding << 1);
-                            }
-                        }
+                        uint64_t len = _getTileById(firstIdOfIterationLevel + relId2, writeBuffer, writeBufferFirstId,
+                                                    writeBufferLastId, idLookup, writeBufferTileSize, neighbourBuffer);
+                        if (len == 0) memset_volatile(neighbourBuffer, 0, _destTileByteSize);
 
-                        if (y == 0) {
-                            // pad top side
-                            writeBitmap.smearVertical(0, _padding,
-                                                      0, 0,
-                                                      _padding + _innerTileWidth, _padding);
-                        } else {
-                            // pad right top side
-                            writeBitmap.deflateRectFrom(bufferBitmap7,
-                                                        _padding, _padding + _innerTileHeight - (_padding << 1),
-                                                        _padding + halfTileWidthInner, 0,
-                                                        _innerTileWidth, _padding << 1);
-
-                            // pad left top side
-                            writeBitmap.deflateRectFrom(bufferBitmap8,
-                                                        _padding, _padding + _innerTileHeight - (_padding << 1),
-                                                        _padding, 0,
-                                                        _innerTileWidth, _padding << 1);
-
-                            if (x == 0) {
-                                // pad upper left corner
-                                writeBitmap.smearHorizontal(_padding, 0,
-                                                            0, 0,
-                                                            _padding, _padding);
-                            }
-                        }
+                        len = _getTileById(firstIdOfIterationLevel + relId1, writeBuffer, writeBufferFirstId,
+                                           writeBufferLastId, idLookup, writeBufferTileSize, &neighbourBuffer[_destTileByteSize]);
+                        if (len == 0) memset_volatile(&neighbourBuffer[_destTileByteSize], 0, _destTileByteSize);
 
                         bool xIsLast = x == (iterationLevelTileWidth - 1);
                         bool yIsLast = y == (iterationLevelTileHeight - 1);
@@ -355,7 +506,7 @@ namespace vt{
 
                             std::memset(&writeBuffer[currentOffset - writeBufferOffset + _destTileByteSize], 0x00,
                                         lastWriteOffset - currentOffset - _destTileByteSize);
-                            std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char *) &buffer[bufferOffset],
+                            std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char *) tile,
                                         _destTileByteSize);
                             lastWriteOffset = currentOffset;
                         } else {
@@ -369,7 +520,7 @@ namespace vt{
                             //std::cout << currentOffset << std::endl;
                             _offsetIndex->set(absIterationId, currentOffset, _destTileByteSize);
 
-                            std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char *) &buffer[bufferOffset],
+                            std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char *) tile,
                                         _destTileByteSize);
                             writeBufferLastId = idLookup[(((currentOffset - writeBufferOffset) / _destTileByteSize) + 1) % writeBufferTileSize];
                             writeBufferFirstId = absIterationId;
@@ -377,6 +528,9 @@ namespace vt{
                             currentOffset += _destTileByteSize;
                         }
 
+                        job.state = DeflateJob::STATE::FREE;
+                        ++writtenJobs;
+
 #ifdef PREPROCESSOR_LOG_PROGRESS
                         ++tilesWritten;
                         auto currentProgress = (uint8_t) (tilesWritten * 100 / iterationLevelTileWidth /
@@ -388,10 +542,6 @@ namespace vt{
                             std::cout.flush();
                         }
 #endif
-
-                        if (relIterationId == 0) {
-                            break;
-                        }
                     }
 
                     levelTileWidth = iterationLevelTileWidth;
@@ -410,12 +560,14 @@ namespace vt{
                 }
             }
 
+            stopFilterThreads();
+
             _destPayloadFile.seekp(_destPayloadOffset + writeBufferOffset);
 
             if (_destLayout == AtlasFile::RAW) {
                 _destPayloadFile.write((char *) writeBuffer,
                                        std::min(writeBufferSize, offsetAfterLastTile - writeBufferOffset));
-            } else if (_destLayout == AtlasFile::PACKED) {
+            } else if (_destLayout == AtlasFile::PACKED || _destLayout == AtlasFile::PACKED_DEFLATE) {
                 _destPayloadFile.write((char *) writeBuffer, (currentOffset - writeBufferOffset));
             }
 
@@ -426,7 +578,8 @@ namespace vt{
             _destIndexFile->seekp(_destCielabIndexOffset);
             _cielabIndex->writeToFile(*_destIndexFile);
 
-            delete[] buffer;
+            delete[] jobBuffer;
+            delete[] neighbourBuffer;
             delete[] writeBuffer;
             delete[] idLookup;
         }
@@ -582,6 +735,9 @@ namespace vt{
                 case AtlasFile::LAYOUT::PACKED:
                     out[0] = 2;
                     break;
+                case AtlasFile::LAYOUT::PACKED_DEFLATE:
+                    out[0] = 3;
+                    break;
                 default:
                     throw std::runtime_error("Trying to save unknown file format.");
             }
@@ -628,7 +784,8 @@ namespace vt{
             _tileHeight = tileHeight;
             _padding = padding;
 
-            if(_destLayout != AtlasFile::LAYOUT::PACKED){
+            // deflated atlases are built packed, the tiles are compressed afterwards
+            if(_destLayout != AtlasFile::LAYOUT::PACKED && _destLayout != AtlasFile::LAYOUT::PACKED_DEFLATE){
                 throw std::runtime_error("All formats but packed are deprecated.");
             }
 
@@ -686,7 +843,7 @@ namespace vt{
 
                 _destHeaderOffset = 0;
                 _destOffsetIndexOffset = _destHeaderOffset + _HEADER_SIZE;
-                _offsetIndex = new vt::pre::OffsetIndex(totalTileCount, format);
+                _offsetIndex = new vt::pre::OffsetIndex(totalTileCount, _destLayout);
                 _destCielabIndexOffset = _destOffsetIndexOffset + _offsetIndex->getByteSize();
                 _cielabIndex = new vt::pre::CielabIndex(totalTileCount);
                 _destPayloadOffset = _destCielabIndexOffset + _cielabIndex->getByteSize();
@@ -727,7 +884,7 @@ namespace vt{
 
                 _destHeaderOffset = 0;
                 _destOffsetIndexOffset = 0;
-                _offsetIndex = new vt::pre::OffsetIndex(totalTileCount, format);
+                _offsetIndex = new vt::pre::OffsetIndex(totalTileCount, _destLayout);
                 _destCielabIndexOffset = _destOffsetIndexOffset + _offsetIndex->getByteSize();
                 _cielabIndex = new vt::pre::CielabIndex(totalTileCount);
                 _destPayloadOffset = 0;
@@ -1002,7 +1159,7 @@ namespace vt{
             if (_destLayout == AtlasFile::RAW) {
                 _destPayloadFile.write((char *) writeBuffer,
                                        std::min(writeBufferSize, offsetAfterLastTile - writeBufferOffset));
-            } else if (_destLayout == AtlasFile::PACKED) {
+            } else if (_destLayout == AtlasFile::PACKED || _destLayout == AtlasFile::PACKED_DEFLATE) {
                 _destPayloadFile.write((char *) writeBuffer, (currentOffset - writeBufferOffset));
             }
 
@@ -1056,17 +1213,158 @@ namespace vt{
             _deflate(maxMemory);
             //_calcDeltaE(maxMemory);
 
+            if (_destLayout == AtlasFile::LAYOUT::PACKED_DEFLATE) {
+                _compress(maxMemory);
+            }
+
 #ifdef  PREPROCESSOR_LOG_PROGRESS
             std::cout << "Done in " << std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::high_resolution_clock::now() - start).count() << " ms." << std::endl << std::endl;
 #endif
         }
 
+        void Preprocessor::_compress(size_t maxMemory) {
+            // packed payload order: highest id first, tiles back to back
+            std::vector<uint64_t> ids;
+
+            for (uint64_t id = QuadTree::firstIdOfLevel(_treeDepth); id-- > 0;) {
+                if (_offsetIndex->exists(id)) {
+                    if (_offsetIndex->getOffset(id) != ids.size() * _destTileByteSize) {
+                        throw std::runtime_error("Unexpected tile order in payload.");
+                    }
+
+                    ids.push_back(id);
+                }
+            }
+
+            if (ids.empty()) {
+                return;
+            }
+
+            size_t boundSize = compressBound((uLong) _destTileByteSize);
+            size_t batchSize = std::max((size_t) 1, maxMemory / (_destTileByteSize + boundSize));
+            batchSize = std::min(batchSize, ids.size());
+
+            size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+            auto readBuffer = new uint8_t[batchSize * _destTileByteSize];
+            auto compressBuffer = new uint8_t[batchSize * boundSize];
+            std::vector<size_t> lengths(batchSize);
+
+            uint64_t writeOffset = 0;
+
+#ifdef PREPROCESSOR_LOG_PROGRESS
+            auto start = std::chrono::high_resolution_clock::now();
+            uint8_t progress = 0;
+
+            std::cout << "Compressing " << ids.size() << " Tiles on " << threadCount << " Threads: " << std::endl;
+            std::cout << std::setw(3) << (int) progress << " %";
+            std::cout.flush();
+#endif
+
+            for (size_t first = 0; first < ids.size(); first += batchSize) {
+                size_t count = std::min(batchSize, ids.size() - first);
+
+                // compressed tiles are never larger than raw ones, so writing
+                // always stays behind the batch that was read last
+                _destPayloadFile.seekg(_destPayloadOffset + first * _destTileByteSize);
+                _destPayloadFile.read((char *) readBuffer, count * _destTileByteSize);
+
+                if (_destPayloadFile.gcount() != (std::streamsize) (count * _destTileByteSize)) {
+                    throw std::runtime_error("Could not read back Tiles for compression.");
+                }
+
+                std::atomic<size_t> nextTile(0);
+
+                auto compressTiles = [&]() {
+                    for (size_t i = nextTile++; i < count; i = nextTile++) {
+                        auto len = (uLongf) boundSize;
+
+                        if (compress2(&compressBuffer[i * boundSize], &len, &readBuffer[i * _destTileByteSize],
+                                      (uLong) _destTileByteSize, Z_DEFAULT_COMPRESSION) != Z_OK ||
+                            len >= _destTileByteSize) {
+                            lengths[i] = _destTileByteSize;
+                        } else {
+                            lengths[i] = len;
+                        }
+                    }
+                };
+
+                std::vector<std::thread> threads;
+
+                for (size_t i = 1; i < std::min(threadCount, count); ++i) {
+                    threads.emplace_back(compressTiles);
+                }
+
+                compressTiles();
+
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+
+                _destPayloadFile.seekp(_destPayloadOffset + writeOffset);
+
+                for (size_t i = 0; i < count; ++i) {
+                    if (lengths[i] == _destTileByteSize) {
+                        _destPayloadFile.write((char *) &readBuffer[i * _destTileByteSize], _destTileByteSize);
+                    } else {
+                        _destPayloadFile.write((char *) &compressBuffer[i * boundSize], lengths[i]);
+                    }
+
+                    _offsetIndex->set(ids[first + i], writeOffset, lengths[i]);
+                    writeOffset += lengths[i];
+                }
+
+#ifdef PREPROCESSOR_LOG_PROGRESS
+                progress = (uint8_t) ((first + count) * 100 / ids.size());
+                std::cout << '\r' << std::setw(3) << (int) progress << " %";
+                std::cout.flush();
+#endif
+            }
+
+#ifdef PREPROCESSOR_LOG_PROGRESS
+            std::cout << " (" << std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::high_resolution_clock::now() - start).count() << " ms, "
+                      << (ids.size() * _destTileByteSize) << " -> " << writeOffset << " Bytes)" << std::endl
+                      << std::endl;
+#endif
+
+            delete[] readBuffer;
+            delete[] compressBuffer;
+
+            _destPayloadFile.flush();
+            _destIndexFile->seekp(_destOffsetIndexOffset);
+            _offsetIndex->writeToFile(*_destIndexFile);
+            _destIndexFile->flush();
+
+            _truncatePayload(_destPayloadOffset + writeOffset);
+        }
+
+        void Preprocessor::_truncatePayload(uint64_t fileSize) {
+            std::string fileName = _destFileName + (_destCombined == DEST_COMBINED::COMBINED ? ".atlas" : ".atlas.data");
+
+#ifdef WIN32
+            int fd = _open(fileName.c_str(), _O_RDWR | _O_BINARY);
+            bool truncated = fd >= 0 && _chsize_s(fd, (__int64) fileSize) == 0;
+
+            if (fd >= 0) {
+                _close(fd);
+            }
+#else
+            bool truncated = truncate(fileName.c_str(), (off_t) fileSize) == 0;
+#endif
+
+            if (!truncated) {
+                throw std::runtime_error("Could not truncate File \"" + fileName + "\".");
+            }
+        }
+
         void Preprocessor::_loadToSeqBuffer(uint8_t *buffer, uint64_t id, size_t count) {
             switch (_destLayout) {
                 case AtlasFile::LAYOUT::RAW:
                     break;
                 case AtlasFile::LAYOUT::PACKED:
+                case AtlasFile::LAYOUT::PACKED_DEFLATE:
                     uint64_t destId = 0;
 
                     if (id > count) {
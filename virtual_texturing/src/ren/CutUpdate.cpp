@@ -29,7 +29,7 @@ CutUpdate::~CutUpdate() {}
 
 void CutUpdate::start()
 {
-    _cut_db->get_tile_provider()->start((size_t)VTConfig::get_instance().get_size_ram_cache() * 1024 * 1024);
+    _cut_db->get_tile_provider()->start((size_t)VTConfig::get_instance().get_size_ram_cache() * 1024 * 1024, VTConfig::get_instance().get_num_loading_threads());
     _worker = std::thread(&CutUpdate::run, this);
 }
 